@@ -468,6 +468,7 @@ CherrySim::CherrySim(const SimConfiguration &simConfig)
 CherrySim::~CherrySim()
 {
     StoreFlashToFile();
+    StopPacketTrace();
 
     //Clean up up all nodes
     for (u32 i = 0; i < GetTotalNodes(); i++) {
@@ -512,6 +513,11 @@ void CherrySim::Init()
         TerminalPrintHandler(versionString.c_str());
     }
 
+    //The stack usage of the handlers is only reported for the current simulation
+    StackWatcher::ResetHandlerStackUsage();
+
+    if (!simConfig.packetTraceFile.empty()) StartPacketTrace(simConfig.packetTraceFile);
+
     //Generate a psuedo random number generator with a uniform distribution
     simState.rnd.SetSeed(simConfig.seed);
 
@@ -554,6 +560,20 @@ void CherrySim::Init()
         LoadPresetNodePositions();
     }
 
+    //Each crystal has its own error, which stays the same over reboots
+    if (simConfig.maxClockDriftPpm > 0) {
+        for (u32 i = 0; i < GetTotalNodes(); i++) {
+            nodes[i].clockDriftPpm = (i32)PSRNGINT(0, 2 * simConfig.maxClockDriftPpm) - (i32)simConfig.maxClockDriftPpm;
+        }
+    }
+
+    //The nRF52833 is close enough to the nRF52840 to share its current consumption
+    for (u32 i = 0; i < GetTotalNodes(); i++) {
+        NodeIndexSetter setter(i);
+        const Chipset chipset = GET_CHIPSET();
+        nodes[i].energyProfile = (chipset == Chipset::CHIP_NRF52840 || chipset == Chipset::CHIP_NRF52833) ? simConfig.energyProfileNrf52840 : simConfig.energyProfileNrf52832;
+    }
+
 #ifndef __EMSCRIPTEN__
     //Opens a Webserver to serve the FruityMap for visualization
     webserver = new FruitySimServer(simConfig.webServerPort);
@@ -1141,10 +1161,23 @@ void CherrySim::SimulateStepForAllNodes()
         globalBreakCounter++;
     }
 
+    if (simConfig.simulateAdvertisingCollisions) SimulateAdvertisingCollisions();
+
     //Run a check on the current clustering state
     if(simConfig.enableClusteringValidityCheck) CheckMeshingConsistency();
 
     simState.simTimeMs += simConfig.simTickDurationMs;
+
+    //The RTC of each node has to drift together with the simulation time so that it never runs backwards.
+    //The passed ms times ticksPerSecond are the passed ticks in 1/1000 ticks, times the drift in ppm gives 1/1000000000 ticks
+    for (u32 i = 0; i < GetTotalNodes(); i++) {
+        nodes[i].clockDriftNanoTicks += (int64_t)simConfig.simTickDurationMs * ticksPerSecond * nodes[i].clockDriftPpm;
+    }
+
+    if (timeSyncMeasurementActive && simState.simTimeMs >= timeSyncNextSampleMs) {
+        timeSyncNextSampleMs += timeSyncSampleIntervalMs;
+        SampleTimeSyncAccuracy();
+    }
     
     //Back up the flash every flashToFileWriteInterval's step.
     flashToFileWriteCycle++;
@@ -1302,6 +1335,13 @@ TerminalCommandHandlerReturnType CherrySim::TerminalCommandHandler(const std::ve
             sim_print_statistics();
 
             printf("Enter 'sim sendstat {nodeId=0}' or 'sim routestat {nodeId=0}' for packet statistics" EOL);
+            printf("Enter 'sim linkstat {nodeId=0}' for the load distribution over the connections" EOL);
+            printf("Enter 'sim sinkstat' for the throughput of all sinks" EOL);
+            printf("Enter 'sim radiostat {nodeId=0}' for the advertising airtime, scanning time and energy usage" EOL);
+            printf("Enter 'sim energy {nodeId=0}' for the average current by cause and the projected battery life" EOL);
+            printf("Enter 'sim stackstat {count=10}' or 'sim stackstat reset' for the handlers with the highest stack usage" EOL);
+            printf("Enter 'sim timesync start {intervalMs=1000}', 'sim timesync stop' or 'sim timesync' for the accuracy of the time sync" EOL);
+            printf("Enter 'sim trace start {path}' or 'sim trace stop' to write all mesh packet events into a pcap file" EOL);
 
             return TerminalCommandHandlerReturnType::SUCCESS;
         }
@@ -1448,7 +1488,9 @@ TerminalCommandHandlerReturnType CherrySim::TerminalCommandHandler(const std::ve
             return TerminalCommandHandlerReturnType::SUCCESS;
         }
         else if (commandArgs[1] == "nodestat") {
-            printf("Node advertising %d (iv %d)\n", currentNode->state.advertisingActive, currentNode->state.advertisingIntervalMs);
+            for (const SoftdeviceAdvertisingSet& advertisingSet : currentNode->state.advertisingSets) {
+                if (advertisingSet.configured) printf("Node advertising %d (iv %d)\n", advertisingSet.advertisingActive, advertisingSet.advertisingIntervalMs);
+            }
             printf("Node scanning %d (window %d, iv %d)\n", currentNode->state.scanningActive, currentNode->state.scanWindowMs, currentNode->state.scanIntervalMs);
 
             return TerminalCommandHandlerReturnType::SUCCESS;
@@ -1509,6 +1551,64 @@ TerminalCommandHandlerReturnType CherrySim::TerminalCommandHandler(const std::ve
             PrintPacketStats(nodeId, "ROUTED");
             return TerminalCommandHandlerReturnType::SUCCESS;
         }
+        else if (commandArgs[1] == "linkstat") {
+            //Print how the packets sent by a node are distributed over its connections
+            NodeId nodeId = commandArgs.size() >= 3 ? Utility::StringToU16(commandArgs[2].c_str()) : 0;
+            PrintLinkStats(nodeId);
+            return TerminalCommandHandlerReturnType::SUCCESS;
+        }
+        else if (commandArgs[1] == "sinkstat") {
+            //Print how many packets for the shortest sink were received by each sink
+            PrintSinkStats();
+            return TerminalCommandHandlerReturnType::SUCCESS;
+        }
+        else if (commandArgs[1] == "radiostat") {
+            //Print how much a node advertised and scanned and its average current
+            NodeId nodeId = commandArgs.size() >= 3 ? Utility::StringToU16(commandArgs[2].c_str()) : 0;
+            PrintRadioStats(nodeId);
+            return TerminalCommandHandlerReturnType::SUCCESS;
+        }
+        else if (commandArgs[1] == "stackstat") {
+            //Print the handlers of all nodes that used the most stack
+            if (commandArgs.size() >= 3 && commandArgs[2] == "reset") {
+                StackWatcher::ResetHandlerStackUsage();
+                return TerminalCommandHandlerReturnType::SUCCESS;
+            }
+            const u32 count = commandArgs.size() >= 3 ? Utility::StringToU32(commandArgs[2].c_str()) : 10;
+            StackWatcher::PrintTopHandlers(count);
+            return TerminalCommandHandlerReturnType::SUCCESS;
+        }
+        else if (commandArgs[1] == "energy") {
+            //Print the average current of the nodes split by its causes
+            NodeId nodeId = commandArgs.size() >= 3 ? Utility::StringToU16(commandArgs[2].c_str()) : 0;
+            PrintEnergyUsage(nodeId);
+            return TerminalCommandHandlerReturnType::SUCCESS;
+        }
+        else if (commandArgs[1] == "timesync") {
+            //Measure how far the time of the nodes deviates from the simulation time
+            if (commandArgs.size() >= 3 && commandArgs[2] == "start") {
+                const u32 sampleIntervalMs = commandArgs.size() >= 4 ? Utility::StringToU32(commandArgs[3].c_str()) : 1000;
+                if (sampleIntervalMs == 0) return TerminalCommandHandlerReturnType::WRONG_ARGUMENT;
+                return StartTimeSyncMeasurement(sampleIntervalMs) ? TerminalCommandHandlerReturnType::SUCCESS : TerminalCommandHandlerReturnType::INTERNAL_ERROR;
+            }
+            if (commandArgs.size() >= 3 && commandArgs[2] == "stop") {
+                StopTimeSyncMeasurement();
+                return TerminalCommandHandlerReturnType::SUCCESS;
+            }
+            PrintTimeSyncAccuracy();
+            return TerminalCommandHandlerReturnType::SUCCESS;
+        }
+        else if (commandArgs[1] == "trace") {
+            //Write the mesh packet events of all nodes into a pcap file
+            if (commandArgs.size() >= 4 && commandArgs[2] == "start") {
+                return StartPacketTrace(commandArgs[3]) ? TerminalCommandHandlerReturnType::SUCCESS : TerminalCommandHandlerReturnType::INTERNAL_ERROR;
+            }
+            if (commandArgs.size() >= 3 && commandArgs[2] == "stop") {
+                StopPacketTrace();
+                return TerminalCommandHandlerReturnType::SUCCESS;
+            }
+            return TerminalCommandHandlerReturnType::NOT_ENOUGH_ARGUMENTS;
+        }
 
         else if (commandArgs[1] == "animation")
         {
@@ -2472,8 +2572,26 @@ void CherrySim::SimCommitSomeFlashOperations(const uint8_t* failData, uint16_t n
 //connected und es wird an beide nodes ein Event geschickt, dass sie nun verbunden sind
 void CherrySim::SimulateAdvertising() {
     //Check for other nodes that are scanning and send them the events
-    if (currentNode->state.advertisingActive) {
-        if (ShouldSimIvTrigger(currentNode->state.advertisingIntervalMs)) {
+    for (SoftdeviceAdvertisingSet& advertisingSet : currentNode->state.advertisingSets) {
+        if (advertisingSet.advertisingActive && ShouldSimIvTrigger(advertisingSet.advertisingIntervalMs)) {
+            currentNode->advertisingEventsSent++;
+            currentNode->advertisingAirtimeUs += SIM_NUM_ADVERTISING_CHANNELS * GetAdvertisingAirtimeUs(advertisingSet.advertisingDataLength);
+            const EnergyProfile& profile = currentNode->energyProfile;
+            currentNode->energyUsage.advertising += (uint64_t)SIM_NUM_ADVERTISING_CHANNELS * (profile.radioRampUpUs + GetAdvertisingAirtimeUs(advertisingSet.advertisingDataLength)) * profile.radioTxCurrentUa
+                + (uint64_t)profile.advertisingEventCpuTimeUs * profile.cpuCurrentUa;
+
+            //Scanners receive the packet at the end of the simulation step once all collisions are known
+            if (simConfig.simulateAdvertisingCollisions) {
+                AdvertisingTransmission transmission;
+                transmission.senderIndex = currentNode->index;
+                transmission.startTimeUs = (uint64_t)simState.simTimeMs * 1000 + PSRNGINT(0, simConfig.simTickDurationMs * 1000 - 1);
+                transmission.airtimeUs = GetAdvertisingAirtimeUs(advertisingSet.advertisingDataLength);
+                transmission.advertisingType = advertisingSet.advertisingType;
+                CheckedMemcpy(transmission.advertisingData, advertisingSet.advertisingData, advertisingSet.advertisingDataLength);
+                transmission.advertisingDataLength = advertisingSet.advertisingDataLength;
+                advertisingTransmissions.push_back(transmission);
+            }
+
             const u32 indexStep = std::max<u32>(simConfig.simulateAdvertisingIndexStep, 1);
             const u32 startIndex = (indexStep == 1 ? 0 : simState.rnd.NextU32() % indexStep);
             const u32 nodeCount = GetTotalNodes() - GetAssetNodes();
@@ -2501,29 +2619,12 @@ void CherrySim::SimulateAdvertising() {
 
                     //If the other node is scanning
                     if (nodes[i].state.scanningActive) {
-                        if (PSRNG(probability)) {
-                            simBleEvent s;
-                            s.globalId = simState.globalEventIdCounter++;
-                            s.bleEvent.header.evt_id = BLE_GAP_EVT_ADV_REPORT;
-                            s.bleEvent.header.evt_len = s.globalId;
-                            s.bleEvent.evt.gap_evt.conn_handle = BLE_CONN_HANDLE_INVALID;
-
-                            CheckedMemcpy(&s.bleEvent.evt.gap_evt.params.adv_report.data, &currentNode->state.advertisingData, currentNode->state.advertisingDataLength);
-                            s.bleEvent.evt.gap_evt.params.adv_report.dlen = currentNode->state.advertisingDataLength;
-                            CheckedMemset(&s.bleEvent.evt.gap_evt.params.adv_report.peer_addr, 0, sizeof(s.bleEvent.evt.gap_evt.params.adv_report.peer_addr));
-                            s.bleEvent.evt.gap_evt.params.adv_report.peer_addr.addr_type = (u8)currentNode->address.addr_type;
-                            static_assert(sizeof(s.bleEvent.evt.gap_evt.params.adv_report.peer_addr.addr) == sizeof(currentNode->address.addr), "See next line.");
-                            CheckedMemcpy(&s.bleEvent.evt.gap_evt.params.adv_report.peer_addr.addr, &currentNode->address.addr, sizeof(currentNode->address.addr));
-                            //TODO: bleEvent.evt.gap_evt.params.adv_report.peer_addr = ...;
-                            s.bleEvent.evt.gap_evt.params.adv_report.rssi = (i8)GetReceptionRssi(currentNode, &nodes[i]);
-                            s.bleEvent.evt.gap_evt.params.adv_report.scan_rsp = 0;
-                            s.bleEvent.evt.gap_evt.params.adv_report.type = (u8)currentNode->state.advertisingType;
-
-                            nodes[i].eventQueue.push_back(s);
+                        if (!simConfig.simulateAdvertisingCollisions && PSRNG(probability)) {
+                            GenerateAdvertisingReport(currentNode, &nodes[i], advertisingSet.advertisingData, advertisingSet.advertisingDataLength, advertisingSet.advertisingType);
                         }
                     }
                     //If the other node is connecting
-                    else if (nodes[i].state.connectingActive && currentNode->state.advertisingType == FruityHal::BleGapAdvType::ADV_IND) {
+                    else if (nodes[i].state.connectingActive && advertisingSet.advertisingType == FruityHal::BleGapAdvType::ADV_IND) {
                         //If the other node matches our partnerId we are connecting to
                         if (memcmp(&nodes[i].state.connectingPartnerAddr, &currentNode->address, sizeof(FruityHal::BleGapAddr)) == 0) {
                             if (PSRNG(probability)) {
@@ -2532,7 +2633,7 @@ void CherrySim::SimulateAdvertising() {
 
                                 //Disable advertising for the own node, because this will be stopped after a connection is made
                                 //Then, Immediately return to not broadcast more packets
-                                currentNode->state.advertisingActive = false;
+                                advertisingSet.advertisingActive = false;
                                 return;
                             }
                         }
@@ -2543,6 +2644,119 @@ void CherrySim::SimulateAdvertising() {
     }
 }
 
+u32 CherrySim::GetAdvertisingAirtimeUs(u8 advertisingDataLength)
+{
+    //Preamble, access address, header, advertiser address, data and CRC on the 1 Mbit PHY
+    return (1 + 4 + 2 + FH_BLE_GAP_ADDR_LEN + advertisingDataLength + 3) * 8;
+}
+
+void CherrySim::GenerateAdvertisingReport(const NodeEntry* sender, NodeEntry* receiver, const u8* advertisingData, u8 advertisingDataLength, FruityHal::BleGapAdvType advertisingType)
+{
+    simBleEvent s;
+    s.globalId = simState.globalEventIdCounter++;
+    s.bleEvent.header.evt_id = BLE_GAP_EVT_ADV_REPORT;
+    s.bleEvent.header.evt_len = s.globalId;
+    s.bleEvent.evt.gap_evt.conn_handle = BLE_CONN_HANDLE_INVALID;
+
+    CheckedMemcpy(&s.bleEvent.evt.gap_evt.params.adv_report.data, advertisingData, advertisingDataLength);
+    s.bleEvent.evt.gap_evt.params.adv_report.dlen = advertisingDataLength;
+    CheckedMemset(&s.bleEvent.evt.gap_evt.params.adv_report.peer_addr, 0, sizeof(s.bleEvent.evt.gap_evt.params.adv_report.peer_addr));
+    s.bleEvent.evt.gap_evt.params.adv_report.peer_addr.addr_type = (u8)sender->address.addr_type;
+    static_assert(sizeof(s.bleEvent.evt.gap_evt.params.adv_report.peer_addr.addr) == sizeof(sender->address.addr), "See next line.");
+    CheckedMemcpy(&s.bleEvent.evt.gap_evt.params.adv_report.peer_addr.addr, &sender->address.addr, sizeof(sender->address.addr));
+    s.bleEvent.evt.gap_evt.params.adv_report.rssi = (i8)GetReceptionRssi(sender, receiver);
+    s.bleEvent.evt.gap_evt.params.adv_report.scan_rsp = 0;
+    s.bleEvent.evt.gap_evt.params.adv_report.type = (u8)advertisingType;
+
+    receiver->eventQueue.push_back(s);
+    SIMSTATCOUNT("advertisingReports");
+}
+
+bool CherrySim::IsScanningOnChannel(const NodeEntry* node, uint64_t timeUs, u8 channel) const
+{
+    const uint64_t scanIntervalUs = (uint64_t)node->state.scanIntervalMs * 1000;
+    const uint64_t scanWindowUs = (uint64_t)node->state.scanWindowMs * 1000;
+    if (scanIntervalUs == 0) return false;
+
+    //The scanners are not synchronized, each one gets a fixed offset. It switches to the next channel each interval
+    const uint64_t nodeTimeUs = timeUs + (uint64_t)node->index * 10007 % scanIntervalUs;
+    if (nodeTimeUs % scanIntervalUs >= scanWindowUs) return false;
+    return (nodeTimeUs / scanIntervalUs) % SIM_NUM_ADVERTISING_CHANNELS == channel;
+}
+
+void CherrySim::SimulateAdvertisingCollisions()
+{
+    const u32 nodeCount = GetTotalNodes() - GetAssetNodes();
+    const u32 numTransmissions = (u32)advertisingTransmissions.size();
+
+    //For each transmission, store the other transmissions that overlap with it together with the affected channels
+    std::vector<std::vector<std::pair<u32, u8>>> overlaps(numTransmissions);
+    for (u32 a = 0; a < numTransmissions; a++) {
+        for (u32 b = a + 1; b < numTransmissions; b++) {
+            const AdvertisingTransmission& ta = advertisingTransmissions[a];
+            const AdvertisingTransmission& tb = advertisingTransmissions[b];
+            u8 channelMask = 0;
+            for (u32 channel = 0; channel < SIM_NUM_ADVERTISING_CHANNELS; channel++) {
+                const uint64_t startA = ta.startTimeUs + channel * (ta.airtimeUs + SIM_ADVERTISING_CHANNEL_SWITCH_US);
+                const uint64_t startB = tb.startTimeUs + channel * (tb.airtimeUs + SIM_ADVERTISING_CHANNEL_SWITCH_US);
+                if (startA < startB + tb.airtimeUs && startB < startA + ta.airtimeUs) channelMask |= 1 << channel;
+            }
+            if (channelMask != 0) {
+                overlaps[a].push_back({ b, channelMask });
+                overlaps[b].push_back({ a, channelMask });
+            }
+        }
+    }
+
+    for (u32 t = 0; t < numTransmissions; t++) {
+        const AdvertisingTransmission& transmission = advertisingTransmissions[t];
+        NodeEntry* sender = &nodes[transmission.senderIndex];
+
+        for (u32 i = 0; i < nodeCount; i++) {
+            NodeEntry* receiver = &nodes[i];
+            if (i == transmission.senderIndex || !receiver->state.scanningActive) continue;
+
+            const float rssi = GetReceptionRssi(sender, receiver);
+            u32 probability = CalculateReceptionProbabilityFromRssi(rssi);
+            if (probability == 0) continue;
+            if (simConfig.perfectReceptionProbabilityForAdvertising) probability = UINT32_MAX;
+
+            //The scanner must listen on one of the channels while the packet is sent there
+            u8 heardChannels = 0;
+            for (u32 channel = 0; channel < SIM_NUM_ADVERTISING_CHANNELS; channel++) {
+                if (IsScanningOnChannel(receiver, transmission.startTimeUs + channel * (transmission.airtimeUs + SIM_ADVERTISING_CHANNEL_SWITCH_US), (u8)channel)) heardChannels |= 1 << channel;
+            }
+            if (heardChannels == 0) continue;
+
+            //Overlapping packets destroy each other unless one of them is strong enough to be captured.
+            //The scanner can not receive at all while it is sending itself.
+            for (const std::pair<u32, u8>& overlap : overlaps[t]) {
+                if ((heardChannels & overlap.second) == 0) continue;
+                const u32 otherSenderIndex = advertisingTransmissions[overlap.first].senderIndex;
+                bool destroyed = otherSenderIndex == i;
+                if (!destroyed) {
+                    const float interferenceRssi = GetReceptionRssi(&nodes[otherSenderIndex], receiver);
+                    destroyed = interferenceRssi > SIM_INTERFERENCE_MIN_RSSI && rssi < interferenceRssi + simConfig.advertisingCaptureThresholdDb;
+                }
+                if (destroyed) {
+                    heardChannels &= ~overlap.second;
+                    if (heardChannels == 0) break;
+                }
+            }
+            if (heardChannels == 0) {
+                SIMSTATCOUNT("advertisingCollisions");
+                continue;
+            }
+
+            if (PSRNG(probability)) {
+                GenerateAdvertisingReport(sender, receiver, transmission.advertisingData, transmission.advertisingDataLength, transmission.advertisingType);
+            }
+        }
+    }
+
+    advertisingTransmissions.clear();
+}
+
 ble_gap_addr_t CherrySim::Convert(const FruityHal::BleGapAddr* address)
 {
     ble_gap_addr_t addr;
@@ -2625,6 +2839,8 @@ void CherrySim::ConnectMasterToSlave(NodeEntry* master, NodeEntry* slave)
     freeInConnection->isCentral = false;
     freeInConnection->lastReceivedPacketTimestampMs = simState.simTimeMs;
     freeInConnection->connectionSetupTimeMs = simState.simTimeMs;
+    freeInConnection->timeSinceLastConnectionEventUs = 0;
+    freeInConnection->sentLinkLayerBytes = 0;
 
     //Generate an event for the current node
     simBleEvent s2;
@@ -2679,6 +2895,8 @@ void CherrySim::ConnectMasterToSlave(NodeEntry* master, NodeEntry* slave)
     freeOutConnection->isCentral = true;
     freeOutConnection->lastReceivedPacketTimestampMs = simState.simTimeMs;
     freeOutConnection->connectionSetupTimeMs = simState.simTimeMs;
+    freeOutConnection->timeSinceLastConnectionEventUs = 0;
+    freeOutConnection->sentLinkLayerBytes = 0;
 
     //Save connection references
     freeInConnection->partnerConnection = freeOutConnection;
@@ -2860,6 +3078,7 @@ void CherrySim::SimulateConnections() {
     * at the same time. Also, all unreliable packets are always sent in one conneciton event.
     * If many connections exist with short connection intervals, the behaviour is not realistic as the amount of packets that are being sent should decrease.
     * There is also no probability of failure and the buffer is always emptied
+    * SimConfiguration::simulateConnectionEvents enables a more accurate model, see SimulateConnectionEvents.
     */
 
     if (blockConnections) return;
@@ -2867,7 +3086,10 @@ void CherrySim::SimulateConnections() {
     //Simulate sending data for each connection individually
     for (int i = 0; i < currentNode->state.configuredTotalConnectionCount; i++) {
         SoftdeviceConnection* connection = &currentNode->state.connections[i];
-        if (connection->connectionActive) {
+        if (connection->connectionActive && simConfig.simulateConnectionEvents) {
+            SimulateConnectionEvents(connection);
+        }
+        else if (connection->connectionActive) {
 
             //FIXME: This implementation will currently not calculate a correct throughput for packets
             //if the interval is smaller than the simulation timestep, it will only simulate one connectionEvent
@@ -2926,59 +3148,8 @@ void CherrySim::SimulateConnections() {
                     SoftDeviceBufferedPacket* packet = getNextPacketToWrite(connection);
                     if (packet == nullptr) break;
 
-#ifdef FM_NATIVE_RENDERER_ENABLED
-                    if (bbeRenderer)
-                    {
-                        bbeRenderer->addPacket(packet->sender, packet->receiver);
-                    }
-#endif
-
-                    //Notifications
-                    if (packet->isHvx) {
-                        GenerateNotification(packet);
-                        //Remove packet from softdevice buffer
-                        packet->sender = nullptr;
-                        unreliablePacketsSent++;
-                    }
-                    //Unreliable Writes
-                    else if (packet->params.writeParams.write_op == BLE_GATT_OP_WRITE_CMD) {
-                        GenerateWrite(packet);
-                        //Remove packet from softdevice buffer
-                        packet->sender = nullptr;
-                        unreliablePacketsSent++;
-                    }
-                    //Reliable Writes
-                    else if (packet->params.writeParams.write_op == BLE_GATT_OP_WRITE_REQ) {
-
-                        //Send tx complete for all previous unreliable writes if there were any
-                        SendUnreliableTxCompleteEvent(currentNode, connection->connectionHandle, unreliablePacketsSent);
-                        unreliablePacketsSent = 0;
-
-                        GenerateWrite(packet);
-                        //Remove packet from softdevice buffer
-                        packet->sender = nullptr;
-
-                        //Generate the event that the write was successful immediately
-                        //TODO: Could be postponed a bit to better match the real world
-                        simBleEvent s2;
-                        CheckedMemset(&s2, 0, sizeof(s2));
-                        s2.globalId = simState.globalEventIdCounter++;
-                        s2.bleEvent.header.evt_id = BLE_GATTC_EVT_WRITE_RSP;
-                        s2.bleEvent.header.evt_len = s2.globalId;
-                        s2.bleEvent.evt.gattc_evt.conn_handle = connection->connectionHandle;
-                        s2.bleEvent.evt.gattc_evt.gatt_status = (u16)FruityHal::BleGattEror::SUCCESS;
-                        //Save the global packet id so that we can track where a packet was generated after we receive it
-                        s2.additionalInfo = packet->globalPacketId;
-                        currentNode->eventQueue.push_back(s2);
-
-
-
-                        //Do not send any more packets this connectionEvent as we need to wait for an ACK
-                        break;
-                    }
-                    else {
-                        SIMEXCEPTION(IllegalArgumentException);
-                    }
+                    //Do not send any more packets this connectionEvent as we need to wait for an ACK
+                    if (TransmitBufferedPacket(connection, packet, unreliablePacketsSent)) break;
                 }
 
                 //Send remaining accumulated tx complete events for notifications and unreliable writes
@@ -3022,6 +3193,157 @@ void CherrySim::SimulateConnections() {
     }
 }
 
+//Connection intervals are multiples of 1.25 ms, but SoftdeviceConnection::connectionInterval is truncated to full ms
+static u32 GetConnectionIntervalUs(const SoftdeviceConnection* connection)
+{
+    return ((u32)connection->connectionInterval * 1000 + 1249) / 1250 * 1250;
+}
+
+u32 CherrySim::GetLinkLayerPacketAirtimeUs(u32 payloadLength, bool encrypted) const
+{
+    //Preamble (one byte on the 1 Mbit PHY, two bytes on the 2 Mbit PHY), access address, header, payload, MIC and CRC
+    const u32 phyMbps = simConfig.connectionPhyMbps == 2 ? 2 : 1;
+    const u32 micLength = (encrypted && payloadLength > 0) ? 4 : 0;
+    const u32 packetLength = phyMbps + 4 + 2 + payloadLength + micLength + 3;
+    return packetLength * 8 / phyMbps;
+}
+
+void CherrySim::SimulateConnectionEvents(SoftdeviceConnection* connection)
+{
+    const u32 intervalUs = GetConnectionIntervalUs(connection);
+    if (intervalUs == 0) return;
+    connection->timeSinceLastConnectionEventUs += simConfig.simTickDurationMs * 1000;
+    if (connection->timeSinceLastConnectionEventUs < intervalUs) return;
+
+    //Simulate timeouts if messages can't be send anymore.
+    SoftDeviceBufferedPacket* nextPacket = getNextPacketToWrite(connection);
+    if (nextPacket != nullptr && simState.simTimeMs - nextPacket->queueTimeMs > 30 * 1000)
+    {
+        DisconnectSimulatorConnection(connection, BLE_HCI_CONNECTION_TIMEOUT, BLE_HCI_CONNECTION_TIMEOUT);
+        return;
+    }
+
+    // Simulate timeouts if there was no message received within connection interval
+    if (simState.simTimeMs >= connection->lastReceivedPacketTimestampMs + connection->connectionSupervisionTimeoutMs)
+    {
+        DisconnectSimulatorConnection(connection, BLE_HCI_CONNECTION_TIMEOUT, BLE_HCI_CONNECTION_TIMEOUT);
+        return;
+    }
+
+    //The softdevice reserves the configured event length for each connection, but all connections have to share
+    //the radio within one connection interval
+    const u32 numConnections = std::max<u32>(GetNumSimConnections(currentNode), 1);
+    const u32 eventLengthUs = std::min<u32>(Conf::gapEventLength * 1250, intervalUs / numConnections);
+
+    //The data length is negotiated so that a packet with the full MTU fits into a single link layer packet
+    const u32 dataLength = std::min<u32>(std::max<u32>(simConfig.connectionMaxDataLength, 27), 251);
+    const u32 receptionProbability = CalculateReceptionProbabilityForConnection(connection->owningNode, connection->partner);
+
+    u32 unreliablePacketsSent = 0;
+    while (connection->timeSinceLastConnectionEventUs >= intervalUs)
+    {
+        connection->timeSinceLastConnectionEventUs -= intervalUs;
+        u32 remainingEventUs = eventLengthUs;
+
+        //Each event starts with an exchange, even if there is no data to send
+        bool firstExchange = true;
+        while (true)
+        {
+            SoftDeviceBufferedPacket* packet = getNextPacketToWrite(connection);
+
+            //Every GATT packet is put into an L2CAP packet with a 4 byte header and 3 bytes of ATT header
+            //that is fragmented into link layer packets of at most the data length
+            const u32 gattLength = packet == nullptr ? 0 : (packet->isHvx ? (u32)(uintptr_t)packet->params.hvxParams.p_len : packet->params.writeParams.len);
+            const u32 l2capLength = packet == nullptr ? 0 : gattLength + FruityHal::ATT_HEADER_SIZE + 4;
+            const u32 fragmentLength = std::min(l2capLength - connection->sentLinkLayerBytes, dataLength);
+            const u32 exchangeUs = GetLinkLayerPacketAirtimeUs(fragmentLength, connection->connectionEncrypted) + GetLinkLayerPacketAirtimeUs(0, false) + 2 * BLE_T_IFS_US;
+
+            if (!firstExchange && exchangeUs > remainingEventUs) break;
+            firstExchange = false;
+            remainingEventUs -= std::min(exchangeUs, remainingEventUs);
+
+            //A lost packet closes the connection event, the link layer retransmits it in the next one
+            if (!PSRNG(receptionProbability))
+            {
+                SIMSTATCOUNT("linkLayerPacketsLost");
+                break;
+            }
+            connection->lastReceivedPacketTimestampMs = simState.simTimeMs;
+            if (packet == nullptr) break;
+
+            connection->sentLinkLayerBytes += fragmentLength;
+            if (connection->sentLinkLayerBytes < l2capLength) continue;
+            connection->sentLinkLayerBytes = 0;
+
+            //The write response of a reliable write can only be sent in the next connection event
+            if (TransmitBufferedPacket(connection, packet, unreliablePacketsSent)) break;
+        }
+    }
+
+    //Send remaining accumulated tx complete events for notifications and unreliable writes
+    SendUnreliableTxCompleteEvent(currentNode, connection->connectionHandle, unreliablePacketsSent);
+}
+
+bool CherrySim::TransmitBufferedPacket(SoftdeviceConnection* connection, SoftDeviceBufferedPacket* packet, u32& unreliablePacketsSent)
+{
+    currentNode->sentPacketsPerLink[connection->partner->index]++;
+
+    const u32 gattLength = packet->isHvx ? (u32)(uintptr_t)packet->params.hvxParams.p_len : packet->params.writeParams.len;
+    AddConnectionDataEnergy(currentNode, connection->partner, gattLength + FruityHal::ATT_HEADER_SIZE + 4, connection->connectionEncrypted);
+
+#ifdef FM_NATIVE_RENDERER_ENABLED
+    if (bbeRenderer)
+    {
+        bbeRenderer->addPacket(packet->sender, packet->receiver);
+    }
+#endif
+
+    //Notifications
+    if (packet->isHvx) {
+        GenerateNotification(packet);
+        //Remove packet from softdevice buffer
+        packet->sender = nullptr;
+        unreliablePacketsSent++;
+    }
+    //Unreliable Writes
+    else if (packet->params.writeParams.write_op == BLE_GATT_OP_WRITE_CMD) {
+        GenerateWrite(packet);
+        //Remove packet from softdevice buffer
+        packet->sender = nullptr;
+        unreliablePacketsSent++;
+    }
+    //Reliable Writes
+    else if (packet->params.writeParams.write_op == BLE_GATT_OP_WRITE_REQ) {
+
+        //Send tx complete for all previous unreliable writes if there were any
+        SendUnreliableTxCompleteEvent(currentNode, connection->connectionHandle, unreliablePacketsSent);
+        unreliablePacketsSent = 0;
+
+        GenerateWrite(packet);
+        //Remove packet from softdevice buffer
+        packet->sender = nullptr;
+
+        //Generate the event that the write was successful immediately
+        //TODO: Could be postponed a bit to better match the real world
+        simBleEvent s2;
+        CheckedMemset(&s2, 0, sizeof(s2));
+        s2.globalId = simState.globalEventIdCounter++;
+        s2.bleEvent.header.evt_id = BLE_GATTC_EVT_WRITE_RSP;
+        s2.bleEvent.header.evt_len = s2.globalId;
+        s2.bleEvent.evt.gattc_evt.conn_handle = connection->connectionHandle;
+        s2.bleEvent.evt.gattc_evt.gatt_status = (u16)FruityHal::BleGattEror::SUCCESS;
+        //Save the global packet id so that we can track where a packet was generated after we receive it
+        s2.additionalInfo = packet->globalPacketId;
+        currentNode->eventQueue.push_back(s2);
+
+        return true;
+    }
+    else {
+        SIMEXCEPTION(IllegalArgumentException);
+    }
+    return false;
+}
+
 //This function generates a WRITE event and a TX for two nodes that want to send data
 void CherrySim::GenerateWrite(SoftDeviceBufferedPacket* bufferedPacket) {
 
@@ -3205,104 +3527,53 @@ void CherrySim::SimulateMovement()
 
 void CherrySim::SimulateBatteryUsage()
 {
-    //Have a look at: https://devzone.nordicsemi.com/b/blog/posts/nrf51-current-consumption-for-common-scenarios
-    //or: https://github.com/mwaylabs/fruitymesh/wiki/Battery-Consumption
-
-    //TODO: Make measurements and check online resources to find out current consumption
-    //TODO: provide values for nrf52
-    //TODO: Take into account what changes at 0 dbm and at +4dmb
-    //TODO: Take into account that each sent packet consumes power in addition to the connectionInterval itself
-    //TODO: If too much activity happens at the same time, the scheduler will postpone tasks and use less energy (also relevant for connection / advertising, etc,... performance)
-
-    u32 divider = 1000UL / simConfig.simTickDurationMs;
-
-    //All current usages are given as nano ampere per step
-    u32 idleDraw = 10 * 1000 / divider; //10 uA idle current usage
-    u32 ledUsage = 10 * 1000 * 1000 / divider; //10 mA led on usage
-    u32 adv20Ms = 800 * 1000 / divider; //imaginary value for 20ms advertising
-    u32 adv100Ms = 220 * 1000 / divider; //220 uA advertising at 100ms interval
-    u32 adv200Ms = 110 * 1000 / divider; //110 uA advertising at 200ms interval
-    u32 adv400Ms = 84 * 1000 / divider; //84 uA advertising at 400ms interval
-    u32 adv1000Ms = 70 * 1000 / divider; //70 uA advertising at 1000ms interval
-    u32 adv2000Ms = 63 * 1000 / divider; //63 uA advertising at 2000ms interval 
-    u32 adv4000Ms = 50 * 1000 / divider; //50 uA advertising at 4000ms interval
-    u32 adv8000Ms = 45 * 1000 / divider; //45 uA advertising at 8000ms interval (imaginary value)
-    u32 adv30000Ms = 30 * 1000 / divider; //30 uA advertising at 30000ms interval
-    u32 conn100Ms = 130 * 1000 / divider; //70 uA per connection at 100ms interval
-    u32 conn7_5Ms = 1000 * 1000 / divider; //1000 uA per connection at 7.5ms interval (imaginary value)
-    u32 conn10Ms = 900 * 1000 / divider; //900 uA per connection at 10ms interval (imaginary value)
-    u32 conn15Ms = 750 * 1000 / divider; //750 uA per connection at 15ms interval (imaginary value)
-    u32 conn30Ms = 600 * 1000 / divider; //600 uA per connection at 30ms interval (imaginary value)
-    u32 conn90Ms = 300 * 1000 / divider; //300 uA per connection at 90ms interval (imaginary value)
-
-    //Other values
-    u32 scanUsage = 11 * 1000 * 1000 / divider; //11mA for scanning at 100% duty cycle
-
-
-    //Next, we add up all the numbers for all active features
-    currentNode->nanoAmperePerMsTotal += idleDraw;
-
-    if (currentNode->led1On) currentNode->nanoAmperePerMsTotal += ledUsage;
-    if (currentNode->led2On) currentNode->nanoAmperePerMsTotal += ledUsage;
-    if (currentNode->led3On) currentNode->nanoAmperePerMsTotal += ledUsage;
-
-    if (currentNode->state.advertisingActive) {
-        if (currentNode->state.advertisingIntervalMs == 20) currentNode->nanoAmperePerMsTotal += adv20Ms;
-        else if (currentNode->state.advertisingIntervalMs == 100) currentNode->nanoAmperePerMsTotal += adv100Ms;
-        else if (currentNode->state.advertisingIntervalMs == 200) currentNode->nanoAmperePerMsTotal += adv200Ms;
-        else if (currentNode->state.advertisingIntervalMs == 400) currentNode->nanoAmperePerMsTotal += adv400Ms;
-        else if (currentNode->state.advertisingIntervalMs == 1000) currentNode->nanoAmperePerMsTotal += adv1000Ms;
-        else if (currentNode->state.advertisingIntervalMs == 2000) currentNode->nanoAmperePerMsTotal += adv2000Ms;
-        else if (currentNode->state.advertisingIntervalMs == 4000) currentNode->nanoAmperePerMsTotal += adv4000Ms;
-        else if (currentNode->state.advertisingIntervalMs == 8000) currentNode->nanoAmperePerMsTotal += adv8000Ms;
-        else if (currentNode->state.advertisingIntervalMs == 30000) currentNode->nanoAmperePerMsTotal += adv30000Ms;
-        else {
-            printf("Adv interval not integrated into battery test, %u" EOL, (u32)currentNode->state.advertisingIntervalMs);
-            SIMEXCEPTION(IllegalAdvertismentStateException);
-        }
-    }
+    //Advertising events, the data sent over connections and flash operations add their energy when they are
+    //simulated. Everything that lasts for the whole simulation step is added here.
+    const EnergyProfile& profile = currentNode->energyProfile;
+    EnergyUsage& usage = currentNode->energyUsage;
+    const uint64_t stepUs = (uint64_t)simConfig.simTickDurationMs * 1000;
+
+    usage.idle += stepUs * profile.idleCurrentNa / 1000;
+
+    if (currentNode->led1On) usage.led += stepUs * profile.ledCurrentUa;
+    if (currentNode->led2On) usage.led += stepUs * profile.ledCurrentUa;
+    if (currentNode->led3On) usage.led += stepUs * profile.ledCurrentUa;
 
     if (currentNode->state.scanningActive) {
-        u32 scanDutyCycle = currentNode->state.scanWindowMs * 1000UL / currentNode->state.scanIntervalMs;
-        u32 usagePerStepWithGivenDutyCycle = scanUsage * scanDutyCycle / 1000;
-        currentNode->nanoAmperePerMsTotal += usagePerStepWithGivenDutyCycle;
+        const uint64_t scanningTimeUs = stepUs * currentNode->state.scanWindowMs / currentNode->state.scanIntervalMs;
+        usage.scanning += scanningTimeUs * profile.radioRxCurrentUa;
+        currentNode->scanningTimeUs += scanningTimeUs;
     }
 
     if (currentNode->state.connectingActive) {
-        u32 scanDutyCycle = currentNode->state.connectingWindowMs * 1000UL / currentNode->state.connectingIntervalMs;
-        u32 usagePerStepWithGivenDutyCycle = scanUsage * scanDutyCycle / 1000;
-        currentNode->nanoAmperePerMsTotal += usagePerStepWithGivenDutyCycle;
+        const uint64_t connectingTimeUs = stepUs * currentNode->state.connectingWindowMs / currentNode->state.connectingIntervalMs;
+        usage.connecting += connectingTimeUs * profile.radioRxCurrentUa;
     }
 
+    //Each connection event starts with an exchange of two packets, even if there is no data to send
+    const u32 emptyPacketUs = GetLinkLayerPacketAirtimeUs(0, false);
+    const uint64_t connectionEventCharge = (uint64_t)(profile.radioRampUpUs + emptyPacketUs) * (profile.radioTxCurrentUa + profile.radioRxCurrentUa)
+        + (uint64_t)profile.connectionEventCpuTimeUs * profile.cpuCurrentUa;
     for (u32 i = 0; i < currentNode->state.configuredTotalConnectionCount; i++) {
-        SoftdeviceConnection* conn = currentNode->state.connections + i;
-        if (conn->connectionActive) {
-            if (conn->connectionInterval == 100) {
-                currentNode->nanoAmperePerMsTotal += conn100Ms;
-            }
-            else if (conn->connectionInterval == 7) {
-                currentNode->nanoAmperePerMsTotal += conn7_5Ms;
-            }
-            else if (conn->connectionInterval == 10) {
-                currentNode->nanoAmperePerMsTotal += conn10Ms;
-            }
-            else if (conn->connectionInterval == 15) {
-                currentNode->nanoAmperePerMsTotal += conn15Ms;
-            }
-            else if (conn->connectionInterval == 30) {
-                currentNode->nanoAmperePerMsTotal += conn30Ms;
-            }
-            else if (conn->connectionInterval == 90) {
-                currentNode->nanoAmperePerMsTotal += conn90Ms;
-            }
-            else {
-                printf("Conn interval not integrated into battery test" EOL);
-                SIMEXCEPTION(IllegalStateException);
-            }
-        }
+        const SoftdeviceConnection* conn = currentNode->state.connections + i;
+        const u32 intervalUs = GetConnectionIntervalUs(conn);
+        if (!conn->connectionActive || intervalUs == 0) continue;
+        usage.connectionEvents += connectionEventCharge * stepUs / intervalUs;
     }
 
-    //TODO: Add up current for connections according to connectionIntervals of each connection
+    currentNode->nanoAmperePerMsTotal = usage.GetTotal() / 1000;
+}
+
+void CherrySim::AddConnectionDataEnergy(NodeEntry* sender, NodeEntry* receiver, u32 l2capLength, bool encrypted)
+{
+    //Each link layer packet is acknowledged by the next packet of the partner, which is empty if it has nothing to send
+    const u32 dataLength = std::min<u32>(std::max<u32>(simConfig.connectionMaxDataLength, 27), 251);
+    const u32 numFragments = std::max<u32>((l2capLength + dataLength - 1) / dataLength, 1);
+    const u32 dataUs = GetLinkLayerPacketAirtimeUs(l2capLength, encrypted) + (numFragments - 1) * GetLinkLayerPacketAirtimeUs(0, encrypted) + numFragments * sender->energyProfile.radioRampUpUs;
+    const u32 ackUs = numFragments * (GetLinkLayerPacketAirtimeUs(0, encrypted) + receiver->energyProfile.radioRampUpUs);
+
+    sender->energyUsage.connectionData += (uint64_t)dataUs * sender->energyProfile.radioTxCurrentUa + (uint64_t)ackUs * sender->energyProfile.radioRxCurrentUa;
+    receiver->energyUsage.connectionData += (uint64_t)dataUs * receiver->energyProfile.radioRxCurrentUa + (uint64_t)ackUs * receiver->energyProfile.radioTxCurrentUa;
 }
 
 //################################ Timeslot Simulation ####################################
@@ -4354,6 +4625,286 @@ void CherrySim::PrintPacketStats(NodeId nodeId, const char* statId)
     printf(">----------------------------------------------------<" EOL);
 }
 
+void CherrySim::PrintLinkStats(NodeId nodeId)
+{
+    printf(">----------------------------------------------------<" EOL);
+    printf("Link load for packets sent by node %u" EOL, nodeId);
+    printf("" EOL);
+
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        if (nodeId != 0 && nodes[i].gs.node.configuration.nodeId != nodeId) continue;
+
+        u32 total = 0;
+        for (const auto& link : nodes[i].sentPacketsPerLink) total += link.second;
+
+        for (const auto& link : nodes[i].sentPacketsPerLink)
+        {
+            printf("%u -> %u :: %u packets (%u%%)" EOL, (u32)nodes[i].gs.node.configuration.nodeId, (u32)nodes[link.first].gs.node.configuration.nodeId, link.second, link.second * 100 / total);
+        }
+    }
+
+    printf(">----------------------------------------------------<" EOL);
+}
+
+void CherrySim::PrintSinkStats()
+{
+    printf(">----------------------------------------------------<" EOL);
+    printf("Packets received by the sinks after %u seconds" EOL, simState.simTimeMs / 1000);
+    printf("" EOL);
+
+    u32 total = 0;
+    for (u32 i = 0; i < GetTotalNodes(); i++) total += nodes[i].gs.cm.receivedSinkPackets;
+
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        if (nodes[i].featuresetPointers == nullptr || nodes[i].featuresetPointers->getDeviceTypePtr() != DeviceType::SINK) continue;
+
+        const u32 received = nodes[i].gs.cm.receivedSinkPackets;
+        const u32 perMinute = simState.simTimeMs > 0 ? (u32)((uint64_t)received * 60 * 1000 / simState.simTimeMs) : 0;
+        printf("Sink %u :: %u packets (%u%%), %u packets/min" EOL, (u32)nodes[i].gs.node.configuration.nodeId, received, total > 0 ? received * 100 / total : 0, perMinute);
+    }
+
+    printf(">----------------------------------------------------<" EOL);
+}
+
+void CherrySim::PrintRadioStats(NodeId nodeId)
+{
+    printf(">----------------------------------------------------<" EOL);
+    printf("Radio usage after %u seconds" EOL, simState.simTimeMs / 1000);
+    printf("" EOL);
+
+    uint64_t totalAirtimeUs = 0;
+    uint64_t totalScanningTimeUs = 0;
+    uint64_t totalCurrentUa = 0;
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        const u32 currentUa = GetAverageCurrentUa(i);
+        totalAirtimeUs += nodes[i].advertisingAirtimeUs;
+        totalScanningTimeUs += nodes[i].scanningTimeUs;
+        totalCurrentUa += currentUa;
+
+        if (nodeId != 0 && nodes[i].gs.node.configuration.nodeId != nodeId) continue;
+        printf("Node %u :: %u adv events, %u ms airtime, %u ms scanning, %u uA" EOL,
+            (u32)nodes[i].gs.node.configuration.nodeId,
+            nodes[i].advertisingEventsSent,
+            (u32)(nodes[i].advertisingAirtimeUs / 1000),
+            (u32)(nodes[i].scanningTimeUs / 1000),
+            currentUa);
+    }
+
+    if (nodeId == 0 && GetTotalNodes() > 0)
+    {
+        printf("" EOL);
+        printf("Total :: %u ms airtime, %u ms scanning, %u uA average per node" EOL,
+            (u32)(totalAirtimeUs / 1000),
+            (u32)(totalScanningTimeUs / 1000),
+            (u32)(totalCurrentUa / GetTotalNodes()));
+    }
+
+    printf(">----------------------------------------------------<" EOL);
+}
+
+u32 CherrySim::GetAverageCurrentUa(u32 nodeIndex) const
+{
+    if (simState.simTimeMs == 0) return 0;
+    return (u32)(nodes[nodeIndex].energyUsage.GetTotal() / ((uint64_t)simState.simTimeMs * 1000));
+}
+
+u32 CherrySim::GetProjectedBatteryLifeHours(u32 nodeIndex) const
+{
+    if (simState.simTimeMs == 0) return 0;
+    const uint64_t totalCharge = nodes[nodeIndex].energyUsage.GetTotal();
+    if (totalCharge == 0) return UINT32_MAX;
+
+    //The capacity in uA * h divided by the average current in uA
+    const uint64_t hours = (uint64_t)simConfig.batteryCapacityMah * 1000 * simState.simTimeMs * 1000 / totalCharge;
+    return (u32)std::min<uint64_t>(hours, UINT32_MAX);
+}
+
+void CherrySim::PrintEnergyUsage(NodeId nodeId)
+{
+    const uint64_t simTimeUs = (uint64_t)simState.simTimeMs * 1000;
+    if (simTimeUs == 0) return;
+
+    printf(">----------------------------------------------------<" EOL);
+    printf("Average current in uA after %u seconds with a %u mAh battery" EOL, simState.simTimeMs / 1000, simConfig.batteryCapacityMah);
+    printf("" EOL);
+
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        if (nodeId != 0 && nodes[i].gs.node.configuration.nodeId != nodeId) continue;
+        const EnergyUsage& usage = nodes[i].energyUsage;
+        printf("Node %u :: %u uA (idle %u, led %u, adv %u, scan %u, connecting %u, conn events %u, conn data %u, flash %u), %u days" EOL,
+            (u32)nodes[i].gs.node.configuration.nodeId,
+            GetAverageCurrentUa(i),
+            (u32)(usage.idle / simTimeUs),
+            (u32)(usage.led / simTimeUs),
+            (u32)(usage.advertising / simTimeUs),
+            (u32)(usage.scanning / simTimeUs),
+            (u32)(usage.connecting / simTimeUs),
+            (u32)(usage.connectionEvents / simTimeUs),
+            (u32)(usage.connectionData / simTimeUs),
+            (u32)(usage.flash / simTimeUs),
+            GetProjectedBatteryLifeHours(i) / 24);
+    }
+
+    printf(">----------------------------------------------------<" EOL);
+}
+
+bool CherrySim::StartTimeSyncMeasurement(u32 sampleIntervalMs)
+{
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        if (!nodes[i].gs.timeManager.IsTimeMaster()) continue;
+
+        NodeIndexSetter setter(i);
+        timeSyncReferenceTime = GS->timeManager.GetLocalTimePoint();
+        timeSyncMeasurementStartMs = simState.simTimeMs;
+        timeSyncSampleIntervalMs = sampleIntervalMs;
+        timeSyncNextSampleMs = simState.simTimeMs + sampleIntervalMs;
+        timeSyncErrorsUs.clear();
+        timeSyncUnsyncedSamples.clear();
+        timeSyncMeasurementActive = true;
+        return true;
+    }
+    printf("No time master found, set the time first" EOL);
+    return false;
+}
+
+void CherrySim::StopTimeSyncMeasurement()
+{
+    if (timeSyncMeasurementActive) timeSyncMeasurementStopMs = simState.simTimeMs;
+    timeSyncMeasurementActive = false;
+}
+
+void CherrySim::SampleTimeSyncAccuracy()
+{
+    //The hops to the time master are determined along the handshaked mesh connections
+    std::vector<i32> hops(GetTotalNodes(), -1);
+    std::queue<u32> nodesToVisit;
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        if (nodes[i].gs.timeManager.IsTimeMaster())
+        {
+            hops[i] = 0;
+            nodesToVisit.push(i);
+        }
+    }
+    while (!nodesToVisit.empty())
+    {
+        const u32 index = nodesToVisit.front();
+        nodesToVisit.pop();
+
+        NodeIndexSetter setter(index);
+        MeshConnections conns = GS->cm.GetMeshConnections(ConnectionDirection::INVALID);
+        for (u32 k = 0; k < conns.count; k++)
+        {
+            if (!conns.handles[k].IsHandshakeDone()) continue;
+            for (u32 m = 0; m < GetTotalNodes(); m++)
+            {
+                if (hops[m] >= 0 || nodes[m].address != conns.handles[k].GetPartnerAddress()) continue;
+                hops[m] = hops[index] + 1;
+                nodesToVisit.push(m);
+            }
+        }
+    }
+
+    //The simulation time that passed since the start of the measurement is the correct time difference
+    const int64_t passedTicks = (int64_t)(simState.simTimeMs - timeSyncMeasurementStartMs) * ticksPerSecond / 1000;
+
+    for (u32 i = 0; i < GetTotalNodes(); i++)
+    {
+        if (hops[i] < 0) continue;
+        if ((u32)hops[i] >= timeSyncErrorsUs.size())
+        {
+            timeSyncErrorsUs.resize(hops[i] + 1);
+            timeSyncUnsyncedSamples.resize(hops[i] + 1, 0);
+        }
+
+        NodeIndexSetter setter(i);
+        if (!GS->timeManager.IsTimeSynced())
+        {
+            timeSyncUnsyncedSamples[hops[i]]++;
+            continue;
+        }
+
+        const TimePoint time = GS->timeManager.GetLocalTimePoint();
+        const int64_t errorTicks = ((int64_t)time.GetUnixTime() - timeSyncReferenceTime.GetUnixTime()) * ticksPerSecond
+            + ((int64_t)time.GetAdditionalTicks() - timeSyncReferenceTime.GetAdditionalTicks())
+            - passedTicks;
+        const int64_t errorUs = errorTicks * 1000000 / ticksPerSecond;
+        timeSyncErrorsUs[hops[i]].push_back((u32)(errorUs < 0 ? -errorUs : errorUs));
+    }
+}
+
+std::vector<TimeSyncAccuracy> CherrySim::GetTimeSyncAccuracy() const
+{
+    std::vector<TimeSyncAccuracy> result;
+    for (u32 hops = 0; hops < timeSyncErrorsUs.size(); hops++)
+    {
+        TimeSyncAccuracy accuracy;
+        accuracy.hops = hops;
+        accuracy.numSamples = (u32)timeSyncErrorsUs[hops].size() + timeSyncUnsyncedSamples[hops];
+        accuracy.numUnsyncedSamples = timeSyncUnsyncedSamples[hops];
+
+        std::vector<u32> errorsUs = timeSyncErrorsUs[hops];
+        if (!errorsUs.empty())
+        {
+            std::sort(errorsUs.begin(), errorsUs.end());
+            accuracy.p50ErrorUs = errorsUs[(errorsUs.size() - 1) * 50 / 100];
+            accuracy.p95ErrorUs = errorsUs[(errorsUs.size() - 1) * 95 / 100];
+            accuracy.p99ErrorUs = errorsUs[(errorsUs.size() - 1) * 99 / 100];
+            accuracy.maxErrorUs = errorsUs.back();
+        }
+        result.push_back(accuracy);
+    }
+    return result;
+}
+
+void CherrySim::PrintTimeSyncAccuracy()
+{
+    printf(">----------------------------------------------------<" EOL);
+    printf("Time sync accuracy after %u seconds of measurement" EOL, ((timeSyncMeasurementActive ? simState.simTimeMs : timeSyncMeasurementStopMs) - timeSyncMeasurementStartMs) / 1000);
+    printf("" EOL);
+
+    for (const TimeSyncAccuracy& accuracy : GetTimeSyncAccuracy())
+    {
+        printf("Hops %u :: %u samples, %u unsynced, p50 %u us, p95 %u us, p99 %u us, max %u us" EOL,
+            accuracy.hops,
+            accuracy.numSamples,
+            accuracy.numUnsyncedSamples,
+            accuracy.p50ErrorUs,
+            accuracy.p95ErrorUs,
+            accuracy.p99ErrorUs,
+            accuracy.maxErrorUs);
+    }
+
+    printf(">----------------------------------------------------<" EOL);
+}
+
+bool CherrySim::StartPacketTrace(const std::string& path)
+{
+    return packetTracer.Open(path);
+}
+
+void CherrySim::StopPacketTrace()
+{
+    packetTracer.Close();
+}
+
+u32 CherrySim::GetNumPacketTraceEvents() const
+{
+    return packetTracer.GetNumEvents();
+}
+
+void CherrySim::TracePacket(PacketTraceEventType eventType, NodeId partnerId, u32 uniqueConnectionId, DeliveryPriority priority, const u8* data, u16 length)
+{
+    if (!packetTracer.IsOpen()) return;
+
+    packetTracer.Trace(simState.simTimeMs, eventType, priority, currentNode->GetNodeId(), partnerId, uniqueConnectionId, data, length);
+}
+
 #pragma warning( pop )
 
 #endif
@@ -44,6 +44,7 @@ into all files in order to rewrite macros and other calls.
 #include <Terminal.h>
 #include <LedWrapper.h>
 #include <CherrySimTypes.h>
+#include <PacketTracer.h>
 #include <map>
 #include <chrono>
 #include <string>
@@ -161,6 +162,20 @@ TESTER_PUBLIC:
     };
     std::vector<LambdaWithHandle> simStepCallbacks;
 
+    //Time sync accuracy measurement, see StartTimeSyncMeasurement
+    bool timeSyncMeasurementActive = false;
+    u32 timeSyncSampleIntervalMs = 0;
+    u32 timeSyncMeasurementStartMs = 0;
+    u32 timeSyncNextSampleMs = 0;
+    u32 timeSyncMeasurementStopMs = 0;
+    TimePoint timeSyncReferenceTime;
+    std::vector<std::vector<u32>> timeSyncErrorsUs; //Absolute error of each sample, indexed by the hops to the time master
+    std::vector<u32> timeSyncUnsyncedSamples;
+    void SampleTimeSyncAccuracy();
+
+    //Records the events of all mesh packets if a trace was started, see StartPacketTrace
+    PacketTracer packetTracer;
+
     std::map<std::string, MoveAnimation> loadedMoveAnimations;
     bool IsValidMoveAnimationJson(const nlohmann::json &json) const;
     MoveAnimation& AnimationGet(const std::string &name);
@@ -263,6 +278,12 @@ public:
 
     //GAP Simulation
     void SimulateAdvertising();
+    void GenerateAdvertisingReport(const NodeEntry* sender, NodeEntry* receiver, const u8* advertisingData, u8 advertisingDataLength, FruityHal::BleGapAdvType advertisingType);
+    //Delivers the advertising packets of the current simulation step, see SimConfiguration::simulateAdvertisingCollisions
+    void SimulateAdvertisingCollisions();
+    bool IsScanningOnChannel(const NodeEntry* node, uint64_t timeUs, u8 channel) const;
+    static u32 GetAdvertisingAirtimeUs(u8 advertisingDataLength); //Airtime of a single packet on one channel
+    std::vector<AdvertisingTransmission> advertisingTransmissions;
     static ble_gap_addr_t Convert(const FruityHal::BleGapAddr* address);
     static FruityHal::BleGapAddr Convert(const ble_gap_addr_t* p_addr);
     void ConnectMasterToSlave(NodeEntry * master, NodeEntry* slave);
@@ -274,6 +295,10 @@ public:
 
     //GATT Simulation
     void SimulateConnections();
+    void SimulateConnectionEvents(SoftdeviceConnection* connection);
+    u32 GetLinkLayerPacketAirtimeUs(u32 payloadLength, bool encrypted) const;
+    //Returns true if the packet was a reliable write so that no more packets can be sent in this connection event
+    bool TransmitBufferedPacket(SoftdeviceConnection* connection, SoftDeviceBufferedPacket* packet, u32& unreliablePacketsSent);
     void SendUnreliableTxCompleteEvent(NodeEntry* node, int connHandle, u8 packetCount);
     void GenerateWrite(SoftDeviceBufferedPacket* bufferedPacket);
     void GenerateNotification(SoftDeviceBufferedPacket* bufferedPacket);
@@ -286,6 +311,8 @@ public:
 
     //Battery usage simulation
     void SimulateBatteryUsage();
+    //Adds the energy for sending a packet of the given length from the sender to the receiver over a connection
+    void AddConnectionDataEnergy(NodeEntry* sender, NodeEntry* receiver, u32 l2capLength, bool encrypted);
 
     //Service Discovery Simulation
     void StartServiceDiscovery(u16 connHandle, const ble_uuid_t &p_uuid, int discoveryTimeMs);
@@ -314,6 +341,30 @@ public:
     void AddPacketToStats(PacketStat* statArray, PacketStat* packet);
     void AddMessageToStats(PacketStat* statArray, u8* message, u16 messageLength);
     void PrintPacketStats(NodeId nodeId, const char* statId);
+    void PrintLinkStats(NodeId nodeId);
+    void PrintSinkStats();
+    void PrintRadioStats(NodeId nodeId);
+    //Average current of a node since the simulation was started, see SimulateBatteryUsage
+    u32 GetAverageCurrentUa(u32 nodeIndex) const;
+    //Battery life with SimConfiguration::batteryCapacityMah if the node keeps its average current
+    u32 GetProjectedBatteryLifeHours(u32 nodeIndex) const;
+    void PrintEnergyUsage(NodeId nodeId);
+
+    //Samples the local time of all nodes in the given interval and compares it to the simulation time. The time of the
+    //time master at the start of the measurement is the reference. Returns false if no node is the time master.
+    bool StartTimeSyncMeasurement(u32 sampleIntervalMs);
+    void StopTimeSyncMeasurement();
+    //Returns the accuracy of the time sync so far, one entry per hop distance to the time master
+    std::vector<TimeSyncAccuracy> GetTimeSyncAccuracy() const;
+    void PrintTimeSyncAccuracy();
+
+    //Writes all mesh packet events of all nodes into a pcap file until StopPacketTrace is called.
+    //Returns false if the file could not be created.
+    bool StartPacketTrace(const std::string& path);
+    void StopPacketTrace();
+    u32 GetNumPacketTraceEvents() const;
+    //Called by the connections of the current node, does nothing if no trace was started
+    void TracePacket(PacketTraceEventType eventType, NodeId partnerId, u32 uniqueConnectionId, DeliveryPriority priority, const u8* data, u16 length);
 
     //#### Helpers
     bool IsClusteringDone();
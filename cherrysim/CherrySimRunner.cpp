@@ -130,6 +130,7 @@ int main(int argc, char** argv) {
             if (!simConfig.siteJsonPath.empty()) simConfig.siteJsonPath = configDir + simConfig.siteJsonPath;
             if (!simConfig.devicesJsonPath.empty()) simConfig.devicesJsonPath = configDir + simConfig.devicesJsonPath;
             if (!simConfig.storeFlashToFile.empty()) simConfig.storeFlashToFile = configDir + simConfig.storeFlashToFile;
+            if (!simConfig.packetTraceFile.empty()) simConfig.packetTraceFile = configDir + simConfig.packetTraceFile;
             if(!simConfig.floorplanImage.empty()) simConfig.floorplanImage = configDir + simConfig.floorplanImage;
 
             //TODO: maybe remove
@@ -449,7 +449,7 @@ void CherrySimTester::SimulateBroadcastMessage(double x, double y, ble_gap_evt_a
 
                 s.bleEvent.evt.gap_evt.params.adv_report.rssi = (i8) sim->GetReceptionRssi(sim->currentNode, &(sim->nodes[i]));
                 s.bleEvent.evt.gap_evt.params.adv_report.scan_rsp = 0;
-                s.bleEvent.evt.gap_evt.params.adv_report.type = (u8)sim->currentNode->state.advertisingType;
+                s.bleEvent.evt.gap_evt.params.adv_report.type = (u8)sim->currentNode->state.advertisingSets[0].advertisingType;
                 sim->nodes[i].eventQueue.push_back(s);
             }
         }
@@ -74,11 +74,22 @@ void to_json(nlohmann::json& j, const SimConfiguration & config)
         { "enableClusteringValidityCheck"            , config.enableClusteringValidityCheck             },
         { "enableSimStatistics"                      , config.enableSimStatistics                       },
         { "storeFlashToFile"                         , config.storeFlashToFile                          },
+        { "packetTraceFile"                          , config.packetTraceFile                           },
         { "floorBiasInMeters"                        , config.floorBiasInMeters                         },
         { "ceilingHeightInMeters"                    , config.ceilingHeightInMeters                     },
         { "ceilingAttenuationDb"                     , config.ceilingAttenuationDb                      },
         { "perfectReceptionProbabilityForAdvertising", config.perfectReceptionProbabilityForAdvertising },
         { "perfectReceptionProbabilityForConnection" , config.perfectReceptionProbabilityForConnection  },
+        { "simulateConnectionEvents"                 , config.simulateConnectionEvents                  },
+        { "connectionPhyMbps"                        , config.connectionPhyMbps                         },
+        { "connectionMaxDataLength"                  , config.connectionMaxDataLength                   },
+        { "simulateAdvertisingCollisions"            , config.simulateAdvertisingCollisions             },
+        { "advertisingCaptureThresholdDb"            , config.advertisingCaptureThresholdDb             },
+        { "numAdvertisingSets"                       , config.numAdvertisingSets                        },
+        { "maxClockDriftPpm"                         , config.maxClockDriftPpm                          },
+        { "batteryCapacityMah"                       , config.batteryCapacityMah                        },
+        { "energyProfileNrf52832"                    , config.energyProfileNrf52832                     },
+        { "energyProfileNrf52840"                    , config.energyProfileNrf52840                     },
         { "verboseCommands"                          , config.verboseCommands                           },
         { "simulateAdvertisingIndexStep"             , config.simulateAdvertisingIndexStep              },
         { "disableNonCriticalExceptions"             , config.disableNonCriticalExceptions              },
@@ -131,11 +142,22 @@ void from_json(const nlohmann::json & j, SimConfiguration & config)
         else if(it.key() == "enableClusteringValidityCheck"             ) config.enableClusteringValidityCheck             = *it;
         else if(it.key() == "enableSimStatistics"                       ) config.enableSimStatistics                       = *it;
         else if(it.key() == "storeFlashToFile"                          ) config.storeFlashToFile                          = *it;
+        else if(it.key() == "packetTraceFile"                           ) config.packetTraceFile                           = *it;
         else if(it.key() == "floorBiasInMeters"                         ) config.floorBiasInMeters                         = *it;
         else if(it.key() == "ceilingHeightInMeters"                     ) config.ceilingHeightInMeters                     = *it;
         else if(it.key() == "ceilingAttenuationDb"                      ) config.ceilingAttenuationDb                      = *it;
         else if(it.key() == "perfectReceptionProbabilityForAdvertising" ) config.perfectReceptionProbabilityForAdvertising = *it;
         else if(it.key() == "perfectReceptionProbabilityForConnection"  ) config.perfectReceptionProbabilityForConnection  = *it;
+        else if(it.key() == "simulateConnectionEvents"                  ) config.simulateConnectionEvents                  = *it;
+        else if(it.key() == "connectionPhyMbps"                         ) config.connectionPhyMbps                         = *it;
+        else if(it.key() == "connectionMaxDataLength"                   ) config.connectionMaxDataLength                   = *it;
+        else if(it.key() == "simulateAdvertisingCollisions"             ) config.simulateAdvertisingCollisions             = *it;
+        else if(it.key() == "advertisingCaptureThresholdDb"             ) config.advertisingCaptureThresholdDb             = *it;
+        else if(it.key() == "numAdvertisingSets"                        ) config.numAdvertisingSets                        = *it;
+        else if(it.key() == "maxClockDriftPpm"                          ) config.maxClockDriftPpm                          = *it;
+        else if(it.key() == "batteryCapacityMah"                        ) config.batteryCapacityMah                        = *it;
+        else if(it.key() == "energyProfileNrf52832"                     ) it->get_to(config.energyProfileNrf52832);
+        else if(it.key() == "energyProfileNrf52840"                     ) it->get_to(config.energyProfileNrf52840);
         else if(it.key() == "verboseCommands"                           ) config.verboseCommands                           = *it;
         else if(it.key() == "simulateAdvertisingIndexStep"              ) config.simulateAdvertisingIndexStep              = *it;
         else if(it.key() == "disableNonCriticalExceptions"              ) config.disableNonCriticalExceptions              = *it;
@@ -53,6 +53,11 @@ constexpr int SIM_MAX_CONNECTION_NUM = 10; //Maximum total num of connections su
 
 constexpr int SIM_NUM_RELIABLE_BUFFERS   = 1;
 constexpr int SIM_NUM_UNRELIABLE_BUFFERS = 7;
+constexpr u32 BLE_T_IFS_US = 150; //Inter frame space between two link layer packets
+constexpr u32 SIM_ADVERTISING_CHANNEL_SWITCH_US = 350; //Time between the end of a packet on one advertising channel and the start on the next one
+constexpr u32 SIM_NUM_ADVERTISING_CHANNELS = 3;
+constexpr u32 SIM_MAX_ADVERTISING_SETS = 4;
+constexpr float SIM_INTERFERENCE_MIN_RSSI = -100.0f; //Transmissions that are weaker at the receiver do not disturb other packets
 
 constexpr int SIM_NUM_SERVICES = 6;
 constexpr int SIM_NUM_CHARS    = 5;
@@ -128,6 +133,8 @@ struct SoftdeviceConnection {
     u32 lastReceivedPacketTimestampMs = 0;
     u32 connectionSetupTimeMs = 0;
     u32 lastConnectionTimestampMs = 0;
+    u32 timeSinceLastConnectionEventUs = 0; //Only used with SimConfiguration::simulateConnectionEvents
+    u32 sentLinkLayerBytes = 0; //Bytes of the next buffered packet that were already sent in previous connection events
 
     SoftDeviceBufferedPacket reliableBuffers[SIM_NUM_RELIABLE_BUFFERS] = {};
     SoftDeviceBufferedPacket unreliableBuffers[SIM_NUM_UNRELIABLE_BUFFERS] = {};
@@ -156,6 +163,16 @@ struct ServiceDB_t
     CharacteristicDB_t  charateristics[SIM_NUM_CHARS];
 };
 
+//An advertising set of a SoftDevice, the legacy advertising functions only use the first one
+struct SoftdeviceAdvertisingSet {
+    bool configured = false;
+    bool advertisingActive = false;
+    int advertisingIntervalMs = 0;
+    FruityHal::BleGapAdvType advertisingType = FruityHal::BleGapAdvType::ADV_IND;
+    u8 advertisingData[40] = {};
+    u8 advertisingDataLength = 0;
+};
+
 //The state of a SoftDevice
 struct SoftdeviceState {
     //Softdevice / Generic
@@ -163,12 +180,8 @@ struct SoftdeviceState {
     u32 timeMs = 0;
     i8 txPower = 0;
 
-    //Advertising
-    bool advertisingActive = false;
-    int advertisingIntervalMs = 0;
-    FruityHal::BleGapAdvType advertisingType = FruityHal::BleGapAdvType::ADV_IND;
-    u8 advertisingData[40] = {};
-    u8 advertisingDataLength = 0;
+    //Advertising, see SimConfiguration::numAdvertisingSets for the number of usable sets
+    std::array<SoftdeviceAdvertisingSet, SIM_MAX_ADVERTISING_SETS> advertisingSets{};
 
     //Scanning
     bool scanningActive = false;
@@ -239,6 +252,50 @@ struct PinSettings
     nrf_drv_gpiote_evt_handler_t handler = nullptr;
 };
 
+//Current consumption and timings of a chip at 3 V with the DC/DC converter enabled, used by
+//CherrySim::SimulateBatteryUsage to calculate the energy of the simulated radio and flash events.
+struct EnergyProfile {
+    u32 idleCurrentNa;             //System ON, RTC running, RAM retained
+    u32 cpuCurrentUa;              //CPU running from flash
+    u32 radioTxCurrentUa;          //TX at 0 dBm
+    u32 radioRxCurrentUa;          //RX on the 1 Mbit PHY
+    u32 radioRampUpUs;             //Before each TX or RX
+    u32 flashWriteCurrentUa;
+    u32 flashEraseCurrentUa;
+    u32 flashWordWriteTimeUs;
+    u32 flashPageEraseTimeUs;
+    u32 ledCurrentUa;
+    u32 advertisingEventCpuTimeUs; //Processing of the SoftDevice for each advertising event
+    u32 connectionEventCpuTimeUs;  //Processing of the SoftDevice for each connection event
+
+    static EnergyProfile Nrf52832()
+    {
+        return { 1900, 3700, 5300, 5400, 140, 3900, 3900, 41, 85000, 10000, 150, 150 };
+    }
+    static EnergyProfile Nrf52840()
+    {
+        return { 3200, 3300, 4800, 4600, 140, 3500, 3500, 41, 85000, 10000, 150, 150 };
+    }
+};
+
+//Charge that a node used since the simulation was started, split by its cause. All values are given in
+//pico coulomb (uA * us).
+struct EnergyUsage {
+    uint64_t idle = 0;
+    uint64_t led = 0;
+    uint64_t advertising = 0;
+    uint64_t scanning = 0;
+    uint64_t connecting = 0;
+    uint64_t connectionEvents = 0;
+    uint64_t connectionData = 0;
+    uint64_t flash = 0;
+
+    uint64_t GetTotal() const
+    {
+        return idle + led + advertising + scanning + connecting + connectionEvents + connectionData + flash;
+    }
+};
+
 struct FeaturesetPointers;
 
 using TerminalId = std::uint32_t;
@@ -269,13 +326,17 @@ struct NodeEntry {
     bool led1On = false;
     bool led2On = false;
     bool led3On = false;
-    u32 nanoAmperePerMsTotal;
+    uint64_t nanoAmperePerMsTotal; //Total charge in nano coulomb (uA * ms), see energyUsage for the details
+    EnergyProfile energyProfile = EnergyProfile::Nrf52832();
+    EnergyUsage energyUsage;
     u8 *moduleMemoryBlock = nullptr;
 
     uint32_t restartCounter = 0; //Counts how many times the node was restarted
     int64_t simulatedFrames = 0;
     u32 watchdogTimeout = 0; //After how many simulated unfeed ms the watchdog should kill the node.
     u32 lastWatchdogFeedTime = 0; //The timestamp at which the watchdog was fed last.
+    i32 clockDriftPpm = 0; //Error of the LF crystal that drives the RTC, see SimConfiguration::maxClockDriftPpm
+    int64_t clockDriftNanoTicks = 0; //RTC ticks that were gained or lost by the drift so far, in 1/1000000000 ticks
     RebootReason rebootReason = RebootReason::UNKNOWN;
 
     std::vector<int> impossibleConnection; //The rssi to these nodes is artificially increased to an unconnectable level.
@@ -306,6 +367,10 @@ struct NodeEntry {
     //Statistics
     PacketStat sentPackets[PACKET_STAT_SIZE];
     PacketStat routedPackets[PACKET_STAT_SIZE];
+    std::map<u32, u32> sentPacketsPerLink; //Packets sent over connections, mapped by the index of the partner node
+    u32 advertisingEventsSent = 0; //Each event is sent on all advertising channels
+    uint64_t advertisingAirtimeUs = 0;
+    uint64_t scanningTimeUs = 0;
 
     MoveAnimation animation;
 
@@ -348,6 +413,29 @@ struct NodeEntry {
 };
 
 
+//An advertising packet that is sent during the current simulation step on all three advertising channels,
+//see SimConfiguration::simulateAdvertisingCollisions
+struct AdvertisingTransmission {
+    u32 senderIndex = 0;
+    uint64_t startTimeUs = 0; //Start of the transmission on the first channel
+    u32 airtimeUs = 0; //Duration of the transmission on each channel
+    FruityHal::BleGapAdvType advertisingType = FruityHal::BleGapAdvType::ADV_IND;
+    u8 advertisingData[40] = {};
+    u8 advertisingDataLength = 0;
+};
+
+//Accuracy of the time of all nodes with the same number of hops to the time master,
+//see CherrySim::StartTimeSyncMeasurement
+struct TimeSyncAccuracy {
+    u32 hops = 0;
+    u32 numSamples = 0;
+    u32 numUnsyncedSamples = 0; //Samples of nodes whose time was not synced and corrected yet, these have no error
+    u32 p50ErrorUs = 0;
+    u32 p95ErrorUs = 0;
+    u32 p99ErrorUs = 0;
+    u32 maxErrorUs = 0;
+};
+
 struct SimulatorState {
     u32 simTimeMs = 0;
     MersenneTwister rnd;
@@ -375,6 +463,42 @@ namespace nlohmann {
             if (j.size() >= 3) j.at(2).get_to(p.z);
         }
     };
+
+    //Missing keys keep their value, so that a json can override single values of a profile
+    template <>
+    struct adl_serializer<EnergyProfile> {
+        static void to_json(nlohmann::json& j, const EnergyProfile& p) {
+            j = nlohmann::json{
+                { "idleCurrentNa"            , p.idleCurrentNa             },
+                { "cpuCurrentUa"             , p.cpuCurrentUa              },
+                { "radioTxCurrentUa"         , p.radioTxCurrentUa          },
+                { "radioRxCurrentUa"         , p.radioRxCurrentUa          },
+                { "radioRampUpUs"            , p.radioRampUpUs             },
+                { "flashWriteCurrentUa"      , p.flashWriteCurrentUa       },
+                { "flashEraseCurrentUa"      , p.flashEraseCurrentUa       },
+                { "flashWordWriteTimeUs"     , p.flashWordWriteTimeUs      },
+                { "flashPageEraseTimeUs"     , p.flashPageEraseTimeUs      },
+                { "ledCurrentUa"             , p.ledCurrentUa              },
+                { "advertisingEventCpuTimeUs", p.advertisingEventCpuTimeUs },
+                { "connectionEventCpuTimeUs" , p.connectionEventCpuTimeUs  },
+            };
+        }
+
+        static void from_json(const nlohmann::json& j, EnergyProfile& p) {
+            if (j.contains("idleCurrentNa"            )) j.at("idleCurrentNa"            ).get_to(p.idleCurrentNa);
+            if (j.contains("cpuCurrentUa"             )) j.at("cpuCurrentUa"             ).get_to(p.cpuCurrentUa);
+            if (j.contains("radioTxCurrentUa"         )) j.at("radioTxCurrentUa"         ).get_to(p.radioTxCurrentUa);
+            if (j.contains("radioRxCurrentUa"         )) j.at("radioRxCurrentUa"         ).get_to(p.radioRxCurrentUa);
+            if (j.contains("radioRampUpUs"            )) j.at("radioRampUpUs"            ).get_to(p.radioRampUpUs);
+            if (j.contains("flashWriteCurrentUa"      )) j.at("flashWriteCurrentUa"      ).get_to(p.flashWriteCurrentUa);
+            if (j.contains("flashEraseCurrentUa"      )) j.at("flashEraseCurrentUa"      ).get_to(p.flashEraseCurrentUa);
+            if (j.contains("flashWordWriteTimeUs"     )) j.at("flashWordWriteTimeUs"     ).get_to(p.flashWordWriteTimeUs);
+            if (j.contains("flashPageEraseTimeUs"     )) j.at("flashPageEraseTimeUs"     ).get_to(p.flashPageEraseTimeUs);
+            if (j.contains("ledCurrentUa"             )) j.at("ledCurrentUa"             ).get_to(p.ledCurrentUa);
+            if (j.contains("advertisingEventCpuTimeUs")) j.at("advertisingEventCpuTimeUs").get_to(p.advertisingEventCpuTimeUs);
+            if (j.contains("connectionEventCpuTimeUs" )) j.at("connectionEventCpuTimeUs" ).get_to(p.connectionEventCpuTimeUs);
+        }
+    };
 }
 
 struct SimConfiguration {
@@ -423,6 +547,7 @@ struct SimConfiguration {
     bool        enableClusteringValidityCheck      = false; //Enable automatic checking of the clustering after each step
     bool        enableSimStatistics                = false;
     std::string storeFlashToFile                   = "";
+    std::string packetTraceFile                    = ""; //If not empty, all mesh packet events are written into this pcap file, see PacketTracer
 
     /// The base height of the lowest floor. This is subtracted from the height of an asset tag before the floor computation takes place.
     float       floorBiasInMeters                  = 0.0f;
@@ -434,6 +559,38 @@ struct SimConfiguration {
     bool        perfectReceptionProbabilityForAdvertising = false;
     bool        perfectReceptionProbabilityForConnection  = false;
 
+    /// If set, connections are simulated per connection event instead of sending a random amount of packets each
+    /// connection interval. The interval, the event length, the MTU, the data length and the PHY then determine
+    /// how many packets are sent and each link layer packet can be lost depending on the rssi.
+    bool        simulateConnectionEvents                  = false;
+    /// The PHY of all connections in Mbit/s (1 or 2), only used with simulateConnectionEvents.
+    uint32_t    connectionPhyMbps                         = 1;
+    /// The maximum link layer payload (27 - 251), only used with simulateConnectionEvents.
+    uint32_t    connectionMaxDataLength                   = 251;
+
+    /// If set, advertising packets are sent on the channels 37, 38 and 39 at a random time within each simulation
+    /// step. A scanner only receives on one channel during its scan window and packets that overlap on the same
+    /// channel are lost unless they are stronger than all others by advertisingCaptureThresholdDb.
+    bool        simulateAdvertisingCollisions             = false;
+    float       advertisingCaptureThresholdDb             = 6.0f;
+
+    /// Number of advertising sets that the SoftDevice of each node can advertise with at the same time
+    /// (at most SIM_MAX_ADVERTISING_SETS). The SoftDevices used by the firmware only support a single set.
+    uint32_t    numAdvertisingSets                        = 1;
+
+    /// If bigger than 0, the RTC of each node runs faster or slower than the simulation time by a random
+    /// error between -maxClockDriftPpm and maxClockDriftPpm, see NodeEntry::clockDriftPpm.
+    /// The timers of the nodes are not affected.
+    uint32_t    maxClockDriftPpm                          = 0;
+
+    /// Capacity of the battery of each node, used to project the battery life from the simulated energy usage.
+    uint32_t    batteryCapacityMah                        = 1000;
+
+    /// Currents and timings of the nodes with an nRF52840 or nRF52833 featureset and of all other nodes,
+    /// see NodeEntry::energyProfile. The defaults are EnergyProfile::Nrf52840() and EnergyProfile::Nrf52832().
+    EnergyProfile energyProfileNrf52832                       = EnergyProfile::Nrf52832();
+    EnergyProfile energyProfileNrf52840                       = EnergyProfile::Nrf52840();
+
     bool        verboseCommands                    = false; // deprecated but retained only for compatability reasons. Should be removed in ticket BR-2321
 
     //Set this to true to disable all non-critical exceptions, e.g. useful for CherrySimRunner
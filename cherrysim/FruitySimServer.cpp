@@ -370,8 +370,8 @@ std::string FruitySimServer::GenerateDevicesJson()
 
 
         char advData[200];
-        if (node->state.advertisingActive) {
-            Logger::ConvertBufferToHexString(node->state.advertisingData, node->state.advertisingDataLength, advData, sizeof(advData));
+        if (node->state.advertisingSets[0].advertisingActive) {
+            Logger::ConvertBufferToHexString(node->state.advertisingSets[0].advertisingData, node->state.advertisingSets[0].advertisingDataLength, advData, sizeof(advData));
         }
         else {
             sprintf(advData, "Not advertising");
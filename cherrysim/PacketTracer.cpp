@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+// /****************************************************************************
+// **
+// ** Copyright (C) 2015-2022 M-Way Solutions GmbH
+// ** Contact: https://www.blureange.io/licensing
+// **
+// ** This file is part of the Bluerange/FruityMesh implementation
+// **
+// ** $BR_BEGIN_LICENSE:GPL-EXCEPT$
+// ** Commercial License Usage
+// ** Licensees holding valid commercial Bluerange licenses may use this file in
+// ** accordance with the commercial license agreement provided with the
+// ** Software or, alternatively, in accordance with the terms contained in
+// ** a written agreement between them and M-Way Solutions GmbH. 
+// ** For licensing terms and conditions see https://www.bluerange.io/terms-conditions. For further
+// ** information use the contact form at https://www.bluerange.io/contact.
+// **
+// ** GNU General Public License Usage
+// ** Alternatively, this file may be used under the terms of the GNU
+// ** General Public License version 3 as published by the Free Software
+// ** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+// ** included in the packaging of this file. Please review the following
+// ** information to ensure the GNU General Public License requirements will
+// ** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+// **
+// ** $BR_END_LICENSE$
+// **
+// ****************************************************************************/
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketTracer.h"
+
+//See https://wiki.wireshark.org/Development/LibpcapFileFormat
+constexpr u32 PCAP_MAGIC_NUMBER = 0xA1B2C3D4;
+constexpr u32 PCAP_LINKTYPE_USER0 = 147;
+//Big enough to write a trace of an hour long simulation without noticeably slowing it down
+constexpr size_t PACKET_TRACER_FILE_BUFFER_SIZE = 1024 * 1024;
+
+#pragma pack(push, 1)
+struct PcapGlobalHeader
+{
+    u32 magicNumber;
+    u16 versionMajor;
+    u16 versionMinor;
+    i32 thisZone;
+    u32 sigFigs;
+    u32 snapLen;
+    u32 network;
+};
+STATIC_ASSERT_SIZE(PcapGlobalHeader, 24);
+
+struct PcapRecordHeader
+{
+    u32 tsSec;
+    u32 tsUsec;
+    u32 inclLen;
+    u32 origLen;
+};
+STATIC_ASSERT_SIZE(PcapRecordHeader, 16);
+#pragma pack(pop)
+
+PacketTracer::~PacketTracer()
+{
+    Close();
+}
+
+bool PacketTracer::Open(const std::string& path)
+{
+    Close();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        printf("WARNING: Packet trace file '%s' could not be created!" EOL, path.c_str());
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, PACKET_TRACER_FILE_BUFFER_SIZE);
+
+    PcapGlobalHeader header = {};
+    header.magicNumber = PCAP_MAGIC_NUMBER;
+    header.versionMajor = 2;
+    header.versionMinor = 4;
+    header.snapLen = sizeof(PacketTraceRecord);
+    header.network = PCAP_LINKTYPE_USER0;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    numEvents = 0;
+    return true;
+}
+
+void PacketTracer::Close()
+{
+    if (file == nullptr) return;
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+void PacketTracer::Trace(u32 timeMs, PacketTraceEventType eventType, DeliveryPriority priority, NodeId nodeId, NodeId partnerId, u32 uniqueConnectionId, const u8* data, u16 length)
+{
+    if (file == nullptr) return;
+
+    PacketTraceRecord record = {};
+    record.eventType = eventType;
+    record.priority = priority;
+    record.nodeId = nodeId;
+    record.partnerId = partnerId;
+    record.uniqueConnectionId = uniqueConnectionId;
+    record.length = length;
+
+    if (data != nullptr && length >= SIZEOF_CONN_PACKET_HEADER)
+    {
+        const ConnPacketHeader* packetHeader = (const ConnPacketHeader*)data;
+        record.messageType = packetHeader->messageType;
+        if (packetHeader->messageType != MessageType::SPLIT_WRITE_CMD && packetHeader->messageType != MessageType::SPLIT_WRITE_CMD_END)
+        {
+            record.sender = packetHeader->sender;
+            record.receiver = packetHeader->receiver;
+        }
+    }
+    else if (data != nullptr && length > 0)
+    {
+        record.messageType = ((const ConnPacketHeader*)data)->messageType;
+    }
+
+    PcapRecordHeader recordHeader = {};
+    recordHeader.tsSec = timeMs / 1000;
+    recordHeader.tsUsec = (timeMs % 1000) * 1000;
+    recordHeader.inclLen = sizeof(record);
+    recordHeader.origLen = sizeof(record);
+    std::fwrite(&recordHeader, sizeof(recordHeader), 1, file);
+    std::fwrite(&record, sizeof(record), 1, file);
+
+    numEvents++;
+}
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+// /****************************************************************************
+// **
+// ** Copyright (C) 2015-2022 M-Way Solutions GmbH
+// ** Contact: https://www.blureange.io/licensing
+// **
+// ** This file is part of the Bluerange/FruityMesh implementation
+// **
+// ** $BR_BEGIN_LICENSE:GPL-EXCEPT$
+// ** Commercial License Usage
+// ** Licensees holding valid commercial Bluerange licenses may use this file in
+// ** accordance with the commercial license agreement provided with the
+// ** Software or, alternatively, in accordance with the terms contained in
+// ** a written agreement between them and M-Way Solutions GmbH. 
+// ** For licensing terms and conditions see https://www.bluerange.io/terms-conditions. For further
+// ** information use the contact form at https://www.bluerange.io/contact.
+// **
+// ** GNU General Public License Usage
+// ** Alternatively, this file may be used under the terms of the GNU
+// ** General Public License version 3 as published by the Free Software
+// ** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+// ** included in the packaging of this file. Please review the following
+// ** information to ensure the GNU General Public License requirements will
+// ** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+// **
+// ** $BR_END_LICENSE$
+// **
+// ****************************************************************************/
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#include "FmTypes.h"
+#include "ConnectionMessageTypes.h"
+
+//The events that are recorded for mesh packets
+enum class PacketTraceEventType : u8
+{
+    TX         = 0, //A packet was sent over a connection (a single split for split messages)
+    RX         = 1, //A packet was received over a connection (a single split for split messages)
+    DROP       = 2, //A message could not be queued as the send queue was full
+    EXPIRE     = 3, //Messages were discarded from the send queue as they expired, length is their number
+    SPLIT      = 4, //A message was queued that must be split as it does not fit into a single packet
+    REASSEMBLE = 5, //All splits of a message were received and it was reassembled
+};
+
+//A single trace event, stored as the payload of a pcap record. All fields are little endian.
+//The message type, sender and receiver are taken from the ConnPacketHeader. For splits, the
+//message type is the split message type and sender and receiver are 0.
+#pragma pack(push, 1)
+struct PacketTraceRecord
+{
+    PacketTraceEventType eventType;
+    DeliveryPriority priority; //INVALID on the receiving side as it is not transmitted
+    NodeId nodeId;
+    NodeId partnerId;
+    u32 uniqueConnectionId;
+    MessageType messageType;
+    NodeId sender;
+    NodeId receiver;
+    u16 length;
+};
+#pragma pack(pop)
+STATIC_ASSERT_SIZE(PacketTraceRecord, 17);
+
+//Writes the events of the mesh packets of all nodes into a pcap file. Each record uses the
+//link type USER0 and can be decoded with the dissector in util/wireshark/fruitymesh.lua.
+class PacketTracer
+{
+private:
+    std::FILE* file = nullptr;
+    u32 numEvents = 0;
+
+public:
+    PacketTracer() = default;
+    PacketTracer(const PacketTracer&) = delete;
+    PacketTracer& operator=(const PacketTracer&) = delete;
+    ~PacketTracer();
+
+    //Creates the file at the given path and writes the pcap header, an open file is closed before
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return file != nullptr; }
+    u32 GetNumEvents() const { return numEvents; }
+
+    //Records an event, data may be nullptr or must point to at least length bytes of a mesh packet
+    void Trace(u32 timeMs, PacketTraceEventType eventType, DeliveryPriority priority, NodeId nodeId, NodeId partnerId, u32 uniqueConnectionId, const u8* data, u16 length);
+};
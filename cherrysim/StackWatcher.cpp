@@ -32,9 +32,28 @@
 #include "StackWatcher.h"
 #include "Exceptions.h"
 #include <cstdio> //for std::size_t
+#include <cstring>
+#include <algorithm>
 
 std::vector<const void*> StackWatcher::stackBase;
 u32 StackWatcher::disableValue = 0;
+std::map<StackWatcher::HandlerKey, HandlerStackUsage> StackWatcher::handlerStackUsage;
+std::vector<HandlerStackUsage*> StackWatcher::activeHandlers;
+
+bool StackWatcher::HandlerKey::operator<(const HandlerKey& other) const
+{
+    //The names are compared by content as each node has its own instance of each module
+    if (eventId != other.eventId) return eventId < other.eventId;
+    const int handlerCompare = strcmp(handlerName, other.handlerName);
+    if (handlerCompare != 0) return handlerCompare < 0;
+    return strcmp(moduleName != nullptr ? moduleName : "", other.moduleName != nullptr ? other.moduleName : "") < 0;
+}
+
+u32 StackWatcher::GetStackSize(const void* stackPosition)
+{
+    const u32 uncleanedStackSize = (const char*)StackWatcher::stackBase.back() - (const char*)stackPosition;
+    return uncleanedStackSize - sizeof(StackBaseSetter);
+}
 
 void StackWatcher::Check()
 {
@@ -50,8 +69,13 @@ void StackWatcher::Check()
 
     int someDummyStackVariable = 0;
 
-    const u32 uncleanedStackSize = (const char*)StackWatcher::stackBase.back() - (const char*)&someDummyStackVariable;
-    const u32 cleanedStackSize = uncleanedStackSize - sizeof(StackBaseSetter);
+    const u32 cleanedStackSize = GetStackSize(&someDummyStackVariable);
+
+    //Nested handlers all see the stack usage of the innermost one
+    for (HandlerStackUsage* usage : activeHandlers)
+    {
+        if (cleanedStackSize > usage->peakStackBytes) usage->peakStackBytes = cleanedStackSize;
+    }
 
     if (cleanedStackSize > 12000)
     {
@@ -89,3 +113,70 @@ StackWatcherDisabler::~StackWatcherDisabler()
 {
     StackWatcher::disableValue--;
 }
+
+StackWatcherScope::StackWatcherScope(const char* handlerName, const char* moduleName, u32 eventId)
+{
+    //Handlers are only recorded while a node is simulated
+    active = StackWatcher::stackBase.size() != 0;
+    if (!active) return;
+
+    const StackWatcher::HandlerKey key = { handlerName, moduleName, eventId };
+    auto entry = StackWatcher::handlerStackUsage.find(key);
+    if (entry == StackWatcher::handlerStackUsage.end())
+    {
+        entry = StackWatcher::handlerStackUsage.insert({ key, { handlerName, moduleName, eventId, 0, 0 } }).first;
+    }
+    entry->second.numCalls++;
+    StackWatcher::activeHandlers.push_back(&entry->second);
+
+    StackWatcher::Check();
+}
+
+StackWatcherScope::~StackWatcherScope()
+{
+    if (!active) return;
+    StackWatcher::activeHandlers.pop_back();
+}
+
+std::vector<HandlerStackUsage> StackWatcher::GetTopHandlers(u32 count)
+{
+    std::vector<HandlerStackUsage> result;
+    for (const auto& entry : handlerStackUsage)
+    {
+        if (entry.second.numCalls > 0) result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(), [](const HandlerStackUsage& a, const HandlerStackUsage& b) {
+        return a.peakStackBytes > b.peakStackBytes;
+    });
+    if (result.size() > count) result.resize(count);
+    return result;
+}
+
+void StackWatcher::PrintTopHandlers(u32 count)
+{
+    printf(">----------------------------------------------------<" EOL);
+    printf("Peak stack usage per handler" EOL);
+    printf("" EOL);
+    for (const HandlerStackUsage& usage : GetTopHandlers(count))
+    {
+        if (usage.moduleName != nullptr)
+        {
+            printf("%s of %s :: %u bytes, %u calls" EOL, usage.handlerName, usage.moduleName, usage.peakStackBytes, usage.numCalls);
+        }
+        else
+        {
+            printf("%s 0x%X :: %u bytes, %u calls" EOL, usage.handlerName, usage.eventId, usage.peakStackBytes, usage.numCalls);
+        }
+    }
+    printf(">----------------------------------------------------<" EOL);
+}
+
+void StackWatcher::ResetHandlerStackUsage()
+{
+    //The entries are kept as handlers that are currently executed reference them
+    for (auto& entry : handlerStackUsage)
+    {
+        entry.second.peakStackBytes = 0;
+        entry.second.numCalls = 0;
+    }
+}
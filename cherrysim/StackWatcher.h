@@ -30,6 +30,7 @@
 
 #pragma once
 #include <vector>
+#include <map>
 
 class StackBaseSetter
 {
@@ -47,15 +48,53 @@ public:
     ~StackWatcherDisabler();
 };
 
+//The peak stack usage while a handler was executed. Handlers of modules are identified by the module name,
+//BLE events by their event id.
+struct HandlerStackUsage
+{
+    const char* handlerName;
+    const char* moduleName;
+    u32 eventId;
+    u32 peakStackBytes;
+    u32 numCalls;
+};
+
+//Records the stack usage for a handler while it is in scope, see STACK_WATCHER_SCOPE
+class StackWatcherScope
+{
+public:
+    StackWatcherScope(const char* handlerName, const char* moduleName, u32 eventId);
+    ~StackWatcherScope();
+private:
+    bool active;
+};
+
 class StackWatcher
 {
     friend StackBaseSetter;
     friend StackWatcherDisabler;
+    friend StackWatcherScope;
 private:
+    struct HandlerKey
+    {
+        const char* handlerName;
+        const char* moduleName;
+        u32 eventId;
+        bool operator<(const HandlerKey& other) const;
+    };
+
     static std::vector<const void*> stackBase;
     static u32 disableValue;
+    static std::map<HandlerKey, HandlerStackUsage> handlerStackUsage;
+    static std::vector<HandlerStackUsage*> activeHandlers;
+
+    static u32 GetStackSize(const void* stackPosition);
 
 public:
     static void Check();
 
+    //Returns the handlers with the highest peak stack usage since the last reset, highest first
+    static std::vector<HandlerStackUsage> GetTopHandlers(u32 count);
+    static void PrintTopHandlers(u32 count);
+    static void ResetHandlerStackUsage();
 };
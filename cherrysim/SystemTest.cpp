@@ -471,6 +471,42 @@ extern "C"
     //############### GAP ###################
 
     uint32_t sd_ble_gap_adv_data_set(const uint8_t* p_data, uint8_t dlen, const uint8_t* p_sr_data, uint8_t srdlen)
+    {
+        uint8_t advHandle = 0;
+        return sim_ble_gap_adv_data_set(&advHandle, p_data, dlen, p_sr_data, srdlen);
+    }
+
+    uint32_t sd_ble_gap_adv_stop()
+    {
+        return sim_ble_gap_adv_stop(0);
+    }
+
+    uint8_t sim_get_max_advertising_sets()
+    {
+        return (uint8_t)std::min(std::max(cherrySimInstance->simConfig.numAdvertisingSets, 1u), SIM_MAX_ADVERTISING_SETS);
+    }
+
+    //Returns the advertising set for the given handle, a new one is configured if the handle is not set
+    static SoftdeviceAdvertisingSet* GetAdvertisingSet(uint8_t* p_adv_handle)
+    {
+        std::array<SoftdeviceAdvertisingSet, SIM_MAX_ADVERTISING_SETS>& advertisingSets = cherrySimInstance->currentNode->state.advertisingSets;
+        if (*p_adv_handle == SIM_ADV_SET_HANDLE_NOT_SET) {
+            for (uint8_t i = 0; i < sim_get_max_advertising_sets(); i++) {
+                if (!advertisingSets[i].configured) {
+                    advertisingSets[i].configured = true;
+                    *p_adv_handle = i;
+                    return &advertisingSets[i];
+                }
+            }
+            return nullptr;
+        }
+        if (*p_adv_handle >= sim_get_max_advertising_sets()) return nullptr;
+
+        advertisingSets[*p_adv_handle].configured = true;
+        return &advertisingSets[*p_adv_handle];
+    }
+
+    uint32_t sim_ble_gap_adv_data_set(uint8_t* p_adv_handle, const uint8_t* p_data, uint8_t dlen, const uint8_t* p_sr_data, uint8_t srdlen)
     {
         START_OF_FUNCTION();
         if (cherrySimInstance->simConfig.sdBleGapAdvDataSetFailProbability != 0 && PSRNG(cherrySimInstance->simConfig.sdBleGapAdvDataSetFailProbability)) {
@@ -478,20 +514,27 @@ extern "C"
             return NRF_ERROR_INVALID_STATE;
         }
 
+        SoftdeviceAdvertisingSet* advertisingSet = GetAdvertisingSet(p_adv_handle);
+        if (advertisingSet == nullptr) return NRF_ERROR_INVALID_PARAM;
+
         //TODO: Should check advertising data if it is valid or not (parse length and type fields)
 
-        CheckedMemcpy(cherrySimInstance->currentNode->state.advertisingData, p_data, dlen);
-        cherrySimInstance->currentNode->state.advertisingDataLength = dlen;
+        CheckedMemcpy(advertisingSet->advertisingData, p_data, dlen);
+        advertisingSet->advertisingDataLength = dlen;
 
         //TODO: could copy scan response data
 
         return 0;
     }
 
-    uint32_t sd_ble_gap_adv_stop()
+    uint32_t sim_ble_gap_adv_stop(uint8_t adv_handle)
     {
         START_OF_FUNCTION();
-        cherrySimInstance->currentNode->state.advertisingActive = false;
+        //Nothing was configured yet, so nothing is advertising
+        if (adv_handle == SIM_ADV_SET_HANDLE_NOT_SET) return 0;
+        if (adv_handle >= sim_get_max_advertising_sets()) return NRF_ERROR_INVALID_PARAM;
+
+        cherrySimInstance->currentNode->state.advertisingSets[adv_handle].advertisingActive = false;
 
         //TODO: could return invalid sate
 
@@ -526,7 +569,13 @@ extern "C"
         }
     }
 
-    uint32_t sd_ble_gap_adv_start(const ble_gap_adv_params_t* p_adv_params, uint32_t)
+    uint32_t sd_ble_gap_adv_start(const ble_gap_adv_params_t* p_adv_params, uint32_t connCfgTag)
+    {
+        uint8_t advHandle = 0;
+        return sim_ble_gap_adv_start(&advHandle, p_adv_params, connCfgTag);
+    }
+
+    uint32_t sim_ble_gap_adv_start(uint8_t* p_adv_handle, const ble_gap_adv_params_t* p_adv_params, uint32_t)
     {
         START_OF_FUNCTION();
         if (PSRNG(cherrySimInstance->simConfig.sdBusyProbability)) {
@@ -549,9 +598,12 @@ extern "C"
 
         //TODO: Check for other error conditions such as invalid state and invalid param as well
 
-        cherrySimInstance->currentNode->state.advertisingActive = true;
-        cherrySimInstance->currentNode->state.advertisingIntervalMs = UNITS_TO_MSEC(p_adv_params->interval, UNIT_0_625_MS);
-        cherrySimInstance->currentNode->state.advertisingType = AdvertisingTypeToGeneric(p_adv_params->type);
+        SoftdeviceAdvertisingSet* advertisingSet = GetAdvertisingSet(p_adv_handle);
+        if (advertisingSet == nullptr) return NRF_ERROR_INVALID_PARAM;
+
+        advertisingSet->advertisingActive = true;
+        advertisingSet->advertisingIntervalMs = UNITS_TO_MSEC(p_adv_params->interval, UNIT_0_625_MS);
+        advertisingSet->advertisingType = AdvertisingTypeToGeneric(p_adv_params->type);
 
         //TODO: could return invalid state
 
@@ -1612,6 +1664,9 @@ extern "C"
             p[i] = 0xFFFFFFFF;
         }
 
+        NodeEntry* node = cherrySimInstance->currentNode;
+        node->energyUsage.flash += (uint64_t)node->energyProfile.flashPageEraseTimeUs * node->energyProfile.flashEraseCurrentUa;
+
         //If the stack is initialized, it will generate an event for the operation, if not, it will only return syncronously
         if (cherrySimInstance->currentNode->state.initialized) {
             if (cherrySimInstance->simConfig.simulateAsyncFlash) {
@@ -1661,6 +1716,9 @@ extern "C"
             p_dst[i] &= p_src[i];
         }
 
+        NodeEntry* node = cherrySimInstance->currentNode;
+        node->energyUsage.flash += (uint64_t)size * node->energyProfile.flashWordWriteTimeUs * node->energyProfile.flashWriteCurrentUa;
+
         //If the stack is initialized, it will generate an event for the operation, if not, it will only return syncronously
         if (cherrySimInstance->currentNode->state.initialized) {
             if (cherrySimInstance->simConfig.simulateAsyncFlash) {
@@ -1917,7 +1975,10 @@ extern "C"
             SIMEXCEPTION(IllegalArgumentException);//Non 0 prescaler not implemented
         }
 
-        return (u32)(cherrySimInstance->simState.simTimeMs * (APP_TIMER_CLOCK_FREQ / 1000.0));
+        //The RTC of each node drifts according to its NodeEntry::clockDriftPpm
+        const int64_t driftTicks = cherrySimInstance->currentNode != nullptr ? cherrySimInstance->currentNode->clockDriftNanoTicks / 1000000000 : 0;
+
+        return (u32)(cherrySimInstance->simState.simTimeMs * (APP_TIMER_CLOCK_FREQ / 1000.0) + driftTicks);
     }
 
     uint32_t app_timer_cnt_diff_compute(uint32_t nowTime, uint32_t previousTime)
@@ -165,6 +165,13 @@ extern "C" {
 
 #define ACTIVATE_REGISTER_HANDLER 1
 
+#define ACTIVATE_RELIABLE_TRANSFER 1
+
+#define ACTIVATE_QUEUE_HISTOGRAMS 1
+
+#define PACKET_QUEUE_MAX_AGE_SEC_MEDIUM 120
+#define PACKET_QUEUE_MAX_AGE_SEC_LOW 30
+
 //#define ACTIVATE_ONLY_SINK_FUNCTIONALITY 1
 
 #define NRF_GPIOTE_POLARITY_TOGGLE 1
@@ -799,6 +806,14 @@ extern uint8_t* simFlashPtr;
 uint32_t sd_ble_gap_adv_data_set(uint8_t const *p_data, uint8_t dlen, uint8_t const *p_sr_data, uint8_t srdlen);
 uint32_t sd_ble_gap_adv_stop();
 uint32_t sd_ble_gap_adv_start(ble_gap_adv_params_t const *p_adv_params, uint32_t);
+
+//Advertising with multiple advertising sets, the legacy functions above use the first set
+#define SIM_ADV_SET_HANDLE_NOT_SET 0xFF
+uint8_t sim_get_max_advertising_sets();
+uint32_t sim_ble_gap_adv_data_set(uint8_t* p_adv_handle, uint8_t const *p_data, uint8_t dlen, uint8_t const *p_sr_data, uint8_t srdlen);
+uint32_t sim_ble_gap_adv_start(uint8_t* p_adv_handle, ble_gap_adv_params_t const *p_adv_params, uint32_t);
+uint32_t sim_ble_gap_adv_stop(uint8_t adv_handle);
+
 uint32_t sd_ble_gap_device_name_set(ble_gap_conn_sec_mode_t const *p_write_perm, uint8_t const *p_dev_name, uint16_t len);
 uint32_t sd_ble_gap_appearance_set(uint16_t appearance);
 uint32_t sd_ble_gap_ppcp_set(ble_gap_conn_params_t const *p_conn_params);
@@ -33,6 +33,7 @@
 #include "gtest/gtest.h"
 
 #include <Exceptions.h>
+#include <CherrySimTester.h>
 
 #include <AutoSenseModule.h>
 #include <AutoActModule.h>
@@ -58,11 +59,30 @@ void RetryOrFail(int maxRetries, SetupFn setupFn, ActionFn actionFn)
     ASSERT_LT(retry, maxRetries);
 }
 
+//Starts a simulation that was set up by the configure function and returns by how much the value of the measure
+//function changed while the simulate function ran. Tests use it to compare a metric between two configurations.
+template <typename ConfigureFn, typename PrepareFn, typename SimulateFn, typename MeasureFn>
+auto MeasureSimulation(ConfigureFn configureFn, PrepareFn prepareFn, SimulateFn simulateFn, MeasureFn measureFn)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    //testerConfig.verbose = true;
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    configureFn(simConfig);
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    prepareFn(tester);
+    const auto before = measureFn(tester);
+    simulateFn(tester);
+    return measureFn(tester) - before;
+}
+
 struct AutoSenseTableEntryBuilder
 {
 #pragma pack(push)
 #pragma pack(1)
     AutoSenseTableEntryV0 entry = { 0 };
+    u8 functionParams[AutoSenseModule::MAX_ENTRY_SIZE - sizeof(AutoSenseTableEntryV0)] = { 0 };
 #pragma pack(pop)
 
     AutoSenseTableEntryBuilder() {}
@@ -70,7 +90,7 @@ struct AutoSenseTableEntryBuilder
     std::string getEntry() const
     {
         char buffer[256];
-        Logger::ConvertBufferToHexString((const u8*)&entry, sizeof(entry), buffer, sizeof(buffer));
+        Logger::ConvertBufferToHexString((const u8*)&entry, sizeof(entry) + AutoSenseModule::GetFunctionParamsSize(&entry), buffer, sizeof(buffer));
         return buffer;
     }
 };
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+// /****************************************************************************
+// **
+// ** Copyright (C) 2015-2022 M-Way Solutions GmbH
+// ** Contact: https://www.blureange.io/licensing
+// **
+// ** This file is part of the Bluerange/FruityMesh implementation
+// **
+// ** $BR_BEGIN_LICENSE:GPL-EXCEPT$
+// ** Commercial License Usage
+// ** Licensees holding valid commercial Bluerange licenses may use this file in
+// ** accordance with the commercial license agreement provided with the
+// ** Software or, alternatively, in accordance with the terms contained in
+// ** a written agreement between them and M-Way Solutions GmbH. 
+// ** For licensing terms and conditions see https://www.bluerange.io/terms-conditions. For further
+// ** information use the contact form at https://www.bluerange.io/contact.
+// **
+// ** GNU General Public License Usage
+// ** Alternatively, this file may be used under the terms of the GNU
+// ** General Public License version 3 as published by the Free Software
+// ** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+// ** included in the packaging of this file. Please review the following
+// ** information to ensure the GNU General Public License requirements will
+// ** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+// **
+// ** $BR_END_LICENSE$
+// **
+#include "gtest/gtest.h"
+#include <HelperFunctions.h>
+#include <CherrySimTester.h>
+#include <CherrySimUtils.h>
+#include <Node.h>
+#include <AdvertisingController.h>
+
+static AdvJob* AddJob(u8 slots, u8 advDataByte, const CherrySimTester &tester, u32 nodeIndex)
+{
+    AdvJob job = {
+        AdvJobTypes::SCHEDULED,
+        slots,
+        0, //Delay
+        MSEC_TO_UNITS(100, CONFIG_UNIT_0_625_MS),
+        0, //AdvChannel
+        0, //CurrentSlots
+        0, //CurrentDelay
+        FruityHal::BleGapAdvType::ADV_NONCONN_IND,
+        {0x02, 0x01, 0x06, 0x05, 0xFF, 0x4D, 0x02, 0xAA, advDataByte},
+        9,
+        {0},
+        0 //ScanDataLength
+    };
+    NodeIndexSetter setter(nodeIndex);
+    return tester.sim->currentNode->gs.advertisingController.AddJob(job);
+}
+
+static u32 CountActiveAdvertisingSets(const CherrySimTester &tester)
+{
+    u32 count = 0;
+    for (const SoftdeviceAdvertisingSet& advertisingSet : tester.sim->nodes[0].state.advertisingSets) {
+        if (advertisingSet.advertisingActive) count++;
+    }
+    return count;
+}
+
+TEST(TestAdvertisingController, TestJobsUseOwnAdvertisingSets) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.numAdvertisingSets = 3;
+    simConfig.nodeConfigName.insert({ "github_dev_nrf52", 1 });
+    simConfig.SetToPerfectConditions();
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    //Each job of the firmware (join_me and mesh access) is advertised in its own set
+    tester.SimulateForGivenTime(1000);
+    ASSERT_EQ(tester.sim->nodes[0].gs.advertisingController.currentNumJobs, 2);
+    ASSERT_EQ(CountActiveAdvertisingSets(tester), 2);
+
+    //A new job gets its own set
+    AddJob(1, 0x01, tester, 0);
+    tester.SimulateForGivenTime(1000);
+    ASSERT_EQ(CountActiveAdvertisingSets(tester), 3);
+
+    //With more jobs than sets, all jobs are rotated through a single set
+    AdvJob* job = AddJob(1, 0x02, tester, 0);
+    tester.SimulateForGivenTime(1000);
+    ASSERT_EQ(CountActiveAdvertisingSets(tester), 1);
+
+    //Once enough sets are available again, they are used
+    {
+        NodeIndexSetter setter(0);
+        tester.sim->currentNode->gs.advertisingController.RemoveJob(job);
+    }
+    tester.SimulateForGivenTime(1000);
+    ASSERT_EQ(CountActiveAdvertisingSets(tester), 3);
+}
+
+TEST(TestAdvertisingController, TestSlotRotationWithSingleAdvertisingSet) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+    simConfig.SetToPerfectConditions();
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    AddJob(1, 0x01, tester, 0);
+    AddJob(1, 0x02, tester, 0);
+    tester.SimulateForGivenTime(1000);
+    ASSERT_EQ(CountActiveAdvertisingSets(tester), 1);
+}
+
+//Returns the time until all nodes are clustered while each node also advertises some other jobs
+static u32 MeasureClusteringTimeWithOtherAdvertisingJobs(u32 numAdvertisingSets)
+{
+    return MeasureSimulation(
+        [&](SimConfiguration& simConfig) {
+            simConfig.numAdvertisingSets = numAdvertisingSets;
+            simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+            simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 9 });
+        },
+        [](CherrySimTester& tester) {
+            //The join_me packet only gets 5 of 35 slots in the slot rotation
+            for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++) {
+                AddJob(10, 0x01, tester, i);
+                AddJob(10, 0x02, tester, i);
+                AddJob(10, 0x03, tester, i);
+            }
+        },
+        [](CherrySimTester& tester) {
+            tester.SimulateUntilClusteringDone(200 * 1000);
+        },
+        [](CherrySimTester& tester) {
+            return tester.sim->simState.simTimeMs;
+        });
+}
+
+TEST(TestAdvertisingController, TestDiscoveryLatencyWithAdvertisingSets) {
+    const u32 clusteringTimeWithRotation = MeasureClusteringTimeWithOtherAdvertisingJobs(1);
+    const u32 clusteringTimeWithSets = MeasureClusteringTimeWithOtherAdvertisingJobs(4);
+
+    //The join_me packet is sent at its own interval instead of waiting for its slots
+    ASSERT_LT(clusteringTimeWithSets, clusteringTimeWithRotation * 9 / 10);
+}
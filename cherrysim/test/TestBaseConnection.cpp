@@ -30,6 +30,8 @@
 #include "gtest/gtest.h"
 #include <CherrySimTester.h>
 #include <CherrySimUtils.h>
+#include <fstream>
+#include <json.hpp>
 
 
 TEST(TestBaseConnection, TestSimpleTransmissions) {
@@ -66,4 +68,324 @@ TEST(TestBaseConnection, TestSimpleTransmissions) {
 
     //We wait until they are connected again
     tester.SimulateUntilClusteringDone(10 * 1000);
-}
\ No newline at end of file
+}
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+struct ReliableTransferResultRecorder : public ReliableTransferListener
+{
+    u32 amountOfResults = 0;
+    ErrorType lastResult = ErrorType::UNKNOWN;
+    virtual void ReliableTransferResultHandler(NodeId receiver, u8 transferId, ErrorType result, u32 userType) override
+    {
+        amountOfResults++;
+        lastResult = result;
+    }
+};
+
+static ErrorType SendReliableComponentSense(NodeId receiver, u8 requestHandle, ReliableTransferListener* listener, u8* transferId = nullptr)
+{
+    //A message that is split into several segments
+    alignas(u32) u8 buffer[SIZEOF_CONN_PACKET_COMPONENT_MESSAGE + 80] = {};
+    ConnPacketComponentMessage* message = (ConnPacketComponentMessage*)buffer;
+    message->componentHeader.header.messageType = MessageType::COMPONENT_SENSE;
+    message->componentHeader.header.sender = 1;
+    message->componentHeader.header.receiver = receiver;
+    message->componentHeader.moduleId = ModuleId::STATUS_REPORTER_MODULE;
+    message->componentHeader.requestHandle = requestHandle;
+    message->componentHeader.registerAddress = 0x1234;
+    for (u32 i = 0; i < 80; i++) message->payload[i] = (u8)i;
+
+    NodeIndexSetter setter(0);
+    return GS->cm.SendMeshMessageReliable(buffer, sizeof(buffer), listener, 0, transferId);
+}
+
+TEST(TestBaseConnection, TestReliableTransfer) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 3 });
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    ReliableTransferResultRecorder recorder;
+
+    //Sent before any connection exists, so that all segments are lost and have to be retransmitted
+    sim_clear_statistics();
+    ASSERT_EQ(SendReliableComponentSense(3, 5, &recorder), ErrorType::SUCCESS);
+    tester.SimulateUntilClusteringDone(100 * 1000);
+    tester.SimulateUntilMessageReceived(60 * 1000, 3, R"("type":"component_sense","module":3,"requestHandle":5,"actionType":0,"component":"0x0000","register":"0x1234")");
+    tester.SimulateForGivenTime(10 * 1000);
+    ASSERT_EQ(recorder.amountOfResults, 1u);
+    ASSERT_EQ(recorder.lastResult, ErrorType::SUCCESS);
+    ASSERT_GT(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED)), 0);
+
+    //Within the mesh, nothing has to be retransmitted
+    sim_clear_statistics();
+    ASSERT_EQ(SendReliableComponentSense(3, 6, &recorder), ErrorType::SUCCESS);
+    tester.SimulateUntilMessageReceived(10 * 1000, 3, R"("type":"component_sense","module":3,"requestHandle":6,"actionType":0,"component":"0x0000","register":"0x1234")");
+    tester.SimulateForGivenTime(10 * 1000);
+    ASSERT_EQ(recorder.amountOfResults, 2u);
+    ASSERT_EQ(recorder.lastResult, ErrorType::SUCCESS);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED)), 0);
+
+    //A receiver that does not exist never acknowledges, the sender gives up after all retries
+    ASSERT_EQ(SendReliableComponentSense(7, 7, &recorder), ErrorType::SUCCESS);
+    tester.SimulateForGivenTime(60 * 1000);
+    ASSERT_EQ(recorder.amountOfResults, 3u);
+    ASSERT_EQ(recorder.lastResult, ErrorType::TIMEOUT);
+    {
+        NodeIndexSetter setter(0);
+        ASSERT_EQ(GS->cm.reliableTransfer.GetAmountOfPendingTransfers(), 0u);
+    }
+}
+
+//The receiver remembers completed transfers for a while, a sender that rebooted in the meantime must not reuse their ids
+TEST(TestBaseConnection, TestReliableTransferAfterReboot) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 3 });
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    ReliableTransferResultRecorder recorder;
+    u8 transferIdBeforeReboot = 0;
+    ASSERT_EQ(SendReliableComponentSense(3, 5, &recorder, &transferIdBeforeReboot), ErrorType::SUCCESS);
+    tester.SimulateUntilMessageReceived(10 * 1000, 3, R"("type":"component_sense","module":3,"requestHandle":5,"actionType":0,"component":"0x0000","register":"0x1234")");
+
+    tester.SendTerminalCommand(1, "reset");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, "reboot");
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    //Node 3 still remembers the transfer from before the reboot
+    u8 transferIdAfterReboot = 0;
+    ASSERT_EQ(SendReliableComponentSense(3, 6, &recorder, &transferIdAfterReboot), ErrorType::SUCCESS);
+    ASSERT_NE(transferIdAfterReboot, transferIdBeforeReboot);
+    tester.SimulateUntilMessageReceived(10 * 1000, 3, R"("type":"component_sense","module":3,"requestHandle":6,"actionType":0,"component":"0x0000","register":"0x1234")");
+}
+#endif //IS_ACTIVE(RELIABLE_TRANSFER)
+
+#ifndef GITHUB_RELEASE
+//Both sinks are one hop away from the mesh node in the middle, the route must follow the link with the better quality
+TEST(TestBaseConnection, TestSinkRouteSelection) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 2 });
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+    simConfig.mapWidthInMeters = 100;
+    simConfig.mapHeightInMeters = 100;
+    simConfig.preDefinedPositions = { {0.29, 0.5}, {0.31, 0.5}, {0.3, 0.5} };
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    //The sinks must not connect to each other so that the mesh node has a route to both of them
+    tester.sim->nodes[0].impossibleConnection.push_back(1);
+    tester.sim->nodes[1].impossibleConnection.push_back(0);
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    u32 routeIndex = 0;
+    {
+        NodeIndexSetter setter(2);
+        MeshConnectionHandle route = GS->cm.GetMeshConnectionToShortestSink(nullptr);
+        ASSERT_TRUE(route);
+        ASSERT_EQ(route.GetHopsToSink(), 1);
+        routeIndex = route.GetPartnerId() - 1;
+    }
+    const u32 otherIndex = 1 - routeIndex;
+
+    //Moving the sink that is currently used far away degrades its link, so that the route has to switch
+    tester.sim->SetPosition(routeIndex, routeIndex == 0 ? 0.05f : 0.55f, 0.5f, 0.0f);
+    tester.SimulateForGivenTime(30 * 1000);
+    {
+        NodeIndexSetter setter(2);
+        MeshConnectionHandle route = GS->cm.GetMeshConnectionToShortestSink(nullptr);
+        ASSERT_TRUE(route);
+        ASSERT_EQ(route.GetPartnerId(), otherIndex + 1);
+    }
+
+    //Packets to the shortest sink must only use the better link
+    const u32 nearSinkPacketsBefore = tester.sim->nodes[2].sentPacketsPerLink[otherIndex];
+    const u32 farSinkPacketsBefore = tester.sim->nodes[2].sentPacketsPerLink[routeIndex];
+    for (u32 i = 0; i < 20; i++)
+    {
+        NodeIndexSetter setter(2);
+        ConnPacketData1 packet;
+        CheckedMemset(&packet, 0, sizeof(packet));
+        packet.header.messageType = MessageType::DATA_1;
+        packet.header.sender = GS->node.configuration.nodeId;
+        packet.header.receiver = NODE_ID_SHORTEST_SINK;
+        GS->cm.SendMeshMessage((u8*)&packet, SIZEOF_CONN_PACKET_DATA_1);
+    }
+    tester.SimulateForGivenTime(10 * 1000);
+
+    ASSERT_GE(tester.sim->nodes[2].sentPacketsPerLink[otherIndex] - nearSinkPacketsBefore, 20u);
+    ASSERT_LT(tester.sim->nodes[2].sentPacketsPerLink[routeIndex] - farSinkPacketsBefore, 5u);
+}
+#endif //GITHUB_RELEASE
+
+#ifndef GITHUB_RELEASE
+static void SendData1ToShortestSink(CherrySimTester& tester, u32 nodeIndex, NodeId sender)
+{
+    NodeIndexSetter setter(nodeIndex);
+    ConnPacketData1 packet;
+    CheckedMemset(&packet, 0, sizeof(packet));
+    packet.header.messageType = MessageType::DATA_1;
+    packet.header.sender = sender;
+    packet.header.receiver = NODE_ID_SHORTEST_SINK;
+    GS->cm.SendMeshMessage((u8*)&packet, SIZEOF_CONN_PACKET_DATA_1);
+}
+
+//The mesh node in the middle has a route to two sinks and must use both of them
+TEST(TestBaseConnection, TestSinkLoadBalancing) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 2 });
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+    simConfig.mapWidthInMeters = 100;
+    simConfig.mapHeightInMeters = 100;
+    simConfig.preDefinedPositions = { {0.29, 0.5}, {0.31, 0.5}, {0.3, 0.5} };
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.sim->nodes[0].impossibleConnection.push_back(1);
+    tester.sim->nodes[1].impossibleConnection.push_back(0);
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        NodeIndexSetter setter(i);
+        GS->config.enableSinkLoadBalancing = true;
+    }
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+    tester.SimulateForGivenTime(10 * 1000);
+
+    //Packets of different senders are spread over both sinks
+    u32 before[] = { tester.sim->nodes[0].gs.cm.receivedSinkPackets, tester.sim->nodes[1].gs.cm.receivedSinkPackets };
+    for (u32 i = 0; i < 40; i++)
+    {
+        SendData1ToShortestSink(tester, 2, (NodeId)(100 + i));
+        tester.SimulateForGivenTime(100);
+    }
+    tester.SimulateForGivenTime(10 * 1000);
+    ASSERT_GE(tester.sim->nodes[0].gs.cm.receivedSinkPackets - before[0], 5u);
+    ASSERT_GE(tester.sim->nodes[1].gs.cm.receivedSinkPackets - before[1], 5u);
+    ASSERT_EQ(tester.sim->nodes[0].gs.cm.receivedSinkPackets - before[0] + tester.sim->nodes[1].gs.cm.receivedSinkPackets - before[1], 40u);
+
+    //All packets of a single sender must take the same route so that their order is kept
+    before[0] = tester.sim->nodes[0].gs.cm.receivedSinkPackets;
+    before[1] = tester.sim->nodes[1].gs.cm.receivedSinkPackets;
+    for (u32 i = 0; i < 20; i++)
+    {
+        SendData1ToShortestSink(tester, 2, 3);
+        tester.SimulateForGivenTime(100);
+    }
+    tester.SimulateForGivenTime(10 * 1000);
+    const u32 receivedBySink0 = tester.sim->nodes[0].gs.cm.receivedSinkPackets - before[0];
+    const u32 receivedBySink1 = tester.sim->nodes[1].gs.cm.receivedSinkPackets - before[1];
+    ASSERT_TRUE((receivedBySink0 == 20 && receivedBySink1 == 0) || (receivedBySink0 == 0 && receivedBySink1 == 20));
+}
+
+//Imports one of the clustering scenarios with the leftmost and the rightmost BLENODE turned into sinks. Each mesh node
+//then sends packets to the shortest sink, which must be spread over both sinks and over the links towards them.
+static void CheckSinkRouteLoadDistribution(const std::string& scenario)
+{
+    std::ifstream devicesIn(CherrySimUtils::GetNormalizedPath() + "/test/res/" + scenario + "/devices.json");
+    const nlohmann::json scenarioDevices = nlohmann::json::parse(devicesIn, nullptr, false, true);
+
+    //Only the BLENODEs take part in the routing, the assets are left out
+    nlohmann::json devices;
+    devices["results"] = nlohmann::json::array();
+    for (const nlohmann::json& device : scenarioDevices["results"])
+    {
+        if (device["platform"] == "BLENODE") devices["results"].push_back(device);
+    }
+    nlohmann::json* leftmost = nullptr;
+    nlohmann::json* rightmost = nullptr;
+    for (nlohmann::json& device : devices["results"])
+    {
+        const double x = device["properties"]["x"].get<double>();
+        if (leftmost == nullptr || x < (*leftmost)["properties"]["x"].get<double>()) leftmost = &device;
+        if (rightmost == nullptr || x > (*rightmost)["properties"]["x"].get<double>()) rightmost = &device;
+    }
+    (*leftmost)["properties"]["cherrySimFeatureSet"] = "prod_sink_nrf52";
+    (*rightmost)["properties"]["cherrySimFeatureSet"] = "prod_sink_nrf52";
+    const std::string devicesPath = scenario + "_two_sinks_devices.json";
+    std::ofstream devicesOut(devicesPath);
+    devicesOut << devices;
+    devicesOut.close();
+
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.importFromJson = true;
+    simConfig.siteJsonPath = CherrySimUtils::GetNormalizedPath() + "/test/res/" + scenario + "/site.json";
+    simConfig.devicesJsonPath = devicesPath;
+    simConfig.terminalId = -1;
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+    tester.SimulateUntilClusteringDone(600 * 1000);
+    tester.SimulateForGivenTime(10 * 1000);
+
+    std::vector<u32> sinkIndices;
+    std::vector<u32> meshIndices;
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        const DeviceType deviceType = tester.sim->nodes[i].featuresetPointers->getDeviceTypePtr();
+        if (deviceType == DeviceType::SINK) sinkIndices.push_back(i);
+        else if (deviceType == DeviceType::STATIC) meshIndices.push_back(i);
+    }
+    ASSERT_EQ(sinkIndices.size(), 2u);
+
+    std::vector<std::map<u32, u32>> linksBefore;
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++) linksBefore.push_back(tester.sim->nodes[i].sentPacketsPerLink);
+    const u32 sinkPacketsBefore[] = { tester.sim->nodes[sinkIndices[0]].gs.cm.receivedSinkPackets, tester.sim->nodes[sinkIndices[1]].gs.cm.receivedSinkPackets };
+
+    constexpr u32 packetsPerNode = 5;
+    for (u32 k = 0; k < packetsPerNode; k++)
+    {
+        for (u32 nodeIndex : meshIndices)
+        {
+            SendData1ToShortestSink(tester, nodeIndex, tester.sim->nodes[nodeIndex].gs.node.configuration.nodeId);
+        }
+        tester.SimulateForGivenTime(1000);
+    }
+    tester.SimulateForGivenTime(10 * 1000);
+
+    //Both sinks get a share of the uplink traffic
+    const u32 sentPackets = packetsPerNode * meshIndices.size();
+    const u32 receivedBySink0 = tester.sim->nodes[sinkIndices[0]].gs.cm.receivedSinkPackets - sinkPacketsBefore[0];
+    const u32 receivedBySink1 = tester.sim->nodes[sinkIndices[1]].gs.cm.receivedSinkPackets - sinkPacketsBefore[1];
+    ASSERT_EQ(receivedBySink0 + receivedBySink1, sentPackets);
+    ASSERT_GE(receivedBySink0, sentPackets / 5);
+    ASSERT_GE(receivedBySink1, sentPackets / 5);
+
+    //No single link carries most of the traffic
+    u32 totalLinkPackets = 0;
+    u32 busiestLinkPackets = 0;
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        for (const auto& link : tester.sim->nodes[i].sentPacketsPerLink)
+        {
+            const u32 packets = link.second - linksBefore[i][link.first];
+            totalLinkPackets += packets;
+            busiestLinkPackets = std::max(busiestLinkPackets, packets);
+        }
+    }
+    ASSERT_LT(busiestLinkPackets, totalLinkPackets / 4);
+}
+
+TEST(TestBaseConnection, TestSinkRouteLoadDistributionStarNetwork) {
+    CheckSinkRouteLoadDistribution("starnetwork");
+}
+
+TEST(TestBaseConnection, TestSinkRouteLoadDistributionDenseNetwork) {
+    CheckSinkRouteLoadDistribution("densenetwork");
+}
+#endif //GITHUB_RELEASE
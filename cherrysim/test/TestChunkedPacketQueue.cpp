@@ -29,6 +29,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "gtest/gtest.h"
 #include <vector>
+#include <deque>
 #include <CherrySimTester.h>
 #include <CherrySimUtils.h>
 #include "ConnectionQueueMemoryAllocator.h"
@@ -225,3 +226,167 @@ TEST(TestChunkedPacketQueue, TestSimpleAllocations)
         }
     }
 }
+
+TEST(TestChunkedPacketQueue, TestRandomAccessPeek)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+    simConfig.SetToPerfectConditions();
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    NodeIndexSetter setter(0);
+    MeshConnections connections = GS->cm.GetMeshConnections(ConnectionDirection::INVALID);
+
+    ASSERT_EQ(connections.count, 1); // With only two nodes, node index 0 should have only one connection after successful clustering.
+
+    // See TestSimpleAllocations, we only care about the ChunkedPacketQueue from here on.
+    MeshConnection* conn = connections.handles[0].GetConnection();
+
+    ChunkedPacketQueue& queue = *conn->queue.GetQueueByPriority(DeliveryPriority::HIGH);
+    queue.SimReset();
+
+    struct Message
+    {
+        size_t size;
+        u8 data[MAX_MESH_PACKET_SIZE];
+    };
+    std::deque<Message> messages;
+    size_t amountOfLookedAheadMessages = 0;
+    MersenneTwister mt(2);
+    // Random adds/pops/lookaheads/rollbacks, after each step every entry is checked via random access.
+    for (int repeat = 0; repeat < 5000; repeat++)
+    {
+        ASSERT_EQ(queue.GetAmountOfPackets(), messages.size());
+        for (size_t i = 0; i < messages.size(); i++)
+        {
+            u8 peekBuffer[1024];
+            u32 messageHandle;
+            ASSERT_EQ(queue.RandomAccessPeek(peekBuffer, sizeof(peekBuffer), i, &messageHandle), messages[i].size);
+            ASSERT_EQ(0, memcmp(peekBuffer, messages[i].data, messages[i].size));
+            ASSERT_EQ(queue.IsRandomAccessIndexLookedAhead(i), i < amountOfLookedAheadMessages);
+        }
+
+        const u32 dice = mt.NextU32();
+        if (dice < 0xFFFFFFFF / 8 * 3 || messages.size() == 0)
+        {
+            // Add, using small messages as well so that many entries share a chunk.
+            Message message;
+            CheckedMemset(&message, 0, sizeof(message));
+            message.size = (mt.NextU32() % 2 == 0) ? (mt.NextU32() % 8 + 1) : (mt.NextU32() % MAX_MESH_PACKET_SIZE + 1);
+            for (size_t i = 0; i < message.size; i++)
+            {
+                message.data[i] = (u8)mt.NextU32();
+            }
+
+            u32 messageHandle;
+            if (queue.AddMessage(message.data, message.size, &messageHandle))
+            {
+                messages.push_back(message);
+            }
+        }
+        else if (dice < 0xFFFFFFFF / 8 * 5)
+        {
+            // Pop
+            queue.PopPacket();
+            messages.pop_front();
+            if (amountOfLookedAheadMessages > 0) amountOfLookedAheadMessages--;
+        }
+        else if (dice < 0xFFFFFFFF / 8 * 7)
+        {
+            // Lookahead
+            if (amountOfLookedAheadMessages < messages.size())
+            {
+                ASSERT_TRUE(queue.HasMoreToLookAhead());
+                queue.IncrementLookAhead();
+                amountOfLookedAheadMessages++;
+            }
+        }
+        else
+        {
+            // Rollback
+            queue.RollbackLookAhead();
+            amountOfLookedAheadMessages = 0;
+        }
+    }
+}
+
+TEST(TestChunkedPacketQueue, TestDiscardExpiredMessages)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+    simConfig.SetToPerfectConditions();
+    //testerConfig.verbose = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    NodeIndexSetter setter(0);
+    MeshConnections connections = GS->cm.GetMeshConnections(ConnectionDirection::INVALID);
+
+    ASSERT_EQ(connections.count, 1);
+
+    // As in TestSimpleAllocations, we grab deeply into the implementation and won't simulate another step.
+    // The app timer is modified directly to age the queued messages.
+    MeshConnection* conn = connections.handles[0].GetConnection();
+
+    ChunkedPacketQueue& queue = *conn->queue.GetQueueByPriority(DeliveryPriority::LOW);
+    queue.SimReset();
+
+    std::array<u8, 128> arr;
+    for (size_t i = 0; i < arr.size(); i++)
+    {
+        arr[i] = i;
+    }
+    u8 readBuffer[1024];
+    u32 messageHandle = 0;
+
+    // A disabled expiry never discards anything.
+    ASSERT_TRUE(queue.AddMessage(arr.data(), 10, &messageHandle));
+    GS->appTimerDs += SEC_TO_DS(1000);
+    ASSERT_EQ(queue.DiscardExpiredMessages(0), 0);
+    ASSERT_EQ(queue.GetAmountOfPackets(), 1);
+
+    // Only messages that reached the maximum age are discarded.
+    ASSERT_TRUE(queue.AddMessage(arr.data(), 20, &messageHandle));
+    GS->appTimerDs += SEC_TO_DS(10);
+    ASSERT_TRUE(queue.AddMessage(arr.data(), 30, &messageHandle));
+    ASSERT_EQ(queue.GetLookAheadAgeSec(), 1010);
+    ASSERT_EQ(queue.DiscardExpiredMessages(10), 2);
+    ASSERT_EQ(queue.GetAmountOfPackets(), 1);
+    ASSERT_EQ(queue.PeekPacket(readBuffer, sizeof(readBuffer)), 30);
+
+    // Messages that were already handed to the HAL are not discarded.
+    queue.IncrementLookAhead();
+    GS->appTimerDs += SEC_TO_DS(10);
+    ASSERT_EQ(queue.DiscardExpiredMessages(10), 0);
+    queue.RollbackLookAhead();
+    ASSERT_EQ(queue.DiscardExpiredMessages(10), 1);
+    ASSERT_FALSE(queue.HasPackets());
+
+    // Split messages are always discarded as a whole and never after some of their splits were sent.
+    ASSERT_TRUE(queue.SplitAndAddMessage(arr.data(), 100, 20, &messageHandle));
+    const u32 amountOfSplits = queue.GetAmountOfPackets();
+    ASSERT_GT(amountOfSplits, 2);
+    ASSERT_TRUE(queue.AddMessage(arr.data(), 10, &messageHandle));
+    GS->appTimerDs += SEC_TO_DS(10);
+    ASSERT_EQ(queue.DiscardExpiredMessages(10), amountOfSplits + 1);
+    ASSERT_FALSE(queue.HasPackets());
+
+    ASSERT_TRUE(queue.SplitAndAddMessage(arr.data(), 100, 20, &messageHandle));
+    queue.IncrementLookAhead();
+    queue.PopPacket();
+    GS->appTimerDs += SEC_TO_DS(10);
+    ASSERT_EQ(queue.DiscardExpiredMessages(10), 0);
+    ASSERT_EQ(queue.GetAmountOfPackets(), amountOfSplits - 1);
+}
@@ -113,6 +113,31 @@ TEST_P(MultiStackFixture, TestBasicClustering) {
     printf("Average clustering time %d seconds" EOL, clusteringTimeTotalMs / clusteringIterations / 1000);
 }
 
+//In a dense network, every node finds enough good candidates quickly, so the clustering decisions are not delayed
+TEST(TestClustering, TestDenseNetworkClusteringTime) {
+    std::vector<u32> clusteringTimesMs;
+    for (u32 i = 0; i < 5; i++) {
+        CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+        SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+        simConfig.seed = i + 1;
+        simConfig.mapWidthInMeters = 10;
+        simConfig.mapHeightInMeters = 10;
+        simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+        simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 29 });
+        simConfig.terminalId = -1;
+        //testerConfig.verbose = true;
+
+        CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+        tester.Start();
+        tester.SimulateUntilClusteringDone(100 * 1000);
+        clusteringTimesMs.push_back(tester.sim->simState.simTimeMs);
+    }
+
+    //The median was 14350 ms with these seeds and 21000 ms when only deciding after Conf::maxTimeUntilDecisionDs
+    std::sort(clusteringTimesMs.begin(), clusteringTimesMs.end());
+    ASSERT_LT(clusteringTimesMs[clusteringTimesMs.size() / 2], 17500u);
+}
+
 #if defined(PROD_SINK_NRF52) && defined(PROD_MESH_NRF52)
 //Tests that the exemplary devices.json and site.json for the github release still work
 TEST_P(MultiStackFixture, TestGithubExample) {
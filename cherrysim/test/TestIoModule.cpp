@@ -365,4 +365,205 @@ TEST(TestIoModule, TestRegisterInToOutLink)
     tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":2,"component":"0x0000","register":"0x4E20","payload":"AQ=="})");
 }
 
+//Configures two AutoSense entries with the same intervals so that their reports are batched into a single message
+TEST(TestIoModule, TestAutoSenseBatchedReports)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    //testerConfig.verbose = true;
+
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52840_sdk17", 2 });
+    simConfig.SetToPerfectConditions();
+    simConfig.enableSimStatistics = true;
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+
+    tester.Start();
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    //Node 2 reports two registers to node 1 at the same interval
+    const u16 registers[] = { IoModule::REGISTER_DIO_OUTPUT_NUM, IoModule::REGISTER_DIO_INPUT_NUM };
+    for (u32 i = 0; i < sizeof(registers) / sizeof(registers[0]); i++)
+    {
+        AutoSenseTableEntryBuilder ast;
+        ast.entry.destNodeId = 1;
+        ast.entry.moduleId = Utility::GetWrappedModuleId(ModuleId::IO_MODULE);
+        ast.entry.component = 0;
+        ast.entry.register_ = registers[i];
+        ast.entry.length = 1;
+        ast.entry.dataType = DataTypeDescriptor::U8_LE;
+        ast.entry.pollingIvDs = 10;
+        ast.entry.reportingIvDs = 10;
+        ast.entry.reportFunction = AutoSenseFunction::LAST;
+        tester.SendTerminalCommand(2, "action this autosense set_autosense_entry 0 %u %s", i, ast.getEntry().data());
+
+        tester.SimulateUntilMessageReceived(10 * 1000, 2, "set_autosense_entry_result");
+    }
+
+    //Both reports must still be printed as separate component_sense messages on the receiver
+    std::vector<SimulationMessage> messages = {
+        SimulationMessage(1, R"({"nodeId":2,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x0064")"),
+        SimulationMessage(1, R"({"nodeId":2,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x0065")"),
+    };
+    tester.SimulateUntilMessagesReceived(10 * 1000, messages);
+
+    //Only count the reports that node 2 sent while both entries were active
+    NodeEntry* sender = tester.sim->FindNodeById(2);
+    for (u32 i = 0; i < PACKET_STAT_SIZE; i++) sender->routedPackets[i] = PacketStat();
+    tester.SimulateForGivenTime(10 * 1000);
+
+    //Both readings must be transmitted together in one BATCHED_SENSE message per interval instead of one message per reading
+    u32 amountOfBatchedSense = 0;
+    u32 amountOfComponentSense = 0;
+    for (u32 i = 0; i < PACKET_STAT_SIZE; i++)
+    {
+        const PacketStat& stat = sender->routedPackets[i];
+        if (stat.messageType == MessageType::COMPONENT_SENSE) amountOfComponentSense += stat.count;
+        if (stat.messageType == MessageType::MODULE_GENERAL
+            && stat.moduleId == Utility::GetWrappedModuleId(ModuleId::AUTO_SENSE_MODULE)
+            && stat.actionType == (u8)AutoSenseModule::AutoSenseModuleGeneralMessages::BATCHED_SENSE)
+        {
+            amountOfBatchedSense += stat.count;
+        }
+    }
+    ASSERT_EQ(amountOfComponentSense, 0);
+    ASSERT_GE(amountOfBatchedSense, 9);
+    ASSERT_LE(amountOfBatchedSense, 11);
+}
+
+//Uses the MAX and THRESHOLD functions of AutoSense on the state of the digital input pins
+TEST(TestIoModule, TestAutoSenseAggregatingFunctions)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    //testerConfig.verbose = true;
+
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52840_sdk17", 1 });
+    simConfig.SetToPerfectConditions();
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+
+    tester.Start();
+
+    //Report the maximum of the first input pin that was polled during each reporting interval
+    AutoSenseTableEntryBuilder maxEntry;
+    maxEntry.entry.destNodeId = 0;
+    maxEntry.entry.moduleId = Utility::GetWrappedModuleId(ModuleId::IO_MODULE);
+    maxEntry.entry.component = 0;
+    maxEntry.entry.register_ = IoModule::REGISTER_DIO_INPUT_STATE_START;
+    maxEntry.entry.length = 1;
+    maxEntry.entry.dataType = DataTypeDescriptor::U8_LE;
+    maxEntry.entry.pollingIvDs = 1;
+    maxEntry.entry.reportingIvDs = 20;
+    maxEntry.entry.reportFunction = AutoSenseFunction::MAX;
+    tester.SendTerminalCommand(1, "action this autosense set_autosense_entry 0 0 %s", maxEntry.getEntry().data());
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("type":"set_autosense_entry_result","nodeId":1,"requestHandle":0,"module":15,"code":0)");
+
+    //Report the second input pin only if it leaves or enters the band [1, 1]
+    AutoSenseTableEntryBuilder thresholdEntry;
+    thresholdEntry.entry.destNodeId = 0;
+    thresholdEntry.entry.moduleId = Utility::GetWrappedModuleId(ModuleId::IO_MODULE);
+    thresholdEntry.entry.component = 0;
+    thresholdEntry.entry.register_ = IoModule::REGISTER_DIO_INPUT_STATE_START + 1;
+    thresholdEntry.entry.length = 1;
+    thresholdEntry.entry.dataType = DataTypeDescriptor::U8_LE;
+    thresholdEntry.entry.pollingIvDs = 1;
+    thresholdEntry.entry.reportingIvDs = 1;
+    thresholdEntry.entry.reportFunction = AutoSenseFunction::THRESHOLD;
+    thresholdEntry.functionParams[0] = 1; //Lower bound
+    thresholdEntry.functionParams[1] = 1; //Upper bound
+    tester.SendTerminalCommand(1, "action this autosense set_autosense_entry 0 1 %s", thresholdEntry.getEntry().data());
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("type":"set_autosense_entry_result","nodeId":1,"requestHandle":0,"module":15,"code":0)");
+
+    //The first value of the threshold entry is always reported
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x7531","payload":"AA==")");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x7530","payload":"AA==")");
+
+    //A short pulse of the first input must be visible in the next report, even though the pin is low again when reporting
+    tester.sim->nodes[0].gpioInitializedPins.at(102).currentState = true;
+    tester.SimulateForGivenTime(500);
+    tester.sim->nodes[0].gpioInitializedPins.at(102).currentState = false;
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x7530","payload":"AQ==")");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x7530","payload":"AA==")");
+
+    //The threshold entry reports entering and leaving the band
+    tester.sim->nodes[0].gpioInitializedPins.at(103).currentState = true;
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x7531","payload":"AQ==")");
+    tester.sim->nodes[0].gpioInitializedPins.at(103).currentState = false;
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":6,"requestHandle":0,"actionType":0,"component":"0x0000","register":"0x7531","payload":"AA==")");
+}
+
+//AutoAct pipelines are compiled when the entry is set, invalid pipelines must be rejected before they are stored
+TEST(TestIoModule, TestAutoActRejectsInvalidPipelines)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    //testerConfig.verbose = true;
+
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52840_sdk17", 1 });
+    simConfig.SetToPerfectConditions();
+
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+
+    tester.Start();
+
+    AutoActTableEntryBuilder aat;
+    aat.entry.receiverNodeIdFilter = 0;
+    aat.entry.moduleIdFilter = Utility::GetWrappedModuleId(ModuleId::IO_MODULE);
+    aat.entry.componentFilter = 0;
+    aat.entry.registerFilter = IoModule::REGISTER_DIO_TOGGLE_PAIR_START;
+    aat.entry.targetModuleId = Utility::GetWrappedModuleId(ModuleId::IO_MODULE);
+    aat.entry.targetComponent = 0;
+    aat.entry.targetRegister = IoModule::REGISTER_DIO_OUTPUT_STATE_START;
+    aat.entry.orgDataType = DataTypeDescriptor::U8_LE;
+    aat.entry.targetDataType = DataTypeDescriptor::U8_LE;
+
+    //The length of a pipeline is only limited by the size of the function list
+    for (u32 i = 0; i < 8; i++)
+    {
+        aat.addFunctionNoop();
+        aat.addFunctionMin(0);
+    }
+    tester.SendTerminalCommand(1, "action this autoact set_autoact_entry 0 0 %s", aat.getEntry().data());
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("type":"set_autoact_entry_result","nodeId":1,"requestHandle":0,"module":%u,"code":0)", (u32)ModuleId::AUTO_ACT_MODULE);
+
+    //Functions that are not valid for numeric pipelines must be rejected
+    aat.addFunctionReverseBytes();
+    {
+        Exceptions::ExceptionDisabler<IllegalStateException> ise;
+        tester.SendTerminalCommand(1, "action this autoact set_autoact_entry 0 1 %s", aat.getEntry().data());
+        tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("type":"set_autoact_entry_result","nodeId":1,"requestHandle":0,"module":%u,"code":%u)", (u32)ModuleId::AUTO_ACT_MODULE, (u32)AutoActModuleResponseCode::INVALID_FUNCTION);
+    }
+
+    //String pipelines can only reverse the bytes, a NO_OP fails to apply just like before pipelines were compiled
+    aat.clearFunctions();
+    aat.entry.orgDataType = DataTypeDescriptor::RAW;
+    aat.entry.targetDataType = DataTypeDescriptor::RAW;
+    aat.addFunctionNoop();
+    {
+        Exceptions::ExceptionDisabler<TransformationFailedException> tfe;
+        tester.SendTerminalCommand(1, "action this autoact set_autoact_entry 0 1 %s", aat.getEntry().data());
+        tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("type":"set_autoact_entry_result","nodeId":1,"requestHandle":0,"module":%u,"code":%u)", (u32)ModuleId::AUTO_ACT_MODULE, (u32)AutoActModuleResponseCode::FAILED_TO_APPLY_TRANSFORMATION);
+    }
+
+    //A data offset that leaves no room for the input value, even for the largest input, fails the dry run
+    aat.clearFunctions();
+    aat.entry.orgDataType = DataTypeDescriptor::U32_LE;
+    aat.entry.targetDataType = DataTypeDescriptor::U32_LE;
+    aat.addFunctionDataOffset(AutoActModule::MAX_IO_SIZE - 2);
+    {
+        Exceptions::ExceptionDisabler<IllegalStateException> ise;
+        tester.SendTerminalCommand(1, "action this autoact set_autoact_entry 0 1 %s", aat.getEntry().data());
+        tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("type":"set_autoact_entry_result","nodeId":1,"requestHandle":0,"module":%u,"code":%u)", (u32)ModuleId::AUTO_ACT_MODULE, (u32)AutoActModuleResponseCode::INPUT_TOO_SMALL);
+    }
+
+    //The rejected entries must not have been stored
+    {
+        NodeIndexSetter setter(0);
+        AutoActModule* mod = (AutoActModule*)GS->node.GetModuleById(ModuleId::AUTO_ACT_MODULE);
+        ASSERT_TRUE(mod->programs[0].valid);
+        ASSERT_FALSE(mod->programs[1].valid);
+    }
+}
+
 #endif //defined(PROD_MESH_NRF52840_SDK17)
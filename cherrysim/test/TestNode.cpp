@@ -650,6 +650,165 @@ TEST(TestNode, TestDiscoveryStates) {
     }
 }
 
+static void ReceiveJoinMe(NodeId sender, i8 rssi)
+{
+    ble_evt_t bleEvent;
+    CheckedMemset(&bleEvent, 0, sizeof(bleEvent));
+    bleEvent.header.evt_id = BLE_GAP_EVT_ADV_REPORT;
+    bleEvent.evt.gap_evt.conn_handle = BLE_CONN_HANDLE_INVALID;
+    bleEvent.evt.gap_evt.params.adv_report.rssi = rssi;
+    bleEvent.evt.gap_evt.params.adv_report.type = (u8)FruityHal::BleGapAdvType::ADV_IND;
+    bleEvent.evt.gap_evt.params.adv_report.dlen = SIZEOF_ADV_PACKET_JOIN_ME;
+
+    AdvPacketJoinMeV0* packet = (AdvPacketJoinMeV0*)bleEvent.evt.gap_evt.params.adv_report.data;
+    packet->header.networkId = GS->node.configuration.networkId;
+    packet->header.messageType = ManufacturerSpecificMessageType::JOIN_ME_V0;
+    packet->payload.sender = sender;
+    packet->payload.clusterId = sender;
+    packet->payload.clusterSize = 1;
+    packet->payload.freeMeshInConnections = 1;
+    packet->payload.freeMeshOutConnections = 3;
+
+    GS->node.GapAdvertisementMessageHandler(FruityHal::GapAdvertisementReportEvent(&bleEvent));
+}
+
+static u32 CountJoinMePackets(NodeId firstSender, NodeId lastSender)
+{
+    u32 count = 0;
+    for (const joinMeBufferPacket& packet : GS->node.joinMePackets)
+    {
+        if (packet.payload.sender >= firstSender && packet.payload.sender <= lastSender) count++;
+    }
+    return count;
+}
+
+TEST(TestNode, TestJoinMeBufferKeepsBestCandidates) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+    //testerConfig.verbose = true;
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+    tester.SimulateForGivenTime(1000);
+
+    NodeIndexSetter setter(0);
+    const u32 bufferSize = GS->node.joinMePackets.size();
+
+    //Fill the buffer with weak candidates
+    for (u32 i = 0; i < bufferSize; i++) ReceiveJoinMe((NodeId)(100 + i), -80);
+    ASSERT_EQ(CountJoinMePackets(100, 199), bufferSize);
+
+    //Updates of a sender use its slot
+    ReceiveJoinMe(100, -80);
+    ASSERT_EQ(CountJoinMePackets(100, 100), 1u);
+
+    //Better candidates replace the weak ones
+    for (u32 i = 0; i < bufferSize; i++) ReceiveJoinMe((NodeId)(200 + i), -50);
+    ASSERT_EQ(CountJoinMePackets(100, 199), 0u);
+    ASSERT_EQ(CountJoinMePackets(200, 299), bufferSize);
+
+    //A weaker candidate is dropped if the buffer only holds better ones
+    ReceiveJoinMe(300, -80);
+    ASSERT_EQ(CountJoinMePackets(300, 300), 0u);
+    ASSERT_EQ(CountJoinMePackets(200, 299), bufferSize);
+}
+
+struct RadioUsage
+{
+    uint64_t advertisingAirtimeUs = 0;
+    uint64_t scanningTimeUs = 0;
+    uint64_t nanoAmperePerMsTotal = 0;
+
+    RadioUsage operator-(const RadioUsage& other) const
+    {
+        return { advertisingAirtimeUs - other.advertisingAirtimeUs, scanningTimeUs - other.scanningTimeUs, nanoAmperePerMsTotal - other.nanoAmperePerMsTotal };
+    }
+};
+
+//Measures the radio usage of a clustered mesh over a few minutes once it is stable
+static RadioUsage MeasureStableMeshRadioUsage(bool enableAdaptiveDiscovery)
+{
+    return MeasureSimulation(
+        [](SimConfiguration& simConfig) {
+            simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+            simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 9 });
+            //The join me packets get their own advertising set so that their interval is not hidden by other advertising jobs
+            simConfig.numAdvertisingSets = 4;
+        },
+        [&](CherrySimTester& tester) {
+            for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+            {
+                NodeIndexSetter setter(i);
+                GS->config.enableAdaptiveDiscovery = enableAdaptiveDiscovery;
+            }
+            tester.SimulateUntilClusteringDone(100 * 1000);
+            tester.SimulateForGivenTime(2 * 60 * 1000);
+        },
+        [](CherrySimTester& tester) {
+            tester.SimulateForGivenTime(2 * 60 * 1000);
+        },
+        [](CherrySimTester& tester) {
+            RadioUsage usage;
+            for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+            {
+                usage.advertisingAirtimeUs += tester.sim->nodes[i].advertisingAirtimeUs;
+                usage.scanningTimeUs += tester.sim->nodes[i].scanningTimeUs;
+                usage.nanoAmperePerMsTotal += tester.sim->nodes[i].nanoAmperePerMsTotal;
+            }
+            return usage;
+        });
+}
+
+TEST(TestNode, TestAdaptiveDiscoverySavesAirtimeAndEnergy) {
+    const RadioUsage fixedUsage = MeasureStableMeshRadioUsage(false);
+    const RadioUsage adaptiveUsage = MeasureStableMeshRadioUsage(true);
+
+    ASSERT_LT(adaptiveUsage.advertisingAirtimeUs, fixedUsage.advertisingAirtimeUs * 3 / 4);
+    ASSERT_LT(adaptiveUsage.scanningTimeUs, fixedUsage.scanningTimeUs / 4);
+    ASSERT_LT(adaptiveUsage.nanoAmperePerMsTotal, fixedUsage.nanoAmperePerMsTotal * 4 / 5);
+}
+
+TEST(TestNode, TestAdaptiveDiscoveryResetsOnTopologyChange) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 4 });
+    //testerConfig.verbose = true;
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        NodeIndexSetter setter(i);
+        GS->config.enableAdaptiveDiscovery = true;
+    }
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    //Every stable period slows down the discovery by one more step
+    tester.SimulateUntilMessageReceived(60 * 1000, 1, "Discovery backoff level 1");
+    tester.SimulateUntilMessageReceived(60 * 1000, 1, "Discovery backoff level 2");
+    tester.SimulateForGivenTime(3 * Conf::adaptiveDiscoveryStepDelaySec * 1000);
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        ASSERT_EQ(tester.sim->nodes[i].gs.node.discoveryBackoffLevel, 4);
+        ASSERT_GT(MSEC_TO_UNITS(tester.sim->nodes[i].state.scanIntervalMs, CONFIG_UNIT_0_625_MS), tester.sim->nodes[i].gs.config.meshScanIntervalHigh);
+    }
+
+    //A cluster that is too far away to connect to does not speed up the discovery
+    {
+        NodeIndexSetter setter(0);
+        ReceiveJoinMe(300, STABLE_CONNECTION_RSSI_THRESHOLD - 10);
+    }
+    ASSERT_EQ(tester.sim->nodes[0].gs.node.discoveryBackoffLevel, 4);
+
+    //Losing a node changes the cluster size, so the whole mesh discovers quickly again
+    tester.SendTerminalCommand(5, "reset");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, "Discovery backoff reset");
+    ASSERT_EQ(tester.sim->nodes[0].gs.node.discoveryBackoffLevel, 0);
+    ASSERT_EQ(MSEC_TO_UNITS(tester.sim->nodes[0].state.scanIntervalMs, CONFIG_UNIT_0_625_MS), tester.sim->nodes[0].gs.config.meshScanIntervalHigh);
+}
+
 //Could be enabled again after this ticket BR-572
 TEST(TestNode, DISABLED_TestDiscoverySettingEnrolled) {
     CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
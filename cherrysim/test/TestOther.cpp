@@ -64,11 +64,206 @@ TEST(TestOther, BatteryTest)
 
     //Log the battery usage
     for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++) {
-        u32 usageMicroAmpere = tester.sim->nodes[i].nanoAmperePerMsTotal / tester.sim->simState.simTimeMs;
+        u32 usageMicroAmpere = (u32)(tester.sim->nodes[i].nanoAmperePerMsTotal / tester.sim->simState.simTimeMs);
         printf("Average Battery usage for node %d was %u uA" EOL, tester.sim->nodes[i].GetNodeId(), usageMicroAmpere);
     }
 }
 
+TEST(TestOther, TestEnergyModel)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1});
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 9});
+    simConfig.batteryCapacityMah = 230;
+    //A single value of a profile can be overridden, e.g. for a board with a brighter LED
+    nlohmann::json::parse(R"({"energyProfileNrf52832": {"ledCurrentUa": 12000}})").get_to(simConfig);
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+    tester.SimulateForGivenTime(10 * 1000);
+
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++) {
+        const NodeEntry& node = tester.sim->nodes[i];
+        ASSERT_EQ(node.energyProfile.radioTxCurrentUa, EnergyProfile::Nrf52832().radioTxCurrentUa);
+        ASSERT_GT(node.energyUsage.idle, 0u);
+        ASSERT_GT(node.energyUsage.advertising, 0u);
+        ASSERT_GT(node.energyUsage.scanning, 0u);
+        ASSERT_GT(node.energyUsage.connectionEvents, 0u);
+        ASSERT_GT(node.energyUsage.connectionData, 0u);
+        ASSERT_EQ(node.nanoAmperePerMsTotal, node.energyUsage.GetTotal() / 1000);
+
+        //The battery life is the capacity divided by the average current
+        const u32 averageCurrentUa = tester.sim->GetAverageCurrentUa(i);
+        ASSERT_GT(averageCurrentUa, 0u);
+        ASSERT_NEAR(tester.sim->GetProjectedBatteryLifeHours(i), 230 * 1000 / averageCurrentUa, 230 * 1000 / averageCurrentUa / 20 + 1);
+    }
+
+    //Flash operations are accounted for when they happen
+    const uint64_t flashBefore = tester.sim->nodes[0].energyUsage.flash;
+    tester.SendTerminalCommand(1, "saverec 13 DE:AD:BE:EF");
+    tester.SimulateGivenNumberOfSteps(10);
+    ASSERT_GT(tester.sim->nodes[0].energyUsage.flash, flashBefore);
+
+    //An LED that is switched on permanently draws its current for the whole time
+    tester.SendTerminalCommand(1, "action this io led on");
+    tester.SimulateForGivenTime(1000);
+    const uint64_t ledBefore = tester.sim->nodes[0].energyUsage.led;
+    const uint64_t idleBefore = tester.sim->nodes[0].energyUsage.idle;
+    tester.SimulateForGivenTime(10 * 1000);
+    ASSERT_EQ(tester.sim->nodes[0].energyProfile.ledCurrentUa, 12000u);
+    ASSERT_GE(tester.sim->nodes[0].energyUsage.led - ledBefore, (uint64_t)10 * 1000 * 1000 * 12000);
+    ASSERT_EQ(tester.sim->nodes[0].energyUsage.idle - idleBefore, (uint64_t)10 * 1000 * 1000 * EnergyProfile::Nrf52832().idleCurrentNa / 1000);
+
+    tester.sim->PrintEnergyUsage(0);
+}
+
+TEST(TestOther, TestStackWatcherHandlerUsage)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1});
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 4});
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+    tester.SendTerminalCommand(1, "status");
+    tester.SimulateGivenNumberOfSteps(10);
+
+    const std::vector<HandlerStackUsage> topHandlers = StackWatcher::GetTopHandlers(1000);
+    ASSERT_FALSE(topHandlers.empty());
+
+    bool timerEventHandlerFound = false;
+    bool terminalCommandHandlerFound = false;
+    bool bleEventFound = false;
+    for (u32 i = 0; i < topHandlers.size(); i++)
+    {
+        const HandlerStackUsage& usage = topHandlers[i];
+        if (i > 0)
+        {
+            ASSERT_LE(usage.peakStackBytes, topHandlers[i - 1].peakStackBytes);
+        }
+        ASSERT_GT(usage.peakStackBytes, 0u);
+        ASSERT_GT(usage.numCalls, 0u);
+
+        if (usage.moduleName == nullptr)
+        {
+            ASSERT_STREQ(usage.handlerName, "BleEvent");
+            bleEventFound = true;
+        }
+        else if (strcmp(usage.handlerName, "TimerEventHandler") == 0 && strcmp(usage.moduleName, "node") == 0)
+        {
+            //The handlers of all nodes are counted together
+            ASSERT_GT(usage.numCalls, 5u);
+            timerEventHandlerFound = true;
+        }
+        else if (strcmp(usage.handlerName, "TerminalCommandHandler") == 0)
+        {
+            terminalCommandHandlerFound = true;
+        }
+    }
+    ASSERT_TRUE(timerEventHandlerFound);
+    ASSERT_TRUE(terminalCommandHandlerFound);
+    ASSERT_TRUE(bleEventFound);
+
+    ASSERT_EQ(StackWatcher::GetTopHandlers(3).size(), 3u);
+
+    tester.SendTerminalCommand(1, "sim stackstat");
+    tester.SimulateGivenNumberOfSteps(1);
+
+    tester.SendTerminalCommand(1, "sim stackstat reset");
+    tester.SimulateGivenNumberOfSteps(1);
+    for (const HandlerStackUsage& usage : StackWatcher::GetTopHandlers(1000))
+    {
+        ASSERT_STRNE(usage.handlerName, "TerminalCommandHandler");
+    }
+}
+
+TEST(TestOther, TestPacketTrace)
+{
+    const char* testFilePath = "TestPacketTrace.pcap";
+    remove(testFilePath);
+
+    u32 numTracedEvents = 0;
+    {
+        CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+        SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+        simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1});
+        simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 3});
+        simConfig.packetTraceFile = testFilePath;
+        CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+        tester.Start();
+
+        tester.SimulateUntilClusteringDone(100 * 1000);
+        //Sends a message that is too big for a single packet
+        tester.SendTerminalCommand(1, "datal");
+        tester.SimulateGivenNumberOfSteps(100);
+
+        //Stopping the trace closes the file, so that no more events are written
+        tester.SendTerminalCommand(1, "sim trace stop");
+        tester.SimulateGivenNumberOfSteps(1);
+        numTracedEvents = tester.sim->GetNumPacketTraceEvents();
+        ASSERT_GT(numTracedEvents, 0u);
+        tester.SendTerminalCommand(1, "action 4 status get_device_info");
+        tester.SimulateUntilMessageReceived(10 * 1000, 1, "{\"nodeId\":4,\"type\":\"device_info\"");
+        ASSERT_EQ(tester.sim->GetNumPacketTraceEvents(), numTracedEvents);
+    }
+
+    std::ifstream file(testFilePath, std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    std::vector<u8> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    remove(testFilePath);
+
+    //pcap global header followed by a record header of 16 bytes for each event
+    ASSERT_EQ(content.size(), 24 + numTracedEvents * (16 + sizeof(PacketTraceRecord)));
+    u32 magicNumber = 0;
+    u32 linkType = 0;
+    CheckedMemcpy(&magicNumber, content.data(), sizeof(magicNumber));
+    CheckedMemcpy(&linkType, content.data() + 20, sizeof(linkType));
+    ASSERT_EQ(magicNumber, 0xA1B2C3D4);
+    ASSERT_EQ(linkType, 147u);
+
+    std::array<u32, 6> eventCounts = {};
+    u32 lastTimestampSec = 0;
+    for (size_t offset = 24; offset < content.size(); offset += 16 + sizeof(PacketTraceRecord))
+    {
+        u32 timestampSec = 0;
+        CheckedMemcpy(&timestampSec, content.data() + offset, sizeof(timestampSec));
+        ASSERT_GE(timestampSec, lastTimestampSec);
+        lastTimestampSec = timestampSec;
+
+        PacketTraceRecord record = {};
+        CheckedMemcpy(&record, content.data() + offset + 16, sizeof(record));
+        ASSERT_LT((u32)record.eventType, eventCounts.size());
+        eventCounts[(u32)record.eventType]++;
+
+        ASSERT_GE(record.nodeId, 1);
+        ASSERT_LE(record.nodeId, 4);
+        ASSERT_NE(record.nodeId, record.partnerId);
+        if (record.eventType == PacketTraceEventType::TX || record.eventType == PacketTraceEventType::SPLIT)
+        {
+            ASSERT_LT((u32)record.priority, AMOUNT_OF_SEND_QUEUE_PRIORITIES);
+        }
+        if (record.eventType == PacketTraceEventType::SPLIT || record.eventType == PacketTraceEventType::REASSEMBLE)
+        {
+            //Split events carry the header of the whole message
+            ASSERT_NE(record.messageType, MessageType::SPLIT_WRITE_CMD);
+            ASSERT_NE(record.messageType, MessageType::SPLIT_WRITE_CMD_END);
+            ASSERT_NE(record.sender, 0);
+        }
+    }
+
+    ASSERT_GT(eventCounts[(u32)PacketTraceEventType::TX], 0u);
+    ASSERT_GT(eventCounts[(u32)PacketTraceEventType::RX], 0u);
+    ASSERT_GT(eventCounts[(u32)PacketTraceEventType::SPLIT], 0u);
+    ASSERT_GT(eventCounts[(u32)PacketTraceEventType::REASSEMBLE], 0u);
+    //Every packet that was received must have been sent
+    ASSERT_LE(eventCounts[(u32)PacketTraceEventType::RX], eventCounts[(u32)PacketTraceEventType::TX]);
+}
+
 TEST(TestOther, TestSimpleQueue)
 {
     SimpleQueue<u32, 4> queue;
@@ -376,11 +571,25 @@ TEST(TestOther, TestJsonConfigSerialization)
     simConfig->enableSimStatistics = true;
     new (&simConfig->storeFlashToFile) std::string;
     simConfig->storeFlashToFile = "eee";
+    new (&simConfig->packetTraceFile) std::string;
+    simConfig->packetTraceFile = "fff";
     simConfig->floorBiasInMeters = 1.2f;
     simConfig->ceilingHeightInMeters = 3.1f;
     simConfig->ceilingAttenuationDb = 4.5f;
     simConfig->perfectReceptionProbabilityForAdvertising = true;
     simConfig->perfectReceptionProbabilityForConnection = true;
+    simConfig->simulateConnectionEvents = true;
+    simConfig->connectionPhyMbps = 2;
+    simConfig->connectionMaxDataLength = 27;
+    simConfig->simulateAdvertisingCollisions = true;
+    simConfig->advertisingCaptureThresholdDb = 3.5f;
+    simConfig->numAdvertisingSets = 3;
+    simConfig->maxClockDriftPpm = 40;
+    simConfig->batteryCapacityMah = 230;
+    simConfig->energyProfileNrf52832 = EnergyProfile::Nrf52832();
+    simConfig->energyProfileNrf52832.ledCurrentUa = 2000;
+    simConfig->energyProfileNrf52840 = EnergyProfile::Nrf52840();
+    simConfig->energyProfileNrf52840.idleCurrentNa = 1500;
     simConfig->verboseCommands = true;
     simConfig->simulateAdvertisingIndexStep = 32;
 
@@ -404,6 +613,7 @@ TEST(TestOther, TestJsonConfigSerialization)
             || IsInSTLRange(preDefinedPositions)
             || IsInSTLRange(nodeConfigName)
             || IsInSTLRange(storeFlashToFile)
+            || IsInSTLRange(packetTraceFile)
             || IsInSTLRange(floorplanImage)) continue;
 #undef IsInSTLRange
         ASSERT_NE(memoryArea[i], garbageMagicNumber);
@@ -457,11 +667,24 @@ TEST(TestOther, TestJsonConfigSerialization)
     ASSERT_EQ(copy.enableClusteringValidityCheck, true);
     ASSERT_EQ(copy.enableSimStatistics, true);
     ASSERT_EQ(copy.storeFlashToFile, "eee");
+    ASSERT_EQ(copy.packetTraceFile, "fff");
     ASSERT_NEAR(copy.floorBiasInMeters, 1.2f, 0.01f);
     ASSERT_NEAR(copy.ceilingHeightInMeters, 3.1f, 0.01f);
     ASSERT_NEAR(copy.ceilingAttenuationDb, 4.5f, 0.01f);
     ASSERT_EQ(copy.perfectReceptionProbabilityForAdvertising, true);
     ASSERT_EQ(copy.perfectReceptionProbabilityForConnection, true);
+    ASSERT_EQ(copy.simulateConnectionEvents, true);
+    ASSERT_EQ(copy.connectionPhyMbps, 2);
+    ASSERT_EQ(copy.connectionMaxDataLength, 27);
+    ASSERT_EQ(copy.simulateAdvertisingCollisions, true);
+    ASSERT_NEAR(copy.advertisingCaptureThresholdDb, 3.5f, 0.01f);
+    ASSERT_EQ(copy.numAdvertisingSets, 3);
+    ASSERT_EQ(copy.maxClockDriftPpm, 40);
+    ASSERT_EQ(copy.batteryCapacityMah, 230);
+    ASSERT_EQ(copy.energyProfileNrf52832.ledCurrentUa, 2000);
+    ASSERT_EQ(copy.energyProfileNrf52832.radioTxCurrentUa, EnergyProfile::Nrf52832().radioTxCurrentUa);
+    ASSERT_EQ(copy.energyProfileNrf52840.idleCurrentNa, 1500);
+    ASSERT_EQ(copy.energyProfileNrf52840.connectionEventCpuTimeUs, EnergyProfile::Nrf52840().connectionEventCpuTimeUs);
     ASSERT_EQ(copy.verboseCommands, true);
     ASSERT_EQ(copy.simulateAdvertisingIndexStep, 32);
 
@@ -473,6 +696,7 @@ TEST(TestOther, TestJsonConfigSerialization)
     ASSERT_EQ(copy.socketServerPort, 4567);
 
     simConfig->storeFlashToFile.~basic_string();
+    simConfig->packetTraceFile.~basic_string();
     simConfig->nodeConfigName.~map();
     simConfig->preDefinedPositions.~vector();
     simConfig->devicesJsonPath.~basic_string();
@@ -914,7 +1138,7 @@ TEST(TestOther, TestBulkMode) {
 
     tester.SimulateForGivenTime(10 * 1000); //Simulate a little to calculate battery usage.
 
-    u32 usageMicroAmpere = tester.sim->nodes[0].nanoAmperePerMsTotal / tester.sim->simState.simTimeMs;
+    u32 usageMicroAmpere = (u32)(tester.sim->nodes[0].nanoAmperePerMsTotal / tester.sim->simState.simTimeMs);
     if (usageMicroAmpere > 100)
     {
         FAIL() << "Bulk Mode should consume very low energy, but consumed: " << usageMicroAmpere;
@@ -1586,6 +1810,126 @@ TEST(TestOther, TestThroughput) {
     }
 }
 
+//Returns the amount of packets that were sent over the connection within 5 seconds while the sender was saturated
+static u32 MeasureConnectionEventThroughput(u32 phyMbps, u32 maxDataLength, u32 distanceInMeters)
+{
+    constexpr u32 simTickDurationMs = 15;
+    return MeasureSimulation(
+        [&](SimConfiguration& simConfig) {
+            simConfig.SetToPerfectConditions();
+            //Packets on the connection can be lost depending on the rssi
+            const SimConfiguration defaultConfig;
+            simConfig.perfectReceptionProbabilityForConnection = false;
+            simConfig.receptionProbabilityVeryClose = defaultConfig.receptionProbabilityVeryClose;
+            simConfig.receptionProbabilityClose = defaultConfig.receptionProbabilityClose;
+            simConfig.receptionProbabilityFar = defaultConfig.receptionProbabilityFar;
+            simConfig.receptionProbabilityVeryFar = defaultConfig.receptionProbabilityVeryFar;
+            simConfig.simTickDurationMs = simTickDurationMs;
+            simConfig.simulateConnectionEvents = true;
+            simConfig.connectionPhyMbps = phyMbps;
+            simConfig.connectionMaxDataLength = maxDataLength;
+            simConfig.mapWidthInMeters = 100;
+            simConfig.mapHeightInMeters = 100;
+            simConfig.preDefinedPositions = { {0.5, 0.5}, {0.5 + distanceInMeters / 100.0, 0.5} };
+            simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+            simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1 });
+        },
+        [](CherrySimTester& tester) {
+            tester.SimulateUntilClusteringDone(50 * 1000);
+        },
+        [&](CherrySimTester& tester) {
+            //The queue of the sender is kept filled so that the connection is the bottleneck
+            for (u32 time = 0; time < 5000; time += simTickDurationMs)
+            {
+                {
+                    NodeIndexSetter setter(0);
+                    while (GS->cm.GetPendingPackets() < 20)
+                    {
+                        u8 buffer[60] = {};
+                        ConnPacketHeader* header = (ConnPacketHeader*)buffer;
+                        header->messageType = MessageType::DATA_1;
+                        header->sender = GS->node.configuration.nodeId;
+                        header->receiver = 2;
+                        GS->cm.SendMeshMessage(buffer, sizeof(buffer));
+                    }
+                }
+                tester.SimulateForGivenTime(simTickDurationMs);
+            }
+        },
+        [](CherrySimTester& tester) {
+            return tester.sim->nodes[0].sentPacketsPerLink[1];
+        });
+}
+
+TEST(TestOther, TestConnectionEventThroughput) {
+    const u32 sent = MeasureConnectionEventThroughput(1, 251, 1);
+    const u32 sent2M = MeasureConnectionEventThroughput(2, 251, 1);
+    const u32 sentWithoutDle = MeasureConnectionEventThroughput(1, 27, 1);
+    const u32 sentFar = MeasureConnectionEventThroughput(1, 251, 30);
+
+    //Each packet needs 67 bytes of link layer payload, only three of them fit into the event length of 3.75 ms
+    //on the 1 Mbit PHY and the connection interval is 15 ms. Most events are used up to that limit.
+    ASSERT_LE(sent, 5000 / 15 * 3);
+    ASSERT_GE(sent, 5000 / 15 * 2);
+    //The 2 Mbit PHY fits more packets into an event
+    ASSERT_GT(sent2M, sent * 5 / 4);
+    //Without data length extension, each packet is split into several fragments
+    ASSERT_LT(sentWithoutDle, sent * 2 / 3);
+    //At a larger distance, many packets have to be retransmitted
+    ASSERT_LT(sentFar, sent / 2);
+}
+
+struct AdvertisingReception
+{
+    u32 reports = 0;
+    u32 collisions = 0;
+
+    AdvertisingReception operator-(const AdvertisingReception& other) const
+    {
+        return { reports - other.reports, collisions - other.collisions };
+    }
+};
+
+//Returns the advertising reports that the nodes received and the collisions during the first seconds of clustering
+static AdvertisingReception MeasureAdvertisingReceptionInDenseCluster(bool simulateAdvertisingCollisions)
+{
+    return MeasureSimulation(
+        [&](SimConfiguration& simConfig) {
+            simConfig.SetToPerfectConditions();
+            //Both models should take the scan window of the receiver into account
+            simConfig.perfectReceptionProbabilityForAdvertising = false;
+            simConfig.simulateAdvertisingCollisions = simulateAdvertisingCollisions;
+            simConfig.mapWidthInMeters = 10;
+            simConfig.mapHeightInMeters = 10;
+            simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1 });
+            simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 39 });
+        },
+        [](CherrySimTester&) {
+            sim_clear_statistics();
+        },
+        [](CherrySimTester& tester) {
+            tester.SimulateForGivenTime(3 * 1000);
+        },
+        [](CherrySimTester&) {
+            return AdvertisingReception{ sim_get_statistics("advertisingReports"), sim_get_statistics("advertisingCollisions") };
+        });
+}
+
+TEST(TestOther, TestAdvertisingCollisions) {
+    const AdvertisingReception withoutModel = MeasureAdvertisingReceptionInDenseCluster(false);
+    const AdvertisingReception withModel = MeasureAdvertisingReceptionInDenseCluster(true);
+    ASSERT_EQ(withoutModel.collisions, 0u);
+    ASSERT_GT(withModel.collisions, 0u);
+    //Collisions cost a noticeable share of the reports in a dense cluster, but most advertising still gets through
+    ASSERT_LT(withModel.reports, withoutModel.reports * 9 / 10);
+    ASSERT_GT(withModel.reports, withoutModel.reports / 2);
+
+    //The model only uses the seeded random number generator
+    const AdvertisingReception withModelRepeated = MeasureAdvertisingReceptionInDenseCluster(true);
+    ASSERT_EQ(withModelRepeated.reports, withModel.reports);
+    ASSERT_EQ(withModelRepeated.collisions, withModel.collisions);
+}
+
 TEST(TestOther, TestNodeEntryFloorNumberComputation)
 {
     CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
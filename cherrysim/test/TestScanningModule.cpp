@@ -70,4 +70,137 @@ TEST(TestScanningModule, TestCommands) {
     tester.SimulateGivenNumberOfSteps(1);
 
     //jstodo This test currently doesn't do much. Investigate if it is still needed.
-}
\ No newline at end of file
+}
+#ifndef GITHUB_RELEASE
+//Three nodes hear the same asset with a different rssi, only the report of the strongest one must reach the sink
+TEST(TestScanningModule, TestTrackedAssetDeduplication) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.terminalId = 0;
+    //testerConfig.verbose = true;
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1});
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 3});
+    simConfig.SetToPerfectConditions();
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        NodeIndexSetter setter(i);
+        ScanningModule* mod = (ScanningModule*)GS->node.GetModuleById(ModuleId::SCANNING_MODULE);
+        mod->assetReportingIntervalDs = 10;
+        //The sink uses a longer window so that it receives all reports before it outputs them
+        mod->assetDeduplicationWindowDs = i == 0 ? 300 : 10;
+    }
+
+    alignas(ble_evt_t) u8 buffer[1024];
+    CheckedMemset(buffer, 0, sizeof(buffer));
+    ble_evt_t& evt = *(ble_evt_t*)buffer;
+    AdvPacketServiceAndDataHeader* packet = (AdvPacketServiceAndDataHeader*)evt.evt.gap_evt.params.adv_report.data;
+    AdvPacketLegacyAssetServiceData* assetPacket = (AdvPacketLegacyAssetServiceData*)&packet->data;
+    evt.header.evt_id = BLE_GAP_EVT_ADV_REPORT;
+    evt.evt.gap_evt.params.adv_report.dlen = SIZEOF_ADV_STRUCTURE_LEGACY_ASSET_SERVICE_DATA;
+    packet->flags.len = SIZEOF_ADV_STRUCTURE_FLAGS - 1;
+    packet->uuid.len = SIZEOF_ADV_STRUCTURE_UUID16 - 1;
+    packet->data.uuid.type = (u8)BleGapAdType::TYPE_SERVICE_DATA;
+    packet->data.uuid.uuid = MESH_SERVICE_DATA_SERVICE_UUID16;
+    packet->data.messageType = ServiceDataMessageType::LEGACY_ASSET_V1;
+    assetPacket->serialNumberIndex = 10;
+    assetPacket->nodeId = 1337;
+    assetPacket->speed = 0xFF;
+    assetPacket->pressure = 0xFFFF;
+
+    //The nodes with nodeId 2, 3 and 4 hear the asset with -60, -50 and -70
+    const i8 rssis[] = { -60, -50, -70 };
+    sim_clear_statistics();
+    for (u32 i = 0; i < 3; i++)
+    {
+        NodeIndexSetter setter(i + 1);
+        evt.evt.gap_evt.params.adv_report.rssi = rssis[i];
+        FruityHal::DispatchBleEvents(&evt);
+    }
+
+    std::vector<SimulationMessage> messages = {
+        SimulationMessage(1, "{\"nodeId\":3,\"type\":\"tracked_assets_ins\",\"assets\":[{\"id\":1337,\"rssi1\":50,\"rssi2\":50,\"rssi3\":50"),
+        SimulationMessage(1, "{\"nodeId\":2,\"type\":\"tracked_assets_ins\"", false),
+        SimulationMessage(1, "{\"nodeId\":4,\"type\":\"tracked_assets_ins\"", false),
+    };
+    tester.SimulateUntilMessagesReceived(60 * 1000, messages);
+
+    //Two of the three reports were merged somewhere in the mesh
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_MERGED_ASSET_REPORTS)), 2);
+}
+#endif //GITHUB_RELEASE
+
+//Fills the tracked asset buffer of a node and checks that assets are evicted or dropped once it is full
+TEST(TestScanningModule, TestTrackedAssetEviction) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.terminalId = 0;
+    //testerConfig.verbose = true;
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 1});
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    alignas(ble_evt_t) u8 buffer[1024];
+    CheckedMemset(buffer, 0, sizeof(buffer));
+    ble_evt_t& evt = *(ble_evt_t*)buffer;
+    AdvPacketServiceAndDataHeader* packet = (AdvPacketServiceAndDataHeader*)evt.evt.gap_evt.params.adv_report.data;
+    AdvPacketLegacyAssetServiceData* assetPacket = (AdvPacketLegacyAssetServiceData*)&packet->data;
+    evt.header.evt_id = BLE_GAP_EVT_ADV_REPORT;
+    evt.evt.gap_evt.params.adv_report.dlen = SIZEOF_ADV_STRUCTURE_LEGACY_ASSET_SERVICE_DATA;
+    packet->flags.len = SIZEOF_ADV_STRUCTURE_FLAGS - 1;
+    packet->uuid.len = SIZEOF_ADV_STRUCTURE_UUID16 - 1;
+    packet->data.uuid.type = (u8)BleGapAdType::TYPE_SERVICE_DATA;
+    packet->data.uuid.uuid = MESH_SERVICE_DATA_SERVICE_UUID16;
+    packet->data.messageType = ServiceDataMessageType::LEGACY_ASSET_V1;
+    assetPacket->serialNumberIndex = 10;
+
+    auto receiveAsset = [&](NodeId assetNodeId, i8 rssi) {
+        NodeIndexSetter setter(0);
+        assetPacket->nodeId = assetNodeId;
+        evt.evt.gap_evt.params.adv_report.rssi = rssi;
+        FruityHal::DispatchBleEvents(&evt);
+    };
+
+    sim_clear_statistics();
+
+    //Fill the whole buffer, the ids are chosen so that some of them collide in the index
+    for (u32 i = 0; i < ASSET_PACKET_BUFFER_SIZE; i++)
+    {
+        receiveAsset(1000 + i * 64, -50);
+    }
+    //Assets that are already tracked are found again
+    receiveAsset(1000, -50);
+    receiveAsset(1000 + (ASSET_PACKET_BUFFER_SIZE - 1) * 64, -50);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS)), 0);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS)), 0);
+
+    //A weaker asset is dropped as all tracked assets were seen just now
+    receiveAsset(5000, -60);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS)), 1);
+
+    //A stronger one replaces one of the others
+    receiveAsset(5001, -40);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS)), 1);
+
+    //Once time has passed, the asset that was not seen for the longest time is evicted even for a weak asset
+    tester.SimulateForGivenTime(2 * 1000);
+    receiveAsset(1000 + 1 * 64, -50);
+    receiveAsset(5002, -80);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS)), 2);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS)), 1);
+
+    //The first and third asset were evicted, all others must still be found after removing them from the index
+    for (u32 i = 3; i < ASSET_PACKET_BUFFER_SIZE; i++)
+    {
+        receiveAsset(1000 + i * 64, -50);
+    }
+    receiveAsset(1000 + 1 * 64, -50);
+    receiveAsset(5001, -40);
+    receiveAsset(5002, -80);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS)), 2);
+    ASSERT_EQ(sim_get_statistics(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS)), 1);
+}
@@ -35,6 +35,7 @@
 #include "CherrySimUtils.h"
 #include "Logger.h"
 #include "DebugModule.h"
+#include "StatusReporterModule.h"
 #include <json.hpp>
 
 using json = nlohmann::json;
@@ -771,12 +772,222 @@ TEST(TestStatusReporterModule, TestRegisters) {
     tester.SendTerminalCommand(1, "component_act this 3 read 0 30118 04");
     tester.SimulateUntilMessageReceived(100 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":0,"actionType":2,"component":"0x0000","register":"0x75A6","payload":)"); //The exact amount varies so it cannot be easily tested
 
+    //CLUSTER_SIZE up to PACKETS_SENT_RELIABLE in a single bulk read
+    tester.SendTerminalCommand(1, "component_act this 3 read 0 30100 0A");
+    tester.SimulateUntilMessageReceived(100 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":0,"actionType":2,"component":"0x0000","register":"0x7594","payload":"AQAAAAAAAAAAAA=="})");
+
+    //Whole blocks must contain the same values as reading their registers one by one
+    {
+        NodeIndexSetter setter(0);
+        StatusReporterModule* mod = (StatusReporterModule*)GS->node.GetModuleById(ModuleId::STATUS_REPORTER_MODULE);
+        struct RegisterBlock { u16 start; std::vector<u8> sizes; };
+        const RegisterBlock blocks[] = {
+            { 30000, { 4, 4, 4 } },
+            { 30100, { 2, 1, 1, 2, 4, 4, 4, 4, 4, 4, 4 } },
+        };
+        for (const RegisterBlock& b : blocks)
+        {
+            u8 single[64] = {};
+            u16 length = 0;
+            for (u8 size : b.sizes)
+            {
+                ASSERT_EQ(mod->GetRegisterValues(0, b.start + length, single + length, size), RegisterHandlerCode::SUCCESS);
+                length += size;
+            }
+            u8 block[64] = {};
+            ASSERT_EQ(mod->GetRegisterValues(0, b.start, block, length), RegisterHandlerCode::SUCCESS);
+            ASSERT_EQ(memcmp(block, single, length), 0);
+        }
+    }
+
     //BATTERY_PERCENTAGE
     tester.SendTerminalCommand(1, "component_act this 3 2 0 30200 01");
     tester.SimulateUntilMessageReceived(100 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":0,"actionType":2,"component":"0x0000","register":"0x75F8","payload":"AA=="})"); //Measurement is 0V by default
 
 }
 
+class RegisterWriteListener : public RegisterHandlerEventListener
+{
+public:
+    //The userType of every finished write, in the order of the callbacks
+    std::vector<u32> finishedWrites;
+    std::vector<RecordStorageResultCode> results;
+
+    void RegisterHandlerEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength, bool dataChanged) override
+    {
+        finishedWrites.push_back(userType);
+        results.push_back(resultCode);
+    }
+};
+
+TEST(TestStatusReporterModule, TestPersistentRegisters) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({"prod_mesh_nrf52", 1 });
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    //The reference voltage for 0% must stay below the one for 100% (2600 by default)
+    tester.SendTerminalCommand(1, "component_act this 3 writeack 0 10000 A0:0F:00:00 13"); // 4000
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":13,"actionType":1,"component":"0x0000","register":"0x2710","payload":"DQM="})"); // ILLEGAL_VALUE in CHECK_VALUES
+
+    tester.SendTerminalCommand(1, "component_act this 3 writeack 0 10004 B8:0B:00:00 13"); // 3000
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":13,"actionType":4,"component":"0x0000","register":"0x2714","payload":"AAA="})");
+
+    //Writes that are issued while the flash is busy are batched, so that the first of the two queued writes is never saved on its own
+    sim_clear_statistics();
+    RegisterWriteListener listener;
+    {
+        NodeIndexSetter setter(0);
+        Module* mod = GS->node.GetModuleById(ModuleId::STATUS_REPORTER_MODULE);
+        u32 write = 0;
+        for (u32 milliVolts : { 1200u, 1100u, 1000u })
+        {
+            ASSERT_EQ(mod->SetRegisterValues(0, 10000, (const u8*)&milliVolts, sizeof(milliVolts), &listener, write).code, RegisterHandlerCode::SUCCESS);
+            write++;
+        }
+    }
+    tester.SimulateForGivenTime(1 * 1000);
+    ASSERT_EQ(sim_get_statistics("RecordStorageSaveSuperseded"), 1);
+
+    //The superseded write is only finished once the write that replaced it has reached the flash
+    const std::vector<u32> expectedWrites = { 0, 2, 1 };
+    ASSERT_EQ(listener.finishedWrites, expectedWrites);
+    for (RecordStorageResultCode result : listener.results) ASSERT_EQ(result, RecordStorageResultCode::SUCCESS);
+
+    //The values must be restored after a reboot
+    tester.SendTerminalCommand(1, "reset");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, "reboot");
+    ASSERT_EQ(tester.sim->nodes[0].restartCounter, 2);
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    tester.SendTerminalCommand(1, "component_act this 3 read 0 10000 08");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":0,"actionType":2,"component":"0x0000","register":"0x2710","payload":"6AMAALgLAAA="})"); // 1000 and 3000
+}
+
+TEST(TestStatusReporterModule, TestQueueHistograms) {
+    //Buckets for 0, 1, 2-3, 4-7, ... with all bigger values in the last one
+    QueueHistogram histogram;
+    for (u32 value : { 0u, 1u, 2u, 3u, 4u, 63u, 64u, 100000u }) histogram.Add(value);
+    const std::array<u16, QUEUE_HISTOGRAM_NUM_BUCKETS> expectedBuckets = { 1, 1, 2, 1, 0, 0, 1, 2 };
+    ASSERT_EQ(histogram.buckets, expectedBuckets);
+    ASSERT_EQ(QueueHistogram::GetBucketLowerBound(0), 0u);
+    ASSERT_EQ(QueueHistogram::GetBucketLowerBound(3), 4u);
+    ASSERT_EQ(QueueHistogram::GetBucketLowerBound(7), 64u);
+
+    //A full bucket halves all buckets instead of overflowing
+    for (u32 i = 0; i < UINT16_MAX - 1; i++) histogram.Add(0);
+    ASSERT_EQ(histogram.buckets[0], UINT16_MAX);
+    histogram.Add(0);
+    ASSERT_EQ(histogram.buckets[0], UINT16_MAX / 2 + 1);
+    ASSERT_EQ(histogram.buckets[2], 1);
+    ASSERT_EQ(histogram.buckets[7], 1);
+
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({"prod_sink_nrf52", 1 });
+    simConfig.nodeConfigName.insert({"prod_mesh_nrf52", 1 });
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+    tester.SendTerminalCommand(1, "datal");
+    tester.SimulateGivenNumberOfSteps(100);
+
+    tester.SendTerminalCommand(1, "queuestat");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, "All connections:");
+
+    {
+        NodeIndexSetter setter(0);
+
+        //Every queued message is counted, but only one message per priority is timed at a time
+        u32 numQueued = 0;
+        u32 numTimed = 0;
+        for (u32 prio = 0; prio < AMOUNT_OF_SEND_QUEUE_PRIORITIES; prio++)
+        {
+            for (u16 count : GS->cm.queueDepthHistograms[prio].buckets) numQueued += count;
+            for (u16 count : GS->cm.queueLatencyHistograms[prio].buckets) numTimed += count;
+        }
+        ASSERT_GT(numQueued, 0u);
+        ASSERT_GT(numTimed, 0u);
+        ASSERT_LE(numTimed, numQueued);
+
+        //The connection counts its own messages
+        BaseConnections conns = GS->cm.GetConnectionsOfType(ConnectionType::FRUITYMESH, ConnectionDirection::INVALID);
+        ASSERT_EQ(conns.count, 1u);
+        const BaseConnection* conn = conns.handles[0].GetConnection();
+        u32 numQueuedOnConnection = 0;
+        for (u32 prio = 0; prio < AMOUNT_OF_SEND_QUEUE_PRIORITIES; prio++)
+        {
+            for (u16 count : conn->queueDepthHistograms[prio].buckets) numQueuedOnConnection += count;
+        }
+        ASSERT_GT(numQueuedOnConnection, 0u);
+        ASSERT_LE(numQueuedOnConnection, numQueued);
+
+        //All buckets of all priorities can be read in one go
+        Module* mod = GS->node.GetModuleById(ModuleId::STATUS_REPORTER_MODULE);
+        std::array<u16, AMOUNT_OF_SEND_QUEUE_PRIORITIES * QUEUE_HISTOGRAM_NUM_BUCKETS> registerValues = {};
+        ASSERT_EQ(mod->GetRegisterValues(0, StatusReporterModule::REGISTER_QUEUE_DEPTH_HISTOGRAMS, (u8*)registerValues.data(), sizeof(registerValues)), RegisterHandlerCode::SUCCESS);
+        for (u32 i = 0; i < registerValues.size(); i++)
+        {
+            ASSERT_EQ(registerValues[i], GS->cm.queueDepthHistograms[i / QUEUE_HISTOGRAM_NUM_BUCKETS].buckets[i % QUEUE_HISTOGRAM_NUM_BUCKETS]);
+        }
+        ASSERT_EQ(mod->GetRegisterValues(0, StatusReporterModule::REGISTER_QUEUE_LATENCY_HISTOGRAMS, (u8*)registerValues.data(), sizeof(registerValues)), RegisterHandlerCode::SUCCESS);
+        for (u32 i = 0; i < registerValues.size(); i++)
+        {
+            ASSERT_EQ(registerValues[i], GS->cm.queueLatencyHistograms[i / QUEUE_HISTOGRAM_NUM_BUCKETS].buckets[i % QUEUE_HISTOGRAM_NUM_BUCKETS]);
+        }
+    }
+
+    //A single bucket is a register of its own
+    tester.SendTerminalCommand(1, "component_act this 3 read 0 30302 02");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":0,"actionType":2,"component":"0x0000","register":"0x765E","payload":)");
+}
+
+TEST(TestStatusReporterModule, TestRegisterSubscriptions) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.nodeConfigName.insert({"prod_mesh_nrf52", 1 });
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    //Subscribing answers with the current value (1800 by default), length 4, min interval 2 seconds, no expiry
+    tester.SendTerminalCommand(1, "component_act this 3 subscribe 0 10000 04:14:00:00:00 7");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":7,"actionType":2,"component":"0x0000","register":"0x2710","payload":"CAcAAA=="})");
+
+    //A written value is pushed as an event
+    sim_clear_statistics();
+    tester.SendTerminalCommand(1, "component_act this 3 write 0 10000 E8:03:00:00"); // 1000
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":7,"actionType":0,"component":"0x0000","register":"0x2710","payload":"6AMAAA=="})");
+    ASSERT_EQ(sim_get_statistics("RegisterSubscriptionPush"), 1);
+
+    //Writing the same value again must not be pushed
+    tester.SendTerminalCommand(1, "component_act this 3 write 0 10000 E8:03:00:00");
+    tester.SimulateForGivenTime(10 * 1000);
+    ASSERT_EQ(sim_get_statistics("RegisterSubscriptionPush"), 1);
+
+    //After unsubscribing, changes are no longer pushed
+    tester.SendTerminalCommand(1, "component_act this 3 subscribe 0 10000 00:00:00:00:00 7");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"({"nodeId":1,"type":"component_sense","module":3,"requestHandle":7,"actionType":4,"component":"0x0000","register":"0x2710","payload":"AAA="})");
+    tester.SendTerminalCommand(1, "component_act this 3 write 0 10000 B0:04:00:00"); // 1200
+    tester.SimulateForGivenTime(10 * 1000);
+    ASSERT_EQ(sim_get_statistics("RegisterSubscriptionPush"), 1);
+
+    //Registers that change on their own are sampled, the uptime is pushed once per interval until the subscription expires
+    tester.SendTerminalCommand(1, "component_act this 3 subscribe 0 30000 04:0A:00:05:00 8"); // 1 second interval, 5 seconds lifetime
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("requestHandle":8,"actionType":2,"component":"0x0000","register":"0x7530")");
+    tester.SimulateUntilMessageReceived(10 * 1000, 1, R"("requestHandle":8,"actionType":0,"component":"0x0000","register":"0x7530")");
+    tester.SimulateForGivenTime(10 * 1000);
+    {
+        NodeIndexSetter setter(0);
+        ASSERT_EQ(GS->registerSubscriptions.GetAmountOfSubscriptions(), 0);
+    }
+}
+
 #ifndef GITHUB_RELEASE
 TEST(TestStatusReporterModule, TestRegistersAutoSense) {
     CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
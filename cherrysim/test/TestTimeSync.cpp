@@ -194,3 +194,127 @@ TEST(TestTimeSync, TestTimeSyncDuration_long) {
     ASSERT_TRUE(timeDiff <= 1);     //We allow 1 second off
 }
 
+
+//Returns the difference of the local time of each node to the time of the time master (node 1) in ticks
+static std::vector<i32> GetTimeSyncErrorsTicks(CherrySimTester& tester)
+{
+    TimePoint masterTime;
+    {
+        NodeIndexSetter setter(0);
+        masterTime = GS->timeManager.GetLocalTimePoint();
+    }
+
+    std::vector<i32> errorsTicks;
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        NodeIndexSetter setter(i);
+        errorsTicks.push_back(GS->timeManager.GetLocalTimePoint() - masterTime);
+    }
+    return errorsTicks;
+}
+
+TEST(TestTimeSync, TestClockDriftCompensation) {
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.terminalId = 0;
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1});
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 9});
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    //Give each crystal a different error of up to 95 ppm
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        tester.sim->nodes[i].clockDriftPpm = (i % 2 == 0) ? (i32)(i * 10) + 15 : -(i32)(i * 10);
+        NodeIndexSetter setter(i);
+        GS->config.enableClockDriftCompensation = true;
+    }
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    tester.SendTerminalCommand(1, "settime 1560262597 0");
+
+    //The time master resyncs after 1, 3, 7, 15, 31, 63 and 95 minutes, which lets the nodes learn their drift
+    tester.SimulateForGivenTime(64 * 60 * 1000);
+
+    for (u32 i = 1; i < tester.sim->GetTotalNodes(); i++)
+    {
+        NodeIndexSetter setter(i);
+        const i32 expectedDriftPpb = (tester.sim->nodes[i].clockDriftPpm - tester.sim->nodes[0].clockDriftPpm) * 1000;
+        ASSERT_NEAR(GS->timeManager.GetClockDriftPpb(), expectedDriftPpb, 500);
+    }
+
+    //Without the compensation, the clocks would drift apart by up to 200 ms until the next resync.
+    //With the compensation, less than 1 ms is allowed.
+    const std::vector<i32> errorsBeforeTicks = GetTimeSyncErrorsTicks(tester);
+    tester.SimulateForGivenTime(30 * 60 * 1000);
+    const std::vector<i32> errorsAfterTicks = GetTimeSyncErrorsTicks(tester);
+
+    for (u32 i = 1; i < tester.sim->GetTotalNodes(); i++)
+    {
+        const i32 driftTicks = errorsAfterTicks[i] - errorsBeforeTicks[i];
+        ASSERT_LT(std::abs(driftTicks), (i32)(ticksPerSecond / 1000));
+    }
+}
+
+TEST(TestTimeSync, TestTimeSyncAccuracyPerHop)
+{
+    CherrySimTesterConfig testerConfig = CherrySimTester::CreateDefaultTesterConfiguration();
+    SimConfiguration simConfig = CherrySimTester::CreateDefaultSimConfiguration();
+    simConfig.terminalId = 0;
+    simConfig.maxClockDriftPpm = 40;
+    //The messages of the time sync are delayed by whole simulation steps, short steps keep this error small
+    simConfig.simTickDurationMs = 2;
+    simConfig.nodeConfigName.insert({ "prod_sink_nrf52", 1});
+    simConfig.nodeConfigName.insert({ "prod_mesh_nrf52", 9});
+    CherrySimTester tester = CherrySimTester(testerConfig, simConfig);
+    tester.Start();
+
+    //The errors are measured against the simulation clock, so the time master must not drift. Otherwise its
+    //drift of up to 40 ppm would add up to 72 ms during the 30 minutes of the measurement on every hop.
+    tester.sim->nodes[0].clockDriftPpm = 0;
+
+    for (u32 i = 0; i < tester.sim->GetTotalNodes(); i++)
+    {
+        NodeIndexSetter setter(i);
+        GS->config.enableClockDriftCompensation = true;
+    }
+
+    tester.SimulateUntilClusteringDone(100 * 1000);
+
+    //Without a time master, nothing can be measured
+    ASSERT_FALSE(tester.sim->StartTimeSyncMeasurement(1000));
+
+    tester.SendTerminalCommand(1, "settime 1560262597 0");
+    tester.SimulateForGivenTime(300 * 1000);
+    {
+        NodeIndexSetter setter(0);
+        ASSERT_TRUE(GS->timeManager.IsTimeMaster());
+    }
+
+    tester.SendTerminalCommand(1, "sim timesync start 1000");
+    tester.SimulateForGivenTime(30 * 60 * 1000);
+    tester.SendTerminalCommand(1, "sim timesync stop");
+    tester.SimulateGivenNumberOfSteps(1);
+
+    tester.sim->PrintTimeSyncAccuracy();
+
+    const std::vector<TimeSyncAccuracy> accuracy = tester.sim->GetTimeSyncAccuracy();
+    ASSERT_GE(accuracy.size(), 2u);
+
+    u32 numSamples = 0;
+    for (const TimeSyncAccuracy& entry : accuracy)
+    {
+        numSamples += entry.numSamples;
+        ASSERT_EQ(entry.numUnsyncedSamples, 0u);
+        ASSERT_LE(entry.p50ErrorUs, entry.p95ErrorUs);
+        ASSERT_LE(entry.p95ErrorUs, entry.p99ErrorUs);
+        ASSERT_LE(entry.p99ErrorUs, entry.maxErrorUs);
+
+        //Every hop adds at most the duration of a simulation step as the messages are sent in the next step.
+        //The maximum is not checked as a resync is briefly off until its correction arrives.
+        //Measured were 0.4 ms on the first hop and about 1 ms more on every further hop.
+        ASSERT_LE(entry.p99ErrorUs, 2 * 1000 + entry.hops * simConfig.simTickDurationMs * 1000);
+    }
+    ASSERT_EQ(numSamples, 1800u * tester.sim->GetTotalNodes());
+}
@@ -34,7 +34,9 @@
 #include "MultiScheduler.h"
 #include "BitMask.h"
 #include "SlotStorage.h"
+#include "MersenneTwister.h"
 #include <set>
+#include <vector>
 
 TEST(TestUtility, TestGetIndexForSerial) {
     //The original serial number range had 5 characters
@@ -644,6 +646,73 @@ TEST(TestUtility, TestMultischeduler)
     }
 }
 
+TEST(TestUtility, TestMultischedulerOrdering)
+{
+    // Compares the scheduler against a trivial reference implementation that always
+    // picks the earliest event and, for equal times, the one that was entered first.
+    struct ReferenceEvent
+    {
+        u8 t;
+        u32 timeBetweenEventsDs;
+        u32 nextOccurrenceDs;
+        u32 enterCounter;
+    };
+    std::vector<ReferenceEvent> reference;
+    u32 enterCounter = 0;
+    u32 timeDs = 0;
+
+    MultiScheduler<u8, 32> ms;
+    MersenneTwister mt(1);
+
+    for (u8 i = 0; i < 32; i++)
+    {
+        // Few different intervals so that a lot of events occur at the same time.
+        const u32 timeBetweenEventsDs = mt.NextU32(1, 6);
+        ms.addEvent(i, timeBetweenEventsDs, 0, EventTimeType::RELATIVE);
+        reference.push_back({ i, timeBetweenEventsDs, timeBetweenEventsDs, enterCounter++ });
+    }
+
+    for (u32 step = 0; step < 2000; step++)
+    {
+        ms.advanceTime(1);
+        timeDs++;
+        while (true)
+        {
+            u32 first = 0;
+            for (u32 k = 1; k < reference.size(); k++)
+            {
+                if (reference[k].nextOccurrenceDs < reference[first].nextOccurrenceDs
+                    || (reference[k].nextOccurrenceDs == reference[first].nextOccurrenceDs && reference[k].enterCounter < reference[first].enterCounter))
+                {
+                    first = k;
+                }
+            }
+            const bool referenceReady = !reference.empty() && reference[first].nextOccurrenceDs <= timeDs;
+            ASSERT_EQ(ms.isEventReady(), referenceReady);
+            if (!referenceReady) break;
+
+            ASSERT_EQ(ms.getAndReenter(), reference[first].t);
+            reference[first].nextOccurrenceDs = timeDs + reference[first].timeBetweenEventsDs;
+            reference[first].enterCounter = enterCounter++;
+        }
+
+        if (step % 100 == 50 && !reference.empty())
+        {
+            // Remove a random event...
+            const u32 index = mt.NextU32(0, reference.size() - 1);
+            ASSERT_TRUE(ms.removeEvent(reference[index].t));
+            ASSERT_FALSE(ms.removeEvent(reference[index].t));
+            const u8 t = reference[index].t;
+            reference.erase(reference.begin() + index);
+
+            // ... and add it back with a new interval.
+            const u32 timeBetweenEventsDs = mt.NextU32(1, 6);
+            ms.addEvent(t, timeBetweenEventsDs, 0, EventTimeType::RELATIVE);
+            reference.push_back({ t, timeBetweenEventsDs, timeDs + timeBetweenEventsDs, enterCounter++ });
+        }
+    }
+}
+
 constexpr u32 numBits = 20;
 void checkEquality(const BitMask<numBits>& bm, const bool* checkArr)
 {
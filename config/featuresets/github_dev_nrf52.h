@@ -36,6 +36,10 @@
 #define ACTIVATE_SEGGER_RTT 1 //Undefine to disable debugging over Segger Rtt
 
 #define ACTIVATE_VENDOR_TEMPLATE_MODULE 1
+#define ACTIVATE_RELIABLE_TRANSFER 1 //Acknowledged end-to-end delivery, see ConnectionManager::SendMeshMessageReliable
+#define ACTIVATE_QUEUE_HISTOGRAMS 1 //Queue depth and latency statistics, see the queuestat command
+#define PACKET_QUEUE_MAX_AGE_SEC_MEDIUM 120 //Drop queued messages that could not be sent in time
+#define PACKET_QUEUE_MAX_AGE_SEC_LOW 30
 
 // Uncomment for testing the AppUartModule example
 //#define ACTIVATE_APP_UART 1
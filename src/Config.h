@@ -172,6 +172,28 @@ static_assert(false, "Featureset was not defined, which is mandatory!");
 #define CONNECTION_QUEUE_MEMORY_MAX_CHUNKS_PER_CONNECTION 25
 #endif
 
+// Queued messages that could not be sent within this amount of seconds are dropped from the send queue
+// of their connection, see the Quality of Service documentation. A value of 0 disables the expiry for the
+// priority, which is the default. VITAL messages never expire. Values must not exceed ChunkedPacketQueue::MAX_TRACKABLE_AGE_SEC.
+#ifndef PACKET_QUEUE_MAX_AGE_SEC_HIGH
+#define PACKET_QUEUE_MAX_AGE_SEC_HIGH 0
+#endif
+#ifndef PACKET_QUEUE_MAX_AGE_SEC_MEDIUM
+#define PACKET_QUEUE_MAX_AGE_SEC_MEDIUM 0
+#endif
+#ifndef PACKET_QUEUE_MAX_AGE_SEC_LOW
+#define PACKET_QUEUE_MAX_AGE_SEC_LOW 0
+#endif
+
+// Amount of messages that can be sent and received end-to-end reliable at the same time, see ReliableTransfer.
+// Each of them keeps a buffer of MAX_MESH_PACKET_SIZE bytes until the transfer is finished
+#ifndef RELIABLE_TRANSFER_MAX_OUTGOING
+#define RELIABLE_TRANSFER_MAX_OUTGOING 2
+#endif
+#ifndef RELIABLE_TRANSFER_MAX_INCOMING
+#define RELIABLE_TRANSFER_MAX_INCOMING 2
+#endif
+
 // Each connection does also have a buffer to assemble packets that were split into 20 byte chunks
 // This is the maximum size that these packets can have
 #ifndef PACKET_REASSEMBLY_BUFFER_SIZE
@@ -199,6 +221,17 @@ static_assert(false, "Featureset was not defined, which is mandatory!");
 #define ADVERTISING_CONTROLLER_MAX_NUM_JOBS 4
 #endif
 
+//The maximum number of advertising sets that the AdvertisingController advertises with at the same time
+//The supported SoftDevices only provide a single set (see FruityHal::BleGapGetMaxAdvertisingSets), so only the
+//simulator reserves memory for more sets
+#ifndef ADVERTISING_CONTROLLER_MAX_NUM_SETS
+#ifdef SIM_ENABLED
+#define ADVERTISING_CONTROLLER_MAX_NUM_SETS ADVERTISING_CONTROLLER_MAX_NUM_JOBS
+#else
+#define ADVERTISING_CONTROLLER_MAX_NUM_SETS 1
+#endif
+#endif
+
 // ########### Flash Settings ##########################################
 // Number of pages used to store records, at least 2 are required for swapping
 #ifndef RECORD_STORAGE_NUM_PAGES
@@ -304,6 +337,18 @@ static_assert(false, "Featureset was not defined, which is mandatory!");
 #define ACTIVATE_REGISTER_HANDLER 1
 #endif
 
+// Activate end-to-end acknowledged delivery of unicast messages, see ReliableTransfer
+// Costs about 880 byte of RAM for the buffered transfers, so it must be enabled by the featuresets that need it
+#ifndef ACTIVATE_RELIABLE_TRANSFER
+#define ACTIVATE_RELIABLE_TRANSFER 0
+#endif
+
+// Activate the queue depth and latency histograms of the connections, see QueueHistogram
+// Costs 160 byte of RAM per connection and another 128 byte for the sums in the ConnectionManager
+#ifndef ACTIVATE_QUEUE_HISTOGRAMS
+#define ACTIVATE_QUEUE_HISTOGRAMS 0
+#endif
+
 // ########### Config class ##########################################
 //This class holds the configuration and some bits are changeable at runtime
 
@@ -458,14 +503,21 @@ class Conf
         //And connections will perform an encryption before the handshake
         static constexpr bool encryptionEnabled = true;
 
-        //If more than # nodes were found, decide immediately
+        //If # nodes with a score above 0 were found, decide immediately
         static constexpr u8 numNodesForDecision = 4;
+        //Minimum time between two decisions, even if enough nodes were found
+        static constexpr u16 minTimeUntilDecisionDs = 5;
         //If not enough nodes were found, decide after this timeout
         static constexpr u16 maxTimeUntilDecisionDs = SEC_TO_DS(2);
         //Delay before setting new discovery after cluster size change
         static constexpr u16 clusterSizeDiscoveryChangeDelaySec = 10;        
         //Switch to low discovery if no other nodes were found for # seconds, set to 0 to disable low discovery state
         u16 highDiscoveryTimeoutSec = 0; // if is not configured in featureset, low discovery will be disabled and will always be in high discovery mode
+        //Slows down the join-me advertising and the scanning of the current discovery state step by step
+        //while the cluster size and the mesh neighbours of the node do not change, see Node::UpdateAdaptiveDiscovery
+        bool enableAdaptiveDiscovery = false;
+        //Time that the cluster has to be stable before the discovery is slowed down by another step
+        static constexpr u16 adaptiveDiscoveryStepDelaySec = 30;
 
         LedMode defaultLedMode = LedMode::OFF;
 
@@ -477,6 +529,21 @@ class Conf
         TerminalMode terminalMode : 8;
 
         bool enableSinkRouting = false;
+        //Spreads the traffic to NODE_ID_SHORTEST_SINK over all sinks that are reachable with at most one additional
+        //hop, depending on their load. Must be enabled on all nodes of the mesh, including the sinks
+        bool enableSinkLoadBalancing = false;
+        //Measures the time with the RTC and learns the drift of the LF clock against the time master from
+        //consecutive time syncs to compensate it, see TimeManager::ProcessTicks. The time master then
+        //redistributes its time periodically. Must be enabled on all nodes of the mesh
+        bool enableClockDriftCompensation = false;
+        //The first resync of the time master happens after the minimum interval, which is doubled with each
+        //resync up to the maximum interval as the other nodes learn their drift
+        static constexpr u32 timeResyncMinIntervalDs = SEC_TO_DS(60);
+        static constexpr u32 timeResyncMaxIntervalDs = SEC_TO_DS(32 * 60);
+        //Syncs that follow the previous one quicker than this are not used to measure the drift
+        static constexpr u32 minClockDriftMeasurementIntervalSec = 30;
+        //Measured drifts above this are discarded, e.g. if the time master was given a new time
+        static constexpr u32 maxClockDriftPpm = 500;
         // ########### TIMINGS ################################################
 
         //Mesh connection parameters (used when a connection is set up)
@@ -66,11 +66,22 @@ void AdvertisingController::Initialize()
 
     //Read used GAP address, will always succeed
     baseGapAddress = FruityHal::GetBleGapAddress();
+
+    maxAdvertisingSets = FruityHal::BleGapGetMaxAdvertisingSets();
+    if (maxAdvertisingSets > advSets.size()) maxAdvertisingSets = (u8)advSets.size();
+    for (u32 i = 0; i < advSets.size(); i++) {
+        advSets[i].handle = 0xFF; //BLE_GAP_ADV_SET_HANDLE_NOT_SET
+    }
 }
 
 void AdvertisingController::Deactivate()
 {
     isActive = false;
+    if (advertisingSetsUsed)
+    {
+        StopAdvertisingSets();
+        return;
+    }
     const ErrorType err = FruityHal::BleGapAdvStop(handle);
     if (err != ErrorType::SUCCESS)
     {
@@ -115,6 +126,10 @@ void AdvertisingController::RefreshJob(const AdvJob* jobHandle){
     //Reset current active job if it was the same one so that it gets sent to the softdevice
     if(jobHandle == currentActiveJob) currentActiveJob = nullptr;
 
+    //Same if the job has its own advertising set
+    AdvSet* advSet = GetAdvertisingSet(jobHandle);
+    if (advSet != nullptr) advSet->dirty = true;
+
     //Update advertising interval if necessary, reschedule current cycle
     if(
         jobHandle->type == AdvJobTypes::SCHEDULED
@@ -160,6 +175,13 @@ void AdvertisingController::RemoveJob(AdvJob* jobHandle)
 
             jobHandle->type = AdvJobTypes::INVALID;
 
+            //Free the advertising set of the job
+            AdvSet* advSet = GetAdvertisingSet(jobHandle);
+            if (advSet != nullptr) {
+                StopAdvertisingSet(*advSet);
+                advSet->job = nullptr;
+            }
+
             //Update Advertising interval
             currentAdvertisingInterval = GetLowestAdvertisingInterval();
 
@@ -189,6 +211,32 @@ void AdvertisingController::DetermineAndSetAdvertisingJob()
 {
     if (!isActive) return;
 
+    //Advertise each job in its own set if possible, otherwise all jobs are rotated through a single set
+    if (ShouldUseAdvertisingSets()) {
+        if (!advertisingSetsUsed) {
+            logt("ADV", "Using advertising sets");
+            //The set of the slot rotation is reused
+            const ErrorType err = FruityHal::BleGapAdvStop(handle);
+            if (err != ErrorType::SUCCESS && err != ErrorType::INVALID_STATE) {
+                GS->logger.LogCustomError(CustomErrorTypes::WARN_ADVERTISING_CONTROLLER_DEACTIVATE_FAILED, (u32)err);
+            }
+            advSets[0].handle = handle;
+            advertisingState = AdvertisingState::DISABLED;
+            advertisingStateAction = AdvertisingStateAction::OK;
+            currentActiveJob = nullptr;
+            advertisingSetsUsed = true;
+        }
+        SetAdvertisingSets();
+        return;
+    }
+    if (advertisingSetsUsed) {
+        logt("ADV", "Using slot rotation");
+        StopAdvertisingSets();
+        handle = advSets[0].handle;
+        advertisingSetsUsed = false;
+        RestartAdvertising();
+    }
+
     //Find the job that should advertise
     jobToSet = DetermineCurrentAdvertisingJob();
 
@@ -393,23 +441,7 @@ void AdvertisingController::SetAdvertisingState(AdvJob* job)
 
     //TODO: Check if our job needs special settings
 
-    BaseConnections connections = GS->cm.GetBaseConnections(ConnectionDirection::DIRECTION_IN);
-    u8 connectedConnections = 0;
-    for(int i=0; i<connections.count; i++){
-        BaseConnectionHandle handle = connections.handles[i];
-        if (handle) {
-            ConnectionState cs = handle.GetConnectionState();
-            if (
-                   cs == ConnectionState::CONNECTED
-                || cs == ConnectionState::HANDSHAKING
-                || cs == ConnectionState::HANDSHAKE_DONE
-                ) {
-                connectedConnections++;
-            }
-        }
-    }
-
-    if(connectedConnections < Conf::GetInstance().totalInConnections){
+    if(IsConnectableAdvertisingPossible()){
     // When number of connections is not at limit always set connectable advertising. By default set it
     // to indirect, otherwise specific one.
     if (job != nullptr)
@@ -475,6 +507,162 @@ void AdvertisingController::SetAdvertisingState(AdvJob* job)
     }
 }
 
+bool AdvertisingController::IsConnectableAdvertisingPossible()
+{
+    BaseConnections connections = GS->cm.GetBaseConnections(ConnectionDirection::DIRECTION_IN);
+    u8 connectedConnections = 0;
+    for(int i=0; i<connections.count; i++){
+        BaseConnectionHandle handle = connections.handles[i];
+        if (handle) {
+            ConnectionState cs = handle.GetConnectionState();
+            if (
+                   cs == ConnectionState::CONNECTED
+                || cs == ConnectionState::HANDSHAKING
+                || cs == ConnectionState::HANDSHAKE_DONE
+                ) {
+                connectedConnections++;
+            }
+        }
+    }
+
+    return connectedConnections < Conf::GetInstance().totalInConnections;
+}
+
+bool AdvertisingController::ShouldUseAdvertisingSets() const
+{
+    if (maxAdvertisingSets <= 1 || currentNumJobs > maxAdvertisingSets) return false;
+
+    //Delays are only supported by the slot rotation
+    for (u32 i = 0; i < jobs.size(); i++) {
+        if (jobs[i].type == AdvJobTypes::SCHEDULED && jobs[i].delay != 0) return false;
+    }
+
+    return true;
+}
+
+AdvSet* AdvertisingController::GetAdvertisingSet(const AdvJob* job)
+{
+    if (job == nullptr) return nullptr;
+
+    for (u32 i = 0; i < advSets.size(); i++) {
+        if (advSets[i].job == job) return &(advSets[i]);
+    }
+
+    return nullptr;
+}
+
+void AdvertisingController::SetAdvertisingSets()
+{
+    //Immediate jobs are removed once their slots are used up, same as in the slot rotation
+    for (u32 i = 0; i < jobs.size(); i++) {
+        if (jobs[i].type == AdvJobTypes::IMMEDIATE) {
+            jobs[i].currentSlots--;
+            if (jobs[i].currentSlots == 0) {
+                RemoveJob(&(jobs[i]));
+            }
+        }
+    }
+
+    //Assign a free set to each new job
+    for (u32 i = 0; i < jobs.size(); i++) {
+        if (jobs[i].type == AdvJobTypes::INVALID || GetAdvertisingSet(&(jobs[i])) != nullptr) continue;
+
+        for (u32 k = 0; k < maxAdvertisingSets; k++) {
+            if (advSets[k].job == nullptr) {
+                logt("ADV", "Job %u uses set %u", i, k);
+                advSets[k].job = &(jobs[i]);
+                advSets[k].dirty = true;
+                break;
+            }
+        }
+    }
+
+    for (u32 k = 0; k < maxAdvertisingSets; k++) {
+        if (advSets[k].job != nullptr && (advSets[k].dirty || !advSets[k].active)) {
+            SetAdvertisingSet(advSets[k]);
+        }
+    }
+}
+
+//Sends the data and parameters of the job to its set, the set is restarted if the parameters changed
+void AdvertisingController::SetAdvertisingSet(AdvSet& advSet)
+{
+    ErrorType err;
+    const AdvJob* job = advSet.job;
+
+    FruityHal::BleGapAdvParams params = currentAdvertisingParams;
+    params.interval = job->advertisingInterval;
+    *((u8*)&params.channelMask) = job->advertisingChannelMask;
+    //Same as in the slot rotation, connectable advertising is used as long as connections are possible
+    if (IsConnectableAdvertisingPossible()) {
+        params.type = job->advertisingType == FruityHal::BleGapAdvType::ADV_NONCONN_IND ? FruityHal::BleGapAdvType::ADV_IND : job->advertisingType;
+    }
+    else {
+        params.type = FruityHal::BleGapAdvType::ADV_NONCONN_IND;
+        //Non connectable advertising must not be faster than 100ms
+        if (params.interval < MSEC_TO_UNITS(100, CONFIG_UNIT_0_625_MS)) {
+            params.interval = MSEC_TO_UNITS(100, CONFIG_UNIT_0_625_MS);
+        }
+    }
+
+    if (advSet.active && (
+           params.interval != advSet.params.interval
+        || params.type != advSet.params.type
+        || *(u8*)&params.channelMask != *(u8*)&advSet.params.channelMask))
+    {
+        StopAdvertisingSet(advSet);
+    }
+
+    //The data must not be changed while the SoftDevice uses it
+    advSet.data[advSet.currentDataUsed].inUse = false;
+    advSet.currentDataUsed = (u8)((advSet.currentDataUsed + 1) % advSet.data.size());
+    AdvData& data = advSet.data[advSet.currentDataUsed];
+    data.inUse = true;
+    CheckedMemcpy(data.advData, job->advData, job->advDataLength);
+    data.advDataLength = job->advDataLength;
+    CheckedMemcpy(data.scanData, job->scanData, job->scanDataLength);
+    data.scanDataLength = job->scanDataLength;
+
+    err = FruityHal::BleGapAdvDataSet(&advSet.handle, data.advData, data.advDataLength, data.scanData, data.scanDataLength);
+    if (err != ErrorType::SUCCESS) {
+        logt("ERROR", "Setting Adv data of set %u err %u", advSet.handle, (u32)err);
+        return;
+    }
+
+    if (!advSet.active) {
+        err = FruityHal::BleGapAdvStart(&advSet.handle, params);
+        if (err != ErrorType::SUCCESS) {
+            logt("WARNING", "Error starting advertising set %u: %u", advSet.handle, (u32)err);
+            return;
+        }
+        err = FruityHal::RadioSetTxPower(Conf::GetInstance().defaultDBmTX, FruityHal::TxRole::ADVERTISING, advSet.handle);
+        if (err != ErrorType::SUCCESS) {
+            logt("ERROR", "error code = %u", (u32)err);
+        }
+        advSet.active = true;
+        advSet.params = params;
+    }
+    advSet.dirty = false;
+}
+
+void AdvertisingController::StopAdvertisingSet(AdvSet& advSet)
+{
+    if (!advSet.active) return;
+
+    const ErrorType err = FruityHal::BleGapAdvStop(advSet.handle);
+    logt("ADV", "Adv set %u stopped %u", advSet.handle, (u32)err);
+    advSet.active = false;
+}
+
+void AdvertisingController::StopAdvertisingSets()
+{
+    for (u32 i = 0; i < advSets.size(); i++) {
+        StopAdvertisingSet(advSets[i]);
+        advSets[i].job = nullptr;
+        advSets[i].dirty = false;
+    }
+}
+
 void AdvertisingController::RestartAdvertising()
 {
     advertisingStateAction = AdvertisingStateAction::RESTART;
@@ -483,6 +671,13 @@ void AdvertisingController::RestartAdvertising()
 void AdvertisingController::GapConnectedEventHandler(const FruityHal::GapConnectedEvent & connectedEvent)
 {
     if (connectedEvent.GetRole() == FruityHal::GapRole::PERIPHERAL) {
+        //The connected set was stopped automatically and the others might have to become non-connectable,
+        //so all sets are restarted
+        if (advertisingSetsUsed) {
+            for (u32 i = 0; i < advSets.size(); i++) {
+                StopAdvertisingSet(advSets[i]);
+            }
+        }
         //If a peripheral connection got connected, we can only advertise non-connectable, reschedule
         //Also, we must restart because the advertising was stopped automatically
         if (advertisingState == AdvertisingState::ENABLED) {
@@ -496,6 +691,9 @@ void AdvertisingController::GapDisconnectedEventHandler(const FruityHal::GapDisc
 {
     //TODO: Should Check if this was a peripheral connection
     //If a peripheral connection is lost, we can restart advertising in connectable mode
+    for (u32 i = 0; i < advSets.size(); i++) {
+        advSets[i].dirty = true;
+    }
     if (advertisingState == AdvertisingState::ENABLED) {
         if (currentNumJobs > 0) RestartAdvertising();
     }
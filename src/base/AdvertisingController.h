@@ -71,12 +71,24 @@ struct AdvData {
     u8 scanDataLength;
 };
 
+//If the HAL supports enough advertising sets, each job is advertised in its own set instead of the slot rotation
+struct AdvSet {
+    AdvJob* job; //nullptr if the set is unused
+    u8 handle;
+    bool active;
+    bool dirty; //Data or parameters of the job changed and must be sent to the SoftDevice
+    FruityHal::BleGapAdvParams params;
+    std::array<AdvData, 2> data;
+    u8 currentDataUsed;
+};
+
 /*
  * The Advertising Controller is responsible for wrapping all advertising
  * functionality and the necessary softdevice calls in one class.
  * It provides a scheduler that can be used to schedule a number of messages.
  * The current message broadcast is then automatically switched between all
- * croadcasted messages.
+ * croadcasted messages. If the HAL supports multiple advertising sets, each
+ * job is advertised in its own set with its own interval instead.
  */
 class AdvertisingController
 {
@@ -91,12 +103,29 @@ private:
 
     bool isActive = true;
 
+    //Number of advertising sets that the HAL can advertise with at the same time
+    u8 maxAdvertisingSets = 1;
+    bool advertisingSetsUsed = false;
+
+    bool IsConnectableAdvertisingPossible();
+
+    //Advertising with one set per job
+    bool ShouldUseAdvertisingSets() const;
+    AdvSet* GetAdvertisingSet(const AdvJob* job);
+    void SetAdvertisingSets();
+    void SetAdvertisingSet(AdvSet& advSet);
+    void StopAdvertisingSet(AdvSet& advSet);
+    void StopAdvertisingSets();
+
 public:
     AdvertisingController();
 
     std::array<AdvJob, ADVERTISING_CONTROLLER_MAX_NUM_JOBS> jobs{};
     std::array<AdvData, 2> advData{};
     u8 currentSlotUsed = 0;
+    //The first set is also used by the slot rotation, so there is always at least one
+    std::array<AdvSet, ADVERTISING_CONTROLLER_MAX_NUM_SETS> advSets{};
+    static_assert(ADVERTISING_CONTROLLER_MAX_NUM_SETS >= 1, "The slot rotation needs one set");
 
     enum class AdvertisingState : u8{
         DISABLED,
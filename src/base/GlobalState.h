@@ -127,6 +127,9 @@ class GlobalState
         Terminal terminal;
         FlashStorage flashStorage;
         RecordStorage recordStorage;
+#if IS_ACTIVE(REGISTER_HANDLER)
+        RegisterSubscriptions registerSubscriptions;
+#endif
 
 #if IS_ACTIVE(TIMESLOT)
         Timeslot timeslot;
@@ -29,6 +29,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "RegisterHandler.h"
 #include "GlobalState.h"
+#include "Module.h"
+#include "Utility.h"
 
 #if IS_ACTIVE(REGISTER_HANDLER)
 
@@ -196,206 +198,244 @@ SupervisedValue::Type SupervisedValue::GetType() const
     return type;
 }
 
-#define READ() oldRecordStorage[i++]
-#define WRITE(val) newRecordStorage[writeHead++] = (val)
-// TODO replace with CheckedMemcpy
-#define COPY(amount) for(u32 warglspargl = 0; warglspargl < (amount); warglspargl++) newRecordStorage[writeHead++] = oldRecordStorage[i++]
-#define SKIP(amount) i += (amount)
-#define WRITE_NEW_RANGE() WRITE(newRegister); WRITE(newLength); for (u32 m = 0; m < newLength; m++) { WRITE(newValues[m]); }
+const RegisterRecordEntry* ReadRegisterRecordEntry(const u8* record, u16 recordLength, u16& offset)
+{
+    if (record == nullptr || offset + SIZEOF_REGISTER_RECORD_ENTRY_HEADER > recordLength) return nullptr;
+
+    const RegisterRecordEntry* entry = (const RegisterRecordEntry*)(record + offset);
+    if (offset + SIZEOF_REGISTER_RECORD_ENTRY_HEADER + entry->length > recordLength) return nullptr;
+
+    offset += SIZEOF_REGISTER_RECORD_ENTRY_HEADER + entry->length;
+    return entry;
+}
 
-#ifdef JSTODO_PERSISTENCE
-void RegisterHandler::LoadFromFlash()
+// Checks if two ranges overlap. Touching does count as overlap, too. So these Ranges do overlap (both numbers inclusive)
+// [4, 10] and [7, 13]
+// [4, 10] and [10, 13]
+// [4, 10] and [11, 13]
+// [4, 10] and [5, 6]
+// But these do not overlap:
+// [4, 10] and [12, 13]
+static bool DoRangesOverlap(u16 s1, u16 l1, u16 s2, u16 l2)
 {
-    const u16 baseId = GetRecordBaseId();
-    for (u32 k = 0; k < REGISTER_RECORDS_PER_MODULE; k++)
+    return (u32)s1 <= (u32)s2 + l2 && (u32)s2 <= (u32)s1 + l1;
+}
+
+// Writes a single entry that spans [start, start + length) and contains the values of all old ranges of the
+// component within that span, overwritten by the new values.
+static u16 WriteMergedRegisterRange(const u8* oldRecordStorage, u16 oldRecordStorageLength, u16 component, u16 start, u16 length, u16 newRegister, u16 newLength, const u8* newValues, u8* out)
+{
+    RegisterRecordEntry* merged = (RegisterRecordEntry*)out;
+    merged->component = component;
+    merged->reg = start;
+    merged->length = length;
+    CheckedMemset(merged->values, 0, length);
+
+    u16 offset = 0;
+    const RegisterRecordEntry* entry = nullptr;
+    while ((entry = ReadRegisterRecordEntry(oldRecordStorage, oldRecordStorageLength, offset)) != nullptr)
     {
-        const u16 id = baseId + k;
-        RecordStorageRecord* record = GS->recordStorage.GetRecord(id);
-        if (record)
+        if (entry->component == component && DoRangesOverlap(entry->reg, entry->length, newRegister, newLength))
         {
-            if (record->recordLength % sizeof(u16) == 1)
-            {
-                GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, 0);
-                SIMEXCEPTION(IllegalStateException);
-                continue;
-            }
-            u16* oldRecordStorage = (u16*)record->data;
-            const u16 amountOfU16 = record->recordLength / sizeof(u16);
-            for (u32 i = 0; i < amountOfU16; i++)
-            {
-                // Basic sanity check. We need at least 2 u16 for component, amount_of_ranges
-                if(amountOfU16 - i < 2) GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, 1);
-
-                const u16 component = READ();
-                const u16 amount_of_ranges = READ();
-                for (u32 k = 0; k < amount_of_ranges; k++)
-                {
-                    // Basic sanity check. We need at least 3 u16 for component, register, value[s]
-                    if (amountOfU16 - i < 3) GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, 2);
-                    const u16 reg = READ();
-                    const u16 length = READ();
-                    // Checking that we have enough data left for the length
-                    if (amountOfU16 - i < length) GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, 3);
-                    SetRegisterValues(component, reg, oldRecordStorage + i, length, nullptr, 0, nullptr, 0, RegisterHandlerSetSource::FLASH);
-                    SKIP(length);
-                }
-            }
+            CheckedMemcpy(merged->values + (entry->reg - start), entry->values, entry->length);
         }
     }
-}
+    CheckedMemcpy(merged->values + (newRegister - start), newValues, newLength);
 
-static bool DoRangesOverlap(u16 s1, u16 l1, u16 s2, u16 l2)
-{
-    // s = start
-    // l = length
-    // e = end
-
-    u16 e1 = s1 + l1 - 1;
-    u16 e2 = s2 + l2 - 1;
-    return (s2 >= s1 && s2 <= e1 + 1)
-        || (e2 >= s1 && e2 <= e1 + 1)
-        || (s1 >= s2 && s1 <= e2 + 1)
-        || (e1 >= s2 && e1 <= e2 + 1);
+    return SIZEOF_REGISTER_RECORD_ENTRY_HEADER + length;
 }
 
-// Checks with how many ranges the new range "overlaps". Touching does count as overlap, too. So these Ranges do overlap (both numbers inclusive)
-// [4, 10] and [7, 13]
-// [4, 10] and [10, 13]
-// [4, 10] and [5, 6]
-// But these do not overlap:
-// [4, 10] and [11, 13]
-static u16 DetermineAmountOfOverlaps(const u16* oldRecordStorage, u32 i, u16 amountOfRanges, u16 newRegister, u16 newLength)
+u16 InsertRegisterRange(const u8* oldRecordStorage, u16 oldRecordStorageLength, u16 newComponent, u16 newRegister, u16 newLength, const u8* newValues, u8* newRecordStorage)
 {
-    u16 retVal = 0;
-    for (u32 k = 0; k < amountOfRanges; k++)
+    // As the stored ranges never touch each other, all ranges that have to be merged
+    // with the new range can be found by comparing them with the new range alone.
+    u32 mergedStart = newRegister;
+    u32 mergedEnd = newRegister + newLength;
+    u16 offset = 0;
+    const RegisterRecordEntry* entry = nullptr;
+    while ((entry = ReadRegisterRecordEntry(oldRecordStorage, oldRecordStorageLength, offset)) != nullptr)
     {
-        u16 oldRegister = READ();
-        u16 oldLength = READ();
-        SKIP(oldLength);
-        if (DoRangesOverlap(oldRegister, oldLength, newRegister, newLength))
+        if (entry->component == newComponent && DoRangesOverlap(entry->reg, entry->length, newRegister, newLength))
         {
-            retVal++;
+            if (entry->reg < mergedStart) mergedStart = entry->reg;
+            if ((u32)entry->reg + entry->length > mergedEnd) mergedEnd = entry->reg + entry->length;
         }
     }
-    return retVal;
+
+    u16 writeHead = 0;
+    bool wroteMergedRange = false;
+    offset = 0;
+    while ((entry = ReadRegisterRecordEntry(oldRecordStorage, oldRecordStorageLength, offset)) != nullptr)
+    {
+        // Ranges that are merged are written together with the new range
+        if (entry->component == newComponent && DoRangesOverlap(entry->reg, entry->length, newRegister, newLength)) continue;
+
+        if (!wroteMergedRange && (entry->component > newComponent || (entry->component == newComponent && entry->reg > mergedStart)))
+        {
+            writeHead += WriteMergedRegisterRange(oldRecordStorage, oldRecordStorageLength, newComponent, mergedStart, mergedEnd - mergedStart, newRegister, newLength, newValues, newRecordStorage + writeHead);
+            wroteMergedRange = true;
+        }
+
+        const u16 entrySize = SIZEOF_REGISTER_RECORD_ENTRY_HEADER + entry->length;
+        CheckedMemcpy(newRecordStorage + writeHead, entry, entrySize);
+        writeHead += entrySize;
+    }
+
+    if (!wroteMergedRange)
+    {
+        writeHead += WriteMergedRegisterRange(oldRecordStorage, oldRecordStorageLength, newComponent, mergedStart, mergedEnd - mergedStart, newRegister, newLength, newValues, newRecordStorage + writeHead);
+    }
+
+    return writeHead;
 }
 
-static u16 DetermineOverlappingRangeSize(const u16* oldRecordStorage, u32 i, u16 amountOfOverlaps, u16 newRegister, u16 newLength)
+RegisterSubscriptions::RegisterSubscriptions()
 {
-    const u16 oldRegister = READ();
-    const u16 oldLength = READ();
-    const u16 start = (oldRegister < newRegister) ? oldRegister : newRegister;
-    const u16 oldEnd = oldRegister + oldLength;
-    const u16 newEnd = newRegister + newLength;
-    const u16 end = (oldEnd > newEnd) ? oldEnd : newEnd;
-    u16 length = end - start;
-    SKIP(oldLength);
-    for (u32 k = 1; k < amountOfOverlaps; k++)
+    CheckedMemset(subscriptions, 0, sizeof(subscriptions));
+    for (u32 i = 0; i < MAX_REGISTER_SUBSCRIPTIONS; i++)
     {
-        const u16 reg = READ();
-        const u16 len = READ();
-        length += len - (start + length - reg);
+        subscriptions[i].subscriber = NODE_ID_INVALID;
     }
-    return length;
 }
 
-u16 InsertRegisterRange(const u8* oldRecordStorage, u16 oldRecordStorageLength, u16 newComponent, u16 newRegister, u16 newLength, const u8* newValues, u8* newRecordStorage)
+RegisterSubscriptions::Subscription* RegisterSubscriptions::Find(NodeId subscriber, ModuleIdWrapper moduleId, u16 component, u16 reg)
 {
-    u16 writeHead = 0;
-    bool foundComponent = false;
-    for (u32 i = 0; i < oldRecordStorageLength; i++)
+    for (u32 i = 0; i < MAX_REGISTER_SUBSCRIPTIONS; i++)
     {
-        u16 oldComponent = READ();
-        u16 amountOfRanges = READ();
-        WRITE(oldComponent);
-        if (oldComponent != newComponent)
+        Subscription& s = subscriptions[i];
+        if (s.subscriber == subscriber && Utility::IsSameModuleId(s.moduleId, moduleId) && s.component == component && s.reg == reg)
         {
-            // We aren't in the right component, copy paste fast forward
-            WRITE(amountOfRanges);
-            for (u32 k = 0; k < amountOfRanges; k++)
-            {
-                COPY(1);
-                u16 length = READ();
-                WRITE(length);
-                COPY(length);
-            }
+            return &s;
         }
-        else
+    }
+    return nullptr;
+}
+
+RegisterHandlerCode RegisterSubscriptions::Subscribe(NodeId subscriber, ModuleIdWrapper moduleId, u16 component, u16 reg, u8 requestHandle, const RegisterSubscribeMessage& message, const u8* values)
+{
+    if (message.length == 0 || message.length > REGISTER_SUBSCRIPTION_MAX_LENGTH)
+    {
+        return RegisterHandlerCode::ILLEGAL_LENGTH;
+    }
+
+    Subscription* s = Find(subscriber, moduleId, component, reg);
+    for (u32 i = 0; i < MAX_REGISTER_SUBSCRIPTIONS && s == nullptr; i++)
+    {
+        if (subscriptions[i].subscriber == NODE_ID_INVALID) s = &subscriptions[i];
+    }
+    if (s == nullptr)
+    {
+        return RegisterHandlerCode::NO_FREE_SUBSCRIPTION;
+    }
+
+    s->moduleId = moduleId;
+    s->subscriber = subscriber;
+    s->component = component;
+    s->reg = reg;
+    s->length = message.length;
+    s->requestHandle = requestHandle;
+    s->changed = false;
+    s->minIntervalDs = message.minIntervalDs < REGISTER_SUBSCRIPTION_MIN_INTERVAL_DS ? REGISTER_SUBSCRIPTION_MIN_INTERVAL_DS : message.minIntervalDs;
+    s->lastCheckDs = GS->appTimerDs;
+    s->lastSentDs = GS->appTimerDs;
+    s->expiryDs = message.lifetimeSec == 0 ? 0 : GS->appTimerDs + message.lifetimeSec * 10UL;
+    // The subscriber receives the current values with the response, so only later changes are pushed
+    s->valuesCrc = Utility::CalculateCrc32(values, message.length);
+
+    logt("MODULE", "Subscription of node %u to %u-%u of component %u", subscriber, reg, reg + message.length - 1, component);
+
+    return RegisterHandlerCode::SUCCESS;
+}
+
+void RegisterSubscriptions::Unsubscribe(NodeId subscriber, ModuleIdWrapper moduleId, u16 component, u16 reg)
+{
+    Subscription* s = Find(subscriber, moduleId, component, reg);
+    if (s != nullptr)
+    {
+        s->subscriber = NODE_ID_INVALID;
+    }
+}
+
+void RegisterSubscriptions::NotifyChanged(ModuleIdWrapper moduleId, u16 component, u16 reg, u16 length)
+{
+    for (u32 i = 0; i < MAX_REGISTER_SUBSCRIPTIONS; i++)
+    {
+        Subscription& s = subscriptions[i];
+        if (s.subscriber != NODE_ID_INVALID
+            && Utility::IsSameModuleId(s.moduleId, moduleId)
+            && s.component == component
+            && reg < s.reg + s.length
+            && s.reg < reg + length)
         {
-            foundComponent = true;
-            const u16 amountOfOverlaps = DetermineAmountOfOverlaps(oldRecordStorage, i, amountOfRanges, newRegister, newLength);
-            const u16 newAmountOfRanges = amountOfRanges + 1 - amountOfOverlaps;
-            WRITE(newAmountOfRanges);
-            bool wroteRegister = false;
-            for (u32 k = 0; k < amountOfRanges; k++)
-            {
-                u16 oldRegister = READ();
-                u16 oldLength = READ();
-                if (DoRangesOverlap(oldRegister, oldLength, newRegister, newLength))
-                {
-                    i -= 2; // So that we can reread the register and length below. Avoids special cases.
-                    const u16 newMergedRangeSize = DetermineOverlappingRangeSize(oldRecordStorage, i, amountOfOverlaps, newRegister, newLength);
-                    const u16 start = (oldRegister < newRegister) ? oldRegister : newRegister;
-                    DYNAMIC_ARRAY(mergedRange, newMergedRangeSize * sizeof(u16));
-                    CheckedMemset(mergedRange, 0, newMergedRangeSize * sizeof(u16));
-                    // Write the old ranges to the merge area
-                    k += amountOfOverlaps - 1;
-                    for (u32 m = 0; m < amountOfOverlaps; m++)
-                    {
-                        u16 reg = READ();
-                        u16 len = READ();
-                        u16 offset = reg - start;
-                        for (u32 z = 0; z < len; z++)
-                        {
-                            mergedRange[z + offset] = READ();
-                        }
-                    }
-                    // Write the new range to the merge area
-                    u16 offset = newRegister - start;
-                    for (u32 z = 0; z < newLength; z++)
-                    {
-                        mergedRange[z + offset] = newValues[z];
-                    }
-                    WRITE(start);
-                    WRITE(newMergedRangeSize);
-                    for (u32 z = 0; z < newMergedRangeSize; z++)
-                    {
-                        WRITE(mergedRange[z]);
-                    }
-                    wroteRegister = true;
-                }
-                else if (newRegister <= oldRegister && !wroteRegister)
-                {
-                    wroteRegister = true;
-                    WRITE_NEW_RANGE();
-                    WRITE(oldRegister);
-                    WRITE(oldLength);
-                    COPY(oldLength);
-                }
-                else
-                {
-                    WRITE(oldRegister);
-                    WRITE(oldLength);
-                    COPY(oldLength);
-                }
-            }
-            if (!wroteRegister)
-            {
-                WRITE_NEW_RANGE();
-            }
+            s.changed = true;
         }
     }
+}
+
+u32 RegisterSubscriptions::GetAmountOfSubscriptions() const
+{
+    u32 amount = 0;
+    for (u32 i = 0; i < MAX_REGISTER_SUBSCRIPTIONS; i++)
+    {
+        if (subscriptions[i].subscriber != NODE_ID_INVALID) amount++;
+    }
+    return amount;
+}
 
-    if (!foundComponent)
+void RegisterSubscriptions::Check(Subscription& subscription)
+{
+    subscription.lastCheckDs = GS->appTimerDs;
+    subscription.changed = false;
+
+    Module* module = GS->node.GetModuleById((VendorModuleId)subscription.moduleId);
+    if (module == nullptr)
     {
-        // The right component wasn't found, so we have to append it.
-        WRITE(newComponent);
-        WRITE(1); // Amount of register ranges in this component. As this is the first one, we only have one.
-        WRITE_NEW_RANGE();
+        subscription.subscriber = NODE_ID_INVALID;
+        return;
     }
 
-    return writeHead;
+    u8 values[REGISTER_SUBSCRIPTION_MAX_LENGTH];
+    if (module->GetRegisterValues(subscription.component, subscription.reg, values, subscription.length) != RegisterHandlerCode::SUCCESS) return;
+
+    // Changes that were reverted in the meantime or writes of identical values are not pushed
+    const u32 crc = Utility::CalculateCrc32(values, subscription.length);
+    if (crc == subscription.valuesCrc) return;
+    subscription.valuesCrc = crc;
+    subscription.lastSentDs = GS->appTimerDs;
+
+    Module::SendComponentSense(
+        subscription.subscriber,
+        subscription.moduleId,
+        subscription.component,
+        subscription.reg,
+        subscription.requestHandle,
+        SensorMessageActionType::UNSPECIFIED,
+        values,
+        subscription.length);
+    SIMSTATCOUNT("RegisterSubscriptionPush");
+}
+
+void RegisterSubscriptions::TimerEventHandler(u16 passedTimeDs)
+{
+    for (u32 i = 0; i < MAX_REGISTER_SUBSCRIPTIONS; i++)
+    {
+        Subscription& s = subscriptions[i];
+        if (s.subscriber == NODE_ID_INVALID) continue;
+
+        if (s.expiryDs != 0 && GS->appTimerDs >= s.expiryDs)
+        {
+            logt("MODULE", "Subscription of node %u to %u of component %u expired", s.subscriber, s.reg, s.component);
+            s.subscriber = NODE_ID_INVALID;
+            continue;
+        }
+
+        // Written ranges are pushed as soon as the rate limit allows, everything else is sampled once per interval
+        if ((s.changed && GS->appTimerDs - s.lastSentDs >= s.minIntervalDs)
+            || GS->appTimerDs - s.lastCheckDs >= s.minIntervalDs)
+        {
+            Check(s);
+        }
+    }
 }
-#endif
 
 #endif //IS_ACTIVE(REGISTER_HANDLER)
@@ -67,6 +67,7 @@ enum class RegisterHandlerCode : u8
     PERSISTED_ID_OUT_OF_RANGE = 17,
     NOT_IMPLEMENTED           = 18,
     NOT_WRITABLE              = 19,
+    NO_FREE_SUBSCRIPTION      = 20,
 
     RECORD_STORAGE_CODES_START = 100,
     RECORD_STORAGE_CODES_END   = 150,
@@ -109,26 +110,95 @@ enum class RegisterHandlerSetSource
     INTERNAL, // Manually called from some other source internal to this node.
 };
 
-// Record Storage Layout:
-// u16 Component
-//   u16 amount_of_ranges
-//     u16 register
-//     u16 length
-//     u8... values
-//   ...
+// Record Storage Layout of the persisted registers of a module. The entries are sorted by component
+// and register and the ranges of the same component never overlap or touch each other.
+// u16 component
+// u16 register
+// u16 length
+// u8  values[length]
 // ...
-struct RegisterRange
+#pragma pack(push)
+#pragma pack(1)
+constexpr u16 SIZEOF_REGISTER_RECORD_ENTRY_HEADER = 6;
+struct RegisterRecordEntry
 {
+    u16 component;
     u16 reg;
     u16 length;
     u8 values[1]; // More may follow
 };
-// Serializes and combines an existing Record Storage entry with some new Register Range. The function assumes that newRecordStorage is
-// guaranteed to be big enough and that the oldRecordStorage data is healthy. It performs NO sanity checks! It returns how many
-// registers (u16s) have actually been written.
-#ifdef JSTODO_PERSISTENCE
+STATIC_ASSERT_SIZE(RegisterRecordEntry, SIZEOF_REGISTER_RECORD_ENTRY_HEADER + 1);
+#pragma pack(pop)
+
+// Returns the entry at offset and moves the offset to the next entry. Returns nullptr once the end of the
+// record is reached or if the remaining data is too short to hold the next entry.
+const RegisterRecordEntry* ReadRegisterRecordEntry(const u8* record, u16 recordLength, u16& offset);
+// Serializes and combines an existing Record Storage entry with some new Register Range. Ranges of the same
+// component that overlap or touch the new range are merged with it. The function assumes that newRecordStorage
+// is big enough to hold oldRecordStorageLength + SIZEOF_REGISTER_RECORD_ENTRY_HEADER + newLength bytes.
+// It returns how many bytes have actually been written.
 u16 InsertRegisterRange(const u8* oldRecordStorage, u16 oldRecordStorageLength, u16 newComponent, u16 newRegister, u16 newLength, const u8* newValues, u8* newRecordStorage);
-#endif
+
+// Payload of a component_act with the SUBSCRIBE action type. The subscriber is informed about changes of the
+// given register range with component_sense messages of the UNSPECIFIED action type. A length of 0 removes
+// the subscription.
+#pragma pack(push)
+#pragma pack(1)
+constexpr u16 SIZEOF_REGISTER_SUBSCRIBE_MESSAGE = 5;
+struct RegisterSubscribeMessage
+{
+    u8 length;
+    u16 minIntervalDs; // Changes are coalesced and sent at most once in this interval
+    u16 lifetimeSec;   // The subscription is removed after this time unless renewed, 0 keeps it until a reboot
+};
+STATIC_ASSERT_SIZE(RegisterSubscribeMessage, SIZEOF_REGISTER_SUBSCRIBE_MESSAGE);
+#pragma pack(pop)
+
+constexpr u32 MAX_REGISTER_SUBSCRIPTIONS = 8;
+constexpr u8 REGISTER_SUBSCRIPTION_MAX_LENGTH = 32;
+constexpr u16 REGISTER_SUBSCRIPTION_MIN_INTERVAL_DS = 10;
+
+/*
+ * Keeps track of the register ranges that other nodes subscribed to. Ranges that are written through the
+ * RegisterHandler are pushed as soon as the rate limit of the subscription allows it, all other ranges
+ * (e.g. data registers that change on their own) are sampled once per interval. Only ranges whose values
+ * differ from the last sent values are pushed.
+ */
+class RegisterSubscriptions
+{
+private:
+    struct Subscription
+    {
+        ModuleIdWrapper moduleId;
+        NodeId subscriber; // NODE_ID_INVALID marks an unused entry
+        u16 component;
+        u16 reg;
+        u8 length;
+        u8 requestHandle;
+        bool changed;
+        u16 minIntervalDs;
+        u32 lastCheckDs;
+        u32 lastSentDs;
+        u32 expiryDs; // 0 if the subscription does not expire
+        u32 valuesCrc;
+    };
+    Subscription subscriptions[MAX_REGISTER_SUBSCRIPTIONS];
+
+    Subscription* Find(NodeId subscriber, ModuleIdWrapper moduleId, u16 component, u16 reg);
+    void Check(Subscription& subscription);
+
+public:
+    RegisterSubscriptions();
+
+    // Adds or renews the subscription of the subscriber, values are the current values of the range
+    RegisterHandlerCode Subscribe(NodeId subscriber, ModuleIdWrapper moduleId, u16 component, u16 reg, u8 requestHandle, const RegisterSubscribeMessage& message, const u8* values);
+    void Unsubscribe(NodeId subscriber, ModuleIdWrapper moduleId, u16 component, u16 reg);
+    // Must be called once registers were changed through the RegisterHandler
+    void NotifyChanged(ModuleIdWrapper moduleId, u16 component, u16 reg, u16 length);
+    u32 GetAmountOfSubscriptions() const;
+
+    void TimerEventHandler(u16 passedTimeDs);
+};
 
 /*
  * A universal value that keeps track of which type it has.
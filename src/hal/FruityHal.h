@@ -401,6 +401,8 @@ namespace FruityHal
     ErrorType BleGapAdvStart(u8 *advHandle, BleGapAdvParams const &advParams);
     ErrorType BleGapAdvDataSet(u8 * p_advHandle, u8 *advData, u8 advDataLength, u8 *scanData, u8 scanDataLength);
     ErrorType BleGapAdvStop(u8 advHandle);
+    //Returns the number of advertising sets that can advertise at the same time
+    u8 BleGapGetMaxAdvertisingSets();
 
     ErrorType BleTxPacketCountGet(u16 connectionHandle, u8* count);
 
@@ -459,6 +461,8 @@ namespace FruityHal
     ErrorType StartTimers();
     u32 GetRtcMs();
     u32 GetRtcDifferenceMs(u32 nowTimeMs, u32 previousTimeMs);
+    u32 GetRtcTicks();
+    u32 GetRtcTicksDifference(u32 nowTicks, u32 previousTicks);
     ErrorType CreateTimer(swTimer &timer, bool repeated, TimerHandler handler);
     ErrorType StartTimer(swTimer timer, u32 timeoutMs);
     ErrorType StopTimer(swTimer timer);
@@ -719,6 +719,7 @@ void FruityHal::DispatchBleEvents(void const * eventVirtualPointer)
 {
     const ble_evt_t& bleEvent = *((ble_evt_t const *)eventVirtualPointer);
     u16 eventId = bleEvent.header.evt_id;
+    STACK_WATCHER_SCOPE("BleEvent", nullptr, eventId);
     if (eventId == BLE_GAP_EVT_ADV_REPORT || eventId == BLE_GAP_EVT_RSSI_CHANGED) {
         logt("EVENTS2", "BLE EVENT %s (%d)", getBleEventNameString(eventId), eventId);
     }
@@ -1521,7 +1522,11 @@ ErrorType FruityHal::BleGapAdvStart(u8 * advHandle, BleGapAdvParams const &advPa
     adv_params.p_peer_addr = nullptr;
     adv_params.timeout = advParams.timeout;
     adv_params.type = AdvertisingTypeToNrf(advParams.type);
+#ifdef SIM_ENABLED
+    err = sim_ble_gap_adv_start(advHandle, &adv_params, BLE_CONN_CFG_TAG_FM);
+#else
     err = sd_ble_gap_adv_start(&adv_params, BLE_CONN_CFG_TAG_FM);
+#endif
     logt("FH", "Adv start (%u) typ %u, iv %u, mask %u", err, adv_params.type, adv_params.interval, *((u8*)&adv_params.channel_mask));
 #endif // (SDK >= 15)
     return nrfErrToGeneric(err);
@@ -1545,6 +1550,14 @@ ErrorType FruityHal::BleGapAdvDataSet(u8 * p_advHandle, u8 *advData, u8 advDataL
                 );
         logt("FH", "Adv data set (%u) handle %u", err, *p_advHandle);
     }
+#elif defined(SIM_ENABLED)
+    err = sim_ble_gap_adv_data_set(
+                p_advHandle,
+                advData,
+                advDataLength,
+                scanData,
+                scanDataLength
+            );
 #else
     err = sd_ble_gap_adv_data_set(
                 advData,
@@ -1563,6 +1576,8 @@ ErrorType FruityHal::BleGapAdvStop(u8 advHandle)
     u32 err;
 #if (SDK >= 15)
     err = sd_ble_gap_adv_stop(advHandle);
+#elif defined(SIM_ENABLED)
+    err = sim_ble_gap_adv_stop(advHandle);
 #else
     err = sd_ble_gap_adv_stop();
 #endif
@@ -1570,6 +1585,16 @@ ErrorType FruityHal::BleGapAdvStop(u8 advHandle)
     return nrfErrToGeneric(err);
 }
 
+u8 FruityHal::BleGapGetMaxAdvertisingSets()
+{
+#ifdef SIM_ENABLED
+    return sim_get_max_advertising_sets();
+#else
+    //The supported SoftDevices can only advertise with a single set (BLE_GAP_ADV_SET_COUNT_MAX)
+    return 1;
+#endif
+}
+
 ErrorType FruityHal::BleGapConnect(FruityHal::BleGapAddr const &peerAddress, BleGapScanParams const &scanParams, BleGapConnParams const &connectionParams)
 {
     u32 err;
@@ -2200,6 +2225,17 @@ u32 FruityHal::GetRtcDifferenceMs(u32 nowTimeMs, u32 previousTimeMs)
     return nowTimeMs - previousTimeMs;
 }
 
+u32 FruityHal::GetRtcTicks()
+{
+    return app_timer_cnt_get();
+}
+
+u32 FruityHal::GetRtcTicksDifference(u32 nowTicks, u32 previousTicks)
+{
+    //The RTC counter only has 24 bits on the nRF5 and overflows every 512 seconds
+    return app_timer_cnt_diff_compute(nowTicks, previousTicks);
+}
+
 //################################################
 #define _____________FAULT_HANDLERS_______________
 
@@ -122,6 +122,7 @@ ErrorType FruityHal::BleGapScanStop(){ return ErrorType::SUCCESS; }
 ErrorType FruityHal::BleGapAdvStart(u8 * advHandle, BleGapAdvParams const &advParams){ return ErrorType::SUCCESS; }
 ErrorType FruityHal::BleGapAdvDataSet(u8 * p_advHandle, u8 *advData, u8 advDataLength, u8 *scanData, u8 scanDataLength){ return ErrorType::SUCCESS; }
 ErrorType FruityHal::BleGapAdvStop(u8 advHandle){ return ErrorType::SUCCESS; }
+u8 FruityHal::BleGapGetMaxAdvertisingSets(){ return 1; }
 
 ErrorType FruityHal::BleTxPacketCountGet(u16 connectionHandle, u8* count){ return ErrorType::SUCCESS; }
 
@@ -169,6 +170,8 @@ ErrorType FruityHal::InitTimers(){ return ErrorType::SUCCESS; }
 ErrorType FruityHal::StartTimers(){ return ErrorType::SUCCESS; }
 u32 FruityHal::GetRtcMs(){ return 0; }
 u32 FruityHal::GetRtcDifferenceMs(u32 nowTimeMs, u32 previousTimeMs){ return 0; }
+u32 FruityHal::GetRtcTicks(){ return 0; }
+u32 FruityHal::GetRtcTicksDifference(u32 nowTicks, u32 previousTicks){ return 0; }
 ErrorType FruityHal::CreateTimer(swTimer &timer, bool repeated, TimerHandler handler){ return ErrorType::SUCCESS; }
 ErrorType FruityHal::StartTimer(swTimer timer, u32 timeoutMs){ return ErrorType::SUCCESS; }
 ErrorType FruityHal::StopTimer(swTimer timer){ return ErrorType::SUCCESS; }
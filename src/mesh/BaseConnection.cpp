@@ -35,6 +35,9 @@
 #include <ConnectionManager.h>
 #include <GlobalState.h>
 #include <MeshConnection.h>
+#ifdef SIM_ENABLED
+#include <CherrySim.h>
+#endif
 
 constexpr int BASE_CONNECTION_MAX_SEND_FAIL  = 10;
 
@@ -120,9 +123,33 @@ bool BaseConnection::QueueData(const BaseConnectionSendData &sendData, u8 const
 
     CheckedMemcpy(buffer + SIZEOF_BASE_CONNECTION_SEND_DATA_PACKED, data, sendData.dataLength.GetRaw());
 
-    const bool successfullyQueued = queue.SplitAndAddMessage(overwritePriority == DeliveryPriority::INVALID ? GetPriorityOfMessage(data, sendData.dataLength) : overwritePriority, buffer, bufferSize, connectionPayloadSize, messageHandle);
+    const DeliveryPriority priority = overwritePriority == DeliveryPriority::INVALID ? GetPriorityOfMessage(data, sendData.dataLength) : overwritePriority;
+
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+    const u32 queueDepth = queue.GetQueueByPriority(priority)->GetAmountOfPackets();
+    queueDepthHistograms[(u32)priority].Add(queueDepth);
+    GS->cm.queueDepthHistograms[(u32)priority].Add(queueDepth);
+#endif
+
+    u32 queuedMessageHandle = 0;
+    const bool successfullyQueued = queue.SplitAndAddMessage(priority, buffer, bufferSize, connectionPayloadSize, &queuedMessageHandle);
+    if (messageHandle != nullptr) *messageHandle = queuedMessageHandle;
 
     if(successfullyQueued){
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+        //Only one message per priority is timed at a time so that the queue entries do not need a timestamp
+        QueueLatencySample& sample = queueLatencySamples[(u32)priority];
+        if (sample.messageHandle == 0)
+        {
+            sample.messageHandle = queuedMessageHandle;
+            sample.enqueueTimeMs = FruityHal::GetRtcMs();
+        }
+#endif
+#ifdef SIM_ENABLED
+        if (sendData.dataLength > connectionPayloadSize) {
+            cherrySimInstance->TracePacket(PacketTraceEventType::SPLIT, partnerId, uniqueConnectionId, priority, data, sendData.dataLength.GetRaw());
+        }
+#endif
         if (fillTxBuffers) FillTransmitBuffers();
         return true;
     } else {
@@ -135,6 +162,9 @@ bool BaseConnection::QueueData(const BaseConnectionSendData &sendData, u8 const
         //Currently, additional packets are dropped
         logt("CM", "Send queue is already full");
         SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_DROPPED_PACKETS));
+#ifdef SIM_ENABLED
+        cherrySimInstance->TracePacket(PacketTraceEventType::DROP, partnerId, uniqueConnectionId, priority, data, sendData.dataLength.GetRaw());
+#endif
 
         //For safety, we try to fill the transmitbuffers if it got stuck
         if(fillTxBuffers) FillTransmitBuffers();
@@ -260,6 +290,45 @@ void BaseConnection::FillTransmitBuffers()
     }
 }
 
+void BaseConnection::DiscardExpiredPackets()
+{
+    const std::array<u32, AMOUNT_OF_SEND_QUEUE_PRIORITIES> discardedPackets = queue.DiscardExpiredMessages();
+    for (u32 i = 0; i < discardedPackets.size(); i++)
+    {
+        if (discardedPackets[i] == 0) continue;
+
+        GS->cm.expiredMeshPackets[i] += discardedPackets[i];
+        GS->logger.LogCustomCount(CustomErrorTypes::COUNT_EXPIRED_PACKETS, discardedPackets[i]);
+
+        logt("CM", "Discarded %u expired packets with prio %u", discardedPackets[i], i);
+        SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_EXPIRED_PACKETS));
+#ifdef SIM_ENABLED
+        cherrySimInstance->TracePacket(PacketTraceEventType::EXPIRE, partnerId, uniqueConnectionId, (DeliveryPriority)i, nullptr, (u16)discardedPackets[i]);
+#endif
+    }
+}
+
+void QueueHistogram::Add(u32 value)
+{
+    u32 bucket = 0;
+    while (value > 0 && bucket < QUEUE_HISTOGRAM_NUM_BUCKETS - 1)
+    {
+        value >>= 1;
+        bucket++;
+    }
+
+    if (buckets[bucket] == UINT16_MAX)
+    {
+        for (u16& count : buckets) count /= 2;
+    }
+    buckets[bucket]++;
+}
+
+u32 QueueHistogram::GetBucketLowerBound(u32 bucket)
+{
+    return bucket == 0 ? 0 : (1UL << (bucket - 1));
+}
+
 void BaseConnection::HandlePacketQueued()
 {
     packetFailedToQueueCounter = 0;
@@ -297,8 +366,8 @@ void BaseConnection::HandlePacketSent(u8 sentUnreliable, u8 sentReliable)
             return;
         }
 
-        ChunkedPacketQueue *const activeQueue = [this]() {
-            DeliveryPriority deliveryPriority = {};
+        DeliveryPriority deliveryPriority = {};
+        ChunkedPacketQueue *const activeQueue = [this, &deliveryPriority]() {
             FRUITYMESH_ERROR_CHECK(queueOrigins.TryPeekAndPop(deliveryPriority) ? (u32)ErrorType::SUCCESS
                                                                                 : (u32)ErrorType::INVALID_STATE);
 
@@ -325,6 +394,7 @@ void BaseConnection::HandlePacketSent(u8 sentUnreliable, u8 sentReliable)
         if (sendData->deliveryOption == (u8)DeliveryOption::WRITE_REQ && !sentReliable) {
             SIMEXCEPTION(IllegalStateException);
         }
+        cherrySimInstance->TracePacket(PacketTraceEventType::TX, partnerId, uniqueConnectionId, deliveryPriority, queueBuffer + SIZEOF_BASE_CONNECTION_SEND_DATA_PACKED, length - SIZEOF_BASE_CONNECTION_SEND_DATA_PACKED);
 #endif
         if (messageHandle == 0)
         {
@@ -355,11 +425,30 @@ void BaseConnection::HandlePacketSent(u8 sentUnreliable, u8 sentReliable)
 #endif
         }
 
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+        //All packets of the message were sent. The handles of a queue increase, so a bigger handle means
+        //that the timed message was discarded and the next queued message can be timed instead.
+        QueueLatencySample& sample = queueLatencySamples[(u32)deliveryPriority];
+        if (sample.messageHandle != 0 && messageHandle >= sample.messageHandle)
+        {
+            if (messageHandle == sample.messageHandle)
+            {
+                //The latency is counted in steps of 10 ms
+                const u32 latencySteps = FruityHal::GetRtcDifferenceMs(FruityHal::GetRtcMs(), sample.enqueueTimeMs) / 10;
+                queueLatencyHistograms[(u32)deliveryPriority].Add(latencySteps);
+                GS->cm.queueLatencyHistograms[(u32)deliveryPriority].Add(latencySteps);
+            }
+            sample.messageHandle = 0;
+        }
+#endif
 
         activeQueue->PopPacket();
         dataSentLength = 0;
     }
 
+    //Messages that were waiting behind the sent packets may have expired in the meantime
+    DiscardExpiredPackets();
+
     //Log how many packets have been sent
     this->sentUnreliable += sentUnreliable;
     this->sentReliable += sentReliable;
@@ -403,6 +492,10 @@ u8 const * BaseConnection::ReassembleData(BaseConnectionSendData* sendData, u8 c
 {
     ConnPacketSplitHeader const * packetHeader = (ConnPacketSplitHeader const *)data;
 
+#ifdef SIM_ENABLED
+    cherrySimInstance->TracePacket(PacketTraceEventType::RX, partnerId, uniqueConnectionId, DeliveryPriority::INVALID, data, sendData->dataLength.GetRaw());
+#endif
+
     //If reassembly is not needed, return packet without modifying
     if(packetHeader->splitMessageType != MessageType::SPLIT_WRITE_CMD && packetHeader->splitMessageType != MessageType::SPLIT_WRITE_CMD_END){
         currentMessageIsMissingASplit = false;
@@ -479,6 +572,9 @@ u8 const * BaseConnection::ReassembleData(BaseConnectionSendData* sendData, u8 c
         }
         else
         {
+#ifdef SIM_ENABLED
+            cherrySimInstance->TracePacket(PacketTraceEventType::REASSEMBLE, partnerId, uniqueConnectionId, DeliveryPriority::INVALID, data, sendData->dataLength.GetRaw());
+#endif
             return data;
         }
     }
@@ -65,6 +65,24 @@ typedef struct BaseConnectionSendDataPacked {
 #pragma pack(pop)
 STATIC_ASSERT_SIZE(BaseConnectionSendDataPacked, SIZEOF_BASE_CONNECTION_SEND_DATA_PACKED);
 
+//Counts values in buckets for 0, 1, 2-3, 4-7, ... The last bucket also counts all bigger values.
+//Once a bucket is full, all buckets are halved so that the distribution is kept.
+constexpr u32 QUEUE_HISTOGRAM_NUM_BUCKETS = 8;
+struct QueueHistogram
+{
+    std::array<u16, QUEUE_HISTOGRAM_NUM_BUCKETS> buckets{};
+
+    void Add(u32 value);
+    static u32 GetBucketLowerBound(u32 bucket);
+};
+
+//A queued message whose latency is measured, a messageHandle of 0 means that no message is timed
+struct QueueLatencySample
+{
+    u32 messageHandle;
+    u32 enqueueTimeMs;
+};
+
 class Node;
 class ConnectionManager;
 
@@ -197,6 +215,8 @@ class BaseConnection
         virtual void PacketSuccessfullyQueuedWithSoftdevice(SizedData* sentData);
         //Fills the tx buffers of the softdevice with the packets from the packet queue
         virtual void FillTransmitBuffers();
+        //Drops all queued messages that exceeded the maximum age of their priority
+        void DiscardExpiredPackets();
         //Gets passed the exact same data that was passed to the HAL. If that data was encrypted, the passed data
         //to this function is encrypted as well (e.g. in the MeshAccessConnection). This means that the data passed
         //to this function is the same as was returned by ProcessDataBeforeTransmission.
@@ -284,5 +304,12 @@ class BaseConnection
         u16 sentReliable = 0;
         u16 sentUnreliable = 0;
 
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+        //Queue statistics per DeliveryPriority, also collected for all connections in the ConnectionManager
+        std::array<QueueHistogram, AMOUNT_OF_SEND_QUEUE_PRIORITIES> queueDepthHistograms{}; //Packets that are already queued when a message is queued
+        std::array<QueueHistogram, AMOUNT_OF_SEND_QUEUE_PRIORITIES> queueLatencyHistograms{}; //Time in steps of 10 ms from queuing a message until its last packet was sent
+        std::array<QueueLatencySample, AMOUNT_OF_SEND_QUEUE_PRIORITIES> queueLatencySamples{}; //The message of each priority whose latency is currently measured
+#endif
+
         static u32 GetAmountOfRemovedConnections();
 };
@@ -161,6 +161,7 @@ void ConnectionManager::DeleteConnection(BaseConnection* connection, AppDisconne
 
     //Update Join me packet after connection was deleted so we have another free one
     GS->node.UpdateJoinMePacket();
+    GS->node.joinMeScoresDirty = true;
 }
 
 //TODO: Mesh specific
@@ -364,6 +365,13 @@ void ConnectionManager::SendMeshMessage(u8* data, u16 dataLength)
     if (err != ErrorType::SUCCESS) logt("ERROR", "Failed to send mesh message error code: %u", (u32)err);
 }
 
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+ErrorType ConnectionManager::SendMeshMessageReliable(u8* data, u16 dataLength, ReliableTransferListener* listener, u32 userType, u8* transferId)
+{
+    return reliableTransfer.Send(data, dataLength, listener, userType, transferId);
+}
+#endif
+
 ErrorType ConnectionManager::SendMeshMessageInternal(u8* data, u16 dataLength, bool reliable, bool loopback, bool toMeshAccess)
 {
     ErrorType err = ErrorType::SUCCESS;
@@ -457,7 +465,7 @@ ErrorType ConnectionManager::SendMeshMessageInternal(u8* data, u16 dataLength, b
     //Packets to the shortest sink, can only be sent to mesh partners
     if (packetHeader->receiver == NODE_ID_SHORTEST_SINK)
     {
-        MeshConnectionHandle dest = GetMeshConnectionToShortestSink(nullptr);
+        MeshConnectionHandle dest = GetMeshConnectionToSink(nullptr, packetHeader);
 
         if (GS->config.enableSinkRouting && dest)
         {
@@ -544,6 +552,31 @@ void ConnectionManager::DispatchMeshMessage(BaseConnection* connection, BaseConn
             packet = modifiedPacket;
         }
 
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+        //Segments are only passed on once the whole message was reassembled
+        if (packet->messageType == MessageType::RELIABLE_SEGMENT)
+        {
+            reliableTransfer.SegmentReceivedHandler(connection, (const ConnPacketReliableSegment*)packet, sendData->dataLength.GetRaw());
+            return;
+        }
+        if (packet->messageType == MessageType::RELIABLE_ACK)
+        {
+            reliableTransfer.AckReceivedHandler((const ConnPacketReliableAck*)packet);
+            return;
+        }
+#endif
+
+        if (packet->messageType == MessageType::SINK_LOAD)
+        {
+            SinkLoadReceivedHandler(connection, (const ConnPacketSinkLoad*)packet);
+            return;
+        }
+        if (packet->receiver == NODE_ID_SHORTEST_SINK && GET_DEVICE_TYPE() == DeviceType::SINK)
+        {
+            receivedSinkPackets++;
+            if (receivedSinkPacketsInInterval < UINT16_MAX) receivedSinkPacketsInInterval++;
+        }
+
         //Now we must pass the message to all of our modules for further processing
         BaseConnection* connectionToSendToModules = connection; //In case one of the modules MeshMessageReceivedHandlers remove the connection, we pass nullptr to the other modules.
         const u32 connectionToSendToModulesUniqueId = connectionToSendToModules != nullptr ? connectionToSendToModules->uniqueConnectionId : 0;
@@ -557,6 +590,7 @@ void ConnectionManager::DispatchMeshMessage(BaseConnection* connection, BaseConn
                         connectionToSendToModules = nullptr;
                     }
                 }
+                STACK_WATCHER_SCOPE("MeshMessageReceivedHandler", GS->activeModules[i]->moduleName, 0);
                 GS->activeModules[i]->MeshMessageReceivedHandler(connectionToSendToModules, sendData, packet);
             }
         }
@@ -791,7 +825,7 @@ void ConnectionManager::RouteMeshData(BaseConnection* connection, BaseConnection
     //The packet should continue to the shortest sink
     else if(packetHeader->receiver == NODE_ID_SHORTEST_SINK)
     {
-        MeshConnectionHandle connectionSink = GS->cm.GetMeshConnectionToShortestSink(connection);
+        MeshConnectionHandle connectionSink = GS->cm.GetMeshConnectionToSink(connection, packetHeader);
 
         if(GS->config.enableSinkRouting && connectionSink && !(routingDecision & ROUTING_DECISION_BLOCK_TO_MESH))
         {
@@ -942,6 +976,12 @@ u32 ConnectionManager::MessageTypeToMinimumPacketSize(MessageType messageType)
     case MessageType::SIG_MESH_SIMPLE:
         return SIZEOF_SIMPLE_SIG_MESSAGE;
 #endif
+    case MessageType::RELIABLE_SEGMENT:
+        return SIZEOF_CONN_PACKET_RELIABLE_SEGMENT_HEADER + 1;
+    case MessageType::RELIABLE_ACK:
+        return SIZEOF_CONN_PACKET_RELIABLE_ACK;
+    case MessageType::SINK_LOAD:
+        return SIZEOF_CONN_PACKET_SINK_LOAD;
     case MessageType::MODULE_CONFIG:
         return SIZEOF_CONN_PACKET_MODULE;
     case MessageType::MODULE_TRIGGER_ACTION:
@@ -1480,25 +1520,180 @@ BaseConnection * ConnectionManager::GetRawConnectionFromHandle(u16 connectionHan
     return nullptr;
 }
 
-//TODO: Only return mesh connections, check
 MeshConnectionHandle ConnectionManager::GetMeshConnectionToShortestSink(const BaseConnection* excludeConnection) const
 {
-    ClusterSize min = INT16_MAX;
+    //The chosen route is kept as long as it is usable, it is only switched in UpdateSinkRoute to avoid flapping
+    MeshConnectionHandle current(sinkRouteUniqueConnectionId);
+    if (current && current.GetConnection() != excludeConnection && current.IsHandshakeDone() && current.GetHopsToSink() > -1)
+    {
+        return current;
+    }
+    return GetMeshConnectionWithLowestSinkRouteCost(excludeConnection);
+}
+
+MeshConnectionHandle ConnectionManager::GetMeshConnectionWithLowestSinkRouteCost(const BaseConnection* excludeConnection) const
+{
+    u32 min = UINT32_MAX;
     MeshConnectionHandle c;
     MeshConnections conn = GetMeshConnections(ConnectionDirection::INVALID);
     for (int i = 0; i < conn.count; i++)
     {
         if (excludeConnection != nullptr && conn.handles[i].GetConnection() == excludeConnection)
             continue;
-        if (conn.handles[i].IsHandshakeDone() && conn.handles[i].GetHopsToSink() > -1 && conn.handles[i].GetHopsToSink() < min)
+        if (conn.handles[i].IsHandshakeDone() && conn.handles[i].GetHopsToSink() > -1)
         {
-            min = conn.handles[i].GetHopsToSink();
-            c = conn.handles[i];
+            const u32 cost = GetSinkRouteCost(conn.handles[i].GetConnection());
+            if (cost < min)
+            {
+                min = cost;
+                c = conn.handles[i];
+            }
         }
     }
     return c;
 }
 
+u32 ConnectionManager::GetSinkRouteCost(const MeshConnection* connection) const
+{
+    u32 cost = (u32)connection->hopsToSink * SINK_ROUTE_COST_PER_HOP;
+
+    //Weak links are more likely to lose packets or to break down
+    const i8 rssi = connection->GetAverageRSSI();
+    if (rssi != 0 && rssi < SINK_ROUTE_GOOD_RSSI)
+    {
+        cost += (u32)(SINK_ROUTE_GOOD_RSSI - rssi) * SINK_ROUTE_COST_PER_DB;
+    }
+
+    //Packets that are already queued delay everything that is queued after them
+    cost += std::min(connection->GetPendingPackets(), SINK_ROUTE_MAX_COUNTED_PACKETS) * SINK_ROUTE_COST_PER_QUEUED_PACKET;
+
+    //Drops show that the link could not keep up with the traffic recently
+    cost += std::min((u32)connection->recentDroppedPackets, SINK_ROUTE_MAX_COUNTED_PACKETS) * SINK_ROUTE_COST_PER_DROPPED_PACKET;
+
+    return cost;
+}
+
+void ConnectionManager::UpdateSinkRoute()
+{
+    MeshConnections conn = GetMeshConnections(ConnectionDirection::INVALID);
+    for (int i = 0; i < conn.count; i++)
+    {
+        MeshConnection* c = conn.handles[i].GetConnection();
+        if (c == nullptr) continue;
+        const u16 newDrops = c->droppedPackets - c->droppedPacketsAtLastSinkRouteUpdate;
+        c->droppedPacketsAtLastSinkRouteUpdate = c->droppedPackets;
+        c->recentDroppedPackets = (u8)std::min(c->recentDroppedPackets / 2 + newDrops, (int)UINT8_MAX);
+    }
+
+    MeshConnectionHandle best = GetMeshConnectionWithLowestSinkRouteCost(nullptr);
+    if (!best)
+    {
+        sinkRouteUniqueConnectionId = 0;
+        return;
+    }
+
+    const u32 bestCost = GetSinkRouteCost(best.GetConnection());
+    MeshConnectionHandle current(sinkRouteUniqueConnectionId);
+    if (current && current.IsHandshakeDone() && current.GetHopsToSink() > -1
+        && GetSinkRouteCost(current.GetConnection()) <= bestCost + SINK_ROUTE_HYSTERESIS)
+    {
+        return;
+    }
+
+    if (best.GetUniqueConnectionId() != sinkRouteUniqueConnectionId)
+    {
+        logt("SINK", "Sink route via partner %u, cost %u", best.GetPartnerId(), bestCost);
+        SIMSTATCOUNT("SinkRouteChanged");
+        sinkRouteUniqueConnectionId = best.GetUniqueConnectionId();
+    }
+}
+
+MeshConnectionHandle ConnectionManager::GetMeshConnectionToSink(const BaseConnection* excludeConnection, const ConnPacketHeader* packetHeader) const
+{
+    if (!GS->config.enableSinkLoadBalancing) return GetMeshConnectionToShortestSink(excludeConnection);
+
+    u32 totalWeight = 0;
+    MeshConnections conn = GetMeshConnections(ConnectionDirection::INVALID);
+    for (int i = 0; i < conn.count; i++)
+    {
+        if (conn.handles[i].GetConnection() == excludeConnection || !conn.handles[i].IsHandshakeDone() || conn.handles[i].GetHopsToSink() < 0) continue;
+        totalWeight += conn.handles[i].GetConnection()->sinkLoadBalancingWeight;
+    }
+    if (totalWeight == 0) return GetMeshConnectionToShortestSink(excludeConnection);
+
+    //The flow of a sender and message type is mapped to a fixed position within the summed up weights
+    const u8 flow[] = { (u8)(packetHeader->sender & 0xFF), (u8)(packetHeader->sender >> 8), (u8)packetHeader->messageType };
+    u32 position = Utility::CalculateCrc32(flow, sizeof(flow)) % totalWeight;
+    for (int i = 0; i < conn.count; i++)
+    {
+        if (conn.handles[i].GetConnection() == excludeConnection || !conn.handles[i].IsHandshakeDone() || conn.handles[i].GetHopsToSink() < 0) continue;
+        const u32 weight = conn.handles[i].GetConnection()->sinkLoadBalancingWeight;
+        if (position < weight) return conn.handles[i];
+        position -= weight;
+    }
+    return GetMeshConnectionToShortestSink(excludeConnection);
+}
+
+void ConnectionManager::SendSinkLoad()
+{
+    ConnPacketSinkLoad packet;
+    CheckedMemset(&packet, 0, sizeof(packet));
+    packet.header.messageType = MessageType::SINK_LOAD;
+    packet.header.sender = GS->node.configuration.nodeId;
+    packet.header.receiver = NODE_ID_BROADCAST;
+    packet.receivedPackets = receivedSinkPacketsInInterval;
+    receivedSinkPacketsInInterval = 0;
+
+    logt("SINK", "Sink load %u", packet.receivedPackets);
+    SendMeshMessage((u8*)&packet, SIZEOF_CONN_PACKET_SINK_LOAD);
+}
+
+void ConnectionManager::SinkLoadReceivedHandler(BaseConnection* connection, const ConnPacketSinkLoad* packet)
+{
+    if (connection == nullptr || connection->connectionType != ConnectionType::FRUITYMESH) return;
+    MeshConnection* c = (MeshConnection*)connection;
+
+    //A connection can lead to several sinks, the least loaded one is remembered as long as it keeps advertising
+    const bool expired = GS->appTimerDs - c->advertisedSinkLoadTimeDs > SINK_LOAD_VALIDITY_DS;
+    if (c->advertisedSinkId == NODE_ID_INVALID || expired || c->advertisedSinkId == packet->header.sender || packet->receivedPackets < c->advertisedSinkLoad)
+    {
+        c->advertisedSinkId = packet->header.sender;
+        c->advertisedSinkLoad = packet->receivedPackets;
+        c->advertisedSinkLoadTimeDs = GS->appTimerDs;
+    }
+}
+
+void ConnectionManager::UpdateSinkLoadBalancingWeights()
+{
+    MeshConnectionHandle best = GetMeshConnectionWithLowestSinkRouteCost(nullptr);
+    const u32 bestCost = best ? GetSinkRouteCost(best.GetConnection()) : 0;
+
+    MeshConnections conn = GetMeshConnections(ConnectionDirection::INVALID);
+    for (int i = 0; i < conn.count; i++)
+    {
+        MeshConnection* c = conn.handles[i].GetConnection();
+        if (c == nullptr) continue;
+        u8 weight = 0;
+        if (best && conn.handles[i].IsHandshakeDone() && c->hopsToSink > -1 && GetSinkRouteCost(c) <= bestCost + SINK_LOAD_BALANCING_MAX_EXTRA_COST)
+        {
+            //Sinks that did not advertise their load yet are treated as idle
+            u8 loadLevel = 0;
+            if (c->advertisedSinkId != NODE_ID_INVALID && GS->appTimerDs - c->advertisedSinkLoadTimeDs <= SINK_LOAD_VALIDITY_DS)
+            {
+                loadLevel = (u8)std::min(c->advertisedSinkLoad / SINK_LOAD_PACKETS_PER_LEVEL, SINK_LOAD_LEVELS - 1);
+            }
+            weight = SINK_LOAD_LEVELS - loadLevel;
+            //The shortest routes get twice the share of routes with an additional hop
+            if (c->hopsToSink <= best.GetHopsToSink()) weight *= 2;
+        }
+        if (weight != c->sinkLoadBalancingWeight)
+        {
+            logt("SINK", "Sink load balancing weight of partner %u: %u", c->partnerId, weight);
+            c->sinkLoadBalancingWeight = weight;
+        }
+    }
+}
+
 ClusterSize ConnectionManager::GetMeshHopsToShortestSink(const BaseConnection* excludeConnection) const
 {
     if (GET_DEVICE_TYPE() == DeviceType::SINK)
@@ -1555,6 +1750,19 @@ void ConnectionManager::TimerEventHandler(u16 passedTimeDs)
         FillTransmitBuffers();
     }
 
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+    reliableTransfer.TimerEventHandler(passedTimeDs);
+#endif
+
+    if (SHOULD_IV_TRIGGER(GS->appTimerDs, passedTimeDs, SINK_ROUTE_UPDATE_INTERVAL_DS)) {
+        UpdateSinkRoute();
+    }
+
+    if (GS->config.enableSinkLoadBalancing && SHOULD_IV_TRIGGER(GS->appTimerDs, passedTimeDs, SINK_LOAD_INTERVAL_DS)) {
+        if (GET_DEVICE_TYPE() == DeviceType::SINK) SendSinkLoad();
+        UpdateSinkLoadBalancingWeights();
+    }
+
     {
         //Go through all connections to do periodic cleanup tasks and other periodic work
         BaseConnections conns = GetConnectionsOfType(ConnectionType::INVALID, ConnectionDirection::INVALID);
@@ -1568,6 +1776,11 @@ void ConnectionManager::TimerEventHandler(u16 passedTimeDs)
             //The average rssi is caluclated using a moving average with 5% influece per time step
             conn->rssiAverageTimes1000 = (95 * (i32)conn->rssiAverageTimes1000 + 5000 * (i32)conn->lastReportedRssi) / 100;
 
+            //Messages also expire if the connection currently does not send anything, e.g. while reestablishing
+            if (SHOULD_IV_TRIGGER(GS->appTimerDs, passedTimeDs, SEC_TO_DS(1))) {
+                conn->DiscardExpiredPackets();
+            }
+
             //Check if an implementation failure did not clear the pending connection
             //FIXME: Should use a timeout stored in the connection as we do not know what connectingTimout this connection has
             if (pendingConnection != nullptr)
@@ -1648,10 +1861,11 @@ void ConnectionManager::TimerEventHandler(u16 passedTimeDs)
 
             if (conn->timeSyncState == MeshConnection::TimeSyncState::UNSYNCED)
             {
-                alignas(u32) TimeSyncInitial dataToSend = GS->timeManager.GetTimeSyncIntialMessage(conn->partnerId);
-
+                //Processes the passed ticks first so that both are taken at the same time
                 conn->syncSendingOrdered = GS->timeManager.GetLocalTimePoint();
 
+                alignas(u32) TimeSyncInitial dataToSend = GS->timeManager.GetTimeSyncIntialMessage(conn->partnerId);
+
                 logt("TSYNC", "Sending out TimeSyncInitial, NodeId: %u, partner: %u", (u32)GS->node.configuration.nodeId, (u32)conn->partnerId);
 
                 GS->cm.SendMeshMessage(
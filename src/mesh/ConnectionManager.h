@@ -40,6 +40,7 @@
 #include <BaseConnection.h>
 #include <MeshConnection.h>
 #include <ConnectionHandle.h>
+#include <ReliableTransfer.h>
 
 struct BaseConnections
 {
@@ -88,6 +89,38 @@ private:
 
     u32 uniqueConnectionIdCounter = 0; //Counts all created connections to assign "unique" ids
 
+    //Weights of the sink route cost, see GetSinkRouteCost. One hop outweighs most link quality penalties so that
+    //a longer route is only taken if the shorter one is in a really bad state
+    static constexpr u32 SINK_ROUTE_COST_PER_HOP = 100;
+    static constexpr i8  SINK_ROUTE_GOOD_RSSI = -60; //Links with an average rssi of at least this value are not penalized
+    static constexpr u32 SINK_ROUTE_COST_PER_DB = 2;
+    static constexpr u32 SINK_ROUTE_COST_PER_QUEUED_PACKET = 3;
+    static constexpr u32 SINK_ROUTE_COST_PER_DROPPED_PACKET = 5;
+    static constexpr u32 SINK_ROUTE_MAX_COUNTED_PACKETS = 20;
+    //The current sink route is only changed if another one is cheaper by more than this to avoid flapping
+    static constexpr u32 SINK_ROUTE_HYSTERESIS = 20;
+    static constexpr u16 SINK_ROUTE_UPDATE_INTERVAL_DS = SEC_TO_DS(1);
+    u32 sinkRouteUniqueConnectionId = 0; //The connection that is currently used for routing to the shortest sink
+
+    //Chooses the connection for sink routing periodically, see GetMeshConnectionToShortestSink
+    void UpdateSinkRoute();
+    MeshConnectionHandle GetMeshConnectionWithLowestSinkRouteCost(const BaseConnection* excludeConnection) const;
+
+    //Sink load balancing, see GS->config.enableSinkLoadBalancing. Each sink advertises how many packets it received
+    //during the last interval, the load is then mapped to one of a few levels so that small fluctuations do not
+    //change the weights of the connections
+    static constexpr u16 SINK_LOAD_INTERVAL_DS = SEC_TO_DS(5);
+    static constexpr u32 SINK_LOAD_VALIDITY_DS = 3 * SINK_LOAD_INTERVAL_DS;
+    static constexpr u16 SINK_LOAD_PACKETS_PER_LEVEL = 25;
+    static constexpr u8  SINK_LOAD_LEVELS = 8;
+    //Connections whose sink route cost exceeds the cheapest one by more than this do not get any sink traffic
+    static constexpr u32 SINK_LOAD_BALANCING_MAX_EXTRA_COST = SINK_ROUTE_COST_PER_HOP + SINK_ROUTE_HYSTERESIS;
+    u16 receivedSinkPacketsInInterval = 0;
+
+    void SendSinkLoad();
+    void SinkLoadReceivedHandler(BaseConnection* connection, const ConnPacketSinkLoad* packet);
+    void UpdateSinkLoadBalancingWeights();
+
     // store these so that the mac addresse can be sent as a livereport in the gatt disconnect event handler
     u32 recentlyDisconnectedMACAddressPart = 0;
     u16 recentlyDisconnectedConnectionHandle = FruityHal::FH_BLE_INVALID_HANDLE;
@@ -119,6 +152,11 @@ public:
     u32 sentMeshPacketsUnreliable = 0; //The number of packets that were sent through the mesh on all connections without ACK
     u32 sentMeshPacketsReliable = 0; //The number of packets that were sent through the mesh on all connections with ACK request
     u32 generatedPackets = 0; // The amount of packets that this node has generated itself to be sent to the mesh or other partners.
+    std::array<u32, AMOUNT_OF_SEND_QUEUE_PRIORITIES> expiredMeshPackets = {}; //The number of packets per priority that were dropped because they exceeded their maximum queue age
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+    std::array<QueueHistogram, AMOUNT_OF_SEND_QUEUE_PRIORITIES> queueDepthHistograms{}; //The queue depth histograms of all connections, see BaseConnection
+    std::array<QueueHistogram, AMOUNT_OF_SEND_QUEUE_PRIORITIES> queueLatencyHistograms{}; //The queue latency histograms of all connections, see BaseConnection
+#endif
 
     //ConnectionType Resolving
     void ResolveConnection(BaseConnection* oldConnection, BaseConnectionSendData* sendData, u8 const * data);
@@ -153,6 +191,14 @@ public:
     //Functions used for sending messages
     void SendMeshMessage(u8* data, u16 dataLength);
 
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+    ReliableTransfer reliableTransfer;
+
+    //Sends a unicast message that is acknowledged by its receiver, lost parts are retransmitted. The listener is
+    //informed once the message was delivered or once delivery failed, see ReliableTransfer
+    ErrorType SendMeshMessageReliable(u8* data, u16 dataLength, ReliableTransferListener* listener, u32 userType = 0, u8* transferId = nullptr);
+#endif
+
     //Send a message with a ConnPacketModule header by using a ModuleId
     ErrorTypeUnchecked SendModuleActionMessage(MessageType messageType, ModuleId moduleId, NodeId toNode, u8 actionType, u8 requestHandle, const u8* additionalData, u16 additionalDataSize, bool reliable, bool lookback) const;
     
@@ -188,7 +234,16 @@ public:
     MeshAccessConnectionHandle GetMeshAccessConnectionByUniqueId(u32 uniqueConnectionId) const;
     MeshConnectionHandle GetMeshConnectionToPartner(NodeId partnerId) const;
 
+    //Returns the connection that packets to NODE_ID_SHORTEST_SINK are routed over. Besides the hops to the sink, the
+    //link quality is taken into account, see GetSinkRouteCost
     MeshConnectionHandle GetMeshConnectionToShortestSink(const BaseConnection* excludeConnection) const;
+    //Combined metric of the hops to the sink and the rssi, queue depth and recent drops of the connection, lower is better
+    u32 GetSinkRouteCost(const MeshConnection* connection) const;
+    //Same as GetMeshConnectionToShortestSink, but spreads the packets over several sinks if sink load balancing is
+    //enabled. All packets of the same sender and message type take the same route so that their order is kept
+    MeshConnectionHandle GetMeshConnectionToSink(const BaseConnection* excludeConnection, const ConnPacketHeader* packetHeader) const;
+    //Packets for NODE_ID_SHORTEST_SINK that were received while being a sink
+    u32 receivedSinkPackets = 0;
     ClusterSize GetMeshHopsToShortestSink(const BaseConnection* excludeConnection) const;
     bool IsSinkAvailable(const BaseConnection* excludeConnection) const;
 
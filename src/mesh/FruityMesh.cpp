@@ -364,13 +364,14 @@ void BootModules()
         // Here we boot in bulk mode. We don't check license in this mode.
     }
 
-    // Load the RegisterHandlers after everything else booted up.
-#ifdef JSTODO_PERSISTENCE
-    for (u32 i = 0; i < GS->amountOfRegisterHandlers; i++)
+    // Load the persisted registers after everything else booted up so that the modules
+    // have their configuration loaded before CommitRegisterChange is called.
+#if IS_ACTIVE(REGISTER_HANDLER)
+    for (u32 i = 0; i < GS->amountOfModules; i++)
     {
-        GS->registerHandlers[i]->LoadFromFlash();
+        GS->activeModules[i]->LoadRegistersFromFlash();
     }
-#endif
+#endif //IS_ACTIVE(REGISTER_HANDLER)
 }
 
 void StartFruityMesh()            //LCOV_EXCL_LINE Simulated in a different way
@@ -405,6 +406,7 @@ void DispatchButtonEvents(u8 buttonId, u32 buttonHoldTimeDs)
     logt("MAIN", "Button %u pressed %u ds", buttonId, buttonHoldTimeDs);
     for(u32 i=0; i<GS->amountOfModules; i++){
         if(GS->activeModules[i]->configurationPointer->moduleActive){
+            STACK_WATCHER_SCOPE("ButtonHandler", GS->activeModules[i]->moduleName, 0);
             GS->activeModules[i]->ButtonHandler(buttonId, buttonHoldTimeDs);
         }
     }
@@ -420,6 +422,8 @@ void DispatchTimerEvents(u16 passedTimeDs)
 
     GS->timeManager.ProcessTicks();
 
+    GS->timeManager.TimerEventHandler(passedTimeDs);
+
     GS->cm.TimerEventHandler(passedTimeDs);
 
     FlashStorage::GetInstance().TimerEventHandler(passedTimeDs);
@@ -432,9 +436,14 @@ void DispatchTimerEvents(u16 passedTimeDs)
     GS->sig.TimerEventHandler(passedTimeDs);
 #endif
 
+#if IS_ACTIVE(REGISTER_HANDLER)
+    GS->registerSubscriptions.TimerEventHandler(passedTimeDs);
+#endif
+
     //Dispatch event to all modules
     for(u32 i=0; i<GS->amountOfModules; i++){
         if(GS->activeModules[i]->configurationPointer->moduleActive){
+            STACK_WATCHER_SCOPE("TimerEventHandler", GS->activeModules[i]->moduleName, 0);
             GS->activeModules[i]->TimerEventHandler(passedTimeDs);
         }
     }
@@ -450,6 +459,7 @@ void DispatchEvent(const FruityHal::GapAdvertisementReportEvent & e)
     ScanController::GetInstance().ScanEventHandler(e);
     for (u32 i = 0; i < GS->amountOfModules; i++) {
         if (GS->activeModules[i]->configurationPointer->moduleActive) {
+            STACK_WATCHER_SCOPE("GapAdvertisementReportEventHandler", GS->activeModules[i]->moduleName, 0);
             GS->activeModules[i]->GapAdvertisementReportEventHandler(e);
         }
     }
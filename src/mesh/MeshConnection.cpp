@@ -135,6 +135,7 @@ void MeshConnection::DisconnectAndRemove(AppDisconnectReason reason)
     //Call our lovely modules
     for(u32 i=0; i<GS->amountOfModules; i++){
         if(GS->activeModules[i]->configurationPointer->moduleActive){
+            STACK_WATCHER_SCOPE("MeshConnectionChangedHandler", GS->activeModules[i]->moduleName, 0);
             GS->activeModules[i]->MeshConnectionChangedHandler(*this);
         }
     }
@@ -723,6 +724,7 @@ void MeshConnection::ReceiveHandshakePacketHandler(BaseConnectionSendData* sendD
 
                 //Update my own information on the connection
                 this->partnerId = packet->header.sender;
+                GS->node.joinMeScoresDirty = true;
 
                 //Send an update to the connected cluster to increase the size by one
                 //This is also the ACK message for our connecting node
@@ -776,6 +778,7 @@ void MeshConnection::ReceiveHandshakePacketHandler(BaseConnectionSendData* sendD
             //Set the master bit for the connection. If the connection would disconnect
             //Then we could keep intact and the other one must dissolve
             this->partnerId = clusterAck1Packet.header.sender;
+            GS->node.joinMeScoresDirty = true;
             this->connectionMasterBit = 1;
             this->hopsToSink = clusterAck1Packet.payload.hopsToSink;
             logt("HANDSHAKE", "NODE %u CREATED MASTERBIT", GS->node.configuration.nodeId);
@@ -954,6 +957,9 @@ bool MeshConnection::IsValidMessageType(MessageType t)
         case(MessageType::COMPONENT_ACT):
         case(MessageType::TIME_SYNC):
         case(MessageType::CAPABILITY):
+        case(MessageType::RELIABLE_SEGMENT):
+        case(MessageType::RELIABLE_ACK):
+        case(MessageType::SINK_LOAD):
             return true;
         default:
             SIMEXCEPTION(MessageTypeInvalidException);
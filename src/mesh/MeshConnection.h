@@ -70,6 +70,17 @@ class MeshConnection
         ClusterSize clusterSizeBackup;
         ClusterSize hopsToSink;
 
+        //Packets that were recently dropped on this connection, halved every time the sink route is updated
+        u8 recentDroppedPackets = 0;
+        u16 droppedPacketsAtLastSinkRouteUpdate = 0;
+
+        //Load of the least loaded sink behind this connection, see ConnectionManager::SinkLoadReceivedHandler
+        NodeId advertisedSinkId = NODE_ID_INVALID;
+        u16 advertisedSinkLoad = 0;
+        u32 advertisedSinkLoadTimeDs = 0;
+        //Share of the sink traffic that is routed over this connection if sink load balancing is enabled
+        u8 sinkLoadBalancingWeight = 0;
+
         //Timestamp and Clustering messages must be sent immediately and are not queued
         //Multiple updates can accumulate in this variable
         //This packet must not be sent during handshakes
@@ -63,6 +63,17 @@
 //The number of connection attempts to one node before blacklisting this node for some time
 constexpr u8 connectAttemptsBeforeBlacklisting = 5;
 
+//Join me advertising intervals that are used for each step of the adaptive discovery (in 0.625 ms units)
+constexpr u16 adaptiveDiscoveryAdvertisingIntervals[] = {
+    (u16)MSEC_TO_UNITS(400, CONFIG_UNIT_0_625_MS),
+    (u16)MSEC_TO_UNITS(1000, CONFIG_UNIT_0_625_MS),
+    (u16)MSEC_TO_UNITS(2000, CONFIG_UNIT_0_625_MS),
+    (u16)MSEC_TO_UNITS(4000, CONFIG_UNIT_0_625_MS),
+};
+constexpr u8 adaptiveDiscoveryMaxBackoffLevel = sizeof(adaptiveDiscoveryAdvertisingIntervals) / sizeof(adaptiveDiscoveryAdvertisingIntervals[0]);
+//Maximum scan interval in 0.625 ms units (10.24 s)
+constexpr u16 adaptiveDiscoveryMaxScanInterval = 16384;
+
 // The Service that is used for two nodes to communicate between each other
 // Fruity Mesh Service UUID 310bfe40-ed6b-11e3-a1be-0002a5d5c51b
 constexpr u8 MESH_SERVICE_BASE_UUID128[] = { 0x23, 0xD1, 0xBC, 0xEA, 0x5F, 0x78, 0x23, 0x15, 0xDE, 0xEF, 0x12, 0x12, 0x00, 0x00, 0x00, 0x00 };
@@ -171,6 +182,7 @@ void Node::ConfigurationLoadedHandler(u8* migratableConfig, u16 migratableConfig
     randomBootNumber = Utility::GetRandomInteger();
 
     clusterId = this->GenerateClusterID();
+    joinMeScoresDirty = true;
 
     //Set the BLE address so that we have the same on every startup, mostly for debugging
     if(configuration.bleAddress.addr_type != FruityHal::BleGapAddrType::INVALID){
@@ -305,12 +317,11 @@ void Node::HandshakeDoneHandler(MeshConnection* connection, bool completedAsWinn
     GS->logger.LogCustomCount(CustomErrorTypes::COUNT_HANDSHAKE_DONE);
 
     //We delete the joinMe packet of this node from the join me buffer
-    for (u32 i = 0; i < joinMePackets.size(); i++)
-    {
-        joinMeBufferPacket* packet = &joinMePackets[i];
-        if (packet->payload.sender == connection->partnerId) {
-            CheckedMemset(packet, 0x00, sizeof(joinMeBufferPacket));
-        }
+    joinMeBufferPacket* partnerPacket = FindJoinMePacket(connection->partnerId);
+    if (partnerPacket != nullptr) {
+        CheckedMemset(partnerPacket, 0x00, sizeof(joinMeBufferPacket));
+        RebuildJoinMePacketIndex();
+        UpdateJoinMeScores((u32)(partnerPacket - joinMePackets.data()));
     }
 
     //We can now commit the changes that were part of the handshake
@@ -327,6 +338,7 @@ void Node::HandshakeDoneHandler(MeshConnection* connection, bool completedAsWinn
         connection->connectedClusterId = connection->clusterIDBackup;
         connection->partnerId = connection->clusterAck1Packet.header.sender;
         connection->connectedClusterSize = 1;
+        joinMeScoresDirty = true;
 
         //Broadcast cluster update to other connections
         ConnPacketClusterInfoUpdate outPacket;
@@ -376,6 +388,7 @@ void Node::HandshakeDoneHandler(MeshConnection* connection, bool completedAsWinn
     //Call our lovely modules
     for(u32 i=0; i<GS->amountOfModules; i++){
         if(GS->activeModules[i]->configurationPointer->moduleActive){
+            STACK_WATCHER_SCOPE("MeshConnectionChangedHandler", GS->activeModules[i]->moduleName, 0);
             GS->activeModules[i]->MeshConnectionChangedHandler(*connection);
         }
     }
@@ -532,6 +545,7 @@ void Node::MeshConnectionDisconnectedHandler(AppDisconnectReason appDisconnectRe
     if (GS->cm.GetConnectionsOfType(ConnectionType::FRUITYMESH, ConnectionDirection::INVALID).count == 0)
     {
         clusterId = GenerateClusterID();
+        joinMeScoresDirty = true;
     }
 
     //In either case, we must update our advertising packet
@@ -947,6 +961,7 @@ void Node::MeshMessageReceivedHandler(BaseConnection* connection, BaseConnection
                 for (u16 i = 0; i < message->amountOfPreferredPartnerIds; i++) {
                     GS->config.configuration.preferredPartnerIds[i] = message->preferredPartnerIds[i];
                 }
+                joinMeScoresDirty = true;
 
                 GS->config.SaveConfigToFlash(nullptr, 0, nullptr, 0);
 
@@ -1842,6 +1857,7 @@ Node::DecisionStruct Node::DetermineBestClusterAvailable(void)
             if (err == ErrorType::SUCCESS) {
                 bestClusterAsMaster->lastConnectAttemptDs = GS->appTimerDs;
                 if(bestClusterAsMaster->attemptsToConnect <= 20) bestClusterAsMaster->attemptsToConnect++;
+                UpdateJoinMeScores((u32)(bestClusterAsMaster - joinMePackets.data()));
             }
 
             result.result = DecisionResult::CONNECT_AS_MASTER;
@@ -1929,17 +1945,19 @@ u32 Node::ModifyScoreBasedOnPreferredPartners(u32 score, NodeId partner) const
     return score;
 }
 
-joinMeBufferPacket * Node::DetermineBestCluster(u32(Node::*clusterRatingFunction)(const joinMeBufferPacket &packet) const)
+joinMeBufferPacket * Node::DetermineBestCluster(u32 joinMeBufferScores::*clusterScore)
 {
     u32 bestScore = 0;
     joinMeBufferPacket* bestCluster = nullptr;
 
+    RefreshJoinMeScores();
+
     for (u32 i = 0; i < joinMePackets.size(); i++)
     {
         joinMeBufferPacket* packet = &joinMePackets[i];
         if (packet->payload.sender == 0) continue;
 
-        u32 score = (this->*clusterRatingFunction)(*packet);
+        u32 score = joinMeScores[i].*clusterScore;
         if (score > bestScore)
         {
             bestScore = score;
@@ -1951,12 +1969,12 @@ joinMeBufferPacket * Node::DetermineBestCluster(u32(Node::*clusterRatingFunction
 
 joinMeBufferPacket* Node::DetermineBestClusterAsSlave()
 {
-    return DetermineBestCluster(&Node::CalculateClusterScoreAsSlave);
+    return DetermineBestCluster(&joinMeBufferScores::asSlave);
 }
 
 joinMeBufferPacket* Node::DetermineBestClusterAsMaster()
 {
-    return DetermineBestCluster(&Node::CalculateClusterScoreAsMaster);
+    return DetermineBestCluster(&joinMeBufferScores::asMaster);
 }
 
 //Calculates the score for a cluster
@@ -2037,6 +2055,84 @@ bool Node::DoesBiggerKnownClusterExist()
     return DetermineBestClusterAsSlave() != nullptr;
 }
 
+//Recalculates the cached scores of all packets if this node changed and of the packets whose scores expired
+void Node::RefreshJoinMeScores()
+{
+    const bool stateChanged = joinMeScoresDirty;
+    joinMeScoresDirty = false;
+
+    for (u32 i = 0; i < joinMePackets.size(); i++)
+    {
+        if (stateChanged || joinMeScores[i].validUntilDs <= GS->appTimerDs) UpdateJoinMeScores(i);
+    }
+}
+
+void Node::UpdateJoinMeScores(u32 slot)
+{
+    const joinMeBufferPacket& packet = joinMePackets[slot];
+    joinMeBufferScores& scores = joinMeScores[slot];
+
+    if (packet.payload.sender == 0)
+    {
+        scores.asMaster = 0;
+        scores.asSlave = 0;
+        scores.validUntilDs = UINT32_MAX;
+        return;
+    }
+
+    scores.asMaster = CalculateClusterScoreAsMaster(packet);
+    scores.asSlave = CalculateClusterScoreAsSlave(packet);
+
+    //Once a packet is too old, its scores stay 0 until it is updated
+    scores.validUntilDs = UINT32_MAX;
+    const u32 expiryDs = packet.receivedTimeDs + MAX_JOIN_ME_PACKET_AGE_DS + 1;
+    if (expiryDs > GS->appTimerDs) scores.validUntilDs = expiryDs;
+
+    //The master score changes once the temporary blacklisting ends
+    const u32 blacklistEndDs = packet.lastConnectAttemptDs + SEC_TO_DS(1) * packet.attemptsToConnect;
+    if (
+        packet.lastConnectAttemptDs != 0
+        && packet.attemptsToConnect > connectAttemptsBeforeBlacklisting
+        && blacklistEndDs > GS->appTimerDs
+        && blacklistEndDs < scores.validUntilDs) {
+        scores.validUntilDs = blacklistEndDs;
+    }
+}
+
+static u32 GetJoinMePacketIndexStart(NodeId sender)
+{
+    return (((u32)sender * 2654435761UL) >> 16) % Node::JOIN_ME_PACKET_INDEX_SIZE;
+}
+
+void Node::RebuildJoinMePacketIndex()
+{
+    joinMePacketIndex.fill(0);
+
+    for (u32 slot = 0; slot < joinMePackets.size(); slot++)
+    {
+        const NodeId sender = joinMePackets[slot].payload.sender;
+        if (sender == 0) continue;
+
+        u32 position = GetJoinMePacketIndexStart(sender);
+        while (joinMePacketIndex[position] != 0) position = (position + 1) % JOIN_ME_PACKET_INDEX_SIZE;
+        joinMePacketIndex[position] = (u8)(slot + 1);
+    }
+}
+
+joinMeBufferPacket* Node::FindJoinMePacket(NodeId sender)
+{
+    if (sender == 0) return nullptr;
+
+    const u32 start = GetJoinMePacketIndexStart(sender);
+    for (u32 i = 0; i < JOIN_ME_PACKET_INDEX_SIZE; i++)
+    {
+        const u8 entry = joinMePacketIndex[(start + i) % JOIN_ME_PACKET_INDEX_SIZE];
+        if (entry == 0) return nullptr;
+        if (joinMePackets[entry - 1].payload.sender == sender) return &joinMePackets[entry - 1];
+    }
+    return nullptr;
+}
+
 void Node::ResetEmergencyDisconnect()
 {
     emergencyDisconnectTimerDs = 0;
@@ -2118,11 +2214,13 @@ void Node::GapAdvertisementMessageHandler(const FruityHal::GapAdvertisementRepor
             logt("DISCOVERY", "JOIN_ME: sender:%u, clusterId:%x, clusterSize:%d, freeIn:%u, freeOut:%u, ack:%u", packet->payload.sender, packet->payload.clusterId, packet->payload.clusterSize, packet->payload.freeMeshInConnections, packet->payload.freeMeshOutConnections, packet->payload.ackField);
 
             //Look through the buffer and determine a space where we can put the packet in
-            joinMeBufferPacket* targetBuffer = FindTargetBuffer(packet);
+            joinMeBufferPacket* targetBuffer = FindTargetBuffer(packet, advertisementReportEvent.GetRssi());
 
             //Now, we have the space for our packet and we fill it with the latest information
             if (targetBuffer != nullptr && packet->payload.clusterId != this->clusterId)
             {
+                const bool isNewSender = targetBuffer->payload.sender != packet->payload.sender;
+
                 targetBuffer->addr.addr = advertisementReportEvent.GetPeerAddr();
                 targetBuffer->addr.addr_type = advertisementReportEvent.GetPeerAddrType();
                 targetBuffer->advType = advertisementReportEvent.IsConnectable() ? FruityHal::BleGapAdvType::ADV_IND : FruityHal::BleGapAdvType::ADV_NONCONN_IND;
@@ -2130,28 +2228,40 @@ void Node::GapAdvertisementMessageHandler(const FruityHal::GapAdvertisementRepor
                 targetBuffer->receivedTimeDs = GS->appTimerDs;
 
                 targetBuffer->payload = packet->payload;
+
+                if (isNewSender)
+                {
+                    //Connection attempts to the previous sender of this slot must not blacklist the new one
+                    targetBuffer->attemptsToConnect = 0;
+                    targetBuffer->lastConnectAttemptDs = 0;
+                    RebuildJoinMePacketIndex();
+                }
+                const u32 slot = (u32)(targetBuffer - joinMePackets.data());
+                UpdateJoinMeScores(slot);
+
+                //Another cluster that we would connect to is nearby, so we have to discover quickly again. The scores
+                //already filter out weak signals and partners that are not preferred.
+                if (packetHeader->networkId == configuration.networkId
+                    && (joinMeScores[slot].asMaster > 0 || joinMeScores[slot].asSlave > 0)
+                    && (packet->payload.freeMeshInConnections > 0 || packet->payload.freeMeshOutConnections > 0))
+                {
+                    ResetAdaptiveDiscovery();
+                }
             }
         }
     }
 
 }
 
-joinMeBufferPacket* Node::FindTargetBuffer(const AdvPacketJoinMeV0* packet)
+joinMeBufferPacket* Node::FindTargetBuffer(const AdvPacketJoinMeV0* packet, i8 rssi)
 {
-    joinMeBufferPacket* targetBuffer = nullptr;
-
     //First, look if a packet from this node is already in the buffer, if yes, we use this space
-    for (u32 i = 0; i < joinMePackets.size(); i++)
+    joinMeBufferPacket* targetBuffer = FindJoinMePacket(packet->payload.sender);
+    if (targetBuffer != nullptr)
     {
-        targetBuffer = &joinMePackets[i];
-
-        if (packet->payload.sender == targetBuffer->payload.sender)
-        {
-            logt("DISCOVERY", "Updated old buffer packet");
-            return targetBuffer;
-        }
+        logt("DISCOVERY", "Updated old buffer packet");
+        return targetBuffer;
     }
-    targetBuffer = nullptr;
 
     //Next, we look if there's an empty space
     for (u32 i = 0; i < joinMePackets.size(); i++)
@@ -2166,45 +2276,35 @@ joinMeBufferPacket* Node::FindTargetBuffer(const AdvPacketJoinMeV0* packet)
     }
     targetBuffer = nullptr;
 
-    //Next, we can overwrite the oldest packet that we saved from our own cluster
-    u32 oldestTimestamp = UINT32_MAX;
+    //If there's still no space, we overwrite the least interesting candidate, packets from our own cluster and
+    //packets that are too old have a score of 0. If scores are equal, the oldest packet is overwritten.
+    RefreshJoinMeScores();
+    u32 minScore = UINT32_MAX;
     for (u32 i = 0; i < joinMePackets.size(); i++)
     {
         joinMeBufferPacket* tmpPacket = &joinMePackets[i];
+        const u32 score = joinMeScores[i].asMaster > joinMeScores[i].asSlave ? joinMeScores[i].asMaster : joinMeScores[i].asSlave;
 
-        if(tmpPacket->payload.clusterId == clusterId && tmpPacket->receivedTimeDs < oldestTimestamp){
-            oldestTimestamp = tmpPacket->receivedTimeDs;
+        if(score < minScore || (score == minScore && tmpPacket->receivedTimeDs < targetBuffer->receivedTimeDs)){
+            minScore = score;
             targetBuffer = tmpPacket;
         }
     }
 
-    if(targetBuffer != nullptr){
-        logt("DISCOVERY", "Overwrote one from our own cluster");
-        return targetBuffer;
-    }
-
-    //If there's still no space, we overwrite the oldest packet that we received, this will not fail
-    //TODO: maybe do not use oldest one but worst candidate?? Use clusterScore on all packets to find the least interesting
-    u32 minScore = UINT32_MAX;
-    for (u32 i = 0; i < joinMePackets.size(); i++)
+    //The new packet is only stored if it is at least as good as the candidate that it replaces
+    joinMeBufferPacket newPacket = {};
+    newPacket.rssi = rssi;
+    newPacket.receivedTimeDs = GS->appTimerDs;
+    newPacket.payload = packet->payload;
+    const u32 scoreAsMaster = CalculateClusterScoreAsMaster(newPacket);
+    const u32 scoreAsSlave = CalculateClusterScoreAsSlave(newPacket);
+    if ((scoreAsMaster > scoreAsSlave ? scoreAsMaster : scoreAsSlave) < minScore)
     {
-        joinMeBufferPacket* tmpPacket = &joinMePackets[i];
-
-        u32 score = 0;
-        if (packet->payload.clusterSize >= clusterSize) {
-            score = CalculateClusterScoreAsMaster(*tmpPacket);
-        }
-        else {
-            score = CalculateClusterScoreAsSlave(*tmpPacket);
-        }
-
-        if(score < minScore){
-            minScore = score;
-            targetBuffer = tmpPacket;
-        }
+        logt("DISCOVERY", "Dropped packet, all buffered packets are better");
+        return nullptr;
     }
 
-    logt("DISCOVERY", "Overwrote worst packet from different cluster");
+    logt("DISCOVERY", "Overwrote worst packet");
     return targetBuffer;
 }
 
@@ -2297,6 +2397,9 @@ void Node::ChangeState(DiscoveryState newState)
         GS->scanController.RemoveJob(p_scanJob);
         p_scanJob = nullptr;
     }
+
+    //The jobs were reconfigured with the intervals of the new state, so the current backoff is applied again
+    ApplyDiscoveryBackoff();
 }
 
 void Node::DisableStateMachine(bool disable)
@@ -2316,6 +2419,8 @@ void Node::TimerEventHandler(u16 passedTimeDs)
         ChangeState(nextDiscoveryState);
     }
 
+    UpdateAdaptiveDiscovery(passedTimeDs);
+
     //Check if new cluster size should trigger discovery change
     if (!clusterSizeChangeHandled && clusterSizeTransitionTimeoutDs <= 0)
     {
@@ -2388,22 +2493,20 @@ void Node::TimerEventHandler(u16 passedTimeDs)
         ResetEmergencyDisconnect();
     }
 
-    //Count the nodes that are a good choice for connecting
-    //TODO: We could use this snippet to connect immediately after enought nodes were collected
-//    u8 numGoodNodesInBuffer = 0;
-//    for (int i = 0; i < joinMePacketBuffer->_numElements; i++)
-//    {
-//        joinMeBufferPacket* packet = (joinMeBufferPacket*) joinMePacketBuffer->PeekItemAt(i);
-//        u32 score = CalculateClusterScoreAsMaster(packet);
-//        if (score > 0){
-//            numGoodNodesInBuffer++;
-//        }
-//    }
-//
-//    if(numGoodNodesInBuffer >= Config->numNodesForDecision) ...
+    //Count the nodes that are a good choice for connecting, the scores are cached so that this is cheap
+    u32 numGoodNodesInBuffer = 0;
+    if (lastDecisionTimeDs + Conf::minTimeUntilDecisionDs <= GS->appTimerDs)
+    {
+        RefreshJoinMeScores();
+        for (u32 i = 0; i < joinMePackets.size(); i++)
+        {
+            if (joinMeScores[i].asMaster > 0 || joinMeScores[i].asSlave > 0) numGoodNodesInBuffer++;
+        }
+    }
 
     //Check if there is a good cluster but add a random delay 
-    if(lastDecisionTimeDs + Conf::maxTimeUntilDecisionDs <= GS->appTimerDs)
+    //If enough nodes were collected, we decide immediately
+    if(lastDecisionTimeDs + Conf::maxTimeUntilDecisionDs <= GS->appTimerDs || numGoodNodesInBuffer >= Conf::numNodesForDecision)
     {
         DecisionStruct decision = DetermineBestClusterAvailable();
 
@@ -2550,6 +2653,95 @@ void Node::KeepHighDiscoveryActive()
     }
 }
 
+void Node::UpdateAdaptiveDiscovery(u16 passedTimeDs)
+{
+    if (!GS->config.enableAdaptiveDiscovery) return;
+
+    //The neighbours changed if the partners of the mesh connections are not the same set as before
+    std::array<NodeId, TOTAL_NUM_CONNECTIONS> neighbours{};
+    u8 numNeighbours = 0;
+    MeshConnections conn = GS->cm.GetMeshConnections(ConnectionDirection::INVALID);
+    for (u32 i = 0; i < conn.count; i++) {
+        if (conn.handles[i].IsHandshakeDone()) neighbours[numNeighbours++] = conn.handles[i].GetPartnerId();
+    }
+
+    bool neighboursChanged = numNeighbours != discoveryStableNumNeighbours;
+    for (u32 i = 0; i < numNeighbours && !neighboursChanged; i++)
+    {
+        neighboursChanged = true;
+        for (u32 j = 0; j < discoveryStableNumNeighbours; j++)
+        {
+            if (discoveryStableNeighbours[j] == neighbours[i]) neighboursChanged = false;
+        }
+    }
+
+    if (clusterSize != discoveryStableClusterSize || neighboursChanged)
+    {
+        discoveryStableClusterSize = clusterSize;
+        discoveryStableNeighbours = neighbours;
+        discoveryStableNumNeighbours = numNeighbours;
+        ResetAdaptiveDiscovery();
+        return;
+    }
+
+    discoveryStableTimeDs += passedTimeDs;
+    if (discoveryStableTimeDs >= SEC_TO_DS((u32)Conf::adaptiveDiscoveryStepDelaySec) && discoveryBackoffLevel < adaptiveDiscoveryMaxBackoffLevel)
+    {
+        discoveryStableTimeDs = 0;
+        discoveryBackoffLevel++;
+        logt("STATES", "Discovery backoff level %u", (u32)discoveryBackoffLevel);
+        ApplyDiscoveryBackoff();
+    }
+}
+
+void Node::ResetAdaptiveDiscovery()
+{
+    discoveryStableTimeDs = 0;
+    if (discoveryBackoffLevel == 0) return;
+
+    discoveryBackoffLevel = 0;
+    logt("STATES", "Discovery backoff reset");
+    ApplyDiscoveryBackoff();
+}
+
+void Node::ApplyDiscoveryBackoff()
+{
+    if (!GS->config.enableAdaptiveDiscovery) return;
+    if (currentDiscoveryState == DiscoveryState::OFF || currentDiscoveryState == DiscoveryState::INVALID) return;
+
+    //Each step uses the next longer join me interval, but never a shorter one than the state itself
+    if (meshAdvJobHandle != nullptr)
+    {
+        u16 advertisingInterval = currentDiscoveryState == DiscoveryState::HIGH ? Conf::meshAdvertisingIntervalHigh : Conf::meshAdvertisingIntervalLow;
+        if (discoveryBackoffLevel > 0 && adaptiveDiscoveryAdvertisingIntervals[discoveryBackoffLevel - 1] > advertisingInterval)
+        {
+            advertisingInterval = adaptiveDiscoveryAdvertisingIntervals[discoveryBackoffLevel - 1];
+        }
+        if (meshAdvJobHandle->advertisingInterval != advertisingInterval)
+        {
+            meshAdvJobHandle->advertisingInterval = advertisingInterval;
+            GS->advertisingController.RefreshJob(meshAdvJobHandle);
+        }
+    }
+
+    //Each step doubles the scan interval while keeping the window, as long as the duty cycle stays above 1%
+    if (p_scanJob != nullptr && (p_scanJob->type == ScanState::HIGH || p_scanJob->type == ScanState::LOW))
+    {
+        u16 scanInterval = p_scanJob->type == ScanState::HIGH ? Conf::GetInstance().meshScanIntervalHigh : Conf::GetInstance().meshScanIntervalLow;
+        for (u32 i = 0; i < discoveryBackoffLevel; i++)
+        {
+            const u32 nextScanInterval = (u32)scanInterval * 2;
+            if (nextScanInterval > adaptiveDiscoveryMaxScanInterval || (p_scanJob->window * 100UL) / nextScanInterval == 0) break;
+            scanInterval = (u16)nextScanInterval;
+        }
+        if (p_scanJob->interval != scanInterval)
+        {
+            p_scanJob->interval = scanInterval;
+            GS->scanController.RefreshJobs();
+        }
+    }
+}
+
 /*
  #########################################################################################################
  ### Helper functions
@@ -2584,6 +2776,7 @@ void Node::SetClusterSize(ClusterSize clusterSize)
         clusterSizeTransitionTimeoutDs = SEC_TO_DS((u32)Conf::GetInstance().clusterSizeDiscoveryChangeDelaySec);
     }
     this->clusterSize = clusterSize;
+    joinMeScoresDirty = true;
 }
 
 void Node::SetEnrolledNodes(u16 enrolledNodes, NodeId sender)
@@ -2814,6 +3007,39 @@ void Node::PrintBufferStatus(void) const
     trace("**************" EOL);
 }
 
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+static void PrintQueueHistograms(const std::array<QueueHistogram, AMOUNT_OF_SEND_QUEUE_PRIORITIES>& depthHistograms, const std::array<QueueHistogram, AMOUNT_OF_SEND_QUEUE_PRIORITIES>& latencyHistograms)
+{
+    for (u32 prio = 0; prio < AMOUNT_OF_SEND_QUEUE_PRIORITIES; prio++)
+    {
+        trace("  prio %u depth:", prio);
+        for (u16 count : depthHistograms[prio].buckets) trace(" %u", count);
+        trace(", latency:");
+        for (u16 count : latencyHistograms[prio].buckets) trace(" %u", count);
+        trace(EOL);
+    }
+}
+
+void Node::PrintQueueStatus() const
+{
+    //Depth in packets and latency in steps of 10 ms, each bucket starts at the given value
+    trace("Queue histograms, buckets:");
+    for (u32 i = 0; i < QUEUE_HISTOGRAM_NUM_BUCKETS; i++) trace(" %u", QueueHistogram::GetBucketLowerBound(i));
+    trace(EOL "All connections:" EOL);
+    PrintQueueHistograms(GS->cm.queueDepthHistograms, GS->cm.queueLatencyHistograms);
+
+    BaseConnections conns = GS->cm.GetConnectionsOfType(ConnectionType::INVALID, ConnectionDirection::INVALID);
+    for (u32 i = 0; i < conns.count; i++)
+    {
+        const BaseConnection* conn = conns.handles[i].GetConnection();
+        if (conn == nullptr) continue;
+
+        trace("Connection %u to %u:" EOL, conn->connectionId, conn->partnerId);
+        PrintQueueHistograms(conn->queueDepthHistograms, conn->queueLatencyHistograms);
+    }
+}
+#endif
+
 
 void Node::RecordStorageEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength)
 {
@@ -3513,6 +3739,14 @@ TerminalCommandHandlerReturnType Node::TerminalCommandHandler(const char* comman
         PrintBufferStatus();
         return TerminalCommandHandlerReturnType::SUCCESS;
     }
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+    //Print the queue depth and latency histograms of the connections
+    else if (TERMARGS(0, "queuestat"))
+    {
+        PrintQueueStatus();
+        return TerminalCommandHandlerReturnType::SUCCESS;
+    }
+#endif
     //Send some large data that is split over a few messages
     else if(TERMARGS(0, "datal"))
     {
@@ -3685,6 +3919,7 @@ ErrorTypeUnchecked Node::SendComponentMessageFromTerminal(MessageType componentM
         if(strcmp("write", commandArgs[3]) == 0) actionType = (u8)ActorMessageActionType::WRITE;
         else if(strcmp("read", commandArgs[3]) == 0) actionType = (u8)ActorMessageActionType::READ;
         else if(strcmp("writeack", commandArgs[3]) == 0) actionType = (u8)ActorMessageActionType::WRITE_ACK;
+        else if(strcmp("subscribe", commandArgs[3]) == 0) actionType = (u8)ActorMessageActionType::SUBSCRIBE;
     } else if(componentMessageType == MessageType::COMPONENT_SENSE){
         if(strcmp("event", commandArgs[3]) == 0) actionType = (u8)SensorMessageActionType::UNSPECIFIED;
         else if(strcmp("error", commandArgs[3]) == 0) actionType = (u8)SensorMessageActionType::ERROR_RSP;
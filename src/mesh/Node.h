@@ -63,6 +63,14 @@ typedef struct
     AdvPacketPayloadJoinMeV0 payload;
 }joinMeBufferPacket;
 
+//Cached cluster scores of a joinMeBufferPacket
+typedef struct
+{
+    u32 asMaster;
+    u32 asSlave;
+    u32 validUntilDs; //The scores only change over time through the packet age and the temporary blacklisting
+}joinMeBufferScores;
+
 //meshServiceStruct that contains all information about the meshService
 typedef struct meshServiceStruct_temporary
 {
@@ -234,7 +242,7 @@ private:
 
         u32 ModifyScoreBasedOnPreferredPartners(u32 score, NodeId partner) const;
         
-        joinMeBufferPacket* DetermineBestCluster        (u32(Node::*clusterRatingFunction)(const joinMeBufferPacket& packet) const);
+        joinMeBufferPacket* DetermineBestCluster        (u32 joinMeBufferScores::*clusterScore);
         joinMeBufferPacket* DetermineBestClusterAsSlave ();
         joinMeBufferPacket* DetermineBestClusterAsMaster();
 
@@ -243,6 +251,12 @@ private:
 
         bool DoesBiggerKnownClusterExist();
 
+        //Join me buffer index and score cache
+        void RefreshJoinMeScores();
+        void UpdateJoinMeScores(u32 slot);
+        void RebuildJoinMePacketIndex();
+        joinMeBufferPacket* FindJoinMePacket(NodeId sender);
+
         bool isSendingCapabilities = false;
         bool firstCallForCurrentCapabilityModule = false;
         constexpr static u32 TIME_BETWEEN_CAPABILITY_SENDINGS_DS = SEC_TO_DS(1);
@@ -294,6 +308,12 @@ private:
         static constexpr int MAX_JOIN_ME_PACKET_AGE_DS = SEC_TO_DS(10);
         static constexpr int JOIN_ME_PACKET_BUFFER_MAX_ELEMENTS = 10;
         std::array<joinMeBufferPacket, JOIN_ME_PACKET_BUFFER_MAX_ELEMENTS> joinMePackets{};
+        //Open addressing index that maps the sender of a buffered packet to its slot (slot + 1, 0 if empty)
+        static constexpr int JOIN_ME_PACKET_INDEX_SIZE = 16;
+        static_assert(JOIN_ME_PACKET_INDEX_SIZE > JOIN_ME_PACKET_BUFFER_MAX_ELEMENTS, "Index must have free entries");
+        std::array<u8, JOIN_ME_PACKET_INDEX_SIZE> joinMePacketIndex{};
+        std::array<joinMeBufferScores, JOIN_ME_PACKET_BUFFER_MAX_ELEMENTS> joinMeScores{};
+        bool joinMeScoresDirty = true; //Set if the cluster, the mesh connections or the preferred partners changed since the scores were cached
         ClusterId currentAckId = 0;
         u16 connectionLossCounter = 0;
         u16 randomBootNumber = 0;
@@ -310,6 +330,13 @@ private:
 
         u8 noNodesFoundCounter = 0; //Incremented every time that no interesting cluster packets are found
 
+        //Adaptive discovery, see Conf::enableAdaptiveDiscovery
+        u8 discoveryBackoffLevel = 0; //Number of steps by which the discovery of the current state is slowed down
+        u32 discoveryStableTimeDs = 0; //Time since the cluster size and the neighbours changed or the last step was taken
+        ClusterSize discoveryStableClusterSize = 0;
+        std::array<NodeId, TOTAL_NUM_CONNECTIONS> discoveryStableNeighbours{}; //Partner ids of all mesh connections
+        u8 discoveryStableNumNeighbours = 0;
+
         //Variables (kinda private, but I'm too lazy to write getters)
         ClusterId clusterId = 0;
 
@@ -386,10 +413,15 @@ private:
 
         void KeepHighDiscoveryActive();
 
+        //Adaptive discovery
+        void UpdateAdaptiveDiscovery(u16 passedTimeDs);
+        void ResetAdaptiveDiscovery(); //Switches back to the unmodified discovery of the current state
+        void ApplyDiscoveryBackoff();
+
         //Connection handlers
         //Message handlers
         void GapAdvertisementMessageHandler(const FruityHal::GapAdvertisementReportEvent& advertisementReportEvent);
-        joinMeBufferPacket* FindTargetBuffer(const AdvPacketJoinMeV0* packet);
+        joinMeBufferPacket* FindTargetBuffer(const AdvPacketJoinMeV0* packet, i8 rssi);
 
         //Timers
         void TimerEventHandler(u16 passedTimeDs) override final;
@@ -413,6 +445,9 @@ private:
 
         void PrintStatus() const;
         void PrintBufferStatus() const;
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+        void PrintQueueStatus() const;
+#endif
         void SetTerminalTitle() const;
         CapabilityEntry GetCapability(u32 index, bool firstCall) override final;
         CapabilityEntry GetNextGlobalCapability();
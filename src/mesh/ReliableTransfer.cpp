@@ -0,0 +1,350 @@
+////////////////////////////////////////////////////////////////////////////////
+// /****************************************************************************
+// **
+// ** Copyright (C) 2015-2022 M-Way Solutions GmbH
+// ** Contact: https://www.blureange.io/licensing
+// **
+// ** This file is part of the Bluerange/FruityMesh implementation
+// **
+// ** $BR_BEGIN_LICENSE:GPL-EXCEPT$
+// ** Commercial License Usage
+// ** Licensees holding valid commercial Bluerange licenses may use this file in
+// ** accordance with the commercial license agreement provided with the
+// ** Software or, alternatively, in accordance with the terms contained in
+// ** a written agreement between them and M-Way Solutions GmbH.
+// ** For licensing terms and conditions see https://www.bluerange.io/terms-conditions. For further
+// ** information use the contact form at https://www.bluerange.io/contact.
+// **
+// ** GNU General Public License Usage
+// ** Alternatively, this file may be used under the terms of the GNU
+// ** General Public License version 3 as published by the Free Software
+// ** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+// ** included in the packaging of this file. Please review the following
+// ** information to ensure the GNU General Public License requirements will
+// ** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+// **
+// ** $BR_END_LICENSE$
+// **
+// ****************************************************************************/
+////////////////////////////////////////////////////////////////////////////////
+
+#include <ReliableTransfer.h>
+#include <ConnectionManager.h>
+#include <Logger.h>
+#include <Utility.h>
+#include <GlobalState.h>
+
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+
+ReliableTransfer::ReliableTransfer()
+{
+    CheckedMemset(outgoing, 0, sizeof(outgoing));
+    CheckedMemset(incoming, 0, sizeof(incoming));
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_OUTGOING; i++) outgoing[i].receiver = NODE_ID_INVALID;
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_INCOMING; i++) incoming[i].sender = NODE_ID_INVALID;
+}
+
+u32 ReliableTransfer::GetAllSegmentsMask(u8 amountOfSegments)
+{
+    if (amountOfSegments >= 32) return 0xFFFFFFFFUL;
+    return (1UL << amountOfSegments) - 1;
+}
+
+ErrorType ReliableTransfer::Send(const u8* data, u16 dataLength, ReliableTransferListener* listener, u32 userType, u8* transferId)
+{
+    if (dataLength < SIZEOF_CONN_PACKET_HEADER || dataLength > MAX_MESH_PACKET_SIZE)
+    {
+        SIMEXCEPTION(IllegalArgumentException);
+        return ErrorType::INVALID_LENGTH;
+    }
+
+    //Only a single node can acknowledge the message
+    const NodeId receiver = ((const ConnPacketHeader*)data)->receiver;
+    if (receiver != NODE_ID_SHORTEST_SINK
+        && (receiver < NODE_ID_DEVICE_BASE || receiver >= NODE_ID_GROUP_BASE)
+        && (receiver < NODE_ID_GLOBAL_DEVICE_BASE || receiver >= NODE_ID_GLOBAL_DEVICE_BASE + NODE_ID_GLOBAL_DEVICE_BASE_SIZE))
+    {
+        return ErrorType::INVALID_PARAM;
+    }
+
+    OutgoingTransfer* transfer = nullptr;
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_OUTGOING; i++)
+    {
+        if (outgoing[i].receiver == NODE_ID_INVALID)
+        {
+            transfer = &outgoing[i];
+            break;
+        }
+    }
+    if (transfer == nullptr) return ErrorType::BUSY;
+
+    if (!transferIdCounterSeeded)
+    {
+        transferIdCounter = (u8)Utility::GetRandomInteger();
+        transferIdCounterSeeded = true;
+    }
+    transferIdCounter++;
+    transfer->receiver = receiver;
+    transfer->transferId = transferIdCounter;
+    transfer->amountOfSegments = (dataLength + RELIABLE_SEGMENT_PAYLOAD_SIZE - 1) / RELIABLE_SEGMENT_PAYLOAD_SIZE;
+    transfer->retriesLeft = MAX_RETRIES;
+    transfer->timeSinceLastSendDs = 0;
+    transfer->messageLength = dataLength;
+    transfer->listener = listener;
+    transfer->userType = userType;
+    CheckedMemcpy(transfer->message, data, dataLength);
+
+    for (u8 i = 0; i < transfer->amountOfSegments; i++)
+    {
+        SendSegment(*transfer, i);
+    }
+
+    if (transferId != nullptr) *transferId = transfer->transferId;
+
+    return ErrorType::SUCCESS;
+}
+
+void ReliableTransfer::SendSegment(const OutgoingTransfer& transfer, u8 segmentIndex) const
+{
+    const u16 offset = segmentIndex * RELIABLE_SEGMENT_PAYLOAD_SIZE;
+    const u16 payloadLength = transfer.messageLength - offset < RELIABLE_SEGMENT_PAYLOAD_SIZE ? transfer.messageLength - offset : RELIABLE_SEGMENT_PAYLOAD_SIZE;
+
+    ConnPacketReliableSegment segment;
+    CheckedMemset(&segment, 0, sizeof(segment));
+    segment.header.messageType = MessageType::RELIABLE_SEGMENT;
+    segment.header.sender = GS->node.configuration.nodeId;
+    segment.header.receiver = transfer.receiver;
+    segment.transferId = transfer.transferId;
+    segment.segmentIndex = segmentIndex;
+    segment.amountOfSegments = transfer.amountOfSegments;
+    CheckedMemcpy(segment.data, transfer.message + offset, payloadLength);
+
+    GS->cm.SendMeshMessage((u8*)&segment, SIZEOF_CONN_PACKET_RELIABLE_SEGMENT_HEADER + payloadLength);
+}
+
+void ReliableTransfer::SendAck(const IncomingTransfer& transfer) const
+{
+    ConnPacketReliableAck ack;
+    CheckedMemset(&ack, 0, sizeof(ack));
+    ack.header.messageType = MessageType::RELIABLE_ACK;
+    ack.header.sender = GS->node.configuration.nodeId;
+    ack.header.receiver = transfer.sender;
+    ack.transferId = transfer.transferId;
+    ack.receivedSegments = transfer.receivedSegments;
+
+    GS->cm.SendMeshMessage((u8*)&ack, SIZEOF_CONN_PACKET_RELIABLE_ACK);
+}
+
+void ReliableTransfer::FinishOutgoing(OutgoingTransfer& transfer, ErrorType result)
+{
+    const NodeId receiver = transfer.receiver;
+    const u8 transferId = transfer.transferId;
+    ReliableTransferListener* listener = transfer.listener;
+    const u32 userType = transfer.userType;
+
+    if (result != ErrorType::SUCCESS)
+    {
+        logt("WARNING", "Reliable transfer %u to %u failed", transferId, receiver);
+        GS->logger.LogCustomError(CustomErrorTypes::WARN_RELIABLE_TRANSFER_FAILED, receiver);
+    }
+
+    //The slot is freed before calling the listener so that it can already send the next message
+    transfer.receiver = NODE_ID_INVALID;
+    if (listener != nullptr)
+    {
+        listener->ReliableTransferResultHandler(receiver, transferId, result, userType);
+    }
+}
+
+ReliableTransfer::IncomingTransfer* ReliableTransfer::GetIncomingSlot(NodeId sender, u8 transferId, u8 amountOfSegments)
+{
+    IncomingTransfer* slot = nullptr;
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_INCOMING; i++)
+    {
+        if (incoming[i].sender == sender && incoming[i].transferId == transferId)
+        {
+            if (incoming[i].amountOfSegments == amountOfSegments) return &incoming[i];
+            slot = &incoming[i];
+            break;
+        }
+    }
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_INCOMING && slot == nullptr; i++)
+    {
+        if (incoming[i].sender == NODE_ID_INVALID) slot = &incoming[i];
+    }
+    //Messages that were already dispatched are only kept to acknowledge retransmissions, the oldest one is replaced
+    if (slot == nullptr)
+    {
+        for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_INCOMING; i++)
+        {
+            if (incoming[i].completed && (slot == nullptr || incoming[i].timeSinceLastSegmentDs > slot->timeSinceLastSegmentDs)) slot = &incoming[i];
+        }
+    }
+    if (slot == nullptr) return nullptr;
+
+    slot->sender = sender;
+    slot->transferId = transferId;
+    slot->amountOfSegments = amountOfSegments;
+    slot->completed = false;
+    slot->reportsLeft = MAX_RETRIES;
+    slot->timeSinceLastSegmentDs = 0;
+    slot->messageLength = 0;
+    slot->receivedSegments = 0;
+
+    return slot;
+}
+
+void ReliableTransfer::SegmentReceivedHandler(BaseConnection* connection, const ConnPacketReliableSegment* segment, u16 segmentLength)
+{
+    const u16 payloadLength = segmentLength - SIZEOF_CONN_PACKET_RELIABLE_SEGMENT_HEADER;
+    const u16 offset = segment->segmentIndex * RELIABLE_SEGMENT_PAYLOAD_SIZE;
+    const bool isLastSegment = segment->segmentIndex + 1 == segment->amountOfSegments;
+    if (segment->amountOfSegments == 0
+        || segment->amountOfSegments > MAX_SEGMENTS
+        || segment->segmentIndex >= segment->amountOfSegments
+        || payloadLength > RELIABLE_SEGMENT_PAYLOAD_SIZE
+        || offset + payloadLength > MAX_MESH_PACKET_SIZE
+        || (!isLastSegment && payloadLength != RELIABLE_SEGMENT_PAYLOAD_SIZE))
+    {
+        SIMEXCEPTION(IllegalFruityMeshPacketException);
+        return;
+    }
+
+    //If no slot is available, the segment is dropped and the sender retransmits it later
+    IncomingTransfer* transfer = GetIncomingSlot(segment->header.sender, segment->transferId, segment->amountOfSegments);
+    if (transfer == nullptr) return;
+
+    if (transfer->completed)
+    {
+        //The sender did not get our acknowledgement
+        if (isLastSegment) SendAck(*transfer);
+        return;
+    }
+
+    CheckedMemcpy(transfer->message + offset, segment->data, payloadLength);
+    if (isLastSegment) transfer->messageLength = offset + payloadLength;
+    transfer->receivedSegments |= 1UL << segment->segmentIndex;
+    transfer->timeSinceLastSegmentDs = 0;
+
+    if (transfer->receivedSegments == GetAllSegmentsMask(transfer->amountOfSegments))
+    {
+        transfer->completed = true;
+        SendAck(*transfer);
+
+        BaseConnectionSendData sendData;
+        sendData.characteristicHandle = FruityHal::FH_BLE_INVALID_HANDLE;
+        sendData.dataLength = transfer->messageLength;
+        sendData.deliveryOption = DeliveryOption::WRITE_CMD;
+        GS->cm.DispatchMeshMessage(connection, &sendData, (const ConnPacketHeader*)transfer->message, true);
+    }
+    else if (isLastSegment)
+    {
+        //Report the missing segments
+        SendAck(*transfer);
+    }
+}
+
+void ReliableTransfer::AckReceivedHandler(const ConnPacketReliableAck* ack)
+{
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_OUTGOING; i++)
+    {
+        OutgoingTransfer& transfer = outgoing[i];
+        if (transfer.receiver == NODE_ID_INVALID
+            || transfer.transferId != ack->transferId
+            || (transfer.receiver != ack->header.sender && transfer.receiver != NODE_ID_SHORTEST_SINK))
+        {
+            continue;
+        }
+
+        const u32 allSegments = GetAllSegmentsMask(transfer.amountOfSegments);
+        if ((ack->receivedSegments & allSegments) == allSegments)
+        {
+            FinishOutgoing(transfer, ErrorType::SUCCESS);
+        }
+        else if (transfer.retriesLeft == 0)
+        {
+            FinishOutgoing(transfer, ErrorType::TIMEOUT);
+        }
+        else
+        {
+            transfer.retriesLeft--;
+            transfer.timeSinceLastSendDs = 0;
+            u32 retransmitted = 0;
+            for (u8 segmentIndex = 0; segmentIndex < transfer.amountOfSegments; segmentIndex++)
+            {
+                if ((ack->receivedSegments & (1UL << segmentIndex)) == 0)
+                {
+                    SendSegment(transfer, segmentIndex);
+                    retransmitted++;
+                    SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED));
+                }
+            }
+            GS->logger.LogCustomCount(CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED, retransmitted);
+        }
+        return;
+    }
+}
+
+void ReliableTransfer::TimerEventHandler(u16 passedTimeDs)
+{
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_OUTGOING; i++)
+    {
+        OutgoingTransfer& transfer = outgoing[i];
+        if (transfer.receiver == NODE_ID_INVALID) continue;
+
+        transfer.timeSinceLastSendDs += passedTimeDs;
+        if (transfer.timeSinceLastSendDs < ACK_TIMEOUT_DS) continue;
+
+        if (transfer.retriesLeft == 0)
+        {
+            FinishOutgoing(transfer, ErrorType::TIMEOUT);
+        }
+        else
+        {
+            //We do not know which segments were lost, the last one makes the receiver report the missing ones
+            transfer.retriesLeft--;
+            transfer.timeSinceLastSendDs = 0;
+            SendSegment(transfer, transfer.amountOfSegments - 1);
+            GS->logger.LogCustomCount(CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED);
+            SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED));
+        }
+    }
+
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_INCOMING; i++)
+    {
+        IncomingTransfer& transfer = incoming[i];
+        if (transfer.sender == NODE_ID_INVALID) continue;
+
+        transfer.timeSinceLastSegmentDs += passedTimeDs;
+        if (transfer.completed)
+        {
+            if (transfer.timeSinceLastSegmentDs >= COMPLETED_KEEP_DS) transfer.sender = NODE_ID_INVALID;
+        }
+        else if (transfer.timeSinceLastSegmentDs >= REASSEMBLY_TIMEOUT_DS)
+        {
+            if (transfer.reportsLeft == 0)
+            {
+                //The sender gave up as well
+                transfer.sender = NODE_ID_INVALID;
+            }
+            else
+            {
+                transfer.reportsLeft--;
+                transfer.timeSinceLastSegmentDs = 0;
+                SendAck(transfer);
+            }
+        }
+    }
+}
+
+u32 ReliableTransfer::GetAmountOfPendingTransfers() const
+{
+    u32 amount = 0;
+    for (u32 i = 0; i < RELIABLE_TRANSFER_MAX_OUTGOING; i++)
+    {
+        if (outgoing[i].receiver != NODE_ID_INVALID) amount++;
+    }
+    return amount;
+}
+
+#endif //IS_ACTIVE(RELIABLE_TRANSFER)
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// /****************************************************************************
+// **
+// ** Copyright (C) 2015-2022 M-Way Solutions GmbH
+// ** Contact: https://www.blureange.io/licensing
+// **
+// ** This file is part of the Bluerange/FruityMesh implementation
+// **
+// ** $BR_BEGIN_LICENSE:GPL-EXCEPT$
+// ** Commercial License Usage
+// ** Licensees holding valid commercial Bluerange licenses may use this file in
+// ** accordance with the commercial license agreement provided with the
+// ** Software or, alternatively, in accordance with the terms contained in
+// ** a written agreement between them and M-Way Solutions GmbH.
+// ** For licensing terms and conditions see https://www.bluerange.io/terms-conditions. For further
+// ** information use the contact form at https://www.bluerange.io/contact.
+// **
+// ** GNU General Public License Usage
+// ** Alternatively, this file may be used under the terms of the GNU
+// ** General Public License version 3 as published by the Free Software
+// ** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+// ** included in the packaging of this file. Please review the following
+// ** information to ensure the GNU General Public License requirements will
+// ** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+// **
+// ** $BR_END_LICENSE$
+// **
+// ****************************************************************************/
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <FmTypes.h>
+#include <ConnectionMessageTypes.h>
+#include <Config.h>
+
+#if IS_ACTIVE(RELIABLE_TRANSFER)
+
+class BaseConnection;
+
+class ReliableTransferListener
+{
+public:
+    ReliableTransferListener() {};
+    virtual ~ReliableTransferListener() {};
+
+    //Called with SUCCESS once the receiver acknowledged the whole message or with TIMEOUT once all retries were used
+    virtual void ReliableTransferResultHandler(NodeId receiver, u8 transferId, ErrorType result, u32 userType) = 0;
+};
+
+/*
+ * The ReliableTransfer sends unicast messages with an end-to-end acknowledgement. The message is cut into
+ * segments that each fit into a single write, so that no hop has to split them. The receiver reassembles the
+ * segments and acknowledges them once the last segment arrived or once no further segments arrived for some
+ * time. The acknowledgement tells the sender which segments are missing so that only these are retransmitted.
+ */
+class ReliableTransfer
+{
+private:
+    //Time after which the sender retransmits if it did not receive any acknowledgement
+    static constexpr u16 ACK_TIMEOUT_DS = SEC_TO_DS(10);
+    //Time after which the receiver reports missing segments if no further segment arrived
+    static constexpr u16 REASSEMBLY_TIMEOUT_DS = SEC_TO_DS(3);
+    //Time that a received message is remembered to acknowledge retransmissions without dispatching it twice
+    static constexpr u16 COMPLETED_KEEP_DS = SEC_TO_DS(30);
+    static constexpr u8 MAX_RETRIES = 3;
+    static constexpr u8 MAX_SEGMENTS = (MAX_MESH_PACKET_SIZE + RELIABLE_SEGMENT_PAYLOAD_SIZE - 1) / RELIABLE_SEGMENT_PAYLOAD_SIZE;
+    static_assert(MAX_SEGMENTS <= 32, "The received segments must fit into the bitmask of the acknowledgement");
+
+    struct OutgoingTransfer
+    {
+        NodeId receiver; //NODE_ID_INVALID if unused
+        u8 transferId;
+        u8 amountOfSegments;
+        u8 retriesLeft;
+        u16 timeSinceLastSendDs;
+        u16 messageLength;
+        ReliableTransferListener* listener;
+        u32 userType;
+        u8 message[MAX_MESH_PACKET_SIZE];
+    };
+    struct IncomingTransfer
+    {
+        NodeId sender; //NODE_ID_INVALID if unused
+        u8 transferId;
+        u8 amountOfSegments;
+        bool completed;
+        u8 reportsLeft;
+        u16 timeSinceLastSegmentDs;
+        u16 messageLength;
+        u32 receivedSegments;
+        u8 message[MAX_MESH_PACKET_SIZE];
+    };
+
+    OutgoingTransfer outgoing[RELIABLE_TRANSFER_MAX_OUTGOING];
+    IncomingTransfer incoming[RELIABLE_TRANSFER_MAX_INCOMING];
+    //Starts at a random value on the first transfer after a boot, as the receivers remember the ids of the
+    //transfers that they completed within COMPLETED_KEEP_DS and would acknowledge a reused id without dispatching it
+    u8 transferIdCounter = 0;
+    bool transferIdCounterSeeded = false;
+
+    static u32 GetAllSegmentsMask(u8 amountOfSegments);
+    void SendSegment(const OutgoingTransfer& transfer, u8 segmentIndex) const;
+    void SendAck(const IncomingTransfer& transfer) const;
+    void FinishOutgoing(OutgoingTransfer& transfer, ErrorType result);
+    IncomingTransfer* GetIncomingSlot(NodeId sender, u8 transferId, u8 amountOfSegments);
+
+public:
+    ReliableTransfer();
+
+    //Sends the message to its receiver, which must be a single node or the shortest sink. The listener
+    //is informed about the result and may be nullptr. The id of the transfer is written to transferId.
+    ErrorType Send(const u8* data, u16 dataLength, ReliableTransferListener* listener, u32 userType, u8* transferId = nullptr);
+
+    void SegmentReceivedHandler(BaseConnection* connection, const ConnPacketReliableSegment* segment, u16 segmentLength);
+    void AckReceivedHandler(const ConnPacketReliableAck* ack);
+    void TimerEventHandler(u16 passedTimeDs);
+
+    u32 GetAmountOfPendingTransfers() const;
+};
+
+#endif //IS_ACTIVE(RELIABLE_TRANSFER)
@@ -74,7 +74,7 @@ static u8 GetFunctionArgumentSize(AutoActFunction func)
     }
 }
 
-// Applies a single numeric transformation from a transformation pipeline.
+// Applies a single numeric transformation of an already validated function list.
 static bool ApplyNumericTransformation(float& value, AutoActFunction func, const u8* arguments)
 {
     if (func == AutoActFunction::MIN)
@@ -92,11 +92,6 @@ static bool ApplyNumericTransformation(float& value, AutoActFunction func, const
         i32 offset = Utility::ToAlignedI32(arguments);
         value += offset;
     }
-    else if (func == AutoActFunction::REVERSE_BYTES)
-    {
-        SIMEXCEPTION(NotImplementedException);
-        return false;
-    }
     else if (func == AutoActFunction::INT_MULT)
     {
         i32 mult = Utility::ToAlignedI32(arguments);
@@ -156,138 +151,66 @@ static bool LoadInitialValue(float& value, const u8* input, DataTypeDescriptor d
     }
 }
 
-// Performs all transformations from a transformation pipeline, one after the other. Only for numeric pipelines.
-static AutoActModuleResponse TransformNumeric(const u8* input, u32 inputSize, DataTypeDescriptor inputDataType, u8* output, DataTypeDescriptor outputDataType, const u8* transformations, u32 transformationsLength)
+// If the data type can be loaded into and stored from the float that is used for numeric calculations.
+static bool IsValidNumericDataType(DataTypeDescriptor dataType)
 {
-    const u8* readPtr = input;
-    const u8* endTransformations = transformations + transformationsLength;
-
-    bool transformationStarted = false;
-    float interimResult = 0;
+    switch (Utility::ToLittleEndianDescriptor(dataType))
+    {
+    case DataTypeDescriptor::U8_LE:
+    case DataTypeDescriptor::U16_LE:
+    case DataTypeDescriptor::U32_LE:
+    case DataTypeDescriptor::FLOAT32_LE:
+        return true;
+    default:
+        return false;
+    }
+}
 
-    bool dataOffsetFound = false;
+// Validates the transformation pipeline of a table entry and decodes it into a program that
+// can be executed for every incoming message without parsing the function list again.
+static AutoActModuleResponseCode CompileProgram(const AutoActTableEntryV0* entry, AutoActProgram& program)
+{
+    program = {};
+    program.inputDataType = entry->orgDataType;
+    program.outputDataType = entry->targetDataType;
+    program.receiverNodeIdFilter = entry->receiverNodeIdFilter;
+    program.moduleIdFilter = entry->moduleIdFilter;
+    program.componentFilter = entry->componentFilter;
+    program.registerFilter = entry->registerFilter;
 
-    while (transformations < endTransformations)
+    if ((program.inputDataType == DataTypeDescriptor::RAW && program.outputDataType != DataTypeDescriptor::RAW)
+        || (program.inputDataType != DataTypeDescriptor::RAW && program.outputDataType == DataTypeDescriptor::RAW))
     {
-        AutoActFunction func = (AutoActFunction)*transformations;
-        if (!IsValidNumericFunc(func))
-        {
-            SIMEXCEPTION(IllegalStateException);
-            return { AutoActModuleResponseCode::INVALID_FUNCTION, 0 };
-        }
-        transformations++;
-        const u8* arguments = transformations;
-        transformations += GetFunctionArgumentSize(func);
-        if (transformations > endTransformations)
-        {
-            // There wasn't enough data in the transformations list to fill out all arguments.
-            SIMEXCEPTION(IllegalStateException);
-            return { AutoActModuleResponseCode::INVALID_ARGUMENTS, 0 };
-        }
-        // Handle Preamble
-        if (func == AutoActFunction::DATA_OFFSET)
-        {
-            if (transformationStarted)
-            {
-                SIMEXCEPTION(PreambleNotAtStartException);
-                return { AutoActModuleResponseCode::DATA_OFFSET_NOT_IN_PREAMBLE, 0 };
-            }
-            if (dataOffsetFound)
-            {
-                SIMEXCEPTION(DoubleDataOffsetException);
-                return { AutoActModuleResponseCode::DATA_OFFSET_MULTIPLE, 0 };
-            }
-            dataOffsetFound = true;
-            const u8 offset = *arguments;
-            readPtr += offset;
-            if (inputSize > offset)
-            {
-                inputSize -= offset;
-            }
-            else
-            {
-                SIMEXCEPTION(IllegalStateException);
-                return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
-            }
-        }
-        else
-        {
-            if (!transformationStarted)
-            {
-                transformationStarted = true;
-                if (GetSize(inputDataType) > inputSize)
-                {
-                    SIMEXCEPTION(IllegalStateException);
-                    return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
-                }
-
-                if (!LoadInitialValue(interimResult, readPtr, inputDataType))
-                {
-                    SIMEXCEPTION(IllegalStateException);
-                    return { AutoActModuleResponseCode::FAILED_TO_LOAD_DATATYPE, 0 };
-                }
-            }
-            if (!ApplyNumericTransformation(interimResult, func, arguments))
-            {
-                // A transformation failed.
-                SIMEXCEPTION(TransformationFailedException);
-                return { AutoActModuleResponseCode::FAILED_TO_APPLY_TRANSFORMATION, 0 };
-            }
-        }
+        // Either both types are numeric, or both are strings. We currently do not support conversion between strings and numerics.
+        SIMEXCEPTION(IllegalStateException);
+        return AutoActModuleResponseCode::DATA_TYPE_MISMATCH;
     }
-
-    if (!transformationStarted)
+    program.isNumeric = program.inputDataType != DataTypeDescriptor::RAW;
+    if (program.isNumeric && !IsValidNumericDataType(program.inputDataType))
     {
-        if (GetSize(inputDataType) > inputSize)
-        {
-            SIMEXCEPTION(IllegalStateException);
-            return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
-        }
-
-        if (!LoadInitialValue(interimResult, readPtr, inputDataType))
-        {
-            SIMEXCEPTION(IllegalStateException);
-            return { AutoActModuleResponseCode::FAILED_TO_LOAD_DATATYPE, 0 };
-        }
-    }
-
-    switch (Utility::ToLittleEndianDescriptor(outputDataType))
-    {
-    case DataTypeDescriptor::U8_LE:      { u8    value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
-    case DataTypeDescriptor::U16_LE:     { u16   value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
-    case DataTypeDescriptor::U32_LE:     { u32   value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
-    case DataTypeDescriptor::FLOAT32_LE: { float value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
-    default: SIMEXCEPTION(IllegalArgumentException); return { AutoActModuleResponseCode::ILLEGAL_OUTPUT_TYPE, 0 };
+        SIMEXCEPTION(IllegalStateException);
+        return AutoActModuleResponseCode::FAILED_TO_LOAD_DATATYPE;
     }
-
-    if (Utility::GetEndianness(outputDataType) == Endianness::BIG)
+    if (program.isNumeric && !IsValidNumericDataType(program.outputDataType))
     {
-        Utility::SwapBytes(output, GetSize(outputDataType));
+        SIMEXCEPTION(IllegalArgumentException);
+        return AutoActModuleResponseCode::ILLEGAL_OUTPUT_TYPE;
     }
 
-    return { AutoActModuleResponseCode::SUCCESS, GetSize(outputDataType) };
-}
-
-// Performs all transformations from a transformation pipeline, one after the other. Only for string pipelines.
-static AutoActModuleResponse TransformString(const u8* input, u32 inputSize, u8* output, const u8* transformations, u32 transformationsLength)
-{
-    const u8* readPtr = input;
-    const u8* endTransformations = transformations + transformationsLength;
+    const u8* transformations = entry->functionList;
+    const u8* endTransformations = transformations + entry->functionListLength;
 
     bool transformationStarted = false;
-
     bool dataOffsetFound = false;
     bool dataLengthFound = false;
-    u8 dataLength = 0;
-    bool reverseBytes = false;
 
     while (transformations < endTransformations)
     {
         AutoActFunction func = (AutoActFunction)*transformations;
-        if (!IsValidStringFunc(func))
+        if (program.isNumeric ? !IsValidNumericFunc(func) : !IsValidStringFunc(func))
         {
             SIMEXCEPTION(IllegalStateException);
-            return { AutoActModuleResponseCode::INVALID_FUNCTION, 0 };
+            return AutoActModuleResponseCode::INVALID_FUNCTION;
         }
         transformations++;
         const u8* arguments = transformations;
@@ -296,7 +219,7 @@ static AutoActModuleResponse TransformString(const u8* input, u32 inputSize, u8*
         {
             // There wasn't enough data in the transformations list to fill out all arguments.
             SIMEXCEPTION(IllegalStateException);
-            return { AutoActModuleResponseCode::INVALID_ARGUMENTS, 0 };
+            return AutoActModuleResponseCode::INVALID_ARGUMENTS;
         }
         // Handle Preamble
         if (func == AutoActFunction::DATA_OFFSET)
@@ -304,104 +227,130 @@ static AutoActModuleResponse TransformString(const u8* input, u32 inputSize, u8*
             if (transformationStarted)
             {
                 SIMEXCEPTION(PreambleNotAtStartException);
-                return { AutoActModuleResponseCode::DATA_OFFSET_NOT_IN_PREAMBLE, 0 };
+                return AutoActModuleResponseCode::DATA_OFFSET_NOT_IN_PREAMBLE;
             }
             if (dataOffsetFound)
             {
                 SIMEXCEPTION(DoubleDataOffsetException);
-                return { AutoActModuleResponseCode::DATA_OFFSET_MULTIPLE, 0 };
+                return AutoActModuleResponseCode::DATA_OFFSET_MULTIPLE;
             }
             dataOffsetFound = true;
-            const u8 offset = *arguments;
-            readPtr += offset;
-            if (inputSize > offset)
-            {
-                inputSize -= offset;
-            }
-            else
-            {
-                SIMEXCEPTION(IllegalStateException);
-                return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
-            }
+            program.hasDataOffset = true;
+            program.dataOffset = *arguments;
         }
         else if (func == AutoActFunction::DATA_LENGTH)
         {
             if (transformationStarted)
             {
                 SIMEXCEPTION(PreambleNotAtStartException);
-                return { AutoActModuleResponseCode::DATA_LENGTH_NOT_IN_PREAMBLE, 0 };
+                return AutoActModuleResponseCode::DATA_LENGTH_NOT_IN_PREAMBLE;
             }
             if (dataLengthFound)
             {
                 SIMEXCEPTION(IllegalStateException);
-                return { AutoActModuleResponseCode::DATA_LENGTH_MULTIPLE, 0 };
+                return AutoActModuleResponseCode::DATA_LENGTH_MULTIPLE;
             }
             dataLengthFound = true;
-            dataLength = *arguments;
-            if (dataLength > inputSize)
-            {
-                SIMEXCEPTION(IllegalStateException);
-                return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
-            }
+            program.dataLength = *arguments;
         }
         else
         {
             if (!transformationStarted)
             {
                 transformationStarted = true;
-                if (dataLength == 0)
-                {
-                    dataLength = inputSize;
-                }
+                program.stepsOffset = (u8)(arguments - 1 - entry->functionList);
             }
             if (func == AutoActFunction::REVERSE_BYTES)
             {
-                reverseBytes = !reverseBytes;
+                program.reverseBytes = !program.reverseBytes;
             }
-            else
+            else if (!program.isNumeric)
             {
-                // A transformation failed.
+                // REVERSE_BYTES is the only transformation that can be applied to strings. Other valid string
+                // functions such as NO_OP have always failed to apply, so such pipelines are rejected as well.
                 SIMEXCEPTION(TransformationFailedException);
-                return { AutoActModuleResponseCode::FAILED_TO_APPLY_TRANSFORMATION, 0 };
+                return AutoActModuleResponseCode::FAILED_TO_APPLY_TRANSFORMATION;
             }
         }
     }
-
     if (!transformationStarted)
     {
-        if (dataLength == 0)
-        {
-            dataLength = inputSize;
-        }
-    }
-    CheckedMemcpy(output, readPtr, dataLength);
-    if (reverseBytes)
-    {
-        Utility::SwapBytes(output, dataLength);
+        program.stepsOffset = entry->functionListLength;
     }
 
-    return { AutoActModuleResponseCode::SUCCESS, dataLength };
+    program.valid = true;
+    return AutoActModuleResponseCode::SUCCESS;
 }
 
-// Performs all transformations from a transformation pipeline, one after the other.
-static AutoActModuleResponse Transform(const u8* input, u32 inputSize, DataTypeDescriptor inputDataType, u8* output, DataTypeDescriptor outputDataType, const u8* transformations, u32 transformationsLength)
+// Executes a compiled program on the input. Only the checks that depend on the input are done here.
+static AutoActModuleResponse ExecuteProgram(const AutoActProgram& program, const AutoActTableEntryV0* entry, const u8* input, u32 inputSize, u8* output)
 {
-    if ((inputDataType == DataTypeDescriptor::RAW && outputDataType != DataTypeDescriptor::RAW)
-        || (inputDataType != DataTypeDescriptor::RAW && outputDataType == DataTypeDescriptor::RAW))
+    if (program.hasDataOffset && inputSize <= program.dataOffset)
     {
-        // Either both types are numeric, or both are strings. We currently do not support conversion between strings and numerics.
         SIMEXCEPTION(IllegalStateException);
-        return { AutoActModuleResponseCode::DATA_TYPE_MISMATCH, 0 };
+        return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
     }
+    const u8* readPtr = input + program.dataOffset;
+    const u32 remainingSize = inputSize - program.dataOffset;
 
-    if (inputDataType == DataTypeDescriptor::RAW)
+    if (!program.isNumeric)
     {
-        return TransformString(input, inputSize, output, transformations, transformationsLength);
+        const u32 dataLength = program.dataLength != 0 ? program.dataLength : remainingSize;
+        if (dataLength > remainingSize)
+        {
+            SIMEXCEPTION(IllegalStateException);
+            return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
+        }
+        CheckedMemcpy(output, readPtr, dataLength);
+        if (program.reverseBytes)
+        {
+            Utility::SwapBytes(output, dataLength);
+        }
+        return { AutoActModuleResponseCode::SUCCESS, dataLength };
     }
-    else
+
+    if (GetSize(program.inputDataType) > remainingSize)
+    {
+        SIMEXCEPTION(IllegalStateException);
+        return { AutoActModuleResponseCode::INPUT_TOO_SMALL, 0 };
+    }
+
+    float interimResult = 0;
+    if (!LoadInitialValue(interimResult, readPtr, program.inputDataType))
+    {
+        SIMEXCEPTION(IllegalStateException); //LCOV_EXCL_LINE Checked when compiling the program.
+        return { AutoActModuleResponseCode::FAILED_TO_LOAD_DATATYPE, 0 }; //LCOV_EXCL_LINE Checked when compiling the program.
+    }
+    // The function list was validated when compiling the program, so the steps are applied without further checks.
+    const u8* transformations = entry->functionList + program.stepsOffset;
+    const u8* endTransformations = entry->functionList + entry->functionListLength;
+    while (transformations < endTransformations)
     {
-        return TransformNumeric(input, inputSize, inputDataType, output, outputDataType, transformations, transformationsLength);
+        const AutoActFunction func = (AutoActFunction)*transformations;
+        const u8* arguments = transformations + 1;
+        transformations = arguments + GetFunctionArgumentSize(func);
+        if (!ApplyNumericTransformation(interimResult, func, arguments))
+        {
+            SIMEXCEPTION(TransformationFailedException); //LCOV_EXCL_LINE Checked when compiling the program.
+            return { AutoActModuleResponseCode::FAILED_TO_APPLY_TRANSFORMATION, 0 }; //LCOV_EXCL_LINE Checked when compiling the program.
+        }
+    }
+
+    switch (Utility::ToLittleEndianDescriptor(program.outputDataType))
+    {
+    case DataTypeDescriptor::U8_LE:      { u8    value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
+    case DataTypeDescriptor::U16_LE:     { u16   value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
+    case DataTypeDescriptor::U32_LE:     { u32   value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
+    case DataTypeDescriptor::FLOAT32_LE: { float value = interimResult; CheckedMemcpy(output, &value, sizeof(value)); break; }
+    default: SIMEXCEPTION(IllegalArgumentException); return { AutoActModuleResponseCode::ILLEGAL_OUTPUT_TYPE, 0 }; //LCOV_EXCL_LINE Checked when compiling the program.
     }
+
+    if (Utility::GetEndianness(program.outputDataType) == Endianness::BIG)
+    {
+        Utility::SwapBytes(output, GetSize(program.outputDataType));
+    }
+
+    return { AutoActModuleResponseCode::SUCCESS, GetSize(program.outputDataType) };
 }
 
 void AutoActModule::RecordStorageEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength)
@@ -419,6 +368,7 @@ void AutoActModule::RecordStorageEventHandler(u16 recordId, RecordStorageResultC
         }
         else
         {
+            LoadProgram(ud->entryIndex);
             SendResponse(AutoActModuleSetEntryResponse{ AutoActModuleResponseCode::SUCCESS, ud->entryIndex }, ud->sender, ud->requestHandle);
         }
     }
@@ -433,6 +383,7 @@ void AutoActModule::RecordStorageEventHandler(u16 recordId, RecordStorageResultC
         }
         else
         {
+            programs[ud->entryIndex] = {};
             if (userType == (u32)AutoActModuleTriggerAndResponseMessages::CLEAR_ENTRY)
             {
                 SendResponse(AutoActModuleClearEntryResponse{ AutoActModuleResponseCode::SUCCESS, ud->entryIndex }, ud->sender, ud->requestHandle);
@@ -538,6 +489,10 @@ void AutoActModule::ConfigurationLoadedHandler(u8* migratableConfig, u16 migrata
     if(newConfig != nullptr && newConfig->moduleVersion == 1){/* ... */};
 
     //Do additional initialization upon loading the config
+    for (u32 entryIndex = 0; entryIndex < MAX_AMOUNT_OF_ENTRIES; entryIndex++)
+    {
+        LoadProgram(entryIndex);
+    }
 #endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
 
 }
@@ -770,16 +725,21 @@ void AutoActModule::MeshMessageReceivedHandler(BaseConnection* connection, BaseC
         {
             for (u32 i = 0; i < MAX_AMOUNT_OF_ENTRIES; i++)
             {
-                // FIXME: Quite a heavy performance hit currently. 
-                //        See https://repo.mwaysolutions.com/relution/fruitymesh/-/merge_requests/1409#note_336338
-                const AutoActTableEntryV0* entry = getTableEntryV0(i);
-                if (entry) // Entry exists
+                // The filters are matched against the compiled programs, the record storage is only accessed for matching entries.
+                const AutoActProgram& program = programs[i];
+                if (program.valid) // Entry exists
                 {
-                    if (   entry->receiverNodeIdFilter    == receiverId
-                        && entry->moduleIdFilter  == moduleId
-                        && entry->componentFilter == component
-                        && entry->registerFilter  == registerAddress) // Entry filters match
+                    if (   program.receiverNodeIdFilter == receiverId
+                        && program.moduleIdFilter       == moduleId
+                        && program.componentFilter      == component
+                        && program.registerFilter       == registerAddress) // Entry filters match
                     {
+                        const AutoActTableEntryV0* entry = getTableEntryV0(i);
+                        if (!entry)
+                        {
+                            SIMEXCEPTION(IllegalStateException); //LCOV_EXCL_LINE Programs are invalidated together with their entries.
+                            continue;                            //LCOV_EXCL_LINE Programs are invalidated together with their entries.
+                        }
                         u8 buffer[sizeof(ConnPacketComponentMessageVendor) + MAX_IO_SIZE];
                         CheckedMemset(buffer, 0, sizeof(buffer));
                         ConnPacketHeader* header = (ConnPacketHeader*)buffer;
@@ -815,7 +775,7 @@ void AutoActModule::MeshMessageReceivedHandler(BaseConnection* connection, BaseC
                             headerSize = SIZEOF_CONN_PACKET_COMPONENT_MESSAGE_VENDOR;
                         }
 
-                        AutoActModuleResponse transformResponse = Transform(inPayload, inPayloadLength.GetRaw(), entry->orgDataType, outPayload, entry->targetDataType, entry->functionList, entry->functionListLength);
+                        AutoActModuleResponse transformResponse = ExecuteProgram(program, entry, inPayload, inPayloadLength.GetRaw(), outPayload);
                         if (AutoActModuleResponseCode::SUCCESS == transformResponse.code)
                         {
                             BaseConnectionSendData sendData;
@@ -851,6 +811,20 @@ const AutoActTableEntryV0* AutoActModule::getTableEntryV0(u8 entryIndex)
     return nullptr;
 }
 
+void AutoActModule::LoadProgram(u8 entryIndex)
+{
+    programs[entryIndex] = {};
+    const AutoActTableEntryV0* entry = getTableEntryV0(entryIndex);
+    if (entry && CompileProgram(entry, programs[entryIndex]) != AutoActModuleResponseCode::SUCCESS)
+    {
+        // Entries are validated before they are stored. Older firmwares stored entries without validating them
+        // and only failed once a message was transformed, so such an entry stays disabled, as no message could
+        // ever pass through it.
+        logt("WARNING", "AutoAct entry %u could not be compiled", (u32)entryIndex);
+        programs[entryIndex] = {};
+    }
+}
+
 void AutoActModule::SetEntry(u8 entryIndex, const AutoActTableEntryV0* tableEntry, MessageLength tableEntryBufferSize, u8 moduleVersion, NodeId sender, u8 requestHandle)
 {
     if (entryIndex >= MAX_AMOUNT_OF_ENTRIES)
@@ -875,12 +849,22 @@ void AutoActModule::SetEntry(u8 entryIndex, const AutoActTableEntryV0* tableEntr
     }
 
     {
-        // Perform a dry run with dummy data and see if all transformations were successful.
+        // Compile the pipeline once to reject invalid entries before they are stored. The program
+        // itself is compiled again from the stored record once saving succeeded.
+        AutoActProgram program;
+        AutoActModuleResponseCode compileResult = CompileProgram(tableEntry, program);
+        if (compileResult != AutoActModuleResponseCode::SUCCESS)
+        {
+            SendResponse(AutoActModuleSetEntryResponse{ compileResult, entryIndex }, sender, requestHandle);
+            return;
+        }
+
+        // Perform a dry run with dummy data and see if the preamble fits into the largest possible input.
         u8 input[MAX_IO_SIZE];
         CheckedMemset(input, 0, sizeof(input));
         u8 output[MAX_IO_SIZE];
         CheckedMemset(output, 0, sizeof(output));
-        AutoActModuleResponseCode dryRunResult = Transform(input, sizeof(input), tableEntry->orgDataType, output, tableEntry->targetDataType, tableEntry->functionList, tableEntry->functionListLength).code;
+        AutoActModuleResponseCode dryRunResult = ExecuteProgram(program, tableEntry, input, sizeof(input), output).code;
         if (dryRunResult != AutoActModuleResponseCode::SUCCESS)
         {
             SendResponse(AutoActModuleSetEntryResponse{ dryRunResult, entryIndex }, sender, requestHandle);
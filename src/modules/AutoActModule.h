@@ -174,6 +174,27 @@ typedef struct
 STATIC_ASSERT_SIZE(AutoActModuleClearEntryResponse, 2);
 #pragma pack(pop)
 
+// The transformation pipeline of a table entry in a validated and decoded form. It is compiled
+// once when the entry is loaded or set so that incoming messages don't have to validate the function list.
+// The numeric transformations themselves are not copied as they are executed from the stored entry.
+struct AutoActProgram
+{
+    bool valid;
+    bool isNumeric;
+    bool reverseBytes;  // Only for string pipelines
+    bool hasDataOffset; // An explicit DATA_OFFSET requires input after the offset, even if the offset is 0
+    u8 dataOffset;
+    u8 dataLength;      // Only for string pipelines, 0 means everything after the dataOffset
+    u8 stepsOffset;     // Only for numeric pipelines, position of the first transformation after the preamble in the function list
+    DataTypeDescriptor inputDataType;
+    DataTypeDescriptor outputDataType;
+    // Copies of the entry filters, so that incoming messages can be matched without accessing the record storage
+    NodeId receiverNodeIdFilter;
+    ModuleIdWrapper moduleIdFilter;
+    u16 componentFilter;
+    u16 registerFilter;
+};
+
 class AutoActModule : 
     public Module,
     public RecordStorageEventListener
@@ -198,6 +219,11 @@ TESTER_PUBLIC:
         u8 requestHandle;
     };
 
+    std::array<AutoActProgram, MAX_AMOUNT_OF_ENTRIES> programs = {};
+
+    // Compiles the stored entry into the programs, or invalidates the program if there is no entry
+    void LoadProgram(u8 entryIndex);
+
     void RecordStorageEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength) override final;
 
     void SendResponse(const AutoActModuleSetEntryResponse&   response, NodeId id, u8 requestHandle) const;
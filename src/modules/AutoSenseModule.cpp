@@ -36,6 +36,70 @@
 #include <Node.h>
 #include <IoModule.h>
 
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+// Returns the size of a numeric sample of the given type or 0 if the type can't be aggregated.
+static u32 GetSampleSize(DataTypeDescriptor dataType)
+{
+    switch (Utility::ToLittleEndianDescriptor(dataType))
+    {
+    case DataTypeDescriptor::U8_LE:      return 1;
+    case DataTypeDescriptor::U16_LE:     return 2;
+    case DataTypeDescriptor::U32_LE:     return 4;
+    case DataTypeDescriptor::I8_LE:      return 1;
+    case DataTypeDescriptor::I16_LE:     return 2;
+    case DataTypeDescriptor::I32_LE:     return 4;
+    case DataTypeDescriptor::FLOAT32_LE: return 4;
+    default:                             return 0;
+    }
+}
+
+// Loads a sample of "any numeric type" into a float so that samples can be compared and averaged.
+static float LoadSample(const u8* input, DataTypeDescriptor dataType)
+{
+    u8 inputCopy[4] = {};
+    CheckedMemcpy(inputCopy, input, GetSampleSize(dataType));
+    if (Utility::GetEndianness(dataType) == Endianness::BIG)
+    {
+        Utility::SwapBytes(inputCopy, GetSampleSize(dataType));
+        dataType = Utility::ToLittleEndianDescriptor(dataType);
+    }
+
+    switch (dataType)
+    {
+    case DataTypeDescriptor::U8_LE:      return *(inputCopy);
+    case DataTypeDescriptor::U16_LE:     return Utility::ToAlignedU16(inputCopy);
+    case DataTypeDescriptor::U32_LE:     return Utility::ToAlignedU32(inputCopy);
+    case DataTypeDescriptor::I8_LE:      return (i8)*(inputCopy);
+    case DataTypeDescriptor::I16_LE:     return Utility::ToAlignedI16(inputCopy);
+    case DataTypeDescriptor::I32_LE:     return Utility::ToAlignedI32(inputCopy);
+    case DataTypeDescriptor::FLOAT32_LE: return Utility::ToAlignedFloat(inputCopy);
+    default: SIMEXCEPTION(IllegalArgumentException); return 0; //LCOV_EXCL_LINE Checked when setting the entry.
+    }
+}
+
+// Stores a calculated value in the given type, integer types are rounded to the nearest value.
+static void StoreSample(u8* output, float value, DataTypeDescriptor dataType)
+{
+    const float rounded = value >= 0 ? value + 0.5f : value - 0.5f;
+    switch (Utility::ToLittleEndianDescriptor(dataType))
+    {
+    case DataTypeDescriptor::U8_LE:      { u8    v = (u8) rounded; CheckedMemcpy(output, &v, sizeof(v)); break; }
+    case DataTypeDescriptor::U16_LE:     { u16   v = (u16)rounded; CheckedMemcpy(output, &v, sizeof(v)); break; }
+    case DataTypeDescriptor::U32_LE:     { u32   v = (u32)rounded; CheckedMemcpy(output, &v, sizeof(v)); break; }
+    case DataTypeDescriptor::I8_LE:      { i8    v = (i8) rounded; CheckedMemcpy(output, &v, sizeof(v)); break; }
+    case DataTypeDescriptor::I16_LE:     { i16   v = (i16)rounded; CheckedMemcpy(output, &v, sizeof(v)); break; }
+    case DataTypeDescriptor::I32_LE:     { i32   v = (i32)rounded; CheckedMemcpy(output, &v, sizeof(v)); break; }
+    case DataTypeDescriptor::FLOAT32_LE: { float v = value;        CheckedMemcpy(output, &v, sizeof(v)); break; }
+    default: SIMEXCEPTION(IllegalArgumentException); return; //LCOV_EXCL_LINE Checked when setting the entry.
+    }
+
+    if (Utility::GetEndianness(dataType) == Endianness::BIG)
+    {
+        Utility::SwapBytes(output, GetSampleSize(dataType));
+    }
+}
+#endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+
 AutoSenseModule::AutoSenseModule()
     : Module(ModuleId::AUTO_SENSE_MODULE, "autosense")
 {
@@ -82,6 +146,10 @@ void AutoSenseModule::ConfigurationLoadedHandler(u8* migratableConfig, u16 migra
         {
             AddScheduleEvents(entryIndex, tableEntry);
             valueCache.registerSlot(entryIndex, tableEntry->length);
+            if (IsAggregatingFunction(tableEntry->reportFunction))
+            {
+                sampleWindows.registerSlot(entryIndex, tableEntry->length * AUTO_SENSE_MAX_SAMPLES_PER_WINDOW);
+            }
         }
     }
     //Start the Module...
@@ -140,13 +208,31 @@ void AutoSenseModule::TimerEventHandler(u16 passedTimeDs)
         {
             // No special handling required.
         }
+        else if (IsAggregatingFunction(tableEntry->reportFunction))
+        {
+            if (!AggregateSampleWindow(entryIndex, tableEntry))
+            {
+                GS->logger.LogCustomCount(CustomErrorTypes::WARN_AUTO_SENSE_REPORT_WITHOUT_DATA);
+                continue; // No sample was polled since the last report.
+            }
+        }
+        else if (tableEntry->reportFunction == AutoSenseFunction::THRESHOLD)
+        {
+            if (!readyForSending.get(entryIndex))
+            {
+                continue;
+            }
+            readyForSending.set(entryIndex, false);
+        }
         else
         {
             SIMEXCEPTION(IllegalStateException); // LCOV_EXCL_LINE Unclear how to get in this state.
         }
 
-        SendEntry(entryIndex, tableEntry);
+        pendingReports.set(entryIndex, true);
     }
+
+    SendPendingEntries();
 #endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
 }
 
@@ -348,7 +434,24 @@ bool AutoSenseModule::ConsumeData(ModuleIdWrapper moduleId, u16 component, u16 r
             CheckedMemcpy(writePointer, data, length);
             if (changed)
             {
-                SendEntry(entryIndex, tableEntry);
+                // Sent together with the other entries of this tick in SendPendingEntries
+                pendingReports.set(entryIndex, true);
+            }
+        }
+        else if (IsAggregatingFunction(tableEntry->reportFunction))
+        {
+            AddSampleToWindow(entryIndex, tableEntry, data);
+        }
+        else if (tableEntry->reportFunction == AutoSenseFunction::THRESHOLD)
+        {
+            const ThresholdBand band = GetThresholdBand(entryIndex, tableEntry, data);
+            if (!anyValueRecorded.get(entryIndex)
+                || band != thresholdBands[entryIndex])
+            {
+                // Same as for ON_CHANGE_RATE_LIMITED, readyForSending is only reset once the value was reported.
+                thresholdBands[entryIndex] = band;
+                readyForSending.set(entryIndex, true);
+                CheckedMemcpy(writePointer, data, length);
             }
         }
         else
@@ -388,6 +491,23 @@ const AutoSenseTableEntryV0* AutoSenseModule::getTableEntryV0(u8 entryIndex)
 #endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
 }
 
+const u8* AutoSenseModule::getFunctionParams(u8 entryIndex)
+{
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+    const AutoSenseTableEntryV0* tableEntry = getTableEntryV0(entryIndex);
+    if (!tableEntry) return nullptr;
+    const u32 functionParamsSize = GetFunctionParamsSize(tableEntry);
+    SizedData data = GS->recordStorage.GetRecordData(RECORD_STORAGE_RECORD_ID_AUTO_SENSE_ENTRIES_BASE + entryIndex);
+    if (functionParamsSize == 0 || data.length < sizeof(AutoSenseTableEntryV0) + functionParamsSize)
+    {
+        return nullptr;
+    }
+    return data.data + sizeof(AutoSenseTableEntryV0);
+#else
+    return nullptr;
+#endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+}
+
 void AutoSenseModule::RecordStorageEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength)
 {
 #if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
@@ -401,6 +521,7 @@ void AutoSenseModule::RecordStorageEventHandler(u16 recordId, RecordStorageResul
         if (resultCode != RecordStorageResultCode::SUCCESS)
         {
             valueCache.unregisterSlot(ud->entryIndex);                                                                                             //LCOV_EXCL_LINE Unclear how to get in this state.
+            sampleWindows.unregisterSlot(ud->entryIndex);                                                                                          //LCOV_EXCL_LINE Unclear how to get in this state.
             SendResponse(AutoSenseModuleSetEntryResponse{ TranslateRecordStorageCode(resultCode), ud->entryIndex }, ud->sender, ud->requestHandle); //LCOV_EXCL_LINE Unclear how to get in this state.
         }
         else
@@ -415,6 +536,8 @@ void AutoSenseModule::RecordStorageEventHandler(u16 recordId, RecordStorageResul
             {
                 pollSchedule.removeEvent(ud->entryIndex);
                 reportSchedule.removeEvent(ud->entryIndex);
+                sampleWindowAmount[ud->entryIndex] = 0;
+                sampleWindowWriteIndex[ud->entryIndex] = 0;
 
                 AddScheduleEvents(ud->entryIndex, table);
             }
@@ -436,8 +559,12 @@ void AutoSenseModule::RecordStorageEventHandler(u16 recordId, RecordStorageResul
             pollSchedule.removeEvent(ud->entryIndex);
             reportSchedule.removeEvent(ud->entryIndex);
             valueCache.unregisterSlot(ud->entryIndex);
+            sampleWindows.unregisterSlot(ud->entryIndex);
+            sampleWindowAmount[ud->entryIndex] = 0;
+            sampleWindowWriteIndex[ud->entryIndex] = 0;
             anyValueRecorded.set(ud->entryIndex, false);
             readyForSending.set(ud->entryIndex, false);
+            pendingReports.set(ud->entryIndex, false);
 
             if (userType == (u32)AutoSenseModuleTriggerAndResponseMessages::CLEAR_ENTRY)
             {
@@ -480,45 +607,55 @@ AutoSenseModuleResponseCode AutoSenseModule::TranslateRecordStorageCode(const Re
 #endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
 }
 
-void AutoSenseModule::SendEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry)
+u16 AutoSenseModule::BuildComponentSenseMessage(u8* buffer, NodeId sender, NodeId receiver, ModuleIdWrapper moduleId, u16 component, u16 register_, u8 requestHandle, const u8* payload, u16 payloadLength)
 {
-#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
     //JSTODO basically a copy past from the node. Shouldn't we put this somewhere central?
-    ModuleIdWrapper moduleId = tableEntry->moduleId;
-
-    u8 buffer[200];
-    const u16 payloadLength = valueCache.getSizeOfSlot(entryIndex);
-    u16 totalLength = 0;
 
     //We use a different packet format with an additional 3 bytes in case of a vendor module id
     if (Utility::IsVendorModuleId(moduleId))
     {
         ConnPacketComponentMessageVendor* message = (ConnPacketComponentMessageVendor*)buffer;
         message->componentHeader.header.messageType = MessageType::COMPONENT_SENSE;
-        message->componentHeader.header.sender = GS->node.configuration.nodeId;
-        message->componentHeader.header.receiver = tableEntry->destNodeId;
+        message->componentHeader.header.sender = sender;
+        message->componentHeader.header.receiver = receiver;
         message->componentHeader.moduleId = (VendorModuleId)moduleId;
         message->componentHeader.actionType = (u8)SensorMessageActionType::UNSPECIFIED;
-        message->componentHeader.component = tableEntry->component;
-        message->componentHeader.registerAddress = tableEntry->register_;
-        message->componentHeader.requestHandle = tableEntry->requestHandle;
-        CheckedMemcpy(buffer + SIZEOF_COMPONENT_MESSAGE_HEADER_VENDOR, valueCache.get(entryIndex), payloadLength);
-        totalLength = SIZEOF_CONN_PACKET_COMPONENT_MESSAGE_VENDOR + payloadLength;
+        message->componentHeader.component = component;
+        message->componentHeader.registerAddress = register_;
+        message->componentHeader.requestHandle = requestHandle;
+        CheckedMemcpy(buffer + SIZEOF_COMPONENT_MESSAGE_HEADER_VENDOR, payload, payloadLength);
+        return SIZEOF_CONN_PACKET_COMPONENT_MESSAGE_VENDOR + payloadLength;
     }
     else
     {
         ConnPacketComponentMessage* message = (ConnPacketComponentMessage*)buffer;
         message->componentHeader.header.messageType = MessageType::COMPONENT_SENSE;
-        message->componentHeader.header.sender = GS->node.configuration.nodeId;
-        message->componentHeader.header.receiver = tableEntry->destNodeId;
+        message->componentHeader.header.sender = sender;
+        message->componentHeader.header.receiver = receiver;
         message->componentHeader.moduleId = Utility::GetModuleId(moduleId);
         message->componentHeader.actionType = (u8)SensorMessageActionType::UNSPECIFIED;
-        message->componentHeader.component = tableEntry->component;
-        message->componentHeader.registerAddress = tableEntry->register_;
-        message->componentHeader.requestHandle = tableEntry->requestHandle;
-        CheckedMemcpy(buffer + SIZEOF_COMPONENT_MESSAGE_HEADER, valueCache.get(entryIndex), payloadLength);
-        totalLength = SIZEOF_CONN_PACKET_COMPONENT_MESSAGE + payloadLength;
+        message->componentHeader.component = component;
+        message->componentHeader.registerAddress = register_;
+        message->componentHeader.requestHandle = requestHandle;
+        CheckedMemcpy(buffer + SIZEOF_COMPONENT_MESSAGE_HEADER, payload, payloadLength);
+        return SIZEOF_CONN_PACKET_COMPONENT_MESSAGE + payloadLength;
     }
+}
+
+void AutoSenseModule::SendEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry)
+{
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+    u8 buffer[200];
+    const u16 totalLength = BuildComponentSenseMessage(
+        buffer,
+        GS->node.configuration.nodeId,
+        tableEntry->destNodeId,
+        tableEntry->moduleId,
+        tableEntry->component,
+        tableEntry->register_,
+        tableEntry->requestHandle,
+        valueCache.get(entryIndex),
+        valueCache.getSizeOfSlot(entryIndex));
 
     GS->cm.SendMeshMessage(
         buffer,
@@ -526,6 +663,107 @@ void AutoSenseModule::SendEntry(u8 entryIndex, const AutoSenseTableEntryV0* tabl
 #endif
 }
 
+void AutoSenseModule::SendPendingEntries()
+{
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+    u8 buffer[MAX_BATCHED_SENSE_PAYLOAD_SIZE];
+    for (u32 firstIndex = 0; firstIndex < MAX_AMOUNT_OF_ENTRIES; firstIndex++)
+    {
+        if (!pendingReports.get(firstIndex)) continue;
+        pendingReports.set(firstIndex, false);
+        const AutoSenseTableEntryV0* firstEntry = getTableEntryV0(firstIndex);
+        if (!firstEntry) continue;
+
+        // Collect all pending entries with the same destination that still fit into the batch. Entries that
+        // don't fit anymore stay pending and are picked up by a later iteration of the outer loop.
+        u32 batchSize = 0;
+        u32 amountOfRecords = 0;
+        for (u32 entryIndex = firstIndex; entryIndex < MAX_AMOUNT_OF_ENTRIES; entryIndex++)
+        {
+            if (entryIndex != firstIndex && !pendingReports.get(entryIndex)) continue;
+            const AutoSenseTableEntryV0* tableEntry = getTableEntryV0(entryIndex);
+            if (!tableEntry)
+            {
+                pendingReports.set(entryIndex, false);
+                continue;
+            }
+            if (tableEntry->destNodeId != firstEntry->destNodeId) continue;
+
+            const u16 payloadLength = valueCache.getSizeOfSlot(entryIndex);
+            if (batchSize + SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER + payloadLength > sizeof(buffer)) continue;
+
+            AutoSenseModuleBatchedSenseRecord* record = (AutoSenseModuleBatchedSenseRecord*)(buffer + batchSize);
+            record->moduleId = tableEntry->moduleId;
+            record->component = tableEntry->component;
+            record->register_ = tableEntry->register_;
+            record->requestHandle = tableEntry->requestHandle;
+            record->length = (u8)payloadLength;
+            CheckedMemcpy(record->data, valueCache.get(entryIndex), payloadLength);
+            batchSize += SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER + payloadLength;
+            amountOfRecords++;
+            pendingReports.set(entryIndex, false);
+        }
+
+        if (amountOfRecords <= 1)
+        {
+            // A single entry is sent as a plain COMPONENT_SENSE message, as it would not benefit from batching.
+            SendEntry(firstIndex, firstEntry);
+        }
+        else
+        {
+            SendModuleActionMessage(
+                MessageType::MODULE_GENERAL,
+                firstEntry->destNodeId,
+                (u8)AutoSenseModuleGeneralMessages::BATCHED_SENSE,
+                0,
+                buffer,
+                batchSize,
+                false
+            );
+        }
+    }
+#endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+}
+
+void AutoSenseModule::ExpandBatchedSense(const ConnPacketModule* packet, MessageLength packetLength)
+{
+    const u32 dataLength = packetLength.GetRaw() - SIZEOF_CONN_PACKET_MODULE;
+    u32 offset = 0;
+    while (offset + SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER <= dataLength)
+    {
+        const AutoSenseModuleBatchedSenseRecord* record = (const AutoSenseModuleBatchedSenseRecord*)(packet->data + offset);
+        if (offset + SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER + record->length > dataLength)
+        {
+            SIMEXCEPTION(PacketTooSmallException);
+            return;
+        }
+
+        u8 buffer[SIZEOF_CONN_PACKET_COMPONENT_MESSAGE_VENDOR + MAX_BATCHED_SENSE_PAYLOAD_SIZE];
+        BaseConnectionSendData sendData;
+        sendData.characteristicHandle = FruityHal::FH_BLE_INVALID_HANDLE;
+        sendData.deliveryOption = DeliveryOption::WRITE_CMD;
+        sendData.dataLength = BuildComponentSenseMessage(
+            buffer,
+            packet->header.sender,
+            packet->header.receiver,
+            record->moduleId,
+            record->component,
+            record->register_,
+            record->requestHandle,
+            record->data,
+            record->length);
+
+        // Same as in the AutoActModule, the modules are called directly so that the record is not counted as another received message.
+        for (u32 i = 0; i < GS->amountOfModules; i++) {
+            if (GS->activeModules[i]->configurationPointer->moduleActive) {
+                GS->activeModules[i]->MeshMessageReceivedHandler(nullptr, &sendData, (const ConnPacketHeader*)buffer);
+            }
+        }
+
+        offset += SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER + record->length;
+    }
+}
+
 void AutoSenseModule::AddScheduleEvents(u32 entryIndex, const AutoSenseTableEntryV0* table)
 {
 #if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
@@ -554,6 +792,130 @@ void AutoSenseModule::AddScheduleEvents(u32 entryIndex, const AutoSenseTableEntr
 #endif
 }
 
+bool AutoSenseModule::IsAggregatingFunction(AutoSenseFunction function)
+{
+    return function == AutoSenseFunction::MEDIAN
+        || function == AutoSenseFunction::AVERAGE
+        || function == AutoSenseFunction::MIN
+        || function == AutoSenseFunction::MAX;
+}
+
+u32 AutoSenseModule::GetFunctionParamsSize(const AutoSenseTableEntryV0* tableEntry)
+{
+    if (tableEntry->reportFunction == AutoSenseFunction::THRESHOLD)
+    {
+        // Lower and upper bound of the band, both in the dataType of the entry.
+        return 2 * tableEntry->length;
+    }
+    return 0;
+}
+
+void AutoSenseModule::AddSampleToWindow(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, const u8* data)
+{
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+    u8* sampleWindow = sampleWindows.get(entryIndex);
+    if (!sampleWindow)
+    {
+        SIMEXCEPTION(IllegalStateException); //LCOV_EXCL_LINE Unclear how to get in this state.
+        return;                              //LCOV_EXCL_LINE Unclear how to get in this state.
+    }
+    CheckedMemcpy(sampleWindow + sampleWindowWriteIndex[entryIndex] * tableEntry->length, data, tableEntry->length);
+    sampleWindowWriteIndex[entryIndex] = (sampleWindowWriteIndex[entryIndex] + 1) % AUTO_SENSE_MAX_SAMPLES_PER_WINDOW;
+    if (sampleWindowAmount[entryIndex] < AUTO_SENSE_MAX_SAMPLES_PER_WINDOW)
+    {
+        sampleWindowAmount[entryIndex]++;
+    }
+#endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+}
+
+bool AutoSenseModule::AggregateSampleWindow(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry)
+{
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+    const u32 amount = sampleWindowAmount[entryIndex];
+    if (amount == 0) return false;
+
+    const u8* sampleWindow = sampleWindows.get(entryIndex);
+    u8* output = valueCache.get(entryIndex);
+    if (!sampleWindow || !output)
+    {
+        SIMEXCEPTION(IllegalStateException); //LCOV_EXCL_LINE Unclear how to get in this state.
+        return false;                        //LCOV_EXCL_LINE Unclear how to get in this state.
+    }
+
+    const u32 length = tableEntry->length;
+    float values[AUTO_SENSE_MAX_SAMPLES_PER_WINDOW];
+    for (u32 i = 0; i < amount; i++)
+    {
+        values[i] = LoadSample(sampleWindow + i * length, tableEntry->dataType);
+    }
+
+    if (tableEntry->reportFunction == AutoSenseFunction::AVERAGE)
+    {
+        float sum = 0;
+        for (u32 i = 0; i < amount; i++) sum += values[i];
+        StoreSample(output, sum / amount, tableEntry->dataType);
+    }
+    else
+    {
+        // MIN, MAX and MEDIAN report one of the polled samples without any conversion.
+        u32 selectedIndex = 0;
+        if (tableEntry->reportFunction == AutoSenseFunction::MIN || tableEntry->reportFunction == AutoSenseFunction::MAX)
+        {
+            for (u32 i = 1; i < amount; i++)
+            {
+                if ((tableEntry->reportFunction == AutoSenseFunction::MIN && values[i] < values[selectedIndex])
+                    || (tableEntry->reportFunction == AutoSenseFunction::MAX && values[i] > values[selectedIndex]))
+                {
+                    selectedIndex = i;
+                }
+            }
+        }
+        else
+        {
+            // Insertion sort of the sample indices, the window is small. For an even amount of
+            // samples, the lower of the two middle samples is reported.
+            u8 order[AUTO_SENSE_MAX_SAMPLES_PER_WINDOW];
+            for (u32 i = 0; i < amount; i++)
+            {
+                u32 k = i;
+                while (k > 0 && values[order[k - 1]] > values[i])
+                {
+                    order[k] = order[k - 1];
+                    k--;
+                }
+                order[k] = (u8)i;
+            }
+            selectedIndex = order[(amount - 1) / 2];
+        }
+        CheckedMemcpy(output, sampleWindow + selectedIndex * length, length);
+    }
+
+    sampleWindowAmount[entryIndex] = 0;
+    sampleWindowWriteIndex[entryIndex] = 0;
+    return true;
+#else
+    return false;
+#endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+}
+
+ThresholdBand AutoSenseModule::GetThresholdBand(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, const u8* data)
+{
+#if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+    const u8* functionParams = getFunctionParams(entryIndex);
+    if (!functionParams)
+    {
+        SIMEXCEPTION(IllegalStateException); //LCOV_EXCL_LINE Unclear how to get in this state.
+        return ThresholdBand::INSIDE;        //LCOV_EXCL_LINE Unclear how to get in this state.
+    }
+    const float value = LoadSample(data, tableEntry->dataType);
+    if (value < LoadSample(functionParams, tableEntry->dataType))                      return ThresholdBand::BELOW;
+    if (value > LoadSample(functionParams + tableEntry->length, tableEntry->dataType)) return ThresholdBand::ABOVE;
+    return ThresholdBand::INSIDE;
+#else
+    return ThresholdBand::INSIDE;
+#endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
+}
+
 void AutoSenseModule::SendResponse(const AutoSenseModuleSetEntryResponse& response, NodeId id, u8 requestHandle) const
 {
     SendModuleActionMessage(
@@ -669,7 +1031,7 @@ void AutoSenseModule::ClearEntry(u8 entryIndex, NodeId sender, u8 requestHandle)
 #endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
 }
 
-void AutoSenseModule::SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, u8 moduleVersion, NodeId sender, u8 requestHandle)
+void AutoSenseModule::SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, u32 entrySize, u8 moduleVersion, NodeId sender, u8 requestHandle)
 {
 #if IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
     if (entryIndex >= MAX_AMOUNT_OF_ENTRIES)
@@ -691,6 +1053,8 @@ void AutoSenseModule::SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* table
             tableEntry->reportFunction != AutoSenseFunction::LAST
             && tableEntry->reportFunction != AutoSenseFunction::ON_CHANGE_RATE_LIMITED
             && tableEntry->reportFunction != AutoSenseFunction::ON_CHANGE_WITH_PERIODIC_REPORT
+            && !IsAggregatingFunction(tableEntry->reportFunction)
+            && tableEntry->reportFunction != AutoSenseFunction::THRESHOLD
             )
         || !Utility::IsValidModuleIdFormat(tableEntry->moduleId)
         )
@@ -698,6 +1062,31 @@ void AutoSenseModule::SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* table
         SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::UNSUPPORTED_ENTRY_CONTENTS, entryIndex }, sender, requestHandle);
         return;
     }
+    if (entrySize != sizeof(AutoSenseTableEntryV0) + GetFunctionParamsSize(tableEntry))
+    {
+        SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::UNSUPPORTED_ENTRY_SIZE, entryIndex }, sender, requestHandle);
+        return;
+    }
+    if (IsAggregatingFunction(tableEntry->reportFunction) || tableEntry->reportFunction == AutoSenseFunction::THRESHOLD)
+    {
+        // The values must be interpreted as numbers, so the dataType must be a numeric type that matches the length.
+        if (GetSampleSize(tableEntry->dataType) != tableEntry->length)
+        {
+            SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::UNSUPPORTED_ENTRY_CONTENTS, entryIndex }, sender, requestHandle);
+            return;
+        }
+    }
+    if (tableEntry->reportFunction == AutoSenseFunction::THRESHOLD)
+    {
+        const u8* functionParams = ((const u8*)tableEntry) + sizeof(AutoSenseTableEntryV0);
+        const float lowerBound = LoadSample(functionParams, tableEntry->dataType);
+        const float upperBound = LoadSample(functionParams + tableEntry->length, tableEntry->dataType);
+        if (lowerBound > upperBound)
+        {
+            SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::UNSUPPORTED_ENTRY_CONTENTS, entryIndex }, sender, requestHandle);
+            return;
+        }
+    }
     bool foundMatchingDataProvider = false;
     for (u32 i = 0; i < MAX_AMOUNT_DATA_PROVIDERS; i++)
     {
@@ -719,14 +1108,29 @@ void AutoSenseModule::SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* table
         SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::FAILED_TO_CREATE_VALUE_CACHE_ENTRY, entryIndex }, sender, requestHandle);
         return;
     }
+    if (IsAggregatingFunction(tableEntry->reportFunction))
+    {
+        u8* sampleWindow = sampleWindows.registerSlot(entryIndex, tableEntry->length * AUTO_SENSE_MAX_SAMPLES_PER_WINDOW);
+        if (!sampleWindow)
+        {
+            valueCache.unregisterSlot(entryIndex);
+            SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::FAILED_TO_CREATE_VALUE_CACHE_ENTRY, entryIndex }, sender, requestHandle);
+            return;
+        }
+    }
+    else
+    {
+        sampleWindows.unregisterSlot(entryIndex);
+    }
     RecordStorageUserData userData = {};
     userData.sender = sender;
     userData.entryIndex = entryIndex;
     userData.requestHandle = requestHandle;
-    RecordStorageResultCode code = GS->recordStorage.SaveRecord(RECORD_STORAGE_RECORD_ID_AUTO_SENSE_ENTRIES_BASE + entryIndex, (const u8*)tableEntry, sizeof(*tableEntry), this, (u32)AutoSenseModuleTriggerAndResponseMessages::SET_ENTRY, (u8*)&userData, sizeof(userData));
+    RecordStorageResultCode code = GS->recordStorage.SaveRecord(RECORD_STORAGE_RECORD_ID_AUTO_SENSE_ENTRIES_BASE + entryIndex, (const u8*)tableEntry, entrySize, this, (u32)AutoSenseModuleTriggerAndResponseMessages::SET_ENTRY, (u8*)&userData, sizeof(userData));
     if (code != RecordStorageResultCode::SUCCESS)
     {
         valueCache.unregisterSlot(entryIndex);
+        sampleWindows.unregisterSlot(entryIndex);
         SendResponse(AutoSenseModuleSetEntryResponse{ TranslateRecordStorageCode(code), entryIndex }, sender, requestHandle);
         return;
     }
@@ -753,13 +1157,13 @@ void AutoSenseModule::MeshMessageReceivedHandler(BaseConnection* connection, Bas
             {
                 const AutoSenseModuleSetEntryMessage* msg = (const AutoSenseModuleSetEntryMessage*)packet->data;
                 u32 entrySize = sendData->dataLength.GetRaw() - SIZEOF_CONN_PACKET_MODULE - sizeof(AutoSenseModuleSetEntryMessage) + sizeof(AutoSenseModuleSetEntryMessage::data);
-                if (entrySize != sizeof(AutoSenseTableEntryV0))
+                if (entrySize < sizeof(AutoSenseTableEntryV0))
                 {
                     SendResponse(AutoSenseModuleSetEntryResponse{ AutoSenseModuleResponseCode::UNSUPPORTED_ENTRY_SIZE, msg->entryIndex }, packet->header.sender, packet->requestHandle);
                     return;
                 }
                 const AutoSenseTableEntryV0* tableEntry = (const AutoSenseTableEntryV0*)msg->data;
-                SetEntry(msg->entryIndex, tableEntry, msg->moduleVersion, packet->header.sender, packet->requestHandle);
+                SetEntry(msg->entryIndex, tableEntry, entrySize, msg->moduleVersion, packet->header.sender, packet->requestHandle);
             }
             else if (packet->actionType == (u8)AutoSenseModuleTriggerAndResponseMessages::GET_ENTRY && sendData->dataLength >= SIZEOF_CONN_PACKET_MODULE + sizeof(AutoSenseModuleGetEntryMessage))
             {
@@ -817,7 +1221,7 @@ void AutoSenseModule::MeshMessageReceivedHandler(BaseConnection* connection, Bas
                 CheckedMemset(sendBuffer, 0, sendBufferSize);
                 AutoSenseModuleGetTableResponse* response = (AutoSenseModuleGetTableResponse*)sendBuffer;
                 response->supportedAmount = MAX_AMOUNT_OF_ENTRIES;
-                response->entryMaxSize = sizeof(AutoSenseTableEntryV0);
+                response->entryMaxSize = MAX_ENTRY_SIZE;
                 for (u32 i = 0; i < MAX_AMOUNT_OF_ENTRIES; i++)
                 {
                     const u32 byte = i / 8;
@@ -852,7 +1256,7 @@ void AutoSenseModule::MeshMessageReceivedHandler(BaseConnection* connection, Bas
                 tableEntry.pollingIvDs = SEC_TO_DS(10);
                 tableEntry.reportingIvDs = SEC_TO_DS(10);
                 tableEntry.reportFunction = AutoSenseFunction::ON_CHANGE_RATE_LIMITED;
-                SetEntry(0, &tableEntry, 0, packet->header.sender, packet->requestHandle);
+                SetEntry(0, &tableEntry, sizeof(tableEntry), 0, packet->header.sender, packet->requestHandle);
             }
             else if (packet->actionType == (u8)AutoSenseModuleTriggerAndResponseMessages::CLEAR_EXAMPLE)
             {
@@ -868,6 +1272,16 @@ void AutoSenseModule::MeshMessageReceivedHandler(BaseConnection* connection, Bas
     
 #endif //IS_INACTIVE(ONLY_SINK_FUNCTIONALITY)
 
+    //Parse batched sense messages, they are expanded into the single COMPONENT_SENSE messages they replace
+    if (packetHeader->messageType == MessageType::MODULE_GENERAL && sendData->dataLength >= SIZEOF_CONN_PACKET_MODULE)
+    {
+        ConnPacketModule const* packet = (ConnPacketModule const*)packetHeader;
+        if (packet->moduleId == ModuleId::AUTO_SENSE_MODULE && packet->actionType == (u8)AutoSenseModuleGeneralMessages::BATCHED_SENSE)
+        {
+            ExpandBatchedSense(packet, sendData->dataLength);
+        }
+    }
+
     //Parse Module responses
     if (packetHeader->messageType == MessageType::MODULE_ACTION_RESPONSE && sendData->dataLength >= SIZEOF_CONN_PACKET_MODULE)
     {
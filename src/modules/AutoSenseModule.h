@@ -35,6 +35,17 @@
 #include <BitMask.h>
 #include <SlotStorage.h>
 
+// The maximum amount of polled samples that are kept per entry for the aggregating report functions.
+// If more samples are polled during a reporting interval, the oldest ones are dropped.
+#ifndef AUTO_SENSE_MAX_SAMPLES_PER_WINDOW
+#define AUTO_SENSE_MAX_SAMPLES_PER_WINDOW 16
+#endif
+static_assert(AUTO_SENSE_MAX_SAMPLES_PER_WINDOW > 0 && AUTO_SENSE_MAX_SAMPLES_PER_WINDOW <= 0xFF, "Sample window positions are stored as u8!");
+// Shared storage for the sample windows of all entries that use an aggregating report function.
+#ifndef AUTO_SENSE_SAMPLE_WINDOW_STORAGE_SIZE
+#define AUTO_SENSE_SAMPLE_WINDOW_STORAGE_SIZE 512
+#endif
+
 class AutoSenseModuleDataConsumer
 {
 public:
@@ -72,11 +83,15 @@ enum class AutoSenseFunction : u8
     UNUSED_BUT_RESERVED_FIRST = 4,
     UNUSED_BUT_RESERVED_SUM = 5,
     UNUSED_BUT_RESERVED_COUNT_AND_SUM = 6,
-    UNUSED_BUT_RESERVED_MEDIAN = 7,
-    UNUSED_BUT_RESERVED_AVERAGE = 8,
-    UNUSED_BUT_RESERVED_MIN = 9,
-    UNUSED_BUT_RESERVED_MAX = 10,
-    UNUSED_BUT_RESERVED_THRESHOLD = 11,
+    // The aggregating functions report a single value calculated over all samples
+    // that were polled during the reporting interval (the sample window).
+    MEDIAN                         = 7,
+    AVERAGE                        = 8,
+    MIN                            = 9,
+    MAX                            = 10,
+    // Reports a polled value once it is in a different band (below, inside or above
+    // the configured bounds) than the previously taken value, rate limited by the reporting interval.
+    THRESHOLD                      = 11,
     UNUSED_BUT_RESERVED_RATE_LIMIT_THRESHOLD_PER_MIN = 12,
 };
 
@@ -103,13 +118,13 @@ struct AutoSenseTableEntryV0
     u16 register_; // _ because register is a keyword
     u8 length;
     u8 requestHandle;
-    DataTypeDescriptor dataType; //JSTODO no effect
+    DataTypeDescriptor dataType; // Only evaluated by the aggregating and threshold functions
     u8 periodicReportInterval : 3; // Actual Type: SyncedReportInterval
     u8 reservedFlags : 5;
     u16 pollingIvDs;
     u16 reportingIvDs;
     AutoSenseFunction reportFunction; // CAREFUL! V0 only supports a subset of functions
-    //u8 functionParams[]; // Currently unused, thus not implemented.
+    //u8 functionParams[]; // Only present for functions that need parameters, see GetFunctionParamsSize.
 };
 STATIC_ASSERT_SIZE(AutoSenseTableEntryV0, 19);
 // This might be overly paranoid, but as these are persisted in
@@ -213,6 +228,24 @@ STATIC_ASSERT_SIZE(AutoSenseModuleClearEntryResponse, 2);
 //} AutoSenseModuleGetTableMessage;
 #pragma pack(pop)
 
+#pragma pack(push)
+#pragma pack(1)
+// One record of a batched sense message. A batched sense message contains
+// multiple of these records, each one carrying the data that would otherwise
+// have been sent as a separate COMPONENT_SENSE message.
+typedef struct
+{
+    ModuleIdWrapper moduleId;
+    u16 component;
+    u16 register_;
+    u8 requestHandle;
+    u8 length;
+    u8 data[1];
+} AutoSenseModuleBatchedSenseRecord;
+constexpr size_t SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER = 10; //Size without the data
+STATIC_ASSERT_SIZE(AutoSenseModuleBatchedSenseRecord, SIZEOF_AUTO_SENSE_MODULE_BATCHED_SENSE_RECORD_HEADER + 1);
+#pragma pack(pop)
+
 #pragma pack(push)
 #pragma pack(1)
 typedef struct
@@ -234,6 +267,13 @@ struct AutoSenseModuleConfiguration : ModuleConfiguration {
 };
 #pragma pack(pop)
 
+enum class ThresholdBand : u8
+{
+    BELOW  = 0,
+    INSIDE = 1,
+    ABOVE  = 2,
+};
+
 class AutoSenseModule : 
     public Module,
     public AutoSenseModuleDataConsumer,
@@ -251,10 +291,17 @@ TESTER_PUBLIC:
     MultiScheduler<u8, MAX_AMOUNT_OF_ENTRIES> reportSchedule;
     BitMask<MAX_AMOUNT_OF_ENTRIES> anyValueRecorded = {};
     BitMask<MAX_AMOUNT_OF_ENTRIES> readyForSending = {};
+    BitMask<MAX_AMOUNT_OF_ENTRIES> pendingReports = {}; // Entries that are sent out together at the end of the current timer tick
     SlotStorage<MAX_AMOUNT_OF_ENTRIES, 512> valueCache;
+    SlotStorage<MAX_AMOUNT_OF_ENTRIES, AUTO_SENSE_SAMPLE_WINDOW_STORAGE_SIZE> sampleWindows; // Only registered for aggregating functions
+    std::array<u8, MAX_AMOUNT_OF_ENTRIES> sampleWindowAmount = {};     // Amount of valid samples in the window
+    std::array<u8, MAX_AMOUNT_OF_ENTRIES> sampleWindowWriteIndex = {}; // Position of the next sample in the window
+    std::array<ThresholdBand, MAX_AMOUNT_OF_ENTRIES> thresholdBands = {}; // Band of the last value that was taken by a THRESHOLD entry
 #endif
 
     const AutoSenseTableEntryV0* getTableEntryV0(u8 entryIndex);
+    // Returns the function params that are stored after the table entry, nullptr if there are none
+    const u8* getFunctionParams(u8 entryIndex);
     static constexpr u8 INVALID_TABLE_INDEX = 0xFF;
 
     struct RecordStorageUserData
@@ -272,11 +319,32 @@ TESTER_PUBLIC:
 
     static AutoSenseModuleResponseCode TranslateRecordStorageCode(const RecordStorageResultCode& code);
 
+    // Writes a COMPONENT_SENSE message to the buffer and returns its size
+    static u16 BuildComponentSenseMessage(u8* buffer, NodeId sender, NodeId receiver, ModuleIdWrapper moduleId, u16 component, u16 register_, u8 requestHandle, const u8* payload, u16 payloadLength);
     // Sends the data attached to the given tableEntry
     void SendEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry);
+    // Sends all pendingReports, combining entries with the same destination into batched sense messages
+    void SendPendingEntries();
+    // Hands every record of a batched sense message to the modules as if it was a separate COMPONENT_SENSE message
+    void ExpandBatchedSense(const ConnPacketModule* packet, MessageLength packetLength);
+
+    // Batched messages are limited to the largest message that every hop is able to relay.
+    static constexpr u32 MAX_BATCHED_SENSE_PAYLOAD_SIZE = MAX_MESH_PACKET_SIZE - SIZEOF_CONN_PACKET_MODULE;
 
     void AddScheduleEvents(u32 entryIndex, const AutoSenseTableEntryV0* table);
 
+    static bool IsAggregatingFunction(AutoSenseFunction function);
+    // Amount of bytes that must follow the table entry as functionParams
+    static u32 GetFunctionParamsSize(const AutoSenseTableEntryV0* tableEntry);
+    // The largest entry including its functionParams, which is a THRESHOLD entry with two 4 byte bounds
+    static constexpr u32 MAX_ENTRY_SIZE = sizeof(AutoSenseTableEntryV0) + 2 * sizeof(u32);
+
+    // Adds a polled value to the sample window of the entry, overwriting the oldest sample if the window is full
+    void AddSampleToWindow(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, const u8* data);
+    // Writes the aggregate of the sample window into the value cache and empties the window. Returns false if the window was empty.
+    bool AggregateSampleWindow(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry);
+    ThresholdBand GetThresholdBand(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, const u8* data);
+
 public:
 
     // For the AutoSenseModule, both the trigger and response messages have the same value.
@@ -291,6 +359,11 @@ public:
         CLEAR_EXAMPLE     = 6,
     };
 
+    enum class AutoSenseModuleGeneralMessages : u8
+    {
+        BATCHED_SENSE = 0,
+    };
+
     //####### Module messages (these need to be packed)
 #pragma pack(push)
 #pragma pack(1)
@@ -320,7 +393,7 @@ public:
 
     void MeshMessageReceivedHandler(BaseConnection* connection, BaseConnectionSendData* sendData, ConnPacketHeader const * packetHeader) override;
 
-    void SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, u8 moduleVersion, NodeId sender, u8 requestHandle);
+    void SetEntry(u8 entryIndex, const AutoSenseTableEntryV0* tableEntry, u32 entrySize, u8 moduleVersion, NodeId sender, u8 requestHandle);
     void ClearEntry(u8 entryIndex, NodeId sender, u8 requestHandle);
     void ClearAllEntries(NodeId sender, u8 requestHandle);
 
@@ -47,6 +47,9 @@ Module::Module(ModuleId moduleId, const char* name)
 
 Module::Module(VendorModuleId _vendorModuleId, const char* name)
     :vendorModuleId(_vendorModuleId), moduleName(name), proxy(*this)
+#if IS_ACTIVE(REGISTER_HANDLER)
+    , proxyRegister(*this)
+#endif //IS_ACTIVE(REGISTER_HANDLER)
 {
     //Overwritten by Modules
     this->configurationPointer = nullptr;
@@ -528,6 +531,40 @@ void Module::MeshMessageReceivedHandler(BaseConnection* connection, BaseConnecti
             }
             HelperSendComponentMessage(reply, totalLength);
         }
+        //Handles subscriptions to changes of a register range
+        else if (cpmc.actionType == (u8)ActorMessageActionType::SUBSCRIBE && payloadLen >= SIZEOF_REGISTER_SUBSCRIBE_MESSAGE)
+        {
+            RegisterSubscribeMessage subscribe;
+            CheckedMemcpy(&subscribe, cpcmc->payload, SIZEOF_REGISTER_SUBSCRIBE_MESSAGE);
+
+            if (subscribe.length == 0)
+            {
+                GS->registerSubscriptions.Unsubscribe(cpmc.sender, cpmc.moduleId, cpcmc->component, cpcmc->registerAddress);
+                const u8 result[] = { (u8)RegisterHandlerCode::SUCCESS, (u8)RegisterHandlerStage::SUCCESS };
+                SendComponentSense(cpmc.sender, cpmc.moduleId, cpcmc->component, cpcmc->registerAddress, cpmc.requestHandle, SensorMessageActionType::RESULT_RSP, result, sizeof(result));
+                return;
+            }
+
+            //The subscription is answered with the current values so that only changes have to be pushed later
+            DYNAMIC_ARRAY(values, subscribe.length);
+            RegisterHandlerCode code = GetRegisterValues(cpcmc->component, cpcmc->registerAddress, values, subscribe.length);
+            if (code == RegisterHandlerCode::LOCATION_DISABLED) return;
+
+            if (code == RegisterHandlerCode::SUCCESS)
+            {
+                code = GS->registerSubscriptions.Subscribe(cpmc.sender, cpmc.moduleId, cpcmc->component, cpcmc->registerAddress, cpmc.requestHandle, subscribe, values);
+            }
+
+            if (code == RegisterHandlerCode::SUCCESS)
+            {
+                SendComponentSense(cpmc.sender, cpmc.moduleId, cpcmc->component, cpcmc->registerAddress, cpmc.requestHandle, SensorMessageActionType::READ_RSP, values, subscribe.length);
+            }
+            else
+            {
+                const u8 error = (u8)code;
+                SendComponentSense(cpmc.sender, cpmc.moduleId, cpcmc->component, cpcmc->registerAddress, cpmc.requestHandle, SensorMessageActionType::ERROR_RSP, &error, sizeof(error));
+            }
+        }
     }
 #endif //IS_ACTIVE(REGISTER_HANDLER)
 }
@@ -602,34 +639,66 @@ void Module::SendModuleConfigResult(NodeId senderId, ModuleIdWrapper moduleId, M
 
 #if IS_ACTIVE(REGISTER_HANDLER)
 
-#ifdef JSTODO_PERSISTENCE
 void Module::RecordStorageEventHandlerRegisterProxy(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength)
 {
-    RecordStorageUserData* data = (RecordStorageUserData*)userData;
-    if (resultCode == RecordStorageResultCode::SUCCESS)
-    {
-        for (u32 i = 0; i < data->length; i++)
-        {
-            CommitRegisterChange(data->component, data->reg + i, data->source);
-        }
-    }
-    else
+    const RegisterRecordStorageUserData* data = (const RegisterRecordStorageUserData*)userData;
+
+    // The values were already changed before they were handed to the RecordStorage, so they are committed
+    // even if persisting them failed. The error is reported to the callback and the value is lost after a reboot.
+    if (resultCode != RecordStorageResultCode::SUCCESS)
     {
-        // Nothing. We have no idea how to handle errors in such a case. It's the duty of the passed callback to deal with it.
+        logt("ERROR", "Could not persist registers %u-%u of component %u (%u)", data->reg, data->reg + data->length - 1, data->component, (u32)resultCode);
+        GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, (u32)resultCode);
     }
+    CommitRegisterChanges(data->component, data->reg, data->length, data->source);
 
     if (data->callback)
     {
         u8* userUserData = nullptr;
-        u16 userUserDataLength = userDataLength - offsetof(RecordStorageUserData, userData);
+        const u16 userUserDataLength = userDataLength - sizeof(RegisterRecordStorageUserData);
         if (userUserDataLength > 0)
         {
-            userUserData = data->userData;
+            userUserData = userData + sizeof(RegisterRecordStorageUserData);
         }
-        data->callback->RecordStorageEventHandler(recordId, resultCode, userType, userUserData, userUserDataLength);
+        data->callback->RegisterHandlerEventHandler(recordId, resultCode, userType, userUserData, userUserDataLength, data->dataChanged);
     }
 }
-#endif
+
+void Module::LoadRegistersFromFlash()
+{
+    const u16 baseId = GetRecordBaseId();
+    //A persistedId of 0 marks registers that are not persisted, so there is no record for it
+    for (u32 persistedId = 1; persistedId < REGISTER_RECORDS_PER_MODULE; persistedId++)
+    {
+        const SizedData record = GS->recordStorage.GetRecordData(baseId + persistedId);
+        u16 offset = 0;
+        const RegisterRecordEntry* entry = nullptr;
+        while ((entry = ReadRegisterRecordEntry(record.data, record.length.GetRaw(), offset)) != nullptr)
+        {
+            const RegisterHandlerCodeStage result = SetRegisterValues(entry->component, entry->reg, entry->values, entry->length, nullptr, 0, nullptr, 0, RegisterHandlerSetSource::FLASH);
+            if (result.code != RegisterHandlerCode::SUCCESS)
+            {
+                //Can happen after a firmware update that changed the register layout, the stored value is skipped
+                logt("WARNING", "Could not restore registers %u-%u of component %u (%u)", entry->reg, entry->reg + entry->length - 1, entry->component, (u32)result.code);
+                GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, entry->reg);
+            }
+        }
+        if (offset != record.length)
+        {
+            GS->logger.LogCustomError(CustomErrorTypes::ERROR_RECORD_STORAGE_REGISTER_HANDLER, baseId + persistedId);
+            SIMEXCEPTION(IllegalStateException);
+        }
+    }
+}
+
+void Module::CommitRegisterChanges(u16 component, u16 reg, u16 length, RegisterHandlerSetSource source)
+{
+    for (u32 i = 0; i < length; i++)
+    {
+        CommitRegisterChange(component, reg + i, source);
+    }
+    GS->registerSubscriptions.NotifyChanged(vendorModuleId, component, reg, length);
+}
 
 u16 Module::GetRecordBaseId() const
 {
@@ -652,6 +721,25 @@ RegisterHandlerCode Module::GetRegisterValues(u16 component, u16 reg, u8* values
 
     for (u32 i = 0; i < length; i++)
     {
+        //Blocks of registers that the module provides as a whole are copied at once
+        const u8* registerSizes = nullptr;
+        const u16 blockLength = MapRegisterBlock(component, reg + i, values + i, length - i, registerSizes);
+        if (blockLength > 0)
+        {
+            if (blockLength > length - i || registerSizes == nullptr)
+            {
+                SIMEXCEPTION(IllegalStateException); //LCOV_EXCL_LINE assertion
+                return RegisterHandlerCode::ILLEGAL_LENGTH; //LCOV_EXCL_LINE assertion
+            }
+            //Each register of the block is reported, the same as if it was mapped on its own
+            for (u32 k = 0; k < blockLength; k += *registerSizes++)
+            {
+                OnRegisterRead(component, reg + i + k);
+            }
+            i += blockLength - 1; //-1 cause loop increment
+            continue;
+        }
+
         SupervisedValue val;
         u32 dummy = 0;
         MapRegister(component, reg + i, val, dummy);
@@ -731,8 +819,8 @@ RegisterHandlerCodeStage Module::SetRegisterValues(u16 component, u16 reg, const
     {
         // First pass to check for errors.
         SupervisedValue val;
-        u32 pId = 0; // TODO: Implement persistence stuff
-       MapRegister(component, reg + i, val, pId);
+        u32 pId = 0;
+        MapRegister(component, reg + i, val, pId);
 
         if (val.GetError() != RegisterHandlerCode::SUCCESS)
         {
@@ -779,6 +867,8 @@ RegisterHandlerCodeStage Module::SetRegisterValues(u16 component, u16 reg, const
     }
 
     bool valuesChanged = false;
+    //The values as they were actually set, which might differ from the given values after ChangeValue
+    DYNAMIC_ARRAY(setValues, length);
     for (u32 i = 0; i < length; i++)
     {
         // Second pass to actually write the values.
@@ -791,15 +881,13 @@ RegisterHandlerCodeStage Module::SetRegisterValues(u16 component, u16 reg, const
         ChangeValue(component, reg + i, changeBuffer, val.GetSize());
         valuesChanged |= memcmp(values + i, changeBuffer, val.GetSize()) != 0;
         val.FromBuffer(changeBuffer, length - i);
+        val.ToBuffer(setValues + i, length - i);
         i += val.GetSize() - 1;
     }
 
     if (persistedId == 0 || source == RegisterHandlerSetSource::FLASH /*If we are already coming from the flash then there is no need to go back to the flash.*/)
     {
-        for (u32 i = 0; i < length; i++)
-        {
-            CommitRegisterChange(component, reg + i, source);
-        }
+        CommitRegisterChanges(component, reg, length, source);
         // Calling the callback so that the caller doesn't have to care if this value is persisted or not.
         if (callback)
         {
@@ -810,64 +898,72 @@ RegisterHandlerCodeStage Module::SetRegisterValues(u16 component, u16 reg, const
     }
     else
     {
-#ifndef JSTODO_PERSISTENCE
-        return { RegisterHandlerCode::NOT_IMPLEMENTED, RegisterHandlerStage::EARLY_RECORD_STORAGE };
-#else
+        // All persisted registers of a module share a single record so that writing a range of registers only
+        // costs a single flash write. Unchanged values do not cause a flash write at all as the RecordStorage
+        // skips saving records with identical data. Register records are only read back during boot, so the
+        // save is supersedable: bursts of writes to the same record are batched into a single flash write and
+        // each write is acknowledged with the result of the save that actually wrote its values.
         const u16 recordId = GetRecordBaseId() + persistedId;
-        RecordStorageRecord* record = GS->recordStorage.GetRecord(recordId);
-        u32 maxSize = length * sizeof(u16);
-        const u16* oldRecordStorage = nullptr;
-        u16 oldRecordStorageLength = 0;
-        if (record)
-        {
-            maxSize += record->recordLength;
-            oldRecordStorage = (u16*)record->data;
-            oldRecordStorageLength = record->recordLength / sizeof(u16);
-        }
-        if (maxSize % sizeof(u16) == 1)
-        {
-            maxSize++;
-            // This should never happen - right?
-            SIMEXCEPTION(IllegalStateException);
-        }
-        DYNAMIC_ARRAY(buffer, maxSize);
-        const u16 actualLength = sizeof(u16) * InsertRegisterRange(oldRecordStorage, 0, component, reg, length, values, (u16*)buffer);
+        const SizedData oldRecord = GS->recordStorage.GetLatestRecordData(recordId);
+        DYNAMIC_ARRAY(recordBuffer, oldRecord.length.GetRaw() + SIZEOF_REGISTER_RECORD_ENTRY_HEADER + length);
+        const u16 recordLength = InsertRegisterRange(oldRecord.data, oldRecord.length.GetRaw(), component, reg, length, setValues, recordBuffer);
 
-        // TODO Missing a commit call here! Probably we have to put a record storage callback in between.
-
-        DYNAMIC_ARRAY(surroundingUserDataBuffer, sizeof(RecordStorageUserData) + userDataLength);
-        CheckedMemset(surroundingUserDataBuffer, 0, sizeof(RecordStorageUserData) + userDataLength);
-        RecordStorageUserData* surroundingUserData = (RecordStorageUserData*)buffer;
+        DYNAMIC_ARRAY(surroundingUserDataBuffer, sizeof(RegisterRecordStorageUserData) + userDataLength);
+        CheckedMemset(surroundingUserDataBuffer, 0, sizeof(RegisterRecordStorageUserData) + userDataLength);
+        RegisterRecordStorageUserData* surroundingUserData = (RegisterRecordStorageUserData*)surroundingUserDataBuffer;
         surroundingUserData->component = component;
-        surroundingUserData->reg = register_;
+        surroundingUserData->reg = reg;
         surroundingUserData->length = length;
         surroundingUserData->source = source;
+        surroundingUserData->dataChanged = valuesChanged;
         surroundingUserData->callback = callback;
         if (userData)
         {
-            CheckedMemcpy(surroundingUserData->userData, userData, userDataLength);
+            CheckedMemcpy(surroundingUserDataBuffer + sizeof(RegisterRecordStorageUserData), userData, userDataLength);
         }
 
         RecordStorageResultCode rsCode = GS->recordStorage.SaveRecord(
             recordId,
-            buffer,
-            actualLength,
-            &proxy,
+            recordBuffer,
+            recordLength,
+            &proxyRegister,
             userType,
             surroundingUserDataBuffer,
-            sizeof(RecordStorageUserData) + userDataLength
+            sizeof(RegisterRecordStorageUserData) + userDataLength,
+            INVALID_WRAPPED_MODULE_ID,
+            false,
+            true
         );
         if (rsCode == RecordStorageResultCode::SUCCESS) return { RegisterHandlerCode::SUCCESS, RegisterHandlerStage::EARLY_RECORD_STORAGE };
         else
         {
+            //The values are already set, so they are committed even though they will not survive a reboot
+            CommitRegisterChanges(component, reg, length, source);
             static_assert((int)RecordStorageResultCode::LAST_ENTRY < (int)RegisterHandlerCode::RECORD_STORAGE_CODES_END - (int)RegisterHandlerCode::RECORD_STORAGE_CODES_START, "Not enough room to embed error code.");
             return { (RegisterHandlerCode)((int)rsCode + (int)RegisterHandlerCode::RECORD_STORAGE_CODES_START), RegisterHandlerStage::EARLY_RECORD_STORAGE };
         }
-#endif
     }
 }
 
-#ifdef JSTODO_PERSISTENCE
+void Module::SendComponentSense(NodeId receiver, ModuleIdWrapper moduleId, u16 component, u16 reg, u8 requestHandle, SensorMessageActionType actionType, const u8* payload, u16 payloadLength)
+{
+    DYNAMIC_ARRAY(buffer, SIZEOF_CONN_PACKET_COMPONENT_MESSAGE_VENDOR + payloadLength);
+    CheckedMemset(buffer, 0, SIZEOF_CONN_PACKET_COMPONENT_MESSAGE_VENDOR + payloadLength);
+
+    ConnPacketComponentMessageVendor* message = (ConnPacketComponentMessageVendor*)buffer;
+    message->componentHeader.header.messageType = MessageType::COMPONENT_SENSE;
+    message->componentHeader.header.sender = GS->node.configuration.nodeId;
+    message->componentHeader.header.receiver = receiver;
+    message->componentHeader.moduleId = moduleId;
+    message->componentHeader.actionType = (u8)actionType;
+    message->componentHeader.component = component;
+    message->componentHeader.registerAddress = reg;
+    message->componentHeader.requestHandle = requestHandle;
+    CheckedMemcpy(message->payload, payload, payloadLength);
+
+    HelperSendComponentMessage(message, SIZEOF_COMPONENT_MESSAGE_HEADER_VENDOR + payloadLength);
+}
+
 Module::RecordStorageEventListenerRegisterProxy::RecordStorageEventListenerRegisterProxy(Module& mod) :
     mod(mod)
 {
@@ -877,7 +973,6 @@ void Module::RecordStorageEventListenerRegisterProxy::RecordStorageEventHandler(
 {
     mod.RecordStorageEventHandlerRegisterProxy(recordId, resultCode, userType, userData, userDataLength);
 }
-#endif
 
 void Module::RegisterHandlerEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength, bool dataChanged)
 {
@@ -81,7 +81,6 @@ class Node;
                                                     && (reg + length - 1u) >= (regIn) && (reg + length - 1u) < (regIn) + sizeof(buffer)) return RGC_STRING
 
 constexpr u32 REGISTER_RECORDS_PER_MODULE = 4;
-// TODO load persistent storage
 
 class RegisterHandlerEventListener
 {
@@ -323,7 +322,6 @@ private:
 
 #if IS_ACTIVE(REGISTER_HANDLER)
 
-#ifdef JSTODO_PERSISTENCE
 private:
     // To make it easy for Modules to simply inherit from RecordStorageEventListener
     // even if they inherit from RegisterHandler we proxy the callback here.
@@ -331,32 +329,33 @@ private:
     {
         Module& mod;
     public:
-        explicit RecordStorageEventListenerRegisterProxy(Module& handler);
+        explicit RecordStorageEventListenerRegisterProxy(Module& mod);
         virtual void RecordStorageEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength) override;
     };
+    RecordStorageEventListenerRegisterProxy proxyRegister;
 
-public:
-    void LoadFromFlash();
-
-    RecordStorageEventListenerProxy proxyRegister;
-    struct RecordStorageUserData
+    struct RegisterRecordStorageUserData
     {
         u16 component;
         u16 reg;
         u16 length;
         RegisterHandlerSetSource source;
+        bool dataChanged;
         // Instead of giving the callback from the user, we give our own callback
         // which is calling commit and then calls the callback from the user, which
-        // is this member.
-        RecordStorageEventListener* callback;
-        u8 userData[1]; // More data follows
+        // is this member. The userData of the user follows this struct.
+        RegisterHandlerEventListener* callback;
     };
-#endif //JSTODO_PERSISTENCE
+
+public:
+    // Restores all persisted register values of this module from flash, called once during boot
+    void LoadRegistersFromFlash();
 
 private:
     virtual void RegisterHandlerEventHandler(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength, bool dataChanged) override;
     void RecordStorageEventHandlerRegisterProxy(u16 recordId, RecordStorageResultCode resultCode, u32 userType, u8* userData, u16 userDataLength);
     u16 GetRecordBaseId() const;
+    void CommitRegisterChanges(u16 component, u16 reg, u16 length, RegisterHandlerSetSource source);
 
 protected:
     //In order to enable the register handler, this method has to be implemented and must return RGC_SUCCESS for regions managed by the RegisterHandler
@@ -365,6 +364,11 @@ protected:
     // CAREFUL! Mapping is assumed to be static, meaning two calls with the same parameters must always return the same value in the out parameters.
     // Reporting different registers at different times will result in undefined behavior.
     virtual void MapRegister(u16 component, u16 reg, SupervisedValue& out, u32& persistedId) { };
+    // Optional bulk read of a contiguous block of readable registers starting at reg. Must copy the values of at
+    // most length bytes to values and return the amount of bytes copied, which must end at a register boundary.
+    // registerSizes must be set to the sizes of the copied registers so that each of them is passed to OnRegisterRead.
+    // Returning 0 falls back to MapRegister for the register at reg.
+    virtual u16 MapRegisterBlock(u16 component, u16 reg, u8* values, u16 length, const u8*& registerSizes) { return 0; };
     // Length of data was reported by the RegisterHandler through MapRegister.
     virtual void ChangeValue(u16 component, u16 reg, u8* data, u16 length) { };
     virtual void CommitRegisterChange(u16 component, u16 reg, RegisterHandlerSetSource source) { };
@@ -373,6 +377,8 @@ protected:
 public:
     RegisterHandlerCode GetRegisterValues(u16 component, u16 reg, u8* values, u16 length);
     RegisterHandlerCodeStage SetRegisterValues(u16 component, u16 reg, const u8* values, u16 length, RegisterHandlerEventListener* callback = nullptr, u32 userType = 0, u8* userData = nullptr, u16 userDataLength = 0, RegisterHandlerSetSource source = RegisterHandlerSetSource::INTERNAL);
+    // Sends a component_sense message with the given payload, e.g. the values of a register range
+    static void SendComponentSense(NodeId receiver, ModuleIdWrapper moduleId, u16 component, u16 reg, u8 requestHandle, SensorMessageActionType actionType, const u8* payload, u16 payloadLength);
 
 
 #endif //IS_ACTIVE(REGISTER_HANDLER)
@@ -128,6 +128,11 @@ void ScanningModule::TimerEventHandler(u16 passedTimeDs)
         //Send asset tracking packets
         SendTrackedAssets();
     }
+
+    if(SHOULD_IV_TRIGGER(GS->appTimerDs, passedTimeDs, assetDeduplicationWindowDs)){
+        //Forward the merged asset tracking packets
+        FlushDeduplicatedAssets();
+    }
 }
 
 void ScanningModule::MeshMessageReceivedHandler(BaseConnection* connection, BaseConnectionSendData* sendData, ConnPacketHeader const * packetHeader)
@@ -148,11 +153,39 @@ void ScanningModule::MeshMessageReceivedHandler(BaseConnection* connection, Base
         {
             TrackedAssetMessage const * msg = (TrackedAssetMessage const *)connPacket->data;
             u32 amount = (sendData->dataLength - SIZEOF_CONN_PACKET_MODULE).GetRaw() / sizeof(TrackedAssetMessage);
-            ReceiveTrackedAssets(msg, amount, packetHeader->sender);
+            //Sinks merge the reports of their relays as well, they are logged once the window has passed
+            if (packetHeader->receiver != NODE_ID_SHORTEST_SINK || !DeduplicateTrackedAssets(msg, amount, packetHeader->sender))
+            {
+                ReceiveTrackedAssets(msg, amount, packetHeader->sender);
+            }
         }
     }
 }
 
+RoutingDecision ScanningModule::MessageRoutingInterceptor(BaseConnection* connection, BaseConnectionSendData* sendData, ConnPacketHeader const * packetHeader)
+{
+    //Sinks merge the asset reports in the MeshMessageReceivedHandler
+    if (assetDeduplicationWindowDs == 0 || GET_DEVICE_TYPE() == DeviceType::SINK) return 0;
+
+    if (packetHeader->messageType == MessageType::ASSET_GENERIC
+        && packetHeader->receiver == NODE_ID_SHORTEST_SINK
+        && sendData->dataLength >= SIZEOF_CONN_PACKET_MODULE)
+    {
+        ConnPacketModule const * connPacket = (ConnPacketModule const *)packetHeader;
+        if (connPacket->actionType == (u8)ScanModuleMessages::ASSET_TRACKING_PACKET)
+        {
+            TrackedAssetMessage const * msg = (TrackedAssetMessage const *)connPacket->data;
+            u32 amount = (sendData->dataLength - SIZEOF_CONN_PACKET_MODULE).GetRaw() / sizeof(TrackedAssetMessage);
+            if (DeduplicateTrackedAssets(msg, amount, packetHeader->sender))
+            {
+                //The merged reports are forwarded once the deduplication window has passed
+                return ROUTING_DECISION_BLOCK_TO_MESH | ROUTING_DECISION_BLOCK_TO_MESH_ACCESS;
+            }
+        }
+    }
+    return 0;
+}
+
 DeliveryPriority ScanningModule::GetPriorityOfMessage(const u8* data, MessageLength size)
 {
     if (size >= SIZEOF_CONN_PACKET_HEADER)
@@ -274,20 +307,45 @@ void ScanningModule::HandleAssetPackets(const FruityHal::GapAdvertisementReportE
 
 bool ScanningModule::AddTrackedAsset(const AdvPacketLegacyV2AssetServiceData * packet, i8 rssi)
 {
+    //An assetNodeId of 0 marks an empty slot and can not be tracked
+    if (packet->assetNodeId == 0) return false;
+
     ScannedAssetTrackingStorage* slot = nullptr;
 
-    //Look for an old entry of this asset or a free space
-    //Because we fill this buffer from the beginning, we can use the first slot that is empty
-    for (int i = 0; i < ASSET_PACKET_BUFFER_SIZE; i++) {
-        if (assetPackets[i].assetNodeId == packet->assetNodeId || assetPackets[i].assetNodeId == 0) {
-            slot = &assetPackets[i];
-            break;
+    //Look up an old entry of this asset or the position where it must be inserted
+    const u32 indexPosition = FindAssetPacketIndexPosition(packet->assetNodeId);
+    if (assetPacketIndex[indexPosition] != 0) {
+        slot = &assetPackets[assetPacketIndex[indexPosition] - 1];
+    }
+    //Because we fill this buffer from the beginning, the next free slot is at the end
+    else if (assetPacketsAmount < ASSET_PACKET_BUFFER_SIZE) {
+        slot = &assetPackets[assetPacketsAmount];
+        assetPacketsAmount++;
+        assetPacketIndex[indexPosition] = assetPacketsAmount;
+    }
+    //The buffer is full, we have to replace another asset
+    else {
+        const u32 evictedSlotNum = FindAssetPacketToEvict((u8)rssi);
+        if (evictedSlotNum >= ASSET_PACKET_BUFFER_SIZE) {
+            GS->logger.LogCustomCount(CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS);
+            SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS));
+            return false;
         }
+        slot = &assetPackets[evictedSlotNum];
+        logt("SCANMOD", "Evicting asset %u from slot %u", slot->assetNodeId, evictedSlotNum);
+
+        RemoveAssetPacketIndexPosition(FindAssetPacketIndexPosition(slot->assetNodeId));
+        //The position might have moved while removing the evicted asset
+        assetPacketIndex[FindAssetPacketIndexPosition(packet->assetNodeId)] = evictedSlotNum + 1;
+        slot->assetNodeId = 0;
+
+        GS->logger.LogCustomCount(CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS);
+        SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS));
     }
 
-    //If a slot was found, add the packet
-    if (slot != nullptr) {
-        u16 slotNum = ((u32)slot - (u32)assetPackets.data()) / sizeof(ScannedAssetTrackingStorage);
+    //Add the packet to the slot
+    {
+        u16 slotNum = slot - assetPackets.data();
         logt("SCANMOD", "Tracked packet %u in slot %d", packet->assetNodeId, slotNum);
 
         //Clean up first, if we overwrite another assetId
@@ -307,12 +365,82 @@ bool ScanningModule::AddTrackedAsset(const AdvPacketLegacyV2AssetServiceData * p
         slot->hasFreeInConnection = packet->hasFreeInConnection;
         slot->interestedInConnection = packet->interestedInConnection;
         slot->hasSameNetworkId = packet->networkId == GS->node.configuration.networkId;
+        slot->lastSeenDs = GS->appTimerDs;
 
         RssiRunningAverageCalculationInPlace(slot->rssiContainer, 0, rssi);
 
         return true;
     }
-    return false;
+}
+
+u32 ScanningModule::GetAssetPacketIndexHash(NodeId assetNodeId)
+{
+    //Fibonacci hashing, the upper bits are the best distributed ones
+    return ((u32)assetNodeId * 2654435769UL) >> (32 - ASSET_PACKET_INDEX_BITS);
+}
+
+//Returns the position in the index that references the given asset or the empty position where it would be inserted
+u32 ScanningModule::FindAssetPacketIndexPosition(NodeId assetNodeId) const
+{
+    u32 position = GetAssetPacketIndexHash(assetNodeId);
+    //The index is never full, so this will always terminate
+    while (assetPacketIndex[position] != 0 && assetPackets[assetPacketIndex[position] - 1].assetNodeId != assetNodeId) {
+        position = (position + 1) % ASSET_PACKET_INDEX_SIZE;
+    }
+    return position;
+}
+
+//Removes an entry from the index and moves the following entries back so that no lookup chain is interrupted
+void ScanningModule::RemoveAssetPacketIndexPosition(u32 position)
+{
+    u32 hole = position;
+    u32 current = (hole + 1) % ASSET_PACKET_INDEX_SIZE;
+    while (assetPacketIndex[current] != 0) {
+        const u32 home = GetAssetPacketIndexHash(assetPackets[assetPacketIndex[current] - 1].assetNodeId);
+        //An entry may only be moved to the hole if the hole is not before its home position
+        if (((current - home) % ASSET_PACKET_INDEX_SIZE) >= ((current - hole) % ASSET_PACKET_INDEX_SIZE)) {
+            assetPacketIndex[hole] = assetPacketIndex[current];
+            hole = current;
+        }
+        current = (current + 1) % ASSET_PACKET_INDEX_SIZE;
+    }
+    assetPacketIndex[hole] = 0;
+}
+
+/**
+ * Returns the slot of the asset that should be replaced by a newly seen asset with the given rssi.
+ * This is the asset that was not seen for the longest time and the weakest one if there are multiple.
+ * Returns ASSET_PACKET_BUFFER_SIZE if all assets were seen just now and are stronger than the new one.
+ */
+u32 ScanningModule::FindAssetPacketToEvict(u8 rssi) const
+{
+    u32 evictedSlotNum = 0;
+    u32 evictedAge = 0;
+    u8 evictedRssi = 0;
+    for (u32 i = 0; i < assetPacketsAmount; i++) {
+        const RssiContainer& container = assetPackets[i].rssiContainer;
+        const u32 age = GS->appTimerDs - assetPackets[i].lastSeenDs;
+        //The rssi is stored as a positive value, the higher it is, the weaker the asset
+        u8 strongestRssi = container.rssi37;
+        if (container.rssi38 < strongestRssi) strongestRssi = container.rssi38;
+        if (container.rssi39 < strongestRssi) strongestRssi = container.rssi39;
+
+        if (i == 0 || age > evictedAge || (age == evictedAge && strongestRssi > evictedRssi)) {
+            evictedSlotNum = i;
+            evictedAge = age;
+            evictedRssi = strongestRssi;
+        }
+    }
+
+    if (evictedAge == 0 && evictedRssi <= rssi) return ASSET_PACKET_BUFFER_SIZE;
+    return evictedSlotNum;
+}
+
+void ScanningModule::ResetTrackedAssets()
+{
+    assetPackets = {};
+    assetPacketIndex = {};
+    assetPacketsAmount = 0;
 }
 
 /**
@@ -323,12 +451,7 @@ bool ScanningModule::AddTrackedAsset(const AdvPacketLegacyV2AssetServiceData * p
 //FIXME: do we average packets or do we just take the best rssi
 void ScanningModule::SendTrackedAssets()
 {
-    //Find out how many assets were tracked
-    u8 count = 0;
-    for (int i = 0; i < ASSET_PACKET_BUFFER_SIZE; i++) {
-        if (assetPackets[i].assetNodeId == 0) break;
-        count++;
-    }
+    const u8 count = assetPacketsAmount;
 
     if (count == 0) return;
 
@@ -358,6 +481,13 @@ void ScanningModule::SendTrackedAssets()
         trackedAssets[i].hasSameNetworkId = assetPackets[i].hasSameNetworkId;
     }
 
+    //Our own reports are merged together with the relayed ones if deduplication is active
+    if (DeduplicateTrackedAssets(trackedAssets, count, GS->node.configuration.nodeId))
+    {
+        ResetTrackedAssets();
+        return;
+    }
+
     SendModuleActionMessage(
         MessageType::ASSET_GENERIC,
         NODE_ID_SHORTEST_SINK,
@@ -369,7 +499,144 @@ void ScanningModule::SendTrackedAssets()
     );
 
     //Clear the buffer
-    assetPackets = {};
+    ResetTrackedAssets();
+}
+
+#define _______________________ASSET_DEDUPLICATION______________________
+
+//Returns the strongest rssi of all channels as a positive value, UINT8_MAX if none is available
+u8 ScanningModule::GetStrongestRssi(const TrackedAssetMessage & asset)
+{
+    u8 rssi = (u8)asset.rssi37;
+    if ((u8)asset.rssi38 < rssi) rssi = (u8)asset.rssi38;
+    if ((u8)asset.rssi39 < rssi) rssi = (u8)asset.rssi39;
+    return rssi;
+}
+
+/**
+ * Merges the given reports of one reporter into the deduplication buffer. For each asset, only the reports
+ * of the assetDeduplicationMaxReporters reporters with the strongest rssi are kept. Returns false if the
+ * deduplication is inactive or the reports do not fit into the buffer, they must be handled by the caller then.
+ */
+bool ScanningModule::DeduplicateTrackedAssets(TrackedAssetMessage const * msg, u32 amount, NodeId reporterNodeId)
+{
+    if (assetDeduplicationWindowDs == 0) return false;
+
+    //Every report might need its own slot, we do not partially accept a message
+    if (deduplicatedAssetsAmount + amount > deduplicatedAssets.size()) return false;
+
+    const u32 maxReporters = assetDeduplicationMaxReporters > 0 ? assetDeduplicationMaxReporters : 1;
+
+    for (u32 i = 0; i < amount; i++)
+    {
+        const TrackedAssetMessage& asset = msg[i];
+        DeduplicatedAssetReport* sameReporter = nullptr;
+        DeduplicatedAssetReport* weakest = nullptr;
+        u32 reportsOfAsset = 0;
+
+        for (u32 k = 0; k < deduplicatedAssetsAmount; k++)
+        {
+            DeduplicatedAssetReport& report = deduplicatedAssets[k];
+            if (report.asset.assetNodeId != asset.assetNodeId) continue;
+
+            if (report.reporterNodeId == reporterNodeId)
+            {
+                sameReporter = &report;
+                break;
+            }
+            reportsOfAsset++;
+            if (weakest == nullptr || GetStrongestRssi(report.asset) > GetStrongestRssi(weakest->asset)) weakest = &report;
+        }
+
+        if (sameReporter != nullptr)
+        {
+            //A newer report of the same reporter replaces the old one
+            sameReporter->asset = asset;
+            GS->logger.LogCustomCount(CustomErrorTypes::COUNT_MERGED_ASSET_REPORTS);
+            SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_MERGED_ASSET_REPORTS));
+        }
+        else if (reportsOfAsset < maxReporters)
+        {
+            deduplicatedAssets[deduplicatedAssetsAmount].reporterNodeId = reporterNodeId;
+            deduplicatedAssets[deduplicatedAssetsAmount].asset = asset;
+            deduplicatedAssetsAmount++;
+        }
+        else
+        {
+            //Only the strongest reports are kept, the other one is dropped
+            if (GetStrongestRssi(asset) < GetStrongestRssi(weakest->asset))
+            {
+                weakest->reporterNodeId = reporterNodeId;
+                weakest->asset = asset;
+            }
+            GS->logger.LogCustomCount(CustomErrorTypes::COUNT_MERGED_ASSET_REPORTS);
+            SIMSTATCOUNT(Logger::GetErrorLogCustomError(CustomErrorTypes::COUNT_MERGED_ASSET_REPORTS));
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Sends all merged reports to the sink (or logs them if we are the sink). The reports are grouped
+ * by their reporter, which is used as the sender so that the sink still knows where the asset was seen.
+ */
+void ScanningModule::FlushDeduplicatedAssets()
+{
+    if (deduplicatedAssetsAmount == 0) return;
+
+    constexpr u32 maxAssetsPerMessage = (MAX_MESH_PACKET_SIZE - SIZEOF_CONN_PACKET_MODULE) / sizeof(TrackedAssetMessage);
+    static_assert(maxAssetsPerMessage > 0, "Tracked assets must fit into a mesh packet");
+
+    //Sort by reporter so that the reports of each reporter can be sent in one go
+    for (u32 i = 1; i < deduplicatedAssetsAmount; i++)
+    {
+        const DeduplicatedAssetReport report = deduplicatedAssets[i];
+        u32 k = i;
+        while (k > 0 && deduplicatedAssets[k - 1].reporterNodeId > report.reporterNodeId)
+        {
+            deduplicatedAssets[k] = deduplicatedAssets[k - 1];
+            k--;
+        }
+        deduplicatedAssets[k] = report;
+    }
+
+    u8 buffer[SIZEOF_CONN_PACKET_MODULE + maxAssetsPerMessage * sizeof(TrackedAssetMessage)];
+    ConnPacketModule* packet = (ConnPacketModule*)buffer;
+    TrackedAssetMessage* trackedAssets = (TrackedAssetMessage*)packet->data;
+
+    u32 start = 0;
+    while (start < deduplicatedAssetsAmount)
+    {
+        const NodeId reporterNodeId = deduplicatedAssets[start].reporterNodeId;
+        u32 count = 0;
+        while (start + count < deduplicatedAssetsAmount
+            && count < maxAssetsPerMessage
+            && deduplicatedAssets[start + count].reporterNodeId == reporterNodeId)
+        {
+            trackedAssets[count] = deduplicatedAssets[start + count].asset;
+            count++;
+        }
+        start += count;
+
+        if (GET_DEVICE_TYPE() == DeviceType::SINK)
+        {
+            ReceiveTrackedAssets(trackedAssets, count, reporterNodeId);
+        }
+        else
+        {
+            packet->header.messageType = MessageType::ASSET_GENERIC;
+            packet->header.sender = reporterNodeId;
+            packet->header.receiver = NODE_ID_SHORTEST_SINK;
+            packet->moduleId = moduleId;
+            packet->requestHandle = 0;
+            packet->actionType = (u8)ScanModuleMessages::ASSET_TRACKING_PACKET;
+
+            GS->cm.SendMeshMessage(buffer, SIZEOF_CONN_PACKET_MODULE + count * sizeof(TrackedAssetMessage));
+        }
+    }
+
+    deduplicatedAssetsAmount = 0;
 }
 
 void ScanningModule::ReceiveTrackedAssetsLegacy(BaseConnectionSendData* sendData, ScanModuleTrackedAssetsLegacyMessage const * packet) const
@@ -44,7 +44,13 @@ constexpr int SCAN_FILTER_NUMBER = 2;//Number of filters that can be set
 constexpr int NUM_ADDRESSES_TRACKED = 50;
 
 constexpr int ASSET_PACKET_BUFFER_SIZE = 30;
+//The asset packet buffer is indexed by an open addressing hash table that must be a power of two and not more than half full
+constexpr int ASSET_PACKET_INDEX_BITS = 6;
+constexpr int ASSET_PACKET_INDEX_SIZE = 1 << ASSET_PACKET_INDEX_BITS;
+static_assert(ASSET_PACKET_INDEX_SIZE >= 2 * ASSET_PACKET_BUFFER_SIZE, "Asset packet index too small");
+static_assert(ASSET_PACKET_BUFFER_SIZE < UINT8_MAX, "Asset packet index can not address the buffer");
 constexpr int ASSET_PACKET_RSSI_SEND_THRESHOLD = -88;
+constexpr int ASSET_DEDUPLICATION_BUFFER_SIZE = 30;
 
 enum class GroupingType : u8 {
     GROUP_BY_ADDRESS =1, 
@@ -185,9 +191,23 @@ private:
         u8 hasSameNetworkId : 1;
         u8 positionValid : 1;
         u8 reservedBits : 3;
+        u32 lastSeenDs;
     };
 
     std::array<ScannedAssetTrackingStorage, ASSET_PACKET_BUFFER_SIZE> assetPackets{};
+    u8 assetPacketsAmount = 0;
+    //Maps the assetNodeId to the slot in the assetPackets (stored as slot + 1, 0 marks an empty position)
+    std::array<u8, ASSET_PACKET_INDEX_SIZE> assetPacketIndex{};
+
+    //Storage for tracked asset reports (own and relayed) that are merged before they are sent to the sink
+    struct DeduplicatedAssetReport
+    {
+        NodeId reporterNodeId;
+        TrackedAssetMessage asset;
+    };
+
+    std::array<DeduplicatedAssetReport, ASSET_DEDUPLICATION_BUFFER_SIZE> deduplicatedAssets{};
+    u32 deduplicatedAssetsAmount = 0;
 
     //####### End of Module specitic messages
 #pragma pack(pop)
@@ -197,12 +217,21 @@ private:
     void HandleAssetLegacyPackets(const FruityHal::GapAdvertisementReportEvent& advertisementReportEvent);
     void HandleAssetPackets(const FruityHal::GapAdvertisementReportEvent& advertisementReportEvent);
     bool AddTrackedAsset(const AdvPacketLegacyV2AssetServiceData* packet, i8 rssi);
+    static u32 GetAssetPacketIndexHash(NodeId assetNodeId);
+    u32 FindAssetPacketIndexPosition(NodeId assetNodeId) const;
+    void RemoveAssetPacketIndexPosition(u32 position);
+    u32 FindAssetPacketToEvict(u8 rssi) const;
+    void ResetTrackedAssets();
     void ReceiveTrackedAssetsLegacy(BaseConnectionSendData* sendData, ScanModuleTrackedAssetsLegacyMessage const * packet) const;
     void ReceiveTrackedAssets(TrackedAssetMessage const * msg, u32 amount, NodeId sender) const;
     void RssiRunningAverageCalculationInPlace(RssiContainer &container, u8 advertisingChannel, i8 rssi);
     
     void SendTrackedAssets();
 
+    static u8 GetStrongestRssi(const TrackedAssetMessage& asset);
+    bool DeduplicateTrackedAssets(TrackedAssetMessage const * msg, u32 amount, NodeId reporterNodeId);
+    void FlushDeduplicatedAssets();
+
 
     static u8 ConvertServiceDataToMeshMessageSpeed(u8 serviceDataSpeed);
     u8 ConvertServiceDataToMeshMessagePressure(u16 serviceDataPressure);
@@ -211,6 +240,13 @@ private:
 public:
     u16 assetReportingIntervalDs = 0;
 
+    //Tracked asset reports for the same asset that are sent towards the sink within this window are
+    //merged on relays and sinks so that only the reports with the strongest rssi reach the sink.
+    //A value of 0 disables the deduplication.
+    u16 assetDeduplicationWindowDs = 0;
+    //The amount of reporting nodes that are kept per asset during deduplication
+    u8 assetDeduplicationMaxReporters = 1;
+
     ScanJob * p_scanJob;
 
     DECLARE_CONFIG_AND_PACKED_STRUCT(ScanningModuleConfiguration);
@@ -227,6 +263,8 @@ public:
 
     void MeshMessageReceivedHandler(BaseConnection* connection, BaseConnectionSendData* sendData, ConnPacketHeader const * packetHeader) override final;
 
+    RoutingDecision MessageRoutingInterceptor(BaseConnection* connection, BaseConnectionSendData* sendData, ConnPacketHeader const * packetHeader) override final;
+
     //Priority
     virtual DeliveryPriority GetPriorityOfMessage(const u8* data, MessageLength size) override;
 
@@ -1465,6 +1465,27 @@ RegisterGeneralChecks StatusReporterModule::GetGeneralChecks(u16 component, u16
     return RegisterGeneralChecks::RGC_LOCATION_DISABLED;
 }
 
+RegisterHandlerCode StatusReporterModule::CheckValues(u16 component, u16 reg, const u8* values, u16 length) const
+{
+    if (component == (u16)StatusReporterModuleComponent::BASIC_REGISTER_HANDLER_FUNCTIONALITY)
+    {
+        //The reference voltages may be written separately, so the check is done on the values they will have afterwards
+        u32 referenceMilliVolts[2] = { referenceMilliVolt0Percent, referenceMilliVolt100Percent };
+        static_assert(REGISTER_REFERENCE_MILLI_VOLT_AT_100_PERCENT - REGISTER_REFERENCE_MILLI_VOLT_AT_0_PERCENT == sizeof(u32), "Reference voltages must be adjacent");
+        for (u32 i = 0; i < length; i++)
+        {
+            if (reg + i >= REGISTER_REFERENCE_MILLI_VOLT_AT_0_PERCENT && reg + i < REGISTER_REFERENCE_MILLI_VOLT_AT_0_PERCENT + sizeof(referenceMilliVolts))
+            {
+                ((u8*)referenceMilliVolts)[reg + i - REGISTER_REFERENCE_MILLI_VOLT_AT_0_PERCENT] = values[i];
+            }
+        }
+        //The battery percentage is interpolated between both values
+        if (referenceMilliVolts[0] >= referenceMilliVolts[1]) return RegisterHandlerCode::ILLEGAL_VALUE;
+    }
+
+    return RegisterHandlerCode::SUCCESS;
+}
+
 void StatusReporterModule::MapRegister(u16 component, u16 reg, SupervisedValue& out, u32& persistedId)
 {
     if (component == (u16)StatusReporterModuleComponent::BASIC_REGISTER_HANDLER_FUNCTIONALITY)
@@ -1487,31 +1508,41 @@ void StatusReporterModule::MapRegister(u16 component, u16 reg, SupervisedValue&
         }
 
         //Configuration Registers
-        if (reg == REGISTER_REFERENCE_MILLI_VOLT_AT_0_PERCENT) out.SetReadable(referenceMilliVolt0Percent); //TODO: Make writable once persistance is available
-        if (reg == REGISTER_REFERENCE_MILLI_VOLT_AT_100_PERCENT) out.SetReadable(referenceMilliVolt100Percent); //TODO: Make writable once persistance is available
+        if (reg == REGISTER_REFERENCE_MILLI_VOLT_AT_0_PERCENT) {
+            out.SetWritable(&referenceMilliVolt0Percent);
+            persistedId = 1;
+        }
+        if (reg == REGISTER_REFERENCE_MILLI_VOLT_AT_100_PERCENT) {
+            out.SetWritable(&referenceMilliVolt100Percent);
+            persistedId = 1;
+        }
 
         //Data Registers
-        if (reg == REGISTER_DEVICE_UPTIME) out.SetReadable(GS->appTimerDs);
-        if (reg == REGISTER_ABSOLUTE_UTC_TIME) out.SetReadable(GS->timeManager.GetUtcTime());
-        if (reg == REGISTER_ABSOLUTE_LOCAL_TIME) out.SetReadable(GS->timeManager.GetLocalTime());
-        
-        if (reg == REGISTER_CLUSTER_SIZE) out.SetReadable(GS->node.GetClusterSize());
-        if (reg == REGISTER_NUM_MESH_CONNECTIONS) {
-            BaseConnections conns = GS->cm.GetConnectionsOfType(ConnectionType::FRUITYMESH, ConnectionDirection::INVALID);
-            u8 connCount = conns.count;
-            out.SetReadable(connCount);
+        if (reg >= REGISTER_DEVICE_UPTIME && reg < REGISTER_DEVICE_UPTIME + sizeof(TimeRegisterBlock))
+        {
+            TimeRegisterBlock block;
+            ReadTimeRegisters(block);
+            if (reg == REGISTER_DEVICE_UPTIME) out.SetReadable(block.deviceUptime);
+            if (reg == REGISTER_ABSOLUTE_UTC_TIME) out.SetReadable(block.absoluteUtcTime);
+            if (reg == REGISTER_ABSOLUTE_LOCAL_TIME) out.SetReadable(block.absoluteLocalTime);
         }
-        if (reg == REGISTER_NUM_OTHER_CONNECTIONS) {
-            BaseConnections meshConns = GS->cm.GetConnectionsOfType(ConnectionType::FRUITYMESH, ConnectionDirection::INVALID);
-            BaseConnections allConns = GS->cm.GetConnectionsOfType(ConnectionType::INVALID, ConnectionDirection::INVALID);
-            u8 connCount = allConns.count - meshConns.count;
-            out.SetReadable(connCount);
+
+        if (reg >= REGISTER_CLUSTER_SIZE && reg < REGISTER_CLUSTER_SIZE + sizeof(ConnectionRegisterBlock))
+        {
+            ConnectionRegisterBlock block;
+            ReadConnectionRegisters(block);
+            if (reg == REGISTER_CLUSTER_SIZE) out.SetReadable(block.clusterSize);
+            if (reg == REGISTER_NUM_MESH_CONNECTIONS) out.SetReadable(block.numMeshConnections);
+            if (reg == REGISTER_NUM_OTHER_CONNECTIONS) out.SetReadable(block.numOtherConnections);
+            if (reg == REGISTER_MESH_CONNECTIONS_DROPPED) out.SetReadable(block.meshConnectionsDropped);
+            if (reg == REGISTER_PACKETS_SENT_RELIABLE) out.SetReadable(block.packetsSentReliable);
+            if (reg == REGISTER_PACKETS_SENT_UNRELIABLE) out.SetReadable(block.packetsSentUnreliable);
+            if (reg == REGISTER_PACKETS_DROPPED) out.SetReadable(block.packetsDropped);
+            if (reg == REGISTER_PACKETS_GENERATED) out.SetReadable(block.packetsGenerated);
+            if (reg == REGISTER_PACKETS_EXPIRED_HIGH) out.SetReadable(block.packetsExpiredHigh);
+            if (reg == REGISTER_PACKETS_EXPIRED_MEDIUM) out.SetReadable(block.packetsExpiredMedium);
+            if (reg == REGISTER_PACKETS_EXPIRED_LOW) out.SetReadable(block.packetsExpiredLow);
         }
-        if (reg == REGISTER_MESH_CONNECTIONS_DROPPED) out.SetReadable(GS->node.connectionLossCounter);
-        if (reg == REGISTER_PACKETS_SENT_RELIABLE) out.SetReadable(GS->cm.sentMeshPacketsReliable);
-        if (reg == REGISTER_PACKETS_SENT_UNRELIABLE) out.SetReadable(GS->cm.sentMeshPacketsUnreliable);
-        if (reg == REGISTER_PACKETS_DROPPED) out.SetReadable(GS->cm.droppedMeshPackets);
-        if (reg == REGISTER_PACKETS_GENERATED) out.SetReadable(GS->cm.generatedPackets);
 
         if (reg == REGISTER_BATTERY_PERCENTAGE)
         {
@@ -1520,7 +1551,100 @@ void StatusReporterModule::MapRegister(u16 component, u16 reg, SupervisedValue&
             batteryPercent = (batteryPercent * 100) / (i32)(referenceMilliVolt100Percent - referenceMilliVolt0Percent);
             out.SetReadable((u8)Utility::Clamp(batteryPercent, 0, 100));
         }
+
+#if IS_ACTIVE(QUEUE_HISTOGRAMS)
+        if (reg >= REGISTER_QUEUE_DEPTH_HISTOGRAMS && reg < REGISTER_QUEUE_DEPTH_HISTOGRAMS + SIZEOF_QUEUE_HISTOGRAM_REGISTERS && (reg - REGISTER_QUEUE_DEPTH_HISTOGRAMS) % sizeof(u16) == 0)
+        {
+            const u32 index = (reg - REGISTER_QUEUE_DEPTH_HISTOGRAMS) / sizeof(u16);
+            out.SetReadable(GS->cm.queueDepthHistograms[index / QUEUE_HISTOGRAM_NUM_BUCKETS].buckets[index % QUEUE_HISTOGRAM_NUM_BUCKETS]);
+        }
+        if (reg >= REGISTER_QUEUE_LATENCY_HISTOGRAMS && reg < REGISTER_QUEUE_LATENCY_HISTOGRAMS + SIZEOF_QUEUE_HISTOGRAM_REGISTERS && (reg - REGISTER_QUEUE_LATENCY_HISTOGRAMS) % sizeof(u16) == 0)
+        {
+            const u32 index = (reg - REGISTER_QUEUE_LATENCY_HISTOGRAMS) / sizeof(u16);
+            out.SetReadable(GS->cm.queueLatencyHistograms[index / QUEUE_HISTOGRAM_NUM_BUCKETS].buckets[index % QUEUE_HISTOGRAM_NUM_BUCKETS]);
+        }
+#endif
+    }
+}
+
+void StatusReporterModule::ReadTimeRegisters(TimeRegisterBlock& block) const
+{
+    block.deviceUptime = GS->appTimerDs;
+    block.absoluteUtcTime = GS->timeManager.GetUtcTime();
+    block.absoluteLocalTime = GS->timeManager.GetLocalTime();
+}
+
+void StatusReporterModule::ReadConnectionRegisters(ConnectionRegisterBlock& block) const
+{
+    const BaseConnections meshConns = GS->cm.GetConnectionsOfType(ConnectionType::FRUITYMESH, ConnectionDirection::INVALID);
+    const BaseConnections allConns = GS->cm.GetConnectionsOfType(ConnectionType::INVALID, ConnectionDirection::INVALID);
+
+    block.clusterSize = GS->node.GetClusterSize();
+    block.numMeshConnections = meshConns.count;
+    block.numOtherConnections = allConns.count - meshConns.count;
+    block.meshConnectionsDropped = GS->node.connectionLossCounter;
+    block.packetsSentReliable = GS->cm.sentMeshPacketsReliable;
+    block.packetsSentUnreliable = GS->cm.sentMeshPacketsUnreliable;
+    block.packetsDropped = GS->cm.droppedMeshPackets;
+    block.packetsGenerated = GS->cm.generatedPackets;
+    block.packetsExpiredHigh = GS->cm.expiredMeshPackets[(u32)DeliveryPriority::HIGH];
+    block.packetsExpiredMedium = GS->cm.expiredMeshPackets[(u32)DeliveryPriority::MEDIUM];
+    block.packetsExpiredLow = GS->cm.expiredMeshPackets[(u32)DeliveryPriority::LOW];
+}
+
+//Returns the amount of bytes that can be read at once from a block of registers with the given sizes. The read
+//must start at the beginning of a register and is shortened to the last register that fits completely.
+//readRegisterSizes is set to the sizes of the registers that are read.
+static u16 GetRegisterBlockReadLength(const u8* registerSizes, u32 amountOfRegisters, u32 offset, u32 length, const u8*& readRegisterSizes)
+{
+    u32 registerStart = 0;
+    for (u32 i = 0; i < amountOfRegisters; i++)
+    {
+        if (registerStart == offset)
+        {
+            u32 readLength = 0;
+            for (u32 k = i; k < amountOfRegisters && readLength + registerSizes[k] <= length; k++)
+            {
+                readLength += registerSizes[k];
+            }
+            readRegisterSizes = registerSizes + i;
+            return readLength;
+        }
+        registerStart += registerSizes[i];
+    }
+    return 0;
+}
+
+u16 StatusReporterModule::MapRegisterBlock(u16 component, u16 reg, u8* values, u16 length, const u8*& registerSizes)
+{
+    if (component != (u16)StatusReporterModuleComponent::BASIC_REGISTER_HANDLER_FUNCTIONALITY) return 0;
+
+    //The data registers are read as whole blocks so that large reads don't have to map every register separately
+    if (reg >= REGISTER_DEVICE_UPTIME && reg < REGISTER_DEVICE_UPTIME + sizeof(TimeRegisterBlock))
+    {
+        static constexpr u8 timeRegisterSizes[] = { 4, 4, 4 };
+        const u32 offset = reg - REGISTER_DEVICE_UPTIME;
+        const u16 readLength = GetRegisterBlockReadLength(timeRegisterSizes, sizeof(timeRegisterSizes), offset, length, registerSizes);
+        if (readLength == 0) return 0;
+
+        TimeRegisterBlock block;
+        ReadTimeRegisters(block);
+        CheckedMemcpy(values, ((u8*)&block) + offset, readLength);
+        return readLength;
+    }
+    if (reg >= REGISTER_CLUSTER_SIZE && reg < REGISTER_CLUSTER_SIZE + sizeof(ConnectionRegisterBlock))
+    {
+        static constexpr u8 connectionRegisterSizes[] = { 2, 1, 1, 2, 4, 4, 4, 4, 4, 4, 4 };
+        const u32 offset = reg - REGISTER_CLUSTER_SIZE;
+        const u16 readLength = GetRegisterBlockReadLength(connectionRegisterSizes, sizeof(connectionRegisterSizes), offset, length, registerSizes);
+        if (readLength == 0) return 0;
+
+        ConnectionRegisterBlock block;
+        ReadConnectionRegisters(block);
+        CheckedMemcpy(values, ((u8*)&block) + offset, readLength);
+        return readLength;
     }
+    return 0;
 }
 #endif //IS_ACTIVE(REGISTER_HANDLER)
 
@@ -444,12 +444,55 @@ public:
     constexpr static u32 REGISTER_PACKETS_SENT_UNRELIABLE = 30110; // Size 4
     constexpr static u32 REGISTER_PACKETS_DROPPED = 30114; // Size 4
     constexpr static u32 REGISTER_PACKETS_GENERATED = 30118; // Size 4
+    constexpr static u32 REGISTER_PACKETS_EXPIRED_HIGH = 30122; // Size 4
+    constexpr static u32 REGISTER_PACKETS_EXPIRED_MEDIUM = 30126; // Size 4
+    constexpr static u32 REGISTER_PACKETS_EXPIRED_LOW = 30130; // Size 4
 
     constexpr static u32 REGISTER_BATTERY_PERCENTAGE = 30200; // Size 1
 
+    //The queue histograms of all connections, 8 buckets of 2 bytes for each DeliveryPriority from VITAL to LOW, see QueueHistogram
+    constexpr static u32 REGISTER_QUEUE_DEPTH_HISTOGRAMS = 30300; // Size 64
+    constexpr static u32 REGISTER_QUEUE_LATENCY_HISTOGRAMS = 30400; // Size 64
+    constexpr static u32 SIZEOF_QUEUE_HISTOGRAM_REGISTERS = AMOUNT_OF_SEND_QUEUE_PRIORITIES * QUEUE_HISTOGRAM_NUM_BUCKETS * sizeof(u16);
+    static_assert(SIZEOF_QUEUE_HISTOGRAM_REGISTERS == 64, "The register layout of the queue histograms changed!");
+
+    //Memory layout of the contiguous data registers that are read in bulk through MapRegisterBlock
+#pragma pack(push, 1)
+    struct TimeRegisterBlock
+    {
+        u32 deviceUptime;
+        u32 absoluteUtcTime;
+        u32 absoluteLocalTime;
+    };
+    struct ConnectionRegisterBlock
+    {
+        ClusterSize clusterSize;
+        u8 numMeshConnections;
+        u8 numOtherConnections;
+        u16 meshConnectionsDropped;
+        u32 packetsSentReliable;
+        u32 packetsSentUnreliable;
+        u32 packetsDropped;
+        u32 packetsGenerated;
+        u32 packetsExpiredHigh;
+        u32 packetsExpiredMedium;
+        u32 packetsExpiredLow;
+    };
+#pragma pack(pop)
+    static_assert(offsetof(TimeRegisterBlock, absoluteLocalTime) == REGISTER_ABSOLUTE_LOCAL_TIME - REGISTER_DEVICE_UPTIME, "Wrong block layout!");
+    static_assert(offsetof(ConnectionRegisterBlock, numOtherConnections) == REGISTER_NUM_OTHER_CONNECTIONS - REGISTER_CLUSTER_SIZE, "Wrong block layout!");
+    static_assert(offsetof(ConnectionRegisterBlock, packetsGenerated) == REGISTER_PACKETS_GENERATED - REGISTER_CLUSTER_SIZE, "Wrong block layout!");
+    static_assert(offsetof(ConnectionRegisterBlock, packetsExpiredLow) == REGISTER_PACKETS_EXPIRED_LOW - REGISTER_CLUSTER_SIZE, "Wrong block layout!");
+
+    //The values of the data registers, used by both MapRegister and MapRegisterBlock
+    void ReadTimeRegisters(TimeRegisterBlock& block) const;
+    void ReadConnectionRegisters(ConnectionRegisterBlock& block) const;
+
     protected:
         virtual RegisterGeneralChecks GetGeneralChecks(u16 component, u16 reg, u16 length) const override final;
+        virtual RegisterHandlerCode CheckValues(u16 component, u16 reg, const u8* values, u16 length) const override final;
         virtual void MapRegister(u16 component, u16 reg, SupervisedValue& out, u32& persistedId) override final;
+        virtual u16 MapRegisterBlock(u16 component, u16 reg, u8* values, u16 length, const u8*& registerSizes) override final;
 #endif //IS_ACTIVE(REGISTER_HANDLER)
 
         // AutoSenseModuleDataProvider
@@ -89,6 +89,9 @@ enum class MessageType : u8
     CAPABILITY = 33,
     ASSET_GENERIC = 34, // Deprecated as of 14.04.2021 (sent as ModuleMessage in AssetScanningModule)
     SIG_MESH_SIMPLE = 35, //A lightweight wrapper for SIG mesh access layer messages
+    RELIABLE_SEGMENT = 36, //A segment of a message that is sent with end-to-end acknowledgement
+    RELIABLE_ACK = 37, //Acknowledges the segments of a reliable transfer that were received
+    SINK_LOAD = 38, //Periodically broadcasted by sinks if sink load balancing is enabled
 
     //Module messages all use the same ConnPacketModule header
     MODULE_MESSAGES_START = 50,
@@ -359,7 +362,8 @@ enum class ActorMessageActionType : u8
     READ = 2, // Read a value
     WRITE_ACK = 3, // Write with acknowledgement
     //CMD = 4, //deprecated as of 09.09.2021, use WRITE_ACK or WRITE instead
-    
+    SUBSCRIBE = 5, // Subscribe to changes of a register range, see RegisterSubscribeMessage
+
     INVALID = 0xFF
 };
 
@@ -770,6 +774,40 @@ typedef struct
 }ConnPacketUpdateConnectionInterval;
 STATIC_ASSERT_SIZE(ConnPacketUpdateConnectionInterval, SIZEOF_CONN_PACKET_UPDATE_CONNECTION_INTERVAL);
 
+//RELIABLE_SEGMENT carries a part of a message that is sent end-to-end reliable, see ReliableTransfer
+//Each segment fits into a single write so that a lost packet on any hop only costs this segment
+constexpr size_t SIZEOF_CONN_PACKET_RELIABLE_SEGMENT_HEADER = (SIZEOF_CONN_PACKET_HEADER + 3);
+constexpr size_t RELIABLE_SEGMENT_PAYLOAD_SIZE = (MAX_DATA_SIZE_PER_WRITE - SIZEOF_CONN_PACKET_RELIABLE_SEGMENT_HEADER);
+typedef struct
+{
+    ConnPacketHeader header;
+    u8 transferId;
+    u8 segmentIndex;
+    u8 amountOfSegments;
+    u8 data[RELIABLE_SEGMENT_PAYLOAD_SIZE];
+}ConnPacketReliableSegment;
+STATIC_ASSERT_SIZE(ConnPacketReliableSegment, MAX_DATA_SIZE_PER_WRITE);
+
+//RELIABLE_ACK is sent by the receiver of a reliable transfer once the last segment arrived or if segments
+//are missing. Each bit of receivedSegments stands for the segment with the same index.
+constexpr size_t SIZEOF_CONN_PACKET_RELIABLE_ACK = (SIZEOF_CONN_PACKET_HEADER + 5);
+typedef struct
+{
+    ConnPacketHeader header;
+    u8 transferId;
+    u32 receivedSegments;
+}ConnPacketReliableAck;
+STATIC_ASSERT_SIZE(ConnPacketReliableAck, SIZEOF_CONN_PACKET_RELIABLE_ACK);
+
+//SINK_LOAD is broadcasted by every sink so that the other nodes can spread their uplink traffic between the sinks
+constexpr size_t SIZEOF_CONN_PACKET_SINK_LOAD = (SIZEOF_CONN_PACKET_HEADER + 2);
+typedef struct
+{
+    ConnPacketHeader header;
+    u16 receivedPackets; //Packets that the sink received for NODE_ID_SHORTEST_SINK during the last interval
+}ConnPacketSinkLoad;
+STATIC_ASSERT_SIZE(ConnPacketSinkLoad, SIZEOF_CONN_PACKET_SINK_LOAD);
+
 enum class TrackedAssetMessageEntryType : u8
 {
     BLE    = 0x00,
@@ -74,8 +74,11 @@ extern "C" {
 #ifdef SIM_ENABLED
 #include "StackWatcher.h"
 #define START_OF_FUNCTION() StackWatcher::Check(); if(cherrySimInstance != nullptr) {cherrySimInstance->SimulateInterrupts();}
+//Records the peak stack usage of a handler until the end of the enclosing scope
+#define STACK_WATCHER_SCOPE(handlerName, moduleName, eventId) StackWatcherScope stackWatcherScope(handlerName, moduleName, eventId)
 #else
 #define START_OF_FUNCTION
+#define STACK_WATCHER_SCOPE(handlerName, moduleName, eventId)
 #endif
 
 #ifdef CHERRYSIM_TESTER_ENABLED
@@ -36,11 +36,17 @@
 #include "ChunkedPacketQueue.h"
 
 // Adds a message. Private as the method does not check for size or nullptrs, the caller has to do this.
-void ChunkedPacketQueue::AddMessageRaw(u8* data, u16 size)
+// If isEntryStart is set, the location of the first written byte is added to the packet index of its chunk.
+void ChunkedPacketQueue::AddMessageRaw(u8* data, u16 size, bool isEntryStart)
 {
     writeChunk->amountOfByteInThisChunk = Utility::NextMultipleOf(writeChunk->amountOfByteInThisChunk, sizeof(u32));
     const u32 sizeLeftInCurrentWriteChunk = CONNECTION_QUEUE_MEMORY_CHUNK_SIZE > writeChunk->amountOfByteInThisChunk ? CONNECTION_QUEUE_MEMORY_CHUNK_SIZE - writeChunk->amountOfByteInThisChunk : 0;
 
+    if (isEntryStart && sizeLeftInCurrentWriteChunk > 0)
+    {
+        AddPacketToChunkIndex(writeChunk, writeChunk->amountOfByteInThisChunk);
+    }
+
     if (sizeLeftInCurrentWriteChunk >= size)
     {
         // The data fits completely in the current writeChunk
@@ -66,12 +72,29 @@ void ChunkedPacketQueue::AddMessageRaw(u8* data, u16 size)
         }
         writeChunk->nextChunk = newChunk;
         writeChunk = newChunk;
+        if (isEntryStart && sizeLeftInCurrentWriteChunk == 0)
+        {
+            AddPacketToChunkIndex(writeChunk, 0);
+        }
         CheckedMemcpy(writeChunk->data.data(), data + sizeLeftInCurrentWriteChunk, size - sizeLeftInCurrentWriteChunk);
         writeChunk->amountOfByteInThisChunk += size - sizeLeftInCurrentWriteChunk;
         writeChunk->amountOfByteInThisChunk = Utility::NextMultipleOf(writeChunk->amountOfByteInThisChunk, sizeof(u32));
     }
 }
 
+void ChunkedPacketQueue::AddPacketToChunkIndex(ConnectionQueueMemoryChunk* chunk, u32 head)
+{
+    if (chunk->amountOfPacketsInThisChunk >= ConnectionQueueMemoryChunk::MAX_PACKETS_PER_CHUNK || head % sizeof(u32) != 0)
+    {
+        // Implementation error! Every entry is 4 byte aligned and at least
+        // 8 bytes long, so the index can never overflow.
+        SIMEXCEPTION(IllegalStateException);
+        return;
+    }
+    chunk->packetOffsets[chunk->amountOfPacketsInThisChunk] = head / sizeof(u32);
+    chunk->amountOfPacketsInThisChunk++;
+}
+
 u16 ChunkedPacketQueue::PeekPacketRaw(u8* outData, u16 outDataSize, const ConnectionQueueMemoryChunk* chunk, u32 head, u32* messageHandle) const
 {
     const QueueEntryHeader* header = (const QueueEntryHeader*)(chunk->data.data() + head);
@@ -145,35 +168,32 @@ ChunkedPacketQueue::ChunkHeadPair ChunkedPacketQueue::GetChunkHeadPairOfIndex(u1
     if (index >= amountOfPackets)
     {
         SIMEXCEPTION(IllegalArgumentException);
-        return ChunkHeadPair{ nullptr, 0 };
+        return ChunkHeadPair{ nullptr, 0, 0 };
     }
 
-    // Search for the chunk and the head
+    // Search for the chunk that contains the start of the entry. Thanks to the per
+    // chunk packet index, only the chunks have to be visited, not every single entry.
     ConnectionQueueMemoryChunk* currentChunk = readChunk;
-    u32 currentHead = readChunk->currentReadHead;
-    for (u16 i = 0; i < index; i++)
-    {
-        const QueueEntryHeader* header = (const QueueEntryHeader*)(currentChunk->data.data() + currentHead);
-        const u16 headerSize = header->isExtended ? sizeof(ExtendedQueueEntryHeader) : sizeof(QueueEntryHeader);
-        currentHead += headerSize;
-        currentHead += header->size;
-        currentHead = Utility::NextMultipleOf(currentHead, sizeof(u32));
-        if (currentHead >= CONNECTION_QUEUE_MEMORY_CHUNK_SIZE)
+    u32 packetIndexInChunk = readChunk->currentReadPacketIndex;
+    u32 indexLeft = index;
+    while (packetIndexInChunk + indexLeft >= currentChunk->amountOfPacketsInThisChunk)
+    {
+        const u32 packetsLeftInChunk = currentChunk->amountOfPacketsInThisChunk > packetIndexInChunk ? currentChunk->amountOfPacketsInThisChunk - packetIndexInChunk : 0;
+        if (currentChunk->nextChunk == nullptr)
         {
-            if (currentChunk->nextChunk == nullptr)
-            {
-                // (Probably) An implementation error! The random access peek reached the
-                // end of the chunk linked list, but did not yet reach the searched index.
-                // This may also be some MemoryCorruption.
-                SIMEXCEPTION(IllegalStateException);
-                return ChunkHeadPair{ nullptr, 0 };
-            }
-            currentChunk = currentChunk->nextChunk;
-            currentHead -= CONNECTION_QUEUE_MEMORY_CHUNK_SIZE;
+            // (Probably) An implementation error! The random access peek reached the
+            // end of the chunk linked list, but did not yet reach the searched index.
+            // This may also be some MemoryCorruption.
+            SIMEXCEPTION(IllegalStateException);
+            return ChunkHeadPair{ nullptr, 0, 0 };
         }
+        indexLeft -= packetsLeftInChunk;
+        currentChunk = currentChunk->nextChunk;
+        packetIndexInChunk = 0;
     }
+    packetIndexInChunk += indexLeft;
 
-    return ChunkHeadPair{ currentChunk, currentHead };
+    return ChunkHeadPair{ currentChunk, (u32)(currentChunk->packetOffsets[packetIndexInChunk] * sizeof(u32)), (u8)packetIndexInChunk };
 }
 
 ChunkedPacketQueue::ChunkedPacketQueue()
@@ -293,7 +313,7 @@ bool ChunkedPacketQueue::AddMessage(u8* data, u16 size, u32 * messageHandle, boo
         SIMEXCEPTION(IllegalArgumentException);
         return false;
     }
-    if (data == nullptr)
+    if (data == nullptr || size == 0)
     {
         SIMEXCEPTION(IllegalArgumentException);
         return false;
@@ -318,7 +338,8 @@ bool ChunkedPacketQueue::AddMessage(u8* data, u16 size, u32 * messageHandle, boo
         CheckedMemset(&header, 0, sizeof(header));
         header.size = size;
         header.isSplit = isSplit;
-        AddMessageRaw((u8*)&header, sizeof(header));
+        header.enqueueTimeSec = GetCurrentEnqueueTimeSec();
+        AddMessageRaw((u8*)&header, sizeof(header), true);
         AddMessageRaw(data, size);
         amountOfPackets++;
 
@@ -344,9 +365,10 @@ bool ChunkedPacketQueue::AddMessage(u8* data, u16 size, u32 * messageHandle, boo
         header.header.size = size;
         header.header.isSplit = isSplit;
         header.header.isExtended = true;
+        header.header.enqueueTimeSec = GetCurrentEnqueueTimeSec();
         header.handle = this->messageHandle;
         if (messageHandle != nullptr) *messageHandle = this->messageHandle;
-        AddMessageRaw((u8*)&header, sizeof(header));
+        AddMessageRaw((u8*)&header, sizeof(header), true);
         AddMessageRaw(data, size);
         amountOfPackets++;
 
@@ -391,9 +413,15 @@ void ChunkedPacketQueue::PopPacket()
     const u16 headerSize = header->isExtended ? sizeof(ExtendedQueueEntryHeader) : sizeof(QueueEntryHeader);
     const u16 sizeToPop = size + headerSize;
     const u16 oldReadHead = readChunk->currentReadHead;
+    isReadInsideSplitMessage = header->isSplit == 1;
     readChunk->currentReadHead += sizeToPop;
     readChunk->currentReadHead = Utility::NextMultipleOf(readChunk->currentReadHead, sizeof(u32));
-    if (needToMoveLookAhead) readChunk->currentLookAheadHead = readChunk->currentReadHead;
+    readChunk->currentReadPacketIndex++;
+    if (needToMoveLookAhead)
+    {
+        readChunk->currentLookAheadHead = readChunk->currentReadHead;
+        readChunk->currentLookAheadPacketIndex = readChunk->currentReadPacketIndex;
+    }
     if (readChunk->currentReadHead >= CONNECTION_QUEUE_MEMORY_CHUNK_SIZE && readChunk != writeChunk)
     {
         auto oldReadChunk = readChunk;
@@ -479,6 +507,7 @@ void ChunkedPacketQueue::IncrementLookAhead()
     const u16 oldReadHead = lookAheadChunk->currentLookAheadHead;
     lookAheadChunk->currentLookAheadHead += sizeToJump;
     lookAheadChunk->currentLookAheadHead = Utility::NextMultipleOf(lookAheadChunk->currentLookAheadHead, sizeof(u32));
+    lookAheadChunk->currentLookAheadPacketIndex++;
     if (lookAheadChunk->currentLookAheadHead >= CONNECTION_QUEUE_MEMORY_CHUNK_SIZE && lookAheadChunk != writeChunk)
     {
         lookAheadChunk = lookAheadChunk->nextChunk;
@@ -496,10 +525,12 @@ void ChunkedPacketQueue::IncrementLookAhead()
 void ChunkedPacketQueue::RollbackLookAhead()
 {
     lookAheadChunk->currentLookAheadHead = lookAheadChunk->currentReadHead;
+    lookAheadChunk->currentLookAheadPacketIndex = lookAheadChunk->currentReadPacketIndex;
     auto currentChunk = readChunk;
     while (currentChunk != lookAheadChunk)
     {
         currentChunk->currentLookAheadHead = currentChunk->currentReadHead;
+        currentChunk->currentLookAheadPacketIndex = currentChunk->currentReadPacketIndex;
         currentChunk = currentChunk->nextChunk;
     }
     lookAheadChunk = readChunk;
@@ -521,7 +552,7 @@ bool ChunkedPacketQueue::IsRandomAccessIndexLookedAhead(u16 index) const
 
     if (pair.chunk == lookAheadChunk)
     {
-        return pair.head < lookAheadChunk->currentLookAheadHead;
+        return pair.packetIndexInChunk < lookAheadChunk->currentLookAheadPacketIndex;
     }
 
     ConnectionQueueMemoryChunk* currentChunk = readChunk;
@@ -534,6 +565,66 @@ bool ChunkedPacketQueue::IsRandomAccessIndexLookedAhead(u16 index) const
     return false;
 }
 
+u32 ChunkedPacketQueue::GetLookAheadAgeSec() const
+{
+    if (!HasMoreToLookAhead())
+    {
+        SIMEXCEPTION(IllegalStateException);
+        return 0;
+    }
+    return GetAgeSec((const QueueEntryHeader*)(lookAheadChunk->data.data() + lookAheadChunk->currentLookAheadHead));
+}
+
+u32 ChunkedPacketQueue::DiscardExpiredMessages(u32 maxAgeSec)
+{
+    if (maxAgeSec == 0) return 0;
+    if (maxAgeSec > MAX_TRACKABLE_AGE_SEC)
+    {
+        SIMEXCEPTION(IllegalArgumentException);
+        return 0;
+    }
+
+    u32 discardedPackets = 0;
+    // Everything between the read and the lookAhead was already handed to the HAL and will
+    // be popped once it was sent. We must also not start dropping in the middle of a message
+    // of which some splits were already sent, so only whole messages at the front are dropped.
+    while (HasPackets() && IsLookAheadAndReadSame() && !isReadInsideSplitMessage)
+    {
+        const QueueEntryHeader* header = (const QueueEntryHeader*)(readChunk->data.data() + readChunk->currentReadHead);
+        if (GetAgeSec(header) < maxAgeSec) break;
+
+        // All splits of a message are queued at once, so the rest of the message is guaranteed to follow.
+        do
+        {
+            PopPacket();
+            discardedPackets++;
+        } while (isReadInsideSplitMessage);
+    }
+
+    if (discardedPackets > 0)
+    {
+        // Same reevaluation as in RollbackLookAhead, the lookAhead now points to a different message.
+        isCurrentlySendingSplitMessage = false;
+        if (HasPackets())
+        {
+            const QueueEntryHeader* header = ((const QueueEntryHeader*)(lookAheadChunk->data.data() + lookAheadChunk->currentLookAheadHead));
+            isCurrentlySendingSplitMessage = header->isSplit == 1 ? true : false;
+        }
+    }
+    return discardedPackets;
+}
+
+u16 ChunkedPacketQueue::GetCurrentEnqueueTimeSec()
+{
+    return (GS->appTimerDs / 10) & MAX_TRACKABLE_AGE_SEC;
+}
+
+u32 ChunkedPacketQueue::GetAgeSec(const QueueEntryHeader* header)
+{
+    static_assert(((MAX_TRACKABLE_AGE_SEC + 1) & MAX_TRACKABLE_AGE_SEC) == 0, "The age calculation relies on a wrap around at a power of two.");
+    return (GetCurrentEnqueueTimeSec() - header->enqueueTimeSec) & MAX_TRACKABLE_AGE_SEC;
+}
+
 u32 ChunkedPacketQueue::GetAmountOfPackets() const
 {
     return amountOfPackets;
@@ -601,5 +692,6 @@ void ChunkedPacketQueue::SimReset()
     readChunk = GS->connectionQueueMemoryAllocator.Allocate(true);
     writeChunk = readChunk;
     lookAheadChunk = readChunk;
+    isReadInsideSplitMessage = false;
 }
 #endif
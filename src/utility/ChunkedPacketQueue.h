@@ -51,6 +51,7 @@ private:
     u32 amountOfPackets = 0;
     u32 messageHandle = 0;
     bool isCurrentlySendingSplitMessage = false;
+    bool isReadInsideSplitMessage = false; //Set if the last popped entry was a split that is followed by further splits of the same message
 
     struct QueueEntryHeader
     {
@@ -58,7 +59,8 @@ private:
         u16 isSplit : 1;
         u16 isExtended : 1;
         u16 isLastSplit : 1;
-        u16 reserved : 13;
+        u16 enqueueTimeSec : 12; //Lower bits of the app timer in seconds at the time the entry was queued
+        u16 reserved : 1;
     };
 
     struct ExtendedQueueEntryHeader
@@ -71,15 +73,22 @@ private:
     {
         ConnectionQueueMemoryChunk* chunk;
         u32 head;
+        u8 packetIndexInChunk;
     };
 
-    void AddMessageRaw(u8* data, u16 size);
+    void AddMessageRaw(u8* data, u16 size, bool isEntryStart = false);
+    void AddPacketToChunkIndex(ConnectionQueueMemoryChunk* chunk, u32 head);
     u16 PeekPacketRaw(u8* outData, u16 outDataSize, const ConnectionQueueMemoryChunk* chunk, u32 head, u32* messageHandle=nullptr) const;
     ChunkHeadPair GetChunkHeadPairOfIndex(u16 index) const;
+    static u16 GetCurrentEnqueueTimeSec();
+    static u32 GetAgeSec(const QueueEntryHeader* header);
 
     DeliveryPriority prio = DeliveryPriority::VITAL;
 
 public:
+    //The enqueue time is stored with 12 bits, an age is therefore only unambiguous up to this amount of seconds
+    static constexpr u32 MAX_TRACKABLE_AGE_SEC = 4095;
+
     ChunkedPacketQueue();
     ~ChunkedPacketQueue();
 
@@ -90,7 +99,7 @@ public:
     
     bool AddMessage(u8* data, u16 size, u32 * messageHandle, bool isSplit = false);
     u16 PeekPacket      (u8* outData, u16 outDataSize, u32* messageHandle=nullptr) const;
-    u16 RandomAccessPeek(u8* outData, u16 outDataSize, u16 index, u32* messageHandle=nullptr) const; //Careful, very expensive!
+    u16 RandomAccessPeek(u8* outData, u16 outDataSize, u16 index, u32* messageHandle=nullptr) const; //Only walks the chunk list, not the entries
     void PopPacket();
     bool HasPackets() const;
     bool IsCurrentlySendingSplitMessage() const;
@@ -104,6 +113,11 @@ public:
     void RollbackLookAhead();
     bool IsRandomAccessIndexLookedAhead(u16 index) const;
 
+    u32 GetLookAheadAgeSec() const;
+    //Pops all messages from the front of the queue that are at least maxAgeSec old and were not yet handed
+    //to the HAL. Returns the amount of removed packets. A maxAgeSec of 0 disables the expiry.
+    u32 DiscardExpiredMessages(u32 maxAgeSec);
+
     u32 GetAmountOfPackets() const;
     void Print() const;
 
@@ -138,6 +138,26 @@ QueuePriorityPair ChunkedPriorityPacketQueue::GetSendQueue()
         return retVal;
     }
 
+    // Head-of-line protection: If the next message of a queue has already waited for half
+    // of its maximum age, it is sent out before the droplets are considered. Promotions and
+    // regular picks alternate so that higher priorities get at least every second packet.
+    if (!lastSendQueueWasAgePromoted)
+    {
+        for (u32 i = 1; i < queues.size(); i++)
+        {
+            if (MAX_QUEUE_AGE_SEC_PER_PRIORITY[i] != 0
+                && queues[i].HasMoreToLookAhead()
+                && queues[i].GetLookAheadAgeSec() * 2 >= MAX_QUEUE_AGE_SEC_PER_PRIORITY[i])
+            {
+                lastSendQueueWasAgePromoted = true;
+                retVal.priority = (DeliveryPriority)i;
+                retVal.queue = &queues[i];
+                return retVal;
+            }
+        }
+    }
+    lastSendQueueWasAgePromoted = false;
+
     //We have to iterate twice in case every queue has a priority droplet overflow.
     //In such a case, all droplets are removed and we start again from the top.
     for (u32 repeat = 0; repeat < 2; repeat++)
@@ -179,3 +199,13 @@ void ChunkedPriorityPacketQueue::RollbackLookAhead()
         queues[i].RollbackLookAhead();
     }
 }
+
+std::array<u32, AMOUNT_OF_SEND_QUEUE_PRIORITIES> ChunkedPriorityPacketQueue::DiscardExpiredMessages()
+{
+    std::array<u32, AMOUNT_OF_SEND_QUEUE_PRIORITIES> discardedPackets = {};
+    for (u32 i = 0; i < queues.size(); i++)
+    {
+        discardedPackets[i] = queues[i].DiscardExpiredMessages(MAX_QUEUE_AGE_SEC_PER_PRIORITY[i]);
+    }
+    return discardedPackets;
+}
@@ -49,12 +49,25 @@ struct QueuePriorityPairConst
 constexpr u32 AMOUNT_OF_PRIORITY_DROPLETS_UNTIL_OVERFLOW = 2;
 static_assert(AMOUNT_OF_PRIORITY_DROPLETS_UNTIL_OVERFLOW > 0, "Must be at least 1, else we always overflow and never send.");
 
+//Maximum age of a queued message per DeliveryPriority, 0 means that the message never expires.
+constexpr std::array<u32, AMOUNT_OF_SEND_QUEUE_PRIORITIES> MAX_QUEUE_AGE_SEC_PER_PRIORITY = {
+    0, // VITAL
+    PACKET_QUEUE_MAX_AGE_SEC_HIGH,
+    PACKET_QUEUE_MAX_AGE_SEC_MEDIUM,
+    PACKET_QUEUE_MAX_AGE_SEC_LOW,
+};
+static_assert(AMOUNT_OF_SEND_QUEUE_PRIORITIES == 4, "MAX_QUEUE_AGE_SEC_PER_PRIORITY must be adjusted to the new amount of priorities.");
+static_assert(PACKET_QUEUE_MAX_AGE_SEC_HIGH   <= ChunkedPacketQueue::MAX_TRACKABLE_AGE_SEC, "Max age can't be tracked.");
+static_assert(PACKET_QUEUE_MAX_AGE_SEC_MEDIUM <= ChunkedPacketQueue::MAX_TRACKABLE_AGE_SEC, "Max age can't be tracked.");
+static_assert(PACKET_QUEUE_MAX_AGE_SEC_LOW    <= ChunkedPacketQueue::MAX_TRACKABLE_AGE_SEC, "Max age can't be tracked.");
+
 class ChunkedPriorityPacketQueue
 {
     //See Quality of Service documentation.
 private:
     std::array<ChunkedPacketQueue, AMOUNT_OF_SEND_QUEUE_PRIORITIES> queues = {};
     std::array<u32,                AMOUNT_OF_SEND_QUEUE_PRIORITIES> priorityDroplets = {};
+    bool lastSendQueueWasAgePromoted = false;
 
     QueuePriorityPair GetSplitQueue();
     QueuePriorityPairConst GetSplitQueue() const;
@@ -68,6 +81,7 @@ public:
     QueuePriorityPair GetSendQueue();
     ChunkedPacketQueue* GetQueueByPriority(DeliveryPriority prio);
     void RollbackLookAhead();
+    std::array<u32, AMOUNT_OF_SEND_QUEUE_PRIORITIES> DiscardExpiredMessages();
 };
 
 
@@ -144,4 +144,8 @@ void ConnectionQueueMemoryChunk::Reset()
     amountOfByteInThisChunk = 0;
     currentReadHead = 0;
     currentLookAheadHead = 0;
+    packetOffsets = {};
+    amountOfPacketsInThisChunk = 0;
+    currentReadPacketIndex = 0;
+    currentLookAheadPacketIndex = 0;
 }
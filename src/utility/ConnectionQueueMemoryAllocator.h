@@ -40,6 +40,13 @@ static_assert((CONNECTION_QUEUE_MEMORY_MAX_CHUNKS_PER_CONNECTION * TOTAL_NUM_CON
 class ConnectionQueueMemoryChunk
 {
     friend class ConnectionQueueMemoryAllocator;
+public:
+    // Every queue entry consists of at least a 4 byte header and 4 bytes (aligned) of payload,
+    // which limits the amount of entries that can start in a single chunk.
+    static constexpr u32 MAX_PACKETS_PER_CHUNK = CONNECTION_QUEUE_MEMORY_CHUNK_SIZE / 8;
+    static_assert(CONNECTION_QUEUE_MEMORY_CHUNK_SIZE / sizeof(u32) <= 0xFF, "Packet offsets are stored as u8 in units of u32.");
+    static_assert(MAX_PACKETS_PER_CHUNK <= 0xFF, "Packet counts are stored as u8.");
+
 private:
 
 #ifdef SIM_ENABLED
@@ -57,6 +64,14 @@ public:
     u32 currentReadHead = 0;
     u32 currentLookAheadHead = 0;
 
+    // Index of all entries that start in this chunk. The offsets are stored in units of u32 as
+    // every entry is 4 byte aligned. This allows random access into the queue without having to
+    // parse every entry header in front of the accessed entry.
+    std::array<u8, MAX_PACKETS_PER_CHUNK> packetOffsets{};
+    u8 amountOfPacketsInThisChunk = 0;
+    u8 currentReadPacketIndex = 0;
+    u8 currentLookAheadPacketIndex = 0;
+
     void Reset();
 
 private:
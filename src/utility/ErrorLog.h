@@ -149,6 +149,12 @@ enum class CustomErrorTypes : u8 {
     COUNT_VENDOR_BYTES_SENT = 97,
     ERROR_TOO_MANY_REGISTER_HANDLERS = 98,
     ERROR_RECORD_STORAGE_REGISTER_HANDLER = 99,
+    COUNT_EXPIRED_PACKETS = 100,
+    COUNT_MERGED_ASSET_REPORTS = 101,
+    COUNT_EVICTED_TRACKED_ASSETS = 102,
+    COUNT_DROPPED_TRACKED_ASSETS = 103,
+    COUNT_RELIABLE_SEGMENTS_RETRANSMITTED = 104,
+    WARN_RELIABLE_TRANSFER_FAILED = 105,
     // When adding new error type please also add in frutyapi in BeaconErrorMessage.java
 };
 
@@ -635,6 +635,18 @@ const char* Logger::GetErrorLogCustomError(CustomErrorTypes type)
         return "WARN_AUTO_SENSE_REPORT_WITHOUT_DATA";
     case CustomErrorTypes::COUNT_VENDOR_BYTES_SENT:
         return "COUNT_VENDOR_BYTES_SENT";
+    case CustomErrorTypes::COUNT_EXPIRED_PACKETS:
+        return "COUNT_EXPIRED_PACKETS";
+    case CustomErrorTypes::COUNT_MERGED_ASSET_REPORTS:
+        return "COUNT_MERGED_ASSET_REPORTS";
+    case CustomErrorTypes::COUNT_EVICTED_TRACKED_ASSETS:
+        return "COUNT_EVICTED_TRACKED_ASSETS";
+    case CustomErrorTypes::COUNT_DROPPED_TRACKED_ASSETS:
+        return "COUNT_DROPPED_TRACKED_ASSETS";
+    case CustomErrorTypes::COUNT_RELIABLE_SEGMENTS_RETRANSMITTED:
+        return "COUNT_RELIABLE_SEGMENTS_RETRANSMITTED";
+    case CustomErrorTypes::WARN_RELIABLE_TRANSFER_FAILED:
+        return "WARN_RELIABLE_TRANSFER_FAILED";
     default:
         SIMEXCEPTION(ErrorCodeUnknownException); //Could be an error or should be added to the list
         return "UNKNOWN_ERROR";
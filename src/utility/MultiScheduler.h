@@ -51,6 +51,10 @@ enum class EventTimeType : u8
  * Events can be both in relative time and in absolute time. An absolute
  * event does not trigger until the absolute time is set (see setAbsoluteTime). 
  * 
+ * The events are kept in a binary heap, so adding and retrieving an event
+ * is O(log n). Events that occur at the same time are retrieved in the
+ * order in which they were added or re-entered.
+ * 
  * T = The type of event data that the scheduler will manage.
  * CAPACITY = The maximum number of events the scheduler can handle.
  */
@@ -66,12 +70,56 @@ private:
         u32 timeBetweenEventsDs = 0;
         u32 nextOccurrenceDs = 0;
         u32 offset = 0;
+        u32 sequenceNumber = 0; // Keeps events with the same occurrence in the order in which they were (re-)entered.
     };
     u32 length = 0;
     u32 baseTimeDs = 0;
     u32 absoluteTimeDs = 0;
+    u32 nextSequenceNumber = 0;
+    // A binary min heap, ordered by nextOccurrenceDs and then by sequenceNumber.
+    // The children of the event at index i are located at 2*i+1 and 2*i+2.
     Event events[CAPACITY];
 
+    static bool isBefore(const Event& a, const Event& b)
+    {
+        if (a.nextOccurrenceDs != b.nextOccurrenceDs) return a.nextOccurrenceDs < b.nextOccurrenceDs;
+        // Compared as a difference so that a wrap of the sequence numbers does not matter.
+        return (i32)(a.sequenceNumber - b.sequenceNumber) < 0;
+    }
+
+    void swapEvents(u32 a, u32 b)
+    {
+        Event temp = events[a];
+        events[a] = events[b];
+        events[b] = temp;
+    }
+
+    void siftUp(u32 i)
+    {
+        while (i > 0)
+        {
+            const u32 parent = (i - 1) / 2;
+            if (!isBefore(events[i], events[parent])) break;
+            swapEvents(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(u32 i)
+    {
+        while (true)
+        {
+            const u32 left = 2 * i + 1;
+            const u32 right = left + 1;
+            u32 smallest = i;
+            if (left < length && isBefore(events[left], events[smallest])) smallest = left;
+            if (right < length && isBefore(events[right], events[smallest])) smallest = right;
+            if (smallest == i) break;
+            swapEvents(i, smallest);
+            i = smallest;
+        }
+    }
+
     void addEvent(/*mutable*/ Event& ev)
     {
         if (absoluteTimeDs == 0 && ev.type == EventTimeType::SYNCED)
@@ -80,32 +128,20 @@ private:
             // Move the occurrence so far into the future that it will basically never happen.
             ev.nextOccurrenceDs = 0xFFFFFFFF;
         }
-        if (length == 0)
-        {
-            events[0] = ev;
-            length++;
-            return;
-        }
-        u32 i = 0;
-        for (; i < length; i++)
-        {
-            if (events[i].nextOccurrenceDs > ev.nextOccurrenceDs) break;
-        }
-        for (u32 end = length - 1; end >= i && end != (u32)-1; end--)
-        {
-            events[end + 1] = events[end];
-        }
-        events[i] = ev;
+        ev.sequenceNumber = nextSequenceNumber++;
+        events[length] = ev;
         length++;
+        siftUp(length - 1);
     }
 
     Event popFirst()
     {
         Event retVal = events[0];
         length--;
-        for (u32 i = 0; i < length; i++)
+        if (length > 0)
         {
-            events[i] = events[i + 1];
+            events[0] = events[length];
+            siftDown(0);
         }
         return retVal;
     }
@@ -192,12 +228,16 @@ public:
         }
         if (found)
         {
-            for (; i < length - 1; i++)
+            length--;
+            if (i != length)
             {
-                events[i] = events[i + 1];
+                // Fill the gap with the last event and restore the heap property
+                // in whichever direction it was violated.
+                events[i] = events[length];
+                siftUp(i);
+                siftDown(i);
             }
-            events[length - 1].t.~T();
-            length--;
+            events[length].t.~T();
         }
         return found;
     }
@@ -221,28 +261,10 @@ public:
             }
         }
 
-        // Edge case that makes sorting easier (We can ignore unsigned int underflows)
-        if (length < 2)
+        // Rebuild the heap bottom up, starting with the last event that has children.
+        for (u32 i = length / 2; i > 0; i--)
         {
-            return;
-        }
-
-        // Sort the events
-        // TODO: This is a bubble sort, do something more clever
-        for (u32 i = 0; i < length - 1; i++)
-        {
-            bool changed = false;
-            for (u32 k = 0; k < length - i - 1; k++)
-            {
-                if (events[k].nextOccurrenceDs > events[k + 1].nextOccurrenceDs)
-                {
-                    changed = true;
-                    Event temp = events[k];
-                    events[k] = events[k + 1];
-                    events[k + 1] = temp;
-                }
-            }
-            if (!changed) break;
+            siftDown(i - 1);
         }
     }
-};
\ No newline at end of file
+};
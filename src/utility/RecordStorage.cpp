@@ -113,7 +113,7 @@ RecordStorageResultCode RecordStorage::SaveRecord(u16 recordId, const u8* data,
     return RecordStorage::SaveRecord(recordId, data, dataLength, callback, userType, nullptr, 0, lockDownModule);
 }
 
-RecordStorageResultCode RecordStorage::SaveRecord(u16 recordId, const u8* data, u16 dataLength, RecordStorageEventListener* callback, u32 userType, u8* userData, u16 userDataLength, ModuleIdWrapper lockDownModule, bool alwaysPersist)
+RecordStorageResultCode RecordStorage::SaveRecord(u16 recordId, const u8* data, u16 dataLength, RecordStorageEventListener* callback, u32 userType, u8* userData, u16 userDataLength, ModuleIdWrapper lockDownModule, bool alwaysPersist, bool supersedable)
 {
     //If persistence is disabled we do not store the entry
     //This can however be overwritten if alwaysPersist is true
@@ -136,6 +136,7 @@ RecordStorageResultCode RecordStorage::SaveRecord(u16 recordId, const u8* data,
         op->stage = RecordStorageSaveStage::FIRST_STAGE;
         op->recordId = recordId;
         op->dataLength = dataLength;
+        op->supersedable = supersedable ? 1 : 0;
         CheckedMemcpy(op->data, data, dataLength);
         if (userData != nullptr) CheckedMemcpy(buffer + (SIZEOF_RECORD_STORAGE_SAVE_RECORD_OP + dataLength), userData, userDataLength);
 
@@ -223,6 +224,31 @@ void RecordStorage::SaveRecordInternal(SaveRecordOperation& op)
     }
 
     if (op.stage == RecordStorageSaveStage::DEFRAGMENT_IF_NEEDED) {
+        //The newer save will write the record anyway, so this one is replaced by an operation that only
+        //keeps the callback until the newer save has finished. If the queue is full, the record is saved.
+        if (op.supersedable && IsSaveOfRecordQueued(op.recordId))
+        {
+            const u16 userDataLength = (u16)op.op.userDataLength;
+            u8* buffer = opQueue.Reserve(SIZEOF_RECORD_STORAGE_SUPERSEDED_SAVE_RECORD_OP + userDataLength);
+            if (buffer != nullptr)
+            {
+                SupersededSaveRecordOperation* supersededOp = (SupersededSaveRecordOperation*)buffer;
+                supersededOp->op = op.op;
+                supersededOp->op.type = (u8)RecordStorageOperationType::SUPERSEDED_SAVE_RECORD;
+                supersededOp->resultCode = (u8)RecordStorageResultCode::SUCCESS;
+                supersededOp->resultAvailable = 0;
+                supersededOp->recordId = op.recordId;
+                supersededOp->reserved = 0;
+                if (userDataLength > 0) CheckedMemcpy(buffer + SIZEOF_RECORD_STORAGE_SUPERSEDED_SAVE_RECORD_OP, op.data + op.dataLength, userDataLength);
+
+                logt("RS", "SaveRecord id %u superseded", op.recordId);
+                SIMSTATCOUNT("RecordStorageSaveSuperseded");
+
+                opQueue.DiscardNext();
+                return ProcessQueue(true);
+            }
+        }
+
         logt("RS", "SaveRecord id %u, len %u", op.recordId, op.dataLength);
 
         u16 recordLength = op.dataLength + SIZEOF_RECORD_STORAGE_RECORD_HEADER;
@@ -891,8 +917,41 @@ void RecordStorage::DefragmentPage(RecordStoragePage& pageToDefragment, bool for
 
 
 //This will call the callback of the operation and will remove it from the queue
+void RecordStorage::SupersededSaveRecordInternal(SupersededSaveRecordOperation& op)
+{
+    //The save that replaced this one is always queued in front of it, see IsSaveOfRecordQueued
+    if (!op.resultAvailable)
+    {
+        SIMEXCEPTION(IllegalStateException);
+        return RecordOperationFinished(op.op, RecordStorageResultCode::BUSY);
+    }
+    return RecordOperationFinished(op.op, (RecordStorageResultCode)op.resultCode);
+}
+
+void RecordStorage::SetResultOfSupersededSaves(u16 recordId, RecordStorageResultCode code)
+{
+    for (u32 i = 0; i < opQueue._numElements; i++)
+    {
+        RecordStorageOperation* op = (RecordStorageOperation*)opQueue.PeekNext((u8)i).data;
+        if (op->type == (u8)RecordStorageOperationType::SUPERSEDED_SAVE_RECORD)
+        {
+            SupersededSaveRecordOperation* supersededOp = (SupersededSaveRecordOperation*)op;
+            if (supersededOp->recordId == recordId && !supersededOp->resultAvailable)
+            {
+                supersededOp->resultCode = (u8)code;
+                supersededOp->resultAvailable = 1;
+            }
+        }
+    }
+}
+
 void RecordStorage::RecordOperationFinished(RecordStorageOperation& op, RecordStorageResultCode code)
 {
+    if (op.type == (u8)RecordStorageOperationType::SAVE_RECORD)
+    {
+        SetResultOfSupersededSaves(((SaveRecordOperation*)&op)->recordId, code);
+    }
+
     ExecuteCallback(op, code);
 
     //Clear operation from operation queue
@@ -937,6 +996,22 @@ void RecordStorage::ExecuteCallback(RecordStorageOperation & op, RecordStorageRe
                 op.callback->RecordStorageEventHandler(dop->recordId, code, op.userType, nullptr, 0);
             }
         }
+        else if (op.type == (u8)RecordStorageOperationType::SUPERSEDED_SAVE_RECORD)
+        {
+            SupersededSaveRecordOperation* sop = (SupersededSaveRecordOperation*)&op;
+            if (op.userDataLength > 0)
+            {
+                // Make sure the user data is 4 byte aligned. That way the user can give
+                // us any struct of alignment <= 4 without problems.
+                DYNAMIC_ARRAY(buffer, op.userDataLength);
+                CheckedMemcpy(buffer, ((u8*)&op) + SIZEOF_RECORD_STORAGE_SUPERSEDED_SAVE_RECORD_OP, op.userDataLength);
+                op.callback->RecordStorageEventHandler(sop->recordId, code, op.userType, buffer, op.userDataLength);
+            }
+            else
+            {
+                op.callback->RecordStorageEventHandler(sop->recordId, code, op.userType, nullptr, 0);
+            }
+        }
     }
 }
 
@@ -993,6 +1068,56 @@ SizedData RecordStorage::GetRecordData(u16 recordId) const
     return result;
 }
 
+SizedData RecordStorage::GetLatestRecordData(u16 recordId) const
+{
+    SizedData result = GetRecordData(recordId);
+
+    //Queued operations are executed in order, so the last one that affects the record wins
+    for (u32 i = 0; i < opQueue._numElements; i++)
+    {
+        const RecordStorageOperation* op = (const RecordStorageOperation*)opQueue.PeekNext((u8)i).data;
+        if (op->type == (u8)RecordStorageOperationType::SAVE_RECORD)
+        {
+            SaveRecordOperation* saveOp = (SaveRecordOperation*)op;
+            if (saveOp->recordId == recordId)
+            {
+                result.data = saveOp->data;
+                result.length = saveOp->dataLength;
+            }
+        }
+        else if (op->type == (u8)RecordStorageOperationType::DEACTIVATE_RECORD)
+        {
+            if (((const DeactivateRecordOperation*)op)->recordId == recordId)
+            {
+                result.data = nullptr;
+                result.length = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+bool RecordStorage::IsSaveOfRecordQueued(u16 recordId) const
+{
+    //The first element is the operation that is currently executed
+    for (u32 i = 1; i < opQueue._numElements; i++)
+    {
+        const RecordStorageOperation* op = (const RecordStorageOperation*)opQueue.PeekNext((u8)i).data;
+        if (op->type == (u8)RecordStorageOperationType::SAVE_RECORD && ((const SaveRecordOperation*)op)->recordId == recordId)
+        {
+            return true;
+        }
+        //A save behind a superseded save must not replace the current one. Otherwise the superseded
+        //save would reach the front of the queue before the save that provides its result has finished.
+        if (op->type == (u8)RecordStorageOperationType::SUPERSEDED_SAVE_RECORD && ((const SupersededSaveRecordOperation*)op)->recordId == recordId)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
 //Will return the latest version of a record if its structure is valid
 //Will also return a record if it has been deactivated
 RecordStorageRecord* RecordStorage::GetRecord(u16 recordId) const
@@ -1226,6 +1351,10 @@ void RecordStorage::FlashStorageItemExecuted(FlashStorageTaskItem* task, FlashSt
                     op->flashStorageErrorCode = errorCode;
                     ImmortalizeRecordInternal(*(ImmortalizeRecordOperation*)op);
                 }
+                else if (op->type == (u8)RecordStorageOperationType::SUPERSEDED_SAVE_RECORD)
+                {
+                    SupersededSaveRecordInternal(*(SupersededSaveRecordOperation*)op);
+                }
             }
 
             if (opQueue._numElements == 0) {
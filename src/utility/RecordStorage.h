@@ -116,7 +116,8 @@ enum class RecordStorageOperationType : u8
 {
     SAVE_RECORD,
     DEACTIVATE_RECORD,
-    IMMORTALIZE_RECORD
+    IMMORTALIZE_RECORD,
+    SUPERSEDED_SAVE_RECORD,
 };
 
 enum class RecordStorageSaveStage : u16
@@ -210,13 +211,14 @@ typedef struct
 }RecordStorageOperation;
 STATIC_ASSERT_SIZE(RecordStorageOperation, SIZEOF_RECORD_STORAGE_OPERATION);
 
-constexpr int SIZEOF_RECORD_STORAGE_SAVE_RECORD_OP = (SIZEOF_RECORD_STORAGE_OPERATION + 6);
+constexpr int SIZEOF_RECORD_STORAGE_SAVE_RECORD_OP = (SIZEOF_RECORD_STORAGE_OPERATION + 7);
 typedef struct
 {
     RecordStorageOperation op;
     RecordStorageSaveStage stage;
     u16 recordId;
     u16 dataLength;
+    u8 supersedable; //If set, the save is skipped if a newer save of the same record is queued
     u8 data[1];
 
 }SaveRecordOperation;
@@ -243,6 +245,20 @@ typedef struct
 
 }ImmortalizeRecordOperation;
 STATIC_ASSERT_SIZE(ImmortalizeRecordOperation, SIZEOF_RECORD_STORAGE_IMMORTALIZE_RECORD_OP);
+
+//Replaces a supersedable save that was skipped because a newer save of the same record was queued.
+//It only holds the callback and the userData and is finished with the result of the newer save.
+constexpr int SIZEOF_RECORD_STORAGE_SUPERSEDED_SAVE_RECORD_OP = (SIZEOF_RECORD_STORAGE_OPERATION + 6);
+typedef struct
+{
+    RecordStorageOperation op;
+    u8 resultCode;
+    u8 resultAvailable;
+    u16 recordId;
+    u16 reserved;
+
+}SupersededSaveRecordOperation;
+STATIC_ASSERT_SIZE(SupersededSaveRecordOperation, SIZEOF_RECORD_STORAGE_SUPERSEDED_SAVE_RECORD_OP);
 #pragma pack(pop)
 
 enum class RecordStorageResultCode : u8
@@ -305,6 +321,13 @@ class RecordStorage : public FlashStorageEventListener
 
         //Stores a record
         void SaveRecordInternal(SaveRecordOperation& op);
+        //Checks if a save of the given record is queued behind the operation that is currently executed
+        //and in front of all superseded saves of the same record that still wait for their result
+        bool IsSaveOfRecordQueued(u16 recordId) const;
+        //Finishes a save that was superseded with the result of the save that replaced it
+        void SupersededSaveRecordInternal(SupersededSaveRecordOperation& op);
+        //Passes the result of a finished save to all superseded saves of the same record
+        void SetResultOfSupersededSaves(u16 recordId, RecordStorageResultCode code);
         //Removes a record
         void DeactivateRecordInternal(DeactivateRecordOperation& op);
         //Makes a record immortal
@@ -359,7 +382,9 @@ class RecordStorage : public FlashStorageEventListener
         //Stores a record (Operation is queued)
         RecordStorageResultCode SaveRecord(u16 recordId, const u8* data, u16 dataLength, RecordStorageEventListener* callback, u32 userType, ModuleIdWrapper lockDownModule = INVALID_WRAPPED_MODULE_ID);
         //Allows to cache some information until store completes
-        RecordStorageResultCode SaveRecord(u16 recordId, const u8* data, u16 dataLength, RecordStorageEventListener* callback, u32 userType, u8* userData, u16 userDataLength, ModuleIdWrapper lockDownModule = INVALID_WRAPPED_MODULE_ID, bool alwaysPersist = false);
+        //A supersedable save is not written to flash if a newer save of the same record is queued once it is
+        //executed. Its callback is then called with the result of the newer save once that one has finished.
+        RecordStorageResultCode SaveRecord(u16 recordId, const u8* data, u16 dataLength, RecordStorageEventListener* callback, u32 userType, u8* userData, u16 userDataLength, ModuleIdWrapper lockDownModule = INVALID_WRAPPED_MODULE_ID, bool alwaysPersist = false, bool supersedable = false);
         //Removes a record (Operation is queued)
         RecordStorageResultCode DeactivateRecord(u16 recordId, RecordStorageEventListener * callback, u32 userType, ModuleIdWrapper lockDownModule = INVALID_WRAPPED_MODULE_ID, bool alwaysPersist = false);
         //Allows to cache some information until remove completes
@@ -368,6 +393,8 @@ class RecordStorage : public FlashStorageEventListener
         RecordStorageRecord* GetRecord(u16 recordId) const;
         //Retrieves the data of a record
         SizedData GetRecordData(u16 recordId) const;
+        //Retrieves the data that a record will have once all queued operations were executed
+        SizedData GetLatestRecordData(u16 recordId) const;
         //Returns if there is any valid record stored (e.g. not factory state)
         //Will also return true if the record has already been deleted in a later version
         bool HasMortalRecords();
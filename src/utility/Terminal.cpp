@@ -445,6 +445,7 @@ void Terminal::ProcessLine(char* line)
 
     
     for(u32 i=0; i<GS->amountOfModules; i++){
+        STACK_WATCHER_SCOPE("TerminalCommandHandler", GS->activeModules[i]->moduleName, 0);
         TerminalCommandHandlerReturnType currentHandled = GS->activeModules[i]->TerminalCommandHandler(commandArgsPtr, (u8)commandArgsSize);
 
         if (          handled != TerminalCommandHandlerReturnType::UNKNOWN
@@ -40,6 +40,11 @@ not sync the same time to all nodes. Doing another sync on one node will however
 The reason is that both nodes will generate the same counter value and therefore, there will be no winner.
 */
 
+//Unit of the fractions of a tick that are kept by the drift compensation, a drift of 1 ppb makes 1 nano tick per tick
+constexpr int64_t NANO_TICKS_PER_TICK = 1000000000;
+//Maximum difference between the local and the received time that is considered to be caused by the clock drift
+constexpr i32 MAX_CLOCK_DRIFT_DIFFERENCE_SEC = 60 * 60;
+
 TimeManager::TimeManager()
 {
     syncTime = 0;
@@ -88,6 +93,8 @@ TimePoint TimeManager::GetLocalTimePoint()
 
 void TimeManager::SetMasterTime(u32 syncTimeDs, u32 timeSinceSyncTimeDs, i16 offset, u32 additionalTicks)
 {
+    ProcessTicks();
+
     this->syncTime = syncTimeDs;
     this->timeSinceSyncTime = timeSinceSyncTimeDs;
     this->additionalTicks = additionalTicks;
@@ -98,6 +105,14 @@ void TimeManager::SetMasterTime(u32 syncTimeDs, u32 timeSinceSyncTimeDs, i16 off
 
     this->isTimeMaster = true;
 
+    //The clock of the time master is the reference for all others
+    this->clockDriftPpb = 0;
+    this->clockDriftRemainderNanoTicks = 0;
+    this->numClockDriftMeasurements = 0;
+    ResetClockDriftMeasurement();
+    this->timeSinceMasterResyncDs = 0;
+    this->masterResyncLevel = 0;
+
     //We inform the connection manager so that it resends the time sync messages.
     logt("TSYNC", "Received time by command! NodeId: %u", (u32)GS->node.configuration.nodeId);
     GS->cm.ResetTimeSync();
@@ -107,6 +122,33 @@ void TimeManager::SetTime(const TimeSyncInitial & timeSyncIntitialMessage)
 {
     if (timeSyncIntitialMessage.counter > this->counter)
     {
+        ProcessTicks();
+
+        //If our clock was synced before, the difference to the received time is the drift since then.
+        //It is evaluated once the correction for the message delay is received, see MeasureClockDrift
+        bool measureDrift = false;
+        i32 differenceTicks = 0;
+        if (GS->config.enableClockDriftCompensation && hasSyncReference && !isTimeMaster)
+        {
+            const u32 localUtcTime = syncTime + timeSinceSyncTime;
+            const u32 receivedUtcTime = timeSyncIntitialMessage.syncTimeStamp + timeSyncIntitialMessage.timeSincSyncTimeStamp;
+            const i32 differenceSeconds = (i32)(localUtcTime - receivedUtcTime);
+            //Larger differences are not caused by the drift but e.g. by a new time given to the time master
+            if (differenceSeconds > -MAX_CLOCK_DRIFT_DIFFERENCE_SEC && differenceSeconds < MAX_CLOCK_DRIFT_DIFFERENCE_SEC)
+            {
+                differenceTicks = TimePoint(localUtcTime, additionalTicks) - TimePoint(receivedUtcTime, timeSyncIntitialMessage.additionalTicks);
+                measureDrift = true;
+            }
+        }
+        const u32 intervalTicks = ticksSinceLastSync;
+        ResetClockDriftMeasurement();
+        if (measureDrift)
+        {
+            driftMeasurementPending = true;
+            driftMeasurementTicks = differenceTicks;
+            driftMeasurementIntervalTicks = intervalTicks;
+        }
+
         this->syncTime = timeSyncIntitialMessage.syncTimeStamp;
         this->timeSinceSyncTime = timeSyncIntitialMessage.timeSincSyncTimeStamp;
         this->additionalTicks = timeSyncIntitialMessage.additionalTicks;
@@ -127,6 +169,9 @@ void TimeManager::SetTime(const TimeSyncInterNetwork& timeSyncInterNetwork)
 {
     if (this->counter == 0 || GET_DEVICE_TYPE() == DeviceType::ASSET)
     {
+        ProcessTicks();
+        ResetClockDriftMeasurement();
+
         this->syncTime = timeSyncInterNetwork.syncTimeStamp;
         this->timeSinceSyncTime = timeSyncInterNetwork.timeSincSyncTimeStamp;
         this->additionalTicks = timeSyncInterNetwork.additionalTicks;
@@ -155,6 +200,9 @@ bool TimeManager::IsTimeCorrected() const
 
 void TimeManager::AddTicks(u32 ticks)
 {
+    //With the drift compensation, the passed time is measured with the RTC in ProcessTicks
+    if (GS->config.enableClockDriftCompensation) return;
+
     additionalTicks += ticks;
 }
 
@@ -162,10 +210,16 @@ void TimeManager::AddCorrection(u32 ticks)
 {
     if (waitingForCorrection)
     {
-        AddTicks(ticks);
+        additionalTicks += ticks;
         this->waitingForCorrection = false;
         this->timeCorrectionReceived = true;
 
+        if (driftMeasurementPending)
+        {
+            MeasureClockDrift(ticks);
+        }
+        hasSyncReference = true;
+
         if(timeSyncedListener)
         {
             timeSyncedListener->TimeSyncedHandler();
@@ -177,12 +231,100 @@ void TimeManager::AddCorrection(u32 ticks)
 
 void TimeManager::ProcessTicks()
 {
+    if (GS->config.enableClockDriftCompensation)
+    {
+        const u32 rtcTicks = FruityHal::GetRtcTicks();
+        if (rtcTicksValid)
+        {
+            const u32 passedTicks = FruityHal::GetRtcTicksDifference(rtcTicks, lastRtcTicks);
+            ticksSinceLastSync = (ticksSinceLastSync < UINT32_MAX - passedTicks) ? ticksSinceLastSync + passedTicks : UINT32_MAX;
+
+            //Subtract the estimated drift, fractions of a tick are kept for the next call
+            const int64_t driftNanoTicks = (int64_t)passedTicks * clockDriftPpb + clockDriftRemainderNanoTicks;
+            const int64_t driftTicks = driftNanoTicks / NANO_TICKS_PER_TICK;
+            clockDriftRemainderNanoTicks = (i32)(driftNanoTicks - driftTicks * NANO_TICKS_PER_TICK);
+            additionalTicks += (u32)((int64_t)passedTicks - driftTicks);
+        }
+        lastRtcTicks = rtcTicks;
+        rtcTicksValid = true;
+    }
+
     u32 seconds = additionalTicks / ticksPerSecond;
     timeSinceSyncTime += seconds;
 
     additionalTicks -= seconds * ticksPerSecond;
 }
 
+void TimeManager::TimerEventHandler(u16 passedTimeDs)
+{
+    if (!GS->config.enableClockDriftCompensation || !isTimeMaster) return;
+
+    timeSinceMasterResyncDs += passedTimeDs;
+    if (timeSinceMasterResyncDs < GetMasterResyncIntervalDs()) return;
+
+    timeSinceMasterResyncDs = 0;
+    if (GetMasterResyncIntervalDs() < Conf::timeResyncMaxIntervalDs) masterResyncLevel++;
+
+    //With a new counter, all other nodes accept our time again, which gives them another drift measurement
+    counter++;
+    logt("TSYNC", "Resyncing time, next resync in %u ds", GetMasterResyncIntervalDs());
+    GS->cm.ResetTimeSync();
+}
+
+u32 TimeManager::GetMasterResyncIntervalDs() const
+{
+    u32 intervalDs = Conf::timeResyncMinIntervalDs;
+    for (u32 i = 0; i < masterResyncLevel && intervalDs < Conf::timeResyncMaxIntervalDs; i++)
+    {
+        intervalDs *= 2;
+    }
+    return intervalDs < Conf::timeResyncMaxIntervalDs ? intervalDs : Conf::timeResyncMaxIntervalDs;
+}
+
+void TimeManager::ResetClockDriftMeasurement()
+{
+    ticksSinceLastSync = 0;
+    hasSyncReference = false;
+    driftMeasurementPending = false;
+}
+
+void TimeManager::MeasureClockDrift(u32 correctionTicks)
+{
+    driftMeasurementPending = false;
+
+    //The error of a single sync is in the range of the message delay, so short intervals are not precise enough
+    if (driftMeasurementIntervalTicks < Conf::minClockDriftMeasurementIntervalSec * ticksPerSecond || driftMeasurementIntervalTicks == UINT32_MAX) return;
+
+    //Our time was set to the time of the partner when it ordered the message, the correction adds the delay until it was sent
+    const int64_t errorTicks = (int64_t)driftMeasurementTicks - correctionTicks;
+    const int64_t residualPpb = errorTicks * NANO_TICKS_PER_TICK / driftMeasurementIntervalTicks;
+    const int64_t maxPpb = (int64_t)Conf::maxClockDriftPpm * 1000;
+    if (residualPpb > maxPpb || residualPpb < -maxPpb)
+    {
+        logt("TSYNC", "Discarded clock drift measurement of %d ppb", (i32)residualPpb);
+        return;
+    }
+
+    //The remaining error is added to the estimate, after the first measurement only halfway to smooth out single syncs
+    int64_t driftPpb = clockDriftPpb + (numClockDriftMeasurements == 0 ? residualPpb : residualPpb / 2);
+    if (driftPpb > maxPpb) driftPpb = maxPpb;
+    if (driftPpb < -maxPpb) driftPpb = -maxPpb;
+    clockDriftPpb = (i32)driftPpb;
+    numClockDriftMeasurements++;
+
+    logt("TSYNC", "Clock drift %d ppb, residual %d ppb over %u s", clockDriftPpb, (i32)residualPpb, driftMeasurementIntervalTicks / ticksPerSecond);
+}
+
+i32 TimeManager::GetClockDriftPpb() const
+{
+    return clockDriftPpb;
+}
+
+u32 TimeManager::GetNumClockDriftMeasurements() const
+{
+    return numClockDriftMeasurements;
+}
+
 void TimeManager::HandleUpdateTimestampMessages(ConnPacketHeader const * packetHeader, MessageLength dataLength)
 {
     if (packetHeader->messageType == MessageType::UPDATE_TIMESTAMP)
@@ -313,6 +455,11 @@ i32 TimePoint::operator-(const TimePoint & other)
     return ticksDifference + secondDifference * ticksPerSecond;
 }
 
+u32 TimePoint::GetUnixTime() const
+{
+    return unixTime;
+}
+
 u32 TimePoint::GetAdditionalTicks() const
 {
     return additionalTicks;
@@ -44,6 +44,7 @@ public:
     i32 operator-(const TimePoint& other);
     TimePoint& operator=(const TimePoint& other) = default;
 
+    u32 GetUnixTime() const;
     u32 GetAdditionalTicks() const;
 };
 
@@ -79,6 +80,26 @@ private:
 
     TimeSyncedListener* timeSyncedListener = nullptr;
 
+    //Clock drift compensation, see Conf::enableClockDriftCompensation
+    bool rtcTicksValid = false;
+    u32 lastRtcTicks = 0; // RTC counter value at the last ProcessTicks call
+    i32 clockDriftPpb = 0; // Estimated drift of the LF clock against the time master in parts per billion, positive if the local clock is too fast
+    i32 clockDriftRemainderNanoTicks = 0; // Fractions of a tick that could not be compensated yet, in 1/1000000000 ticks
+    u32 numClockDriftMeasurements = 0;
+    u32 ticksSinceLastSync = 0; // Uncompensated RTC ticks since the time was last received from the mesh
+    bool hasSyncReference = false; // Set once a sync was corrected, so that the next sync can measure the drift
+    bool driftMeasurementPending = false;
+    i32 driftMeasurementTicks = 0; // Difference between the local and the received time when the last time sync was received
+    u32 driftMeasurementIntervalTicks = 0;
+
+    //Periodic resync of the time master
+    u32 timeSinceMasterResyncDs = 0;
+    u8 masterResyncLevel = 0;
+
+    void ResetClockDriftMeasurement();
+    void MeasureClockDrift(u32 correctionTicks);
+    u32 GetMasterResyncIntervalDs() const;
+
 public:
     TimeManager();
 
@@ -115,7 +136,16 @@ public:
     void AddTicks(u32 ticks);
     void AddCorrection(u32 ticks);
 
+    //Converts the passed ticks to seconds. With Conf::enableClockDriftCompensation, the passed
+    //ticks are read from the RTC instead and the estimated clock drift is subtracted
     void ProcessTicks();
+
+    //Lets the time master redistribute its time periodically if the clock drift is compensated
+    void TimerEventHandler(u16 passedTimeDs);
+
+    //Returns the estimated drift of the local clock against the time master in parts per billion
+    i32 GetClockDriftPpb() const;
+    u32 GetNumClockDriftMeasurements() const;
     
     void HandleUpdateTimestampMessages(ConnPacketHeader const * packetHeader, MessageLength dataLength);
 
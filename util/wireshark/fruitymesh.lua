@@ -32,6 +32,7 @@ Proto_Fruitymesh = Proto("fruitymesh", "FruityMesh Protocol")
 Proto_Fruitymesh_Debug = Proto("fruitymesh_debug", "FruityMesh Debug")
 Proto_Fruitymesh_MeshAccess = Proto("fruitymesh_ma", "FruityMesh MeshAccess")
 Proto_Fruitymesh_Asset = Proto("fruitymesh_asset", "FruityMesh Asset")
+Proto_Fruitymesh_Trace = Proto("fruitymesh_trace", "FruityMesh Packet Trace")
 
 -- ######################################################################################################################
 
@@ -291,10 +292,68 @@ Proto_Fruitymesh_Asset.fields = {
 
 -- ######################################################################################################################
 
+-- Packet traces written by CherrySim (see cherrysim/PacketTracer.h) contain one PacketTraceRecord per pcap record
+trace_event_names = { [0] = "TX", [1] = "RX", [2] = "DROP", [3] = "EXPIRE", [4] = "SPLIT", [5] = "REASSEMBLE" }
+trace_priority_names = { [0] = "VITAL", [1] = "HIGH", [2] = "MEDIUM", [3] = "LOW", [255] = "INVALID" }
+
+function Proto_Fruitymesh_Trace.dissector (buffer, pinfo, tree)
+  if buffer:len() < 17 then
+    return
+  end
+
+  local event_type = buffer(0, 1):uint()
+  local event_name = trace_event_names[event_type] or "UNKNOWN"
+
+  pinfo.cols.protocol = "FM Trace"
+  pinfo.cols.src = tostring(buffer(2, 2):le_uint())
+  pinfo.cols.dst = tostring(buffer(4, 2):le_uint())
+  pinfo.cols.info = event_name.." Message Type "..buffer(10, 1):uint()..", "..buffer(15, 2):le_uint().." bytes"
+
+  local t = tree:add(Proto_Fruitymesh_Trace, buffer(0, 17))
+
+  t:add_le(trace_event_type, buffer(0, 1))
+  t:add_le(trace_priority, buffer(1, 1))
+  t:add_le(trace_node_id, buffer(2, 2))
+  t:add_le(trace_partner_id, buffer(4, 2))
+  t:add_le(trace_connection_id, buffer(6, 4))
+  t:add_le(trace_message_type, buffer(10, 1))
+  t:add_le(trace_sender, buffer(11, 2))
+  t:add_le(trace_receiver, buffer(13, 2))
+  t:add_le(trace_length, buffer(15, 2))
+end
+
+-- Create the protocol fields for the packet trace
+trace_event_type = ProtoField.uint8("fruitymesh_trace.event_type","Event",base.DEC,trace_event_names)
+trace_priority = ProtoField.uint8("fruitymesh_trace.priority","Priority",base.DEC,trace_priority_names)
+trace_node_id = ProtoField.uint16("fruitymesh_trace.node_id","Node Id",base.DEC)
+trace_partner_id = ProtoField.uint16("fruitymesh_trace.partner_id","Partner Id",base.DEC)
+trace_connection_id = ProtoField.uint32("fruitymesh_trace.connection_id","Unique Connection Id",base.DEC)
+trace_message_type = ProtoField.uint8("fruitymesh_trace.message_type","Message Type",base.DEC)
+trace_sender = ProtoField.uint16("fruitymesh_trace.sender","Sender",base.DEC)
+trace_receiver = ProtoField.uint16("fruitymesh_trace.receiver","Receiver",base.DEC)
+trace_length = ProtoField.uint16("fruitymesh_trace.length","Length",base.DEC)
+
+-- add the fields to the protocol
+Proto_Fruitymesh_Trace.fields = {
+  trace_event_type,
+  trace_priority,
+  trace_node_id,
+  trace_partner_id,
+  trace_connection_id,
+  trace_message_type,
+  trace_sender,
+  trace_receiver,
+  trace_length
+}
+
+-- ######################################################################################################################
+
 -- Register the dissector
 wtap_table = DissectorTable.get("wtap_encap")
 nordic_dissector = wtap_table:get_dissector(55)
 wtap_table:add (55, Proto_Fruitymesh)
+-- 45 is the encapsulation of the link type USER0 (147) that is used by the CherrySim packet traces
+wtap_table:add (45, Proto_Fruitymesh_Trace)
 
 debug("FruityMesh Dissector registered")
 